@@ -106,6 +106,20 @@ base_uint<BITS>& base_uint<BITS>::operator/=(const base_uint& b)
     return *this;
 }
 
+template <unsigned int BITS>
+base_uint<BITS>& base_uint<BITS>::DivideBy(uint32_t b32)
+{
+    if (b32 == 0)
+        throw uint_error("Division by zero");
+    uint64_t rem = 0;
+    for (int i = WIDTH - 1; i >= 0; i--) {
+        uint64_t n = (rem << 32) | pn[i];
+        pn[i] = n / b32;
+        rem = n % b32;
+    }
+    return *this;
+}
+
 template <unsigned int BITS>
 int base_uint<BITS>::CompareTo(const base_uint<BITS>& b) const
 {
@@ -190,6 +204,7 @@ template base_uint<256>& base_uint<256>::operator>>=(unsigned int);
 template base_uint<256>& base_uint<256>::operator*=(uint32_t b32);
 template base_uint<256>& base_uint<256>::operator*=(const base_uint<256>& b);
 template base_uint<256>& base_uint<256>::operator/=(const base_uint<256>& b);
+template base_uint<256>& base_uint<256>::DivideBy(uint32_t b32);
 template int base_uint<256>::CompareTo(const base_uint<256>&) const;
 template bool base_uint<256>::EqualTo(uint64_t) const;
 template double base_uint<256>::getdouble() const;
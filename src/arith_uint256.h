@@ -170,6 +170,13 @@ public:
     base_uint& operator*=(const base_uint& b);
     base_uint& operator/=(const base_uint& b);
 
+    /**
+     * Divide by a 32-bit unsigned integer. Gives exactly the same result as dividing by
+     * the widened value with operator/=, but does a single pass of word-wise long division
+     * instead of the bit-by-bit shift and subtract loop.
+     */
+    base_uint& DivideBy(uint32_t b32);
+
     base_uint& operator++()
     {
         // prefix operator
@@ -5,12 +5,19 @@
 #include "bench.h"
 #include "random.h"
 #include "bls/bls_worker.h"
+#include "clientversion.h"
+#include "streams.h"
 #include "utiltime.h"
 
 #include <iostream>
 
 CBLSWorker blsWorker;
 
+void InitBLSTests()
+{
+    blsWorker.Start();
+}
+
 void CleanupBLSTests()
 {
     blsWorker.Stop();
@@ -296,7 +303,9 @@ static void BLSVerify_Batched(benchmark::State& state)
     }
 }
 
-static void BLSVerify_BatchedParallel(benchmark::State& state)
+// Measures verification throughput of the shared verification queue of CBLSWorker for different batch sizes. Each
+// iteration consumes the result of one verification, so the result is the time per verified signature
+static void BLSVerify_BatchedParallel(size_t batchSize, benchmark::State& state)
 {
     BLSPublicKeyVector pubKeys;
     BLSSecretKeyVector secKeys;
@@ -312,6 +321,8 @@ static void BLSVerify_BatchedParallel(benchmark::State& state)
         return cancel;
     };
 
+    blsWorker.SetSigVerifyBatchSize(batchSize);
+
     // Benchmark.
     size_t i = 0;
     while (state.KeepRunning()) {
@@ -343,9 +354,93 @@ static void BLSVerify_BatchedParallel(benchmark::State& state)
     }
 }
 
+static void BLSVerify_BatchedParallel1(benchmark::State& state)
+{
+    BLSVerify_BatchedParallel(1, state);
+}
+
+static void BLSVerify_BatchedParallel8(benchmark::State& state)
+{
+    BLSVerify_BatchedParallel(8, state);
+}
+
+static void BLSVerify_BatchedParallel64(benchmark::State& state)
+{
+    BLSVerify_BatchedParallel(64, state);
+}
+
+static void BLSVerify_BatchedParallel512(benchmark::State& state)
+{
+    BLSVerify_BatchedParallel(512, state);
+}
+
+// Deserializes the operator keys of a list of 1000 MNs, as done when the MN lists are loaded from evodb
+template<typename PubKey>
+static void BLSPubKeyDeserialize(benchmark::State& state)
+{
+    CDataStream ds(SER_DISK, CLIENT_VERSION);
+    for (size_t i = 0; i < 1000; i++) {
+        CBLSSecretKey secKey;
+        secKey.MakeNewKey();
+        ds << secKey.GetPublicKey();
+    }
+
+    std::vector<PubKey> pubKeys(1000);
+    while (state.KeepRunning()) {
+        CDataStream ds2(ds);
+        for (auto& pubKey : pubKeys) {
+            ds2 >> pubKey;
+        }
+    }
+}
+
+static void BLSPubKeyDeserialize_Normal(benchmark::State& state)
+{
+    BLSPubKeyDeserialize<CBLSPublicKey>(state);
+}
+
+static void BLSPubKeyDeserialize_Lazy(benchmark::State& state)
+{
+    BLSPubKeyDeserialize<CBLSLazyPublicKey>(state);
+}
+
+// Deserializes 1000 sig shares, which are mostly only relayed or dropped as duplicates
+template<typename Sig>
+static void BLSSigDeserialize(benchmark::State& state)
+{
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    CBLSSecretKey secKey;
+    secKey.MakeNewKey();
+    for (size_t i = 0; i < 1000; i++) {
+        ds << secKey.Sign(GetRandHash());
+    }
+
+    std::vector<Sig> sigs(1000);
+    while (state.KeepRunning()) {
+        CDataStream ds2(ds);
+        for (auto& sig : sigs) {
+            ds2 >> sig;
+        }
+    }
+}
+
+static void BLSSigDeserialize_Normal(benchmark::State& state)
+{
+    BLSSigDeserialize<CBLSSignature>(state);
+}
+
+static void BLSSigDeserialize_Lazy(benchmark::State& state)
+{
+    BLSSigDeserialize<CBLSLazySignature>(state);
+}
+
 BENCHMARK(BLSPubKeyAggregate_Normal)
 BENCHMARK(BLSSecKeyAggregate_Normal)
 BENCHMARK(BLSSign_Normal)
+BENCHMARK(BLSPubKeyDeserialize_Normal)
+BENCHMARK(BLSPubKeyDeserialize_Lazy)
+BENCHMARK(BLSSigDeserialize_Normal)
+BENCHMARK(BLSSigDeserialize_Lazy)
 BENCHMARK(BLSVerify_Normal)
 BENCHMARK(BLSVerify_LargeBlock1000)
 BENCHMARK(BLSVerify_LargeBlockSelfAggregated1000)
@@ -354,4 +449,7 @@ BENCHMARK(BLSVerify_LargeAggregatedBlock1000)
 BENCHMARK(BLSVerify_LargeAggregatedBlock10000)
 BENCHMARK(BLSVerify_LargeAggregatedBlock1000PreVerified)
 BENCHMARK(BLSVerify_Batched)
-BENCHMARK(BLSVerify_BatchedParallel)
+BENCHMARK(BLSVerify_BatchedParallel1)
+BENCHMARK(BLSVerify_BatchedParallel8)
+BENCHMARK(BLSVerify_BatchedParallel64)
+BENCHMARK(BLSVerify_BatchedParallel512)
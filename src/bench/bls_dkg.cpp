@@ -111,28 +111,21 @@ struct DKG
     }
 };
 
-std::shared_ptr<DKG> dkg10;
-std::shared_ptr<DKG> dkg100;
-std::shared_ptr<DKG> dkg400;
+std::map<int, std::shared_ptr<DKG>> dkgs;
 
-void InitIfNeeded()
+// Generating contributions is expensive for large quorums, so only create the ones which are actually benchmarked
+std::shared_ptr<DKG> GetDKG(int quorumSize)
 {
-    if (dkg10 == nullptr) {
-        dkg10 = std::make_shared<DKG>(10);
-    }
-    if (dkg100 == nullptr) {
-        dkg100 = std::make_shared<DKG>(100);
-    }
-    if (dkg400 == nullptr) {
-        dkg400 = std::make_shared<DKG>(400);
+    auto& dkg = dkgs[quorumSize];
+    if (dkg == nullptr) {
+        dkg = std::make_shared<DKG>(quorumSize);
     }
+    return dkg;
 }
 
 void CleanupBLSDkgTests()
 {
-    dkg10.reset();
-    dkg100.reset();
-    dkg400.reset();
+    dkgs.clear();
 }
 
 
@@ -140,8 +133,7 @@ void CleanupBLSDkgTests()
 #define BENCH_BuildQuorumVerificationVectors(name, quorumSize, parallel) \
     static void BLSDKG_BuildQuorumVerificationVectors_##name##_##quorumSize(benchmark::State& state) \
     { \
-        InitIfNeeded(); \
-        dkg##quorumSize->Bench_BuildQuorumVerificationVectors(state, parallel); \
+        GetDKG(quorumSize)->Bench_BuildQuorumVerificationVectors(state, parallel); \
     } \
     BENCHMARK(BLSDKG_BuildQuorumVerificationVectors_##name##_##quorumSize)
 
@@ -149,8 +141,10 @@ BENCH_BuildQuorumVerificationVectors(simple, 10, false)
 BENCH_BuildQuorumVerificationVectors(simple, 100, false)
 BENCH_BuildQuorumVerificationVectors(simple, 400, false)
 BENCH_BuildQuorumVerificationVectors(parallel, 10, true)
+BENCH_BuildQuorumVerificationVectors(parallel, 50, true)
 BENCH_BuildQuorumVerificationVectors(parallel, 100, true)
 BENCH_BuildQuorumVerificationVectors(parallel, 400, true)
+BENCH_BuildQuorumVerificationVectors(parallel, 1000, true)
 
 ///////////////////////////////
 
@@ -159,8 +153,7 @@ BENCH_BuildQuorumVerificationVectors(parallel, 400, true)
 #define BENCH_VerifyContributionShares(name, quorumSize, invalidCount, parallel, aggregated) \
     static void BLSDKG_VerifyContributionShares_##name##_##quorumSize(benchmark::State& state) \
     { \
-        InitIfNeeded(); \
-        dkg##quorumSize->Bench_VerifyContributionShares(state, invalidCount, parallel, aggregated); \
+        GetDKG(quorumSize)->Bench_VerifyContributionShares(state, invalidCount, parallel, aggregated); \
     } \
     BENCHMARK(BLSDKG_VerifyContributionShares_##name##_##quorumSize)
 
@@ -177,5 +170,7 @@ BENCH_VerifyContributionShares(parallel, 100, 5, true, false)
 BENCH_VerifyContributionShares(parallel, 400, 5, true, false)
 
 BENCH_VerifyContributionShares(parallel_aggregated, 10, 5, true, true)
+BENCH_VerifyContributionShares(parallel_aggregated, 50, 5, true, true)
 BENCH_VerifyContributionShares(parallel_aggregated, 100, 5, true, true)
 BENCH_VerifyContributionShares(parallel_aggregated, 400, 5, true, true)
+BENCH_VerifyContributionShares(parallel_aggregated, 1000, 5, true, true)
@@ -4,7 +4,9 @@
 
 #include "bench.h"
 #include "coins.h"
+#include "crypto/common.h"
 #include "policy/policy.h"
+#include "random.h"
 #include "wallet/crypter.h"
 
 #include <vector>
@@ -84,4 +86,49 @@ static void CCoinsCaching(benchmark::State& state)
     }
 }
 
+static uint256 RandomHash(FastRandomContext& rnd)
+{
+    uint256 hash;
+    for (int i = 0; i < 8; i++) {
+        WriteLE32(hash.begin() + i * 4, rnd.rand32());
+    }
+    return hash;
+}
+
+// Typical life of a per-block cache on top of the tip cache: fetch coins from the parent, spend some of them, add new
+// ones and flush everything back into the parent
+static void CCoinsCachingFetchFlush(benchmark::State& state)
+{
+    const int COINS_COUNT = 100000;
+    const int COINS_PER_BLOCK = 2000;
+
+    FastRandomContext rnd(true);
+    CCoinsView coinsDummy;
+    CCoinsViewCache base(&coinsDummy);
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < COINS_COUNT; i++) {
+        Coin coin;
+        coin.out.nValue = COIN;
+        coin.out.scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, (unsigned char)i) << OP_EQUALVERIFY << OP_CHECKSIG;
+        coin.nHeight = 1;
+        outpoints.emplace_back(RandomHash(rnd), 0);
+        base.AddCoin(outpoints.back(), std::move(coin), false);
+    }
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&base);
+        for (int i = 0; i < COINS_PER_BLOCK; i++) {
+            size_t idx = rnd.rand32(outpoints.size());
+            Coin coin;
+            bool fSpent = cache.SpendCoin(outpoints[idx], &coin);
+            assert(fSpent);
+            // replace the spent coin with a new one, so that the number of coins stays the same
+            outpoints[idx] = COutPoint(RandomHash(rnd), 0);
+            cache.AddCoin(outpoints[idx], std::move(coin), false);
+        }
+        cache.Flush();
+    }
+}
+
 BENCHMARK(CCoinsCaching);
+BENCHMARK(CCoinsCachingFetchFlush);
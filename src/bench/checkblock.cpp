@@ -6,6 +6,7 @@
 
 #include "chainparams.h"
 #include "validation.h"
+#include "hash.h"
 #include "streams.h"
 #include "consensus/validation.h"
 
@@ -50,5 +51,38 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+static void BlockHeaderHashTest(benchmark::State& state)
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    CBlockHeader header = block.GetBlockHeader();
+
+    while (state.KeepRunning()) {
+        header.GetHash();
+    }
+}
+
+static void BlockHeaderHashStreamTest(benchmark::State& state)
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    CBlockHeader header = block.GetBlockHeader();
+
+    while (state.KeepRunning()) {
+        // what GetHash() did before the header was written to a stack buffer
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << header;
+        HashX11(ss.begin(), ss.end());
+    }
+}
+
 BENCHMARK(DeserializeBlockTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(BlockHeaderHashTest);
+BENCHMARK(BlockHeaderHashStreamTest);
@@ -0,0 +1,117 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "coins.h"
+#include "consensus/consensus.h"
+#include "consensus/validation.h"
+#include "random.h"
+#include "validation.h"
+
+// Replays a synthetic chain against a coins cache with a fixed memory budget, the way IBD does it: every block is
+// connected to a temporary view on top of the tip cache (spending existing coins and creating new ones, as in
+// ConnectBlock), and the tip cache is flushed to its base whenever it exceeds the budget (as in FlushStateToDisk).
+static const int REPLAY_INITIAL_COINBASES = 100;
+static const int REPLAY_COINBASE_OUTPUTS = 1000;
+static const int REPLAY_BLOCKS = 200;
+static const int REPLAY_TXS_PER_BLOCK = 250;
+static const size_t REPLAY_CACHE_BUDGET = 8 << 20;
+
+static CScript RandomP2PKHScript(FastRandomContext& rnd)
+{
+    std::vector<unsigned char> hash(20);
+    for (auto& b : hash) {
+        b = (unsigned char)rnd.rand32();
+    }
+    return CScript() << OP_DUP << OP_HASH160 << hash << OP_EQUALVERIFY << OP_CHECKSIG;
+}
+
+static void BuildReplayChain(std::vector<std::vector<CTransactionRef> >& blocks)
+{
+    FastRandomContext rnd(true);
+    std::vector<std::pair<COutPoint, CAmount> > utxos;
+
+    // Mature coinbases at height 0 provide the initial UTXO set
+    blocks.emplace_back();
+    for (int i = 0; i < REPLAY_INITIAL_COINBASES; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << i << OP_0;
+        tx.vout.resize(REPLAY_COINBASE_OUTPUTS);
+        for (auto& out : tx.vout) {
+            out.nValue = COIN;
+            out.scriptPubKey = RandomP2PKHScript(rnd);
+        }
+        CTransactionRef txRef = MakeTransactionRef(tx);
+        for (uint32_t n = 0; n < txRef->vout.size(); n++) {
+            utxos.emplace_back(COutPoint(txRef->GetHash(), n), COIN);
+        }
+        blocks.back().emplace_back(txRef);
+    }
+
+    // Every following transaction spends two random coins and creates two new ones
+    for (int h = 1; h <= REPLAY_BLOCKS; h++) {
+        blocks.emplace_back();
+        for (int i = 0; i < REPLAY_TXS_PER_BLOCK; i++) {
+            CMutableTransaction tx;
+            CAmount nValueIn = 0;
+            tx.vin.resize(2);
+            for (auto& in : tx.vin) {
+                size_t idx = rnd.rand32(utxos.size());
+                in.prevout = utxos[idx].first;
+                nValueIn += utxos[idx].second;
+                utxos[idx] = utxos.back();
+                utxos.pop_back();
+            }
+            tx.vout.resize(2);
+            tx.vout[0].nValue = nValueIn / 2;
+            tx.vout[1].nValue = nValueIn - nValueIn / 2;
+            for (auto& out : tx.vout) {
+                out.scriptPubKey = RandomP2PKHScript(rnd);
+            }
+            CTransactionRef txRef = MakeTransactionRef(tx);
+            for (uint32_t n = 0; n < txRef->vout.size(); n++) {
+                utxos.emplace_back(COutPoint(txRef->GetHash(), n), txRef->vout[n].nValue);
+            }
+            blocks.back().emplace_back(txRef);
+        }
+    }
+}
+
+static void CoinsReplay(benchmark::State& state)
+{
+    std::vector<std::vector<CTransactionRef> > blocks;
+    BuildReplayChain(blocks);
+
+    while (state.KeepRunning()) {
+        CCoinsView viewDummy;
+        CCoinsViewCache base(&viewDummy);
+        CCoinsViewCache tip(&base);
+        tip.SetMaxTableSize(REPLAY_CACHE_BUDGET / 10 * 9);
+
+        for (size_t h = 0; h < blocks.size(); h++) {
+            int nHeight = h == 0 ? 0 : (int)h + COINBASE_MATURITY;
+            {
+                // ConnectBlock
+                CCoinsViewCache view(&tip);
+                for (const auto& tx : blocks[h]) {
+                    if (!tx->IsCoinBase()) {
+                        CValidationState validationState;
+                        bool fValid = Consensus::CheckTxInputs(*tx, validationState, view, nHeight);
+                        assert(fValid);
+                    }
+                    UpdateCoins(*tx, view, nHeight);
+                }
+                bool fFlushed = view.Flush();
+                assert(fFlushed);
+            }
+
+            if (tip.DynamicMemoryUsage() > REPLAY_CACHE_BUDGET) {
+                tip.Flush();
+            }
+        }
+    }
+}
+
+BENCHMARK(CoinsReplay);
@@ -186,6 +186,15 @@ static void HASH_X11_2048b_single(benchmark::State& state)
         hash = HashX11(in.begin(), in.end());
 }
 
+static void HASH_X11_0080b_batch(benchmark::State& state)
+{
+    // a full headers message worth of 80 byte inputs
+    std::vector<uint256> hashes(2000);
+    std::vector<uint8_t> in(80 * hashes.size(), 0);
+    while (state.KeepRunning())
+        HashX11Batch(in.data(), 80, hashes.size(), hashes.data());
+}
+
 BENCHMARK(HASH_RIPEMD160);
 BENCHMARK(HASH_SHA1);
 BENCHMARK(HASH_SHA256);
@@ -209,3 +218,4 @@ BENCHMARK(HASH_X11_0128b_single);
 BENCHMARK(HASH_X11_0512b_single);
 BENCHMARK(HASH_X11_1024b_single);
 BENCHMARK(HASH_X11_2048b_single);
+BENCHMARK(HASH_X11_0080b_batch);
@@ -0,0 +1,72 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "random.h"
+#include "txdb.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <boost/filesystem.hpp>
+
+// Looks up the full histories of addresses with many entries, the way getaddressdeltas and getaddresstxids do it. The
+// index is kept on disk with a cache much smaller than the index, once with the tuning of the index database and once
+// with the settings which are used for the block database.
+static const int LOOKUP_ADDRESSES = 200;
+static const int LOOKUP_HISTORY_SIZE = 2000;
+static const size_t LOOKUP_CACHE_SIZE = 4 << 20;
+
+static void AddressIndexLookup(benchmark::State& state, const CDBWrapperOptions& dbOptions)
+{
+    ClearDatadirCache();
+    boost::filesystem::path pathTemp = boost::filesystem::temp_directory_path() / strprintf("bench_insightindex_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000));
+    boost::filesystem::create_directories(pathTemp);
+    ForceSetArg("-datadir", pathTemp.string());
+
+    std::vector<uint160> addresses;
+    {
+        FastRandomContext rnd(true);
+        CInsightIndexDB db(LOOKUP_CACHE_SIZE, false, true, dbOptions);
+        for (int i = 0; i < LOOKUP_ADDRESSES; i++) {
+            std::vector<unsigned char> hashBytes(20);
+            for (auto& b : hashBytes) {
+                b = (unsigned char)rnd.rand32();
+            }
+            addresses.emplace_back(hashBytes);
+            std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+            for (int j = 0; j < LOOKUP_HISTORY_SIZE; j++) {
+                history.emplace_back(CAddressIndexKey(1, addresses.back(), j + 1, rnd.rand32() % 100, GetRandHash(), rnd.rand32() % 4, j % 2), (CAmount)rnd.rand32());
+            }
+            bool fWritten = db.WriteAddressIndex(history);
+            assert(fWritten);
+        }
+        // Lookups should hit the table files, not the memtable
+        db.CompactRange('a', 'b');
+    }
+
+    {
+        CInsightIndexDB db(LOOKUP_CACHE_SIZE, false, false, dbOptions);
+        FastRandomContext rnd(true);
+        while (state.KeepRunning()) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+            bool fRead = db.ReadAddressIndex(addresses[rnd.rand32(addresses.size())], 1, history);
+            assert(fRead && history.size() == LOOKUP_HISTORY_SIZE);
+        }
+    }
+
+    boost::filesystem::remove_all(pathTemp);
+}
+
+static void AddressIndexLookupIndexDB(benchmark::State& state)
+{
+    AddressIndexLookup(state, CInsightIndexDB::DefaultOptions());
+}
+
+static void AddressIndexLookupBlockDBOptions(benchmark::State& state)
+{
+    AddressIndexLookup(state, CDBWrapperOptions());
+}
+
+BENCHMARK(AddressIndexLookupIndexDB);
+BENCHMARK(AddressIndexLookupBlockDBOptions);
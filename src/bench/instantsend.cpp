@@ -0,0 +1,60 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "dbwrapper.h"
+#include "random.h"
+
+#include "llmq/quorums_instantsend.h"
+
+// One iteration writes the islocks of one minute at a rate of 10k islocks per minute. Every second islock spends from
+// the TX of the previous one, so that chained islocks are part of the load.
+static const size_t ISLOCKS_PER_MINUTE = 10000;
+// islocks which arrive between two runs of the InstantSend worker thread
+static const size_t ISLOCKS_PER_BATCH = 100;
+
+static std::vector<std::pair<uint256, llmq::CInstantSendLockPtr>> BuildInstantSendLocks()
+{
+    std::vector<std::pair<uint256, llmq::CInstantSendLockPtr>> ret;
+    ret.reserve(ISLOCKS_PER_MINUTE);
+    for (size_t i = 0; i < ISLOCKS_PER_MINUTE; i++) {
+        auto islock = std::make_shared<llmq::CInstantSendLock>();
+        islock->txid = GetRandHash();
+        if (i % 2 == 1) {
+            islock->inputs.emplace_back(ret.back().second->txid, 0);
+        }
+        islock->inputs.emplace_back(GetRandHash(), 0);
+        islock->inputs.emplace_back(GetRandHash(), 1);
+        ret.emplace_back(::SerializeHash(*islock), islock);
+    }
+    return ret;
+}
+
+static void InstantSendLocks_Write(benchmark::State& state)
+{
+    auto islocks = BuildInstantSendLocks();
+    while (state.KeepRunning()) {
+        CDBWrapper llmqDb("", 1 << 20, true);
+        llmq::CInstantSendDb db(llmqDb);
+        for (auto& p : islocks) {
+            db.WriteNewInstantSendLock(p.first, *p.second);
+        }
+    }
+}
+
+static void InstantSendLocks_WriteBatched(benchmark::State& state)
+{
+    auto islocks = BuildInstantSendLocks();
+    while (state.KeepRunning()) {
+        CDBWrapper llmqDb("", 1 << 20, true);
+        llmq::CInstantSendDb db(llmqDb);
+        for (size_t i = 0; i < islocks.size(); i += ISLOCKS_PER_BATCH) {
+            std::vector<std::pair<uint256, llmq::CInstantSendLockPtr>> batch(islocks.begin() + i, islocks.begin() + std::min(i + ISLOCKS_PER_BATCH, islocks.size()));
+            db.WriteNewInstantSendLocks(batch, {});
+        }
+    }
+}
+
+BENCHMARK(InstantSendLocks_Write);
+BENCHMARK(InstantSendLocks_WriteBatched);
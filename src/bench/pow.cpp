@@ -0,0 +1,64 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "pow.h"
+#include "random.h"
+
+static const int DGW_CHAIN_LENGTH = 2000;
+
+static void BuildDGWChain(std::vector<uint256>& hashes, std::vector<CBlockIndex>& blocks, bool fWithHashes)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    FastRandomContext rnd(true);
+    hashes.resize(DGW_CHAIN_LENGTH);
+    blocks.resize(DGW_CHAIN_LENGTH);
+    for (int i = 0; i < DGW_CHAIN_LENGTH; i++) {
+        hashes[i] = GetRandHash();
+        CBlockIndex& block = blocks[i];
+        block.phashBlock = fWithHashes ? &hashes[i] : NULL;
+        block.pprev = i ? &blocks[i - 1] : NULL;
+        block.nHeight = 100000 + i;
+        block.nTime = 1500000000 + i * params.nPowTargetSpacing + (int)(rnd.rand32() % 600) - 300;
+        block.nBits = 0x1b1418d4;
+    }
+}
+
+// Simulates receiving a headers message: every header is checked against the target of its parent,
+// plus a few competing/re-checked headers on the same parent
+static void GetNextWorkRequiredHeaders(benchmark::State& state, bool fWithHashes)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = Params().GetConsensus();
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+    BuildDGWChain(hashes, blocks, fWithHashes);
+
+    int i = 30;
+    while (state.KeepRunning()) {
+        CBlockHeader header = blocks[i].GetBlockHeader();
+        for (int j = 0; j < 4; j++) {
+            header.nTime++;
+            GetNextWorkRequired(&blocks[i - 1], &header, params);
+        }
+        if (++i == DGW_CHAIN_LENGTH) {
+            i = 30;
+        }
+    }
+}
+
+static void DGW_Headers_Uncached(benchmark::State& state)
+{
+    GetNextWorkRequiredHeaders(state, false);
+}
+
+static void DGW_Headers_Cached(benchmark::State& state)
+{
+    GetNextWorkRequiredHeaders(state, true);
+}
+
+BENCHMARK(DGW_Headers_Uncached);
+BENCHMARK(DGW_Headers_Cached);
@@ -0,0 +1,49 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "evo/deterministicmns.h"
+#include "random.h"
+
+static CDeterministicMNList BuildMNList(size_t count)
+{
+    CDeterministicMNList mnList(uint256(), 1);
+    for (size_t i = 0; i < count; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>();
+        dmn->proTxHash = GetRandHash();
+        dmn->collateralOutpoint = COutPoint(GetRandHash(), 0);
+        dmn->nOperatorReward = 0;
+
+        CDeterministicMNState state;
+        state.keyIDOwner.SetHex(strprintf("%040x", i + 1));
+        state.UpdateConfirmedHash(dmn->proTxHash, GetRandHash());
+        dmn->pdmnState = std::make_shared<CDeterministicMNState>(state);
+        mnList.AddMN(dmn);
+    }
+    return mnList;
+}
+
+static void CalculateQuorum(benchmark::State& state, size_t mnCount)
+{
+    auto mnList = BuildMNList(mnCount);
+    uint256 modifier;
+    while (state.KeepRunning()) {
+        // each iteration is a cache miss in GetAllQuorumMembers
+        modifier = GetRandHash();
+        mnList.CalculateQuorum(400, modifier);
+    }
+}
+
+static void Quorum_Calculate_5000(benchmark::State& state)
+{
+    CalculateQuorum(state, 5000);
+}
+
+static void Quorum_Calculate_20000(benchmark::State& state)
+{
+    CalculateQuorum(state, 20000);
+}
+
+BENCHMARK(Quorum_Calculate_5000);
+BENCHMARK(Quorum_Calculate_20000);
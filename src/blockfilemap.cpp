@@ -0,0 +1,181 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/cbdhealthnetwork-config.h"
+#endif
+
+#include "blockfilemap.h"
+
+#include "chain.h"
+#include "crypto/common.h"
+#include "protocol.h"
+#include "util.h"
+#include "validation.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+CBlockFileMapCache blockFileMaps;
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    munmap(const_cast<unsigned char*>(pbegin), nSize);
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CMappedBlockFile::Open(const boost::filesystem::path& path)
+{
+#ifndef WIN32
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file open
+    close(fd);
+    if (p == MAP_FAILED) {
+        LogPrintf("%s: Unable to map %s\n", __func__, path.string());
+        return nullptr;
+    }
+    return std::shared_ptr<const CMappedBlockFile>(new CMappedBlockFile(static_cast<const unsigned char*>(p), st.st_size));
+#else
+    return nullptr;
+#endif
+}
+
+std::vector<CBlockFileRecord> FindBlockRecords(const CMappedBlockFile& file, size_t nStart, const unsigned char* messageStart, unsigned int nMaxSize)
+{
+    const size_t nHeaderSize = CMessageHeader::MESSAGE_START_SIZE + 4;
+    std::vector<CBlockFileRecord> records;
+    size_t nPos = nStart;
+    while (nPos < file.size()) {
+        const unsigned char* p = static_cast<const unsigned char*>(memchr(file.data() + nPos, messageStart[0], file.size() - nPos));
+        if (p == nullptr) {
+            break;
+        }
+        size_t nMessageStart = p - file.data();
+        if (nHeaderSize > file.size() - nMessageStart) {
+            break;
+        }
+        nPos = nMessageStart + 1;
+        if (memcmp(p, messageStart, CMessageHeader::MESSAGE_START_SIZE)) {
+            continue;
+        }
+        unsigned int nSize = ReadLE32(p + CMessageHeader::MESSAGE_START_SIZE);
+        size_t nBlockPos = nMessageStart + nHeaderSize;
+        if (nSize < 80 || nSize > nMaxSize || nSize > file.size() - nBlockPos) {
+            continue;
+        }
+        records.push_back({nMessageStart, nBlockPos, nSize});
+        nPos = nBlockPos + nSize;
+    }
+    return records;
+}
+
+static bool ExtractRecord(const std::shared_ptr<const CMappedBlockFile>& file, unsigned int nPos, size_t nExtra, CMappedBlockRecord& record)
+{
+    if (nPos < 4 || nPos > file->size()) {
+        return false;
+    }
+    size_t nSize = ReadLE32(file->data() + nPos - 4);
+    if (nSize + nExtra > file->size() - nPos) {
+        return false;
+    }
+    record.file = file;
+    record.data = file->data() + nPos;
+    record.size = nSize + nExtra;
+    return true;
+}
+
+void CBlockFileMapCache::SetMaxFiles(size_t nMaxFilesIn)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    nMaxFiles = nMaxFilesIn;
+    if (entries.size() > nMaxFiles) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.nLastAccess > b.nLastAccess;
+        });
+        entries.resize(nMaxFiles);
+    }
+}
+
+bool CBlockFileMapCache::GetRecord(const CDiskBlockPos& pos, bool fUndo, size_t nExtra, CMappedBlockRecord& record)
+{
+    if (pos.IsNull()) {
+        return false;
+    }
+
+    std::shared_ptr<const CMappedBlockFile> file;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (nMaxFiles == 0) {
+            return false;
+        }
+        for (auto& entry : entries) {
+            if (entry.nFile == pos.nFile && entry.fUndo == fUndo) {
+                entry.nLastAccess = ++nAccessCounter;
+                file = entry.file;
+                break;
+            }
+        }
+    }
+    if (file && ExtractRecord(file, pos.nPos, nExtra, record)) {
+        return true;
+    }
+
+    // Not mapped yet, or the record was appended after the file was mapped
+    file = CMappedBlockFile::Open(GetBlockPosFilename(pos, fUndo ? "rev" : "blk"));
+    if (!file) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cs);
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return entry.nFile == pos.nFile && entry.fUndo == fUndo;
+    });
+    if (it == entries.end()) {
+        if (entries.size() >= nMaxFiles) {
+            // Mappings still in use by readers are released when they are done
+            it = std::min_element(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                return a.nLastAccess < b.nLastAccess;
+            });
+        } else {
+            it = entries.emplace(entries.end());
+        }
+    }
+    it->nFile = pos.nFile;
+    it->fUndo = fUndo;
+    it->file = file;
+    it->nLastAccess = ++nAccessCounter;
+
+    return ExtractRecord(file, pos.nPos, nExtra, record);
+}
+
+void CBlockFileMapCache::Remove(int nFile)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [nFile](const Entry& entry) {
+        return entry.nFile == nFile;
+    }), entries.end());
+}
+
+void CBlockFileMapCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    entries.clear();
+}
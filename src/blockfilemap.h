@@ -0,0 +1,111 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_BLOCKFILEMAP_H
+#define CHN_BLOCKFILEMAP_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+struct CDiskBlockPos;
+
+/** -blockfilemaps default (number of block and undo files kept memory mapped for reading, 0 = read through fread) */
+static const int DEFAULT_BLOCK_FILE_MAPS = sizeof(void*) > 4 ? 32 : 0;
+/** Maximum number of memory mapped block and undo files */
+static const int MAX_BLOCK_FILE_MAPS = 1024;
+
+/** Read-only memory mapping of a whole blk?????.dat or rev?????.dat file */
+class CMappedBlockFile
+{
+private:
+    const unsigned char* pbegin;
+    size_t nSize;
+
+    CMappedBlockFile(const unsigned char* pbeginIn, size_t nSizeIn) : pbegin(pbeginIn), nSize(nSizeIn) {}
+
+public:
+    ~CMappedBlockFile();
+    CMappedBlockFile(const CMappedBlockFile&) = delete;
+    CMappedBlockFile& operator=(const CMappedBlockFile&) = delete;
+
+    /** Maps the file as it is now. Returns nullptr if it can't be mapped (or mapping isn't supported). */
+    static std::shared_ptr<const CMappedBlockFile> Open(const boost::filesystem::path& path);
+
+    const unsigned char* data() const { return pbegin; }
+    size_t size() const { return nSize; }
+};
+
+/** A block or undo record inside a mapped file */
+struct CMappedBlockRecord
+{
+    //! Keeps the mapping alive while the record is read
+    std::shared_ptr<const CMappedBlockFile> file;
+    const unsigned char* data{nullptr};
+    size_t size{0};
+};
+
+/** A block in a blk?????.dat file, as found by FindBlockRecords() */
+struct CBlockFileRecord
+{
+    //! Position of the message start in front of the block
+    size_t nStart;
+    //! Position and size of the serialized block
+    size_t nPos;
+    unsigned int nSize;
+};
+
+/**
+ * Finds the blocks in a mapped blk?????.dat file from nStart on, the same way LoadExternalBlockFile scans a file: a
+ * block is a message start followed by a size between 80 and nMaxSize. Scanning goes on after the end of every block
+ * found, a block which turns out not to deserialize must be scanned again from one byte after its message start.
+ * Blocks which are cut off by the end of the file are skipped.
+ */
+std::vector<CBlockFileRecord> FindBlockRecords(const CMappedBlockFile& file, size_t nStart, const unsigned char* messageStart, unsigned int nMaxSize);
+
+/**
+ * Keeps the most recently read block and undo files memory mapped, so that reading blocks (for peers, REST, rescans
+ * and reorgs) costs page cache hits instead of opening the file and copying it through stdio buffers.
+ *
+ * Files are appended to while they are mapped. A mapping only covers the file as it was when it was mapped, so a
+ * record beyond its end causes the file to be mapped again. Pruned files must be removed with Remove().
+ */
+class CBlockFileMapCache
+{
+private:
+    struct Entry
+    {
+        int nFile;
+        bool fUndo;
+        std::shared_ptr<const CMappedBlockFile> file;
+        uint64_t nLastAccess;
+    };
+
+    std::mutex cs;
+    std::vector<Entry> entries;
+    size_t nMaxFiles{0};
+    uint64_t nAccessCounter{0};
+
+public:
+    /** Sets how many files are kept mapped. 0 disables the cache, GetRecord() then always fails. */
+    void SetMaxFiles(size_t nMaxFilesIn);
+
+    /**
+     * Looks up the record that starts at pos. The 4 bytes before pos hold the length of the record, as written by
+     * WriteBlockToDisk and WriteUndoToDisk. nExtra bytes after the record (e.g. a checksum) are included in it.
+     * Returns false if the record can't be found in a mapping, callers fall back to reading the file then.
+     */
+    bool GetRecord(const CDiskBlockPos& pos, bool fUndo, size_t nExtra, CMappedBlockRecord& record);
+
+    /** Forgets the mappings of a block file and its undo file */
+    void Remove(int nFile);
+    void Clear();
+};
+
+extern CBlockFileMapCache blockFileMaps;
+
+#endif // CHN_BLOCKFILEMAP_H
@@ -423,6 +423,118 @@ bool CBLSSignature::Recover(const std::vector<CBLSSignature>& sigs, const std::v
     return true;
 }
 
+bool CBLSSignature::Recover(const std::vector<CBLSSignature>& sigs, const CBLSLagrangeCoefficients& coefficients)
+{
+    fValid = false;
+    UpdateHash();
+
+    if (sigs.empty() || sigs.size() != coefficients.size()) {
+        return false;
+    }
+
+    std::vector<bls::InsecureSignature> v;
+    v.reserve(sigs.size());
+
+    bn_t c;
+    bn_null(c);
+    try {
+        bn_new(c);
+        for (size_t i = 0; i < sigs.size(); i++) {
+            if (!sigs[i].IsValid()) {
+                bn_free(c);
+                return false;
+            }
+            bn_read_bin(c, coefficients.coefficients[i].data(), BLS_CURVE_SECKEY_SIZE);
+            v.emplace_back(sigs[i].impl.Exp(c));
+        }
+        impl = bls::InsecureSignature::Aggregate(v);
+    } catch (...) {
+        bn_free(c);
+        return false;
+    }
+    bn_free(c);
+
+    fValid = true;
+    UpdateHash();
+    return true;
+}
+
+bool CBLSLagrangeCoefficients::Init(const std::vector<CBLSId>& ids)
+{
+    coefficients.clear();
+
+    if (ids.empty()) {
+        return false;
+    }
+    for (auto& id : ids) {
+        if (!id.IsValid()) {
+            return false;
+        }
+    }
+
+    // The coefficient of id i is the product of x_j / (x_j - x_i) over all other ids j. The ids are read the same way
+    // as bls::BLS::RecoverSig reads them, so that both ways of recovering result in the same signature
+    std::vector<std::array<uint8_t, BLS_CURVE_SECKEY_SIZE>> result(ids.size());
+    bool ok = true;
+
+    bn_t order, exp, xi, xj, num, den, tmp;
+    bn_null(order); bn_null(exp); bn_null(xi); bn_null(xj); bn_null(num); bn_null(den); bn_null(tmp);
+    try {
+        bn_new(order); bn_new(exp); bn_new(xi); bn_new(xj); bn_new(num); bn_new(den); bn_new(tmp);
+
+        g1_get_ord(order);
+        // the group order is prime, so x^(order-2) is the inverse of x
+        bn_sub_dig(exp, order, 2);
+
+        for (size_t i = 0; i < ids.size() && ok; i++) {
+            bn_read_bin(xi, ids[i].impl.begin(), BLS_CURVE_ID_SIZE);
+            bn_mod(xi, xi, order);
+            bn_set_dig(num, 1);
+            bn_set_dig(den, 1);
+
+            for (size_t j = 0; j < ids.size(); j++) {
+                if (j == i) {
+                    continue;
+                }
+                bn_read_bin(xj, ids[j].impl.begin(), BLS_CURVE_ID_SIZE);
+                bn_mod(xj, xj, order);
+
+                bn_mul(num, num, xj);
+                bn_mod(num, num, order);
+
+                // x_j - x_i, kept positive
+                bn_add(tmp, xj, order);
+                bn_sub(tmp, tmp, xi);
+                bn_mod(tmp, tmp, order);
+                if (bn_is_zero(tmp)) {
+                    // duplicate id
+                    ok = false;
+                    break;
+                }
+                bn_mul(den, den, tmp);
+                bn_mod(den, den, order);
+            }
+            if (!ok) {
+                break;
+            }
+
+            bn_mxp(den, den, exp, order);
+            bn_mul(num, num, den);
+            bn_mod(num, num, order);
+            bn_write_bin(result[i].data(), BLS_CURVE_SECKEY_SIZE, num);
+        }
+    } catch (...) {
+        ok = false;
+    }
+    bn_free(order); bn_free(exp); bn_free(xi); bn_free(xj); bn_free(num); bn_free(den); bn_free(tmp);
+
+    if (!ok) {
+        return false;
+    }
+    coefficients = std::move(result);
+    return true;
+}
+
 #ifndef BUILD_BITCOIN_INTERNAL
 
 static std::once_flag init_flag;
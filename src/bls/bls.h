@@ -18,6 +18,7 @@
 #undef DOUBLE
 
 #include <array>
+#include <memory>
 #include <mutex>
 #include <unistd.h>
 
@@ -36,6 +37,7 @@ class CBLSWrapper
     friend class CBLSSecretKey;
     friend class CBLSPublicKey;
     friend class CBLSSignature;
+    friend class CBLSLagrangeCoefficients;
 
 protected:
     ImplType impl;
@@ -283,6 +285,25 @@ protected:
     bool InternalGetBuf(void* buf) const;
 };
 
+/**
+ * The Lagrange coefficients at zero for a set of ids. A threshold signature is the sum of the signature shares of these
+ * ids, each multiplied with its coefficient. The coefficients only depend on the ids, so they can be computed once and
+ * then be reused for all signatures which are recovered from the shares of the same signers.
+ */
+class CBLSLagrangeCoefficients
+{
+    friend class CBLSSignature;
+
+private:
+    // big-endian scalars modulo the group order, in the order of the ids passed to Init()
+    std::vector<std::array<uint8_t, BLS_CURVE_SECKEY_SIZE>> coefficients;
+
+public:
+    bool Init(const std::vector<CBLSId>& ids);
+
+    size_t size() const { return coefficients.size(); }
+};
+
 class CBLSSignature : public CBLSWrapper<bls::InsecureSignature, BLS_CURVE_SIG_SIZE, CBLSSignature>
 {
     friend class CBLSSecretKey;
@@ -308,6 +329,8 @@ public:
     bool VerifySecureAggregated(const std::vector<CBLSPublicKey>& pks, const uint256& hash) const;
 
     bool Recover(const std::vector<CBLSSignature>& sigs, const std::vector<CBLSId>& ids);
+    // sigs must be in the order of the ids the coefficients were initialized with
+    bool Recover(const std::vector<CBLSSignature>& sigs, const CBLSLagrangeCoefficients& coefficients);
 
 protected:
     bool InternalSetBuf(const void* buf);
@@ -315,6 +338,8 @@ protected:
 };
 
 #ifndef BUILD_BITCOIN_INTERNAL
+// Keeps the serialized form of a BLS object and only decompresses it into the (much larger) curve point on the first
+// call to Get(). Comparing, hashing and re-serializing work on the serialized form and never decompress.
 template<typename BLSObject>
 class CBLSLazyWrapper
 {
@@ -324,8 +349,8 @@ private:
     mutable char buf[BLSObject::SerSize];
     mutable bool bufValid{false};
 
-    mutable BLSObject obj;
-    mutable bool objInitialized{false};
+    // only allocated when needed
+    mutable std::unique_ptr<BLSObject> obj;
 
     mutable uint256 hash;
 
@@ -344,6 +369,9 @@ public:
 
     CBLSLazyWrapper& operator=(const CBLSLazyWrapper& r)
     {
+        if (this == &r) {
+            return *this;
+        }
         std::unique_lock<std::mutex> l(r.mutex);
         bufValid = r.bufValid;
         if (r.bufValid) {
@@ -351,11 +379,10 @@ public:
         } else {
             memset(buf, 0, sizeof(buf));
         }
-        objInitialized = r.objInitialized;
-        if (r.objInitialized) {
-            obj = r.obj;
+        if (r.obj) {
+            obj.reset(new BLSObject(*r.obj));
         } else {
-            obj.Reset();
+            obj.reset();
         }
         hash = r.hash;
         return *this;
@@ -370,14 +397,10 @@ public:
     inline void Serialize(Stream& s) const
     {
         std::unique_lock<std::mutex> l(mutex);
-        if (!objInitialized && !bufValid) {
+        if (!obj && !bufValid) {
             throw std::ios_base::failure("obj and buf not initialized");
         }
-        if (!bufValid) {
-            obj.GetBuf(buf, sizeof(buf));
-            bufValid = true;
-            hash = uint256();
-        }
+        UpdateBuf();
         s.write(buf, sizeof(buf));
     }
 
@@ -387,7 +410,7 @@ public:
         std::unique_lock<std::mutex> l(mutex);
         s.read(buf, sizeof(buf));
         bufValid = true;
-        objInitialized = false;
+        obj.reset();
         hash = uint256();
     }
 
@@ -395,39 +418,43 @@ public:
     {
         std::unique_lock<std::mutex> l(mutex);
         bufValid = false;
-        objInitialized = true;
-        obj = _obj;
+        obj.reset(new BLSObject(_obj));
         hash = uint256();
     }
     const BLSObject& Get() const
     {
         std::unique_lock<std::mutex> l(mutex);
         static BLSObject invalidObj;
-        if (!bufValid && !objInitialized) {
+        if (!bufValid && !obj) {
             return invalidObj;
         }
-        if (!objInitialized) {
-            obj.SetBuf(buf, sizeof(buf));
-            if (!obj.CheckMalleable(buf, sizeof(buf))) {
+        if (!obj) {
+            obj.reset(new BLSObject());
+            obj->SetBuf(buf, sizeof(buf));
+            if (!obj->CheckMalleable(buf, sizeof(buf))) {
                 bufValid = false;
-                objInitialized = false;
-                obj = invalidObj;
-            } else {
-                objInitialized = true;
+                obj.reset();
+                return invalidObj;
             }
         }
-        return obj;
+        return *obj;
     }
 
     bool operator==(const CBLSLazyWrapper& r) const
     {
-        if (bufValid && r.bufValid) {
-            return memcmp(buf, r.buf, sizeof(buf)) == 0;
+        if (this == &r) {
+            return true;
         }
-        if (objInitialized && r.objInitialized) {
-            return obj == r.obj;
+        std::unique_lock<std::mutex> l(mutex, std::defer_lock);
+        std::unique_lock<std::mutex> l2(r.mutex, std::defer_lock);
+        std::lock(l, l2);
+        if (obj && r.obj) {
+            return *obj == *r.obj;
         }
-        return Get() == r.Get();
+        // compressing an already decompressed object is cheap, decompressing is not
+        UpdateBuf();
+        r.UpdateBuf();
+        return memcmp(buf, r.buf, sizeof(buf)) == 0;
     }
 
     bool operator!=(const CBLSLazyWrapper& r) const
@@ -438,17 +465,33 @@ public:
     uint256 GetHash() const
     {
         std::unique_lock<std::mutex> l(mutex);
-        if (!bufValid) {
-            obj.GetBuf(buf, sizeof(buf));
-            bufValid = true;
-            hash = uint256();
-        }
+        UpdateBuf();
         if (hash.IsNull()) {
             UpdateHash();
         }
         return hash;
     }
+
+    std::string ToString() const
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        UpdateBuf();
+        return HexStr(buf, buf + sizeof(buf));
+    }
 private:
+    void UpdateBuf() const
+    {
+        if (!bufValid) {
+            if (obj) {
+                obj->GetBuf(buf, sizeof(buf));
+            } else {
+                // Get() found a malleable buf, which results in an invalid object
+                memset(buf, 0, sizeof(buf));
+            }
+            bufValid = true;
+            hash = uint256();
+        }
+    }
     void UpdateHash() const
     {
         CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
@@ -8,6 +8,8 @@
 
 #include "util.h"
 
+#include <algorithm>
+
 template <typename T>
 bool VerifyVectorHelper(const std::vector<T>& vec, size_t start, size_t count)
 {
@@ -60,16 +62,34 @@ CBLSWorker::~CBLSWorker()
 
 void CBLSWorker::Start()
 {
-    int workerCount = std::thread::hardware_concurrency() / 2;
-    workerCount = std::max(std::min(1, workerCount), 4);
-    workerPool.resize(workerCount);
-    RenameThreadPool(workerPool, "cbdhealthnetwork-bls-worker");
+    // Use half of the CPUs of the NUMA node we're started on. DKG aggregation is memory bound and sharing work
+    // between many threads on different nodes mostly means moving BLS objects across the interconnect
+    int workerCount = std::max(CWorkStealingPool::GetNumaNodeThreadCount() / 2, 1);
+    {
+        std::unique_lock<std::mutex> l(sigVerifyMutex);
+        sigVerifyStopped = false;
+    }
+    workerPool.Start(workerCount, "cbdhealthnetwork-bls-worker");
 }
 
 void CBLSWorker::Stop()
 {
-    workerPool.clear_queue();
-    workerPool.stop(true);
+    std::vector<SigVerifyJob> jobs;
+    {
+        std::unique_lock<std::mutex> l(sigVerifyMutex);
+        sigVerifyStopped = true;
+        jobs = std::move(sigVerifyQueue);
+        sigVerifyQueue = std::vector<SigVerifyJob>();
+    }
+    for (auto& job : jobs) {
+        job.doneCallback(false);
+    }
+
+    // batches which were not picked up yet are dropped, which fails their jobs (see PushSigVerifyBatch)
+    workerPool.Stop(false);
+
+    std::unique_lock<std::mutex> l(sigVerifyMutex);
+    sigVerifyBatchesInProgress = 0;
 }
 
 bool CBLSWorker::GenerateContributions(int quorumThreshold, const BLSIdVector& ids, BLSVerificationVectorPtr& vvecRet, BLSSecretKeyVector& skShares)
@@ -93,7 +113,7 @@ bool CBLSWorker::GenerateContributions(int quorumThreshold, const BLSIdVector& i
             }
             return true;
         };
-        futures.emplace_back(workerPool.push(f));
+        futures.emplace_back(workerPool.Push(f));
     }
 
     for (size_t i = 0; i < ids.size(); i += batchSize) {
@@ -107,7 +127,7 @@ bool CBLSWorker::GenerateContributions(int quorumThreshold, const BLSIdVector& i
             }
             return true;
         };
-        futures.emplace_back(workerPool.push(f));
+        futures.emplace_back(workerPool.Push(f));
     }
     bool success = true;
     for (auto& f : futures) {
@@ -119,10 +139,10 @@ bool CBLSWorker::GenerateContributions(int quorumThreshold, const BLSIdVector& i
 }
 
 // aggregates a single vector of BLS objects in parallel
-// the input vector is split into batches and each batch is aggregated in parallel
-// when enough batches are finished to form a new batch, the new batch is queued for further parallel aggregation
-// when no more batches can be created from finished batch results, the final aggregated is created and the doneCallback
-// called.
+// the input range is split recursively into two halves until a range fits into a single batch. One half is pushed to
+// the worker pool, where an idle thread can steal it, while the current thread continues splitting the other half.
+// When both halves of a split are aggregated, the thread that finished last combines them and continues upwards, until
+// the final result is reached and the doneCallback called.
 // The Aggregator object needs to be created on the heap and it will delete itself after calling the doneCallback
 // The input vector is not copied into the Aggregator but instead a vector of pointers to the original entries from the
 // input vector is stored. This means that the input vector must stay alive for the whole lifetime of the Aggregator
@@ -134,16 +154,19 @@ struct Aggregator {
     std::shared_ptr<std::vector<const T*> > inputVec;
 
     bool parallel;
-    ctpl::thread_pool& workerPool;
+    CWorkStealingPool& workerPool;
 
-    std::mutex m;
-    // items in the queue are all intermediate aggregation results of finished batches.
-    // The intermediate results must be deleted by us again (which we do in SyncAggregateAndPushAggQueue)
-    boost::lockfree::queue<T*> aggQueue;
-    std::atomic<size_t> aggQueueSize{0};
+    // Joins the results of the two halves of a split range
+    struct SplitNode {
+        std::shared_ptr<SplitNode> parent;
+        int parentSlot;
+        T results[2];
+        std::atomic<int> doneCount{0};
 
-    // keeps track of currently queued/in-progress batches. If it reaches 0, we are done
-    std::atomic<size_t> waitCount{0};
+        SplitNode(std::shared_ptr<SplitNode> _parent, int _parentSlot) :
+            parent(std::move(_parent)), parentSlot(_parentSlot) {}
+    };
+    typedef std::shared_ptr<SplitNode> SplitNodePtr;
 
     typedef std::function<void(const T& agg)> DoneCallback;
     DoneCallback doneCallback;
@@ -153,11 +176,10 @@ struct Aggregator {
     Aggregator(const std::vector<TP>& _inputVec,
                size_t start, size_t count,
                bool _parallel,
-               ctpl::thread_pool& _workerPool,
+               CWorkStealingPool& _workerPool,
                DoneCallback _doneCallback) :
-            workerPool(_workerPool),
             parallel(_parallel),
-            aggQueue(0),
+            workerPool(_workerPool),
             doneCallback(std::move(_doneCallback))
     {
         inputVec = std::make_shared<std::vector<const T*> >(count);
@@ -173,8 +195,6 @@ struct Aggregator {
     // If parallel=true, then this will return fast, otherwise this will block until aggregation is done
     void Start()
     {
-        size_t batchCount = (inputVec->size() + batchSize - 1) / batchSize;
-
         if (!parallel) {
             if (inputVec->size() == 1) {
                 doneCallback(*(*inputVec)[0]);
@@ -185,120 +205,43 @@ struct Aggregator {
             return;
         }
 
-        if (batchCount == 1) {
-            // just a single batch of work, take a shortcut.
-            PushWork([this](int threadId) {
-                if (inputVec->size() == 1) {
-                    doneCallback(*(*inputVec)[0]);
-                } else {
-                    doneCallback(SyncAggregate(*inputVec, 0, inputVec->size()));
-                }
-                delete this;
-            });
-            return;
-        }
-
-        // increment wait counter as otherwise the first finished async aggregation might signal that we're done
-        IncWait();
-        for (size_t i = 0; i < batchCount; i++) {
-            size_t start = i * batchSize;
-            size_t count = std::min(batchSize, inputVec->size() - start);
-            AsyncAggregateAndPushAggQueue(inputVec, start, count, false);
-        }
-        // this will decrement the wait counter and in most cases NOT finish, as async work is still in progress
-        CheckDone();
+        size_t count = inputVec->size();
+        PushWork([this, count](int threadId) {
+            AggregateRange(0, count, nullptr, 0);
+        });
     }
 
-    void IncWait()
-    {
-        ++waitCount;
-    }
-
-    void CheckDone()
-    {
-        if (--waitCount == 0) {
-            Finish();
-        }
-    }
-
-    void Finish()
+    void AggregateRange(size_t start, size_t count, SplitNodePtr parent, int parentSlot)
     {
-        // All async work is done, but we might have items in the aggQueue which are the results of the async
-        // work. This is the case when these did not add up to a new batch. In this case, we have to aggregate
-        // the items into the final result
-
-        std::vector<T*> rem(aggQueueSize);
-        for (size_t i = 0; i < rem.size(); i++) {
-            T* p = nullptr;
-            bool s = aggQueue.pop(p);
-            assert(s);
-            rem[i] = p;
-        }
-
-        T r;
-        if (rem.size() == 1) {
-            // just one intermediate result, which is actually the final result
-            r = *rem[0];
-        } else {
-            // multiple intermediate results left which did not add up to a new batch. aggregate them now
-            r = SyncAggregate(rem, 0, rem.size());
-        }
-
-        // all items which are left in the queue are intermediate results, so we must delete them
-        for (size_t i = 0; i < rem.size(); i++) {
-            delete rem[i];
+        while (count > batchSize) {
+            size_t half = count / 2;
+            auto node = std::make_shared<SplitNode>(std::move(parent), parentSlot);
+            PushWork([this, start, half, count, node](int threadId) {
+                AggregateRange(start + half, count - half, node, 1);
+            });
+            count = half;
+            parent = std::move(node);
+            parentSlot = 0;
         }
-        doneCallback(r);
-
-        delete this;
+        HandleResult(SyncAggregate(*inputVec, start, count), std::move(parent), parentSlot);
     }
 
-    void AsyncAggregateAndPushAggQueue(std::shared_ptr<std::vector<const T*> >& vec, size_t start, size_t count, bool del)
+    void HandleResult(T result, SplitNodePtr node, int slot)
     {
-        IncWait();
-        PushWork(std::bind(&Aggregator::SyncAggregateAndPushAggQueue, this, vec, start, count, del));
-    }
-
-    void SyncAggregateAndPushAggQueue(std::shared_ptr<std::vector<const T*> >& vec, size_t start, size_t count, bool del)
-    {
-        // aggregate vec and push the intermediate result onto the work queue
-        PushAggQueue(SyncAggregate(*vec, start, count));
-        if (del) {
-            for (size_t i = 0; i < count; i++) {
-                delete (*vec)[start + i];
+        while (node != nullptr) {
+            node->results[slot] = std::move(result);
+            if (++node->doneCount != 2) {
+                // the other half is still in progress and will continue from here
+                return;
             }
+            result = node->results[0];
+            result.AggregateInsecure(node->results[1]);
+            slot = node->parentSlot;
+            node = node->parent;
         }
-        CheckDone();
-    }
-
-    void PushAggQueue(const T& v)
-    {
-        aggQueue.push(new T(v));
-
-        if (++aggQueueSize >= batchSize) {
-            // we've collected enough intermediate results to form a new batch.
-            std::shared_ptr<std::vector<const T*> > newBatch;
-            {
-                std::unique_lock<std::mutex> l(m);
-                if (aggQueueSize < batchSize) {
-                    // some other worker thread grabbed this batch
-                    return;
-                }
-                newBatch = std::make_shared<std::vector<const T*> >(batchSize);
-                // collect items for new batch
-                for (size_t i = 0; i < batchSize; i++) {
-                    T* p = nullptr;
-                    bool s = aggQueue.pop(p);
-                    assert(s);
-                    (*newBatch)[i] = p;
-                }
-                aggQueueSize -= batchSize;
-            }
 
-            // push new batch to work queue. del=true this time as these items are intermediate results and need to be deleted
-            // after aggregation is done
-            AsyncAggregateAndPushAggQueue(newBatch, 0, newBatch->size(), true);
-        }
+        doneCallback(result);
+        delete this;
     }
 
     template <typename TP>
@@ -314,7 +257,7 @@ struct Aggregator {
     template <typename Callable>
     void PushWork(Callable&& f)
     {
-        workerPool.push(f);
+        workerPool.Push(f);
     }
 };
 
@@ -342,7 +285,7 @@ struct VectorAggregator {
     size_t start;
     size_t count;
     bool parallel;
-    ctpl::thread_pool& workerPool;
+    CWorkStealingPool& workerPool;
 
     std::atomic<size_t> doneCount;
 
@@ -351,7 +294,7 @@ struct VectorAggregator {
 
     VectorAggregator(const VectorVectorType& _vecs,
                      size_t _start, size_t _count,
-                     bool _parallel, ctpl::thread_pool& _workerPool,
+                     bool _parallel, CWorkStealingPool& _workerPool,
                      DoneCallback _doneCallback) :
             vecs(_vecs),
             parallel(_parallel),
@@ -422,7 +365,7 @@ struct ContributionVerifier {
     bool parallel;
     bool aggregated;
 
-    ctpl::thread_pool& workerPool;
+    CWorkStealingPool& workerPool;
 
     size_t batchCount;
     size_t verifyCount;
@@ -433,7 +376,7 @@ struct ContributionVerifier {
 
     ContributionVerifier(const CBLSId& _forId, const std::vector<BLSVerificationVectorPtr>& _vvecs,
                          const BLSSecretKeyVector& _skShares, size_t _batchSize,
-                         bool _parallel, bool _aggregated, ctpl::thread_pool& _workerPool,
+                         bool _parallel, bool _aggregated, CWorkStealingPool& _workerPool,
                          std::function<void(const std::vector<bool>&)> _doneCallback) :
         forId(_forId),
         vvecs(_vvecs),
@@ -590,7 +533,7 @@ struct ContributionVerifier {
     void PushOrDoWork(Callable&& f)
     {
         if (parallel) {
-            workerPool.push(std::move(f));
+            workerPool.Push(std::move(f));
         } else {
             f(0);
         }
@@ -632,7 +575,7 @@ BLSVerificationVectorPtr CBLSWorker::BuildQuorumVerificationVector(const std::ve
 }
 
 template <typename T>
-void AsyncAggregateHelper(ctpl::thread_pool& workerPool,
+void AsyncAggregateHelper(CWorkStealingPool& workerPool,
                           const std::vector<T>& vec, size_t start, size_t count, bool parallel,
                           std::function<void(const T&)> doneCallback)
 {
@@ -770,7 +713,7 @@ std::future<bool> CBLSWorker::AsyncVerifyContributionShare(const CBLSId& forId,
         CBLSPublicKey pk2 = skContribution.GetPublicKey();
         return pk1 == pk2;
     };
-    return workerPool.push(f);
+    return workerPool.Push(f);
 }
 
 bool CBLSWorker::VerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec,
@@ -832,7 +775,7 @@ bool CBLSWorker::VerifySignatureVector(const BLSSignatureVector& sigs, size_t st
 
 void CBLSWorker::AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash, CBLSWorker::SignDoneCallback doneCallback)
 {
-    workerPool.push([secKey, msgHash, doneCallback](int threadId) {
+    workerPool.Push([secKey, msgHash, doneCallback](int threadId) {
         doneCallback(secKey.Sign(msgHash));
     });
 }
@@ -853,23 +796,14 @@ void CBLSWorker::AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& p
     }
 
     std::unique_lock<std::mutex> l(sigVerifyMutex);
-
-    bool foundDuplicate = false;
-    for (auto& s : sigVerifyQueue) {
-        if (s.msgHash == msgHash) {
-            foundDuplicate = true;
-            break;
-        }
-    }
-
-    if (foundDuplicate) {
-        // batched/aggregated verification does not allow duplicate hashes, so we push what we currently have and start
-        // with a fresh batch
-        PushSigVerifyBatch();
+    if (sigVerifyStopped) {
+        l.unlock();
+        doneCallback(false);
+        return;
     }
 
     sigVerifyQueue.emplace_back(std::move(doneCallback), std::move(cancelCond), sig, pubKey, msgHash);
-    if (sigVerifyBatchesInProgress == 0 || sigVerifyQueue.size() >= SIG_VERIFY_BATCH_SIZE) {
+    if (sigVerifyBatchesInProgress == 0 || sigVerifyQueue.size() >= sigVerifyBatchSize) {
         PushSigVerifyBatch();
     }
 }
@@ -887,74 +821,149 @@ bool CBLSWorker::IsAsyncVerifyInProgress()
     return sigVerifyBatchesInProgress != 0;
 }
 
+void CBLSWorker::SetSigVerifyBatchSize(size_t batchSize)
+{
+    std::unique_lock<std::mutex> l(sigVerifyMutex);
+    sigVerifyBatchSize = std::max(batchSize, (size_t)1);
+}
+
 // sigVerifyMutex must be held while calling
 void CBLSWorker::PushSigVerifyBatch()
 {
     auto f = [this](int threadId, std::shared_ptr<std::vector<SigVerifyJob> > _jobs) {
-        auto& jobs = *_jobs;
-        if (jobs.size() == 1) {
-            auto& job = jobs[0];
-            if (!job.cancelCond()) {
-                bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
-                job.doneCallback(valid);
-            }
-            std::unique_lock<std::mutex> l(sigVerifyMutex);
-            sigVerifyBatchesInProgress--;
-            if (!sigVerifyQueue.empty()) {
-                PushSigVerifyBatch();
+        VerifySigBatch(*_jobs);
+
+        std::unique_lock<std::mutex> l(sigVerifyMutex);
+        sigVerifyBatchesInProgress--;
+        if (!sigVerifyQueue.empty()) {
+            PushSigVerifyBatch();
+        }
+    };
+
+    // jobs which did not complete when the batch is destroyed, because the worker was stopped before it ran, fail
+    auto batch = std::shared_ptr<std::vector<SigVerifyJob> >(new std::vector<SigVerifyJob>(std::move(sigVerifyQueue)), [](std::vector<SigVerifyJob>* jobs) {
+        for (auto& job : *jobs) {
+            if (job.doneCallback) {
+                job.doneCallback(false);
             }
+        }
+        delete jobs;
+    });
+    sigVerifyQueue = std::vector<SigVerifyJob>();
+    sigVerifyQueue.reserve(sigVerifyBatchSize);
+
+    sigVerifyBatchesInProgress++;
+    workerPool.Push(f, batch);
+}
+
+void CBLSWorker::VerifySigBatch(std::vector<SigVerifyJob>& jobs)
+{
+    std::vector<size_t> indexes;
+    indexes.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!jobs[i].cancelCond()) {
+            indexes.emplace_back(i);
+        } else {
+            jobs[i].doneCallback = nullptr;
+        }
+    }
+    if (indexes.empty()) {
+        return;
+    }
+
+    // sort by message hash first, so that jobs for the same message end up next to each other. This is common when
+    // the same recovered sig/ISLOCK/CLSIG is received from multiple peers at the same time
+    std::sort(indexes.begin(), indexes.end(), [&](size_t a, size_t b) {
+        const auto& ja = jobs[a];
+        const auto& jb = jobs[b];
+        if (ja.msgHash != jb.msgHash) {
+            return ja.msgHash < jb.msgHash;
+        }
+        if (ja.pubKey.GetHash() != jb.pubKey.GetHash()) {
+            return ja.pubKey.GetHash() < jb.pubKey.GetHash();
+        }
+        return ja.sig.GetHash() < jb.sig.GetHash();
+    });
+
+    std::vector<SigVerifyGroup> groups;
+    groups.reserve(indexes.size());
+    for (size_t idx : indexes) {
+        const auto& job = jobs[idx];
+        if (groups.empty() || groups.back().msgHash != job.msgHash || groups.back().pubKey != job.pubKey || groups.back().sig != job.sig) {
+            groups.emplace_back(SigVerifyGroup{job.msgHash, job.pubKey, job.sig, {}});
+        }
+        groups.back().jobIndexes.emplace_back(idx);
+    }
+
+    VerifySigGroups(jobs, groups, 0, groups.size());
+}
+
+// Verifies the groups in [begin, end) with a single aggregated verification. If that fails, the range is split into
+// two halves which are then verified individually. This way, a few invalid signatures in a large batch only cost
+// O(invalidCount * log(batchSize)) additional verifications instead of reverting to per-signature verification
+void CBLSWorker::VerifySigGroups(std::vector<SigVerifyJob>& jobs, const std::vector<SigVerifyGroup>& groups, size_t begin, size_t end)
+{
+    assert(begin < end);
+
+    bool valid;
+    if (end - begin == 1) {
+        const auto& group = groups[begin];
+        valid = group.sig.VerifyInsecure(group.pubKey, group.msgHash);
+    } else {
+        valid = VerifySigGroupsAggregated(groups, begin, end);
+        if (!valid) {
+            size_t mid = begin + (end - begin) / 2;
+            VerifySigGroups(jobs, groups, begin, mid);
+            VerifySigGroups(jobs, groups, mid, end);
             return;
         }
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        for (size_t idx : groups[i].jobIndexes) {
+            jobs[idx].doneCallback(valid);
+            jobs[idx].doneCallback = nullptr;
+        }
+    }
+}
 
+bool CBLSWorker::VerifySigGroupsAggregated(const std::vector<SigVerifyGroup>& groups, size_t begin, size_t end)
+{
+    // Aggregated verification does not allow the same message hash to appear multiple times. We also can't aggregate the
+    // public keys of groups with the same message hash, as this would make the rogue public key attack possible. So we
+    // verify these in multiple rounds, each round only taking one group per message hash. In most cases, there is only
+    // one round
+    std::vector<bool> taken(end - begin, false);
+    size_t remaining = end - begin;
+
+    while (remaining != 0) {
         CBLSSignature aggSig;
-        std::vector<size_t> indexes;
         std::vector<CBLSPublicKey> pubKeys;
         std::vector<uint256> msgHashes;
-        indexes.reserve(jobs.size());
-        pubKeys.reserve(jobs.size());
-        msgHashes.reserve(jobs.size());
-        for (size_t i = 0; i < jobs.size(); i++) {
-            auto& job = jobs[i];
-            if (job.cancelCond()) {
+        pubKeys.reserve(remaining);
+        msgHashes.reserve(remaining);
+
+        for (size_t i = begin; i < end; i++) {
+            const auto& group = groups[i];
+            // groups are sorted by message hash, so we only need to compare with the last one taken in this round
+            if (taken[i - begin] || (!msgHashes.empty() && msgHashes.back() == group.msgHash)) {
                 continue;
             }
-            if (pubKeys.empty()) {
-                aggSig = job.sig;
-            } else {
-                aggSig.AggregateInsecure(job.sig);
-            }
-            indexes.emplace_back(i);
-            pubKeys.emplace_back(job.pubKey);
-            msgHashes.emplace_back(job.msgHash);
-        }
+            taken[i - begin] = true;
+            remaining--;
 
-        if (!pubKeys.empty()) {
-            bool allValid = aggSig.VerifyInsecureAggregated(pubKeys, msgHashes);
-            if (allValid) {
-                for (size_t i = 0; i < pubKeys.size(); i++) {
-                    jobs[indexes[i]].doneCallback(true);
-                }
+            if (pubKeys.empty()) {
+                aggSig = group.sig;
             } else {
-                // one or more sigs were not valid, revert to per-sig verification
-                // TODO this could be improved if we would cache pairing results in some way as the previous aggregated verification already calculated all the pairings for the hashes
-                for (size_t i = 0; i < pubKeys.size(); i++) {
-                    auto& job = jobs[indexes[i]];
-                    bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
-                    job.doneCallback(valid);
-                }
+                aggSig.AggregateInsecure(group.sig);
             }
+            pubKeys.emplace_back(group.pubKey);
+            msgHashes.emplace_back(group.msgHash);
         }
 
-        std::unique_lock<std::mutex> l(sigVerifyMutex);
-        sigVerifyBatchesInProgress--;
-        if (!sigVerifyQueue.empty()) {
-            PushSigVerifyBatch();
+        if (!aggSig.VerifyInsecureAggregated(pubKeys, msgHashes)) {
+            return false;
         }
-    };
-
-    auto batch = std::make_shared<std::vector<SigVerifyJob> >(std::move(sigVerifyQueue));
-    sigVerifyQueue.reserve(SIG_VERIFY_BATCH_SIZE);
-
-    sigVerifyBatchesInProgress++;
-    workerPool.push(f, batch);
+    }
+    return true;
 }
@@ -7,13 +7,11 @@
 
 #include "bls.h"
 
-#include "ctpl.h"
+#include "workstealingpool.h"
 
 #include <future>
 #include <mutex>
 
-#include <boost/lockfree/queue.hpp>
-
 // Low level BLS/DKG stuff. All very compute intensive and optimized for parallelization
 // The worker tries to parallelize as much as possible and utilizes a few properties of BLS aggregation to speed up things
 // For example, public key vectors can be aggregated in parallel if they are split into batches and the batched aggregations are
@@ -26,9 +24,9 @@ public:
     typedef std::function<bool()> CancelCond;
 
 private:
-    ctpl::thread_pool workerPool;
+    CWorkStealingPool workerPool;
 
-    static const int SIG_VERIFY_BATCH_SIZE = 8;
+    static const size_t SIG_VERIFY_BATCH_SIZE = 64;
     struct SigVerifyJob {
         SigVerifyDoneCallback doneCallback;
         CancelCond cancelCond;
@@ -45,8 +43,19 @@ private:
         }
     };
 
+    // Jobs with the same message hash, public key and signature are verified only once
+    struct SigVerifyGroup {
+        uint256 msgHash;
+        CBLSPublicKey pubKey;
+        CBLSSignature sig;
+        std::vector<size_t> jobIndexes;
+    };
+
     std::mutex sigVerifyMutex;
+    // once stopped, verification jobs fail right away instead of waiting for a worker thread that never comes
+    bool sigVerifyStopped{false};
     int sigVerifyBatchesInProgress{0};
+    size_t sigVerifyBatchSize{SIG_VERIFY_BATCH_SIZE};
     std::vector<SigVerifyJob> sigVerifyQueue;
 
 public:
@@ -133,14 +142,23 @@ public:
     bool VerifySignatureVector(const BLSSignatureVector& sigs, size_t start = 0, size_t count = 0);
 
     // Internally batched signature signing and verification
+    // Verification jobs from all callers are collected in a shared queue and verified in large batches. Jobs are grouped
+    // by message hash and public key, so that the same signature received multiple times is only verified once. If a
+    // batch fails to verify, it is bisected until the invalid signatures are found. doneCallback is called from one of
+    // the worker threads and thus must be thread safe and should not block. After Stop(), every job which is not
+    // cancelled completes with false
     void AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash, SignDoneCallback doneCallback);
     std::future<CBLSSignature> AsyncSign(const CBLSSecretKey& secKey, const uint256& msgHash);
     void AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, SigVerifyDoneCallback doneCallback, CancelCond cancelCond = [] { return false; });
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
+    void SetSigVerifyBatchSize(size_t batchSize);
 
 private:
     void PushSigVerifyBatch();
+    void VerifySigBatch(std::vector<SigVerifyJob>& jobs);
+    void VerifySigGroups(std::vector<SigVerifyJob>& jobs, const std::vector<SigVerifyGroup>& groups, size_t begin, size_t end);
+    bool VerifySigGroupsAggregated(const std::vector<SigVerifyGroup>& groups, size_t begin, size_t end);
 };
 
 // Builds and caches different things from CBLSWorker
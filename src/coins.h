@@ -8,6 +8,7 @@
 
 #include "compressor.h"
 #include "core_memusage.h"
+#include "flathashmap.h"
 #include "hash.h"
 #include "memusage.h"
 #include "serialize.h"
@@ -15,7 +16,6 @@
 
 #include <assert.h>
 #include <stdint.h>
-#include <unordered_map>
 
 /**
  * A UTXO entry.
@@ -82,8 +82,8 @@ public:
 class SaltedOutpointHasher
 {
 private:
-    /** Salt */
-    const uint64_t k0, k1;
+    /** Salt (not const, so that maps using this hasher can be swapped) */
+    uint64_t k0, k1;
 
 public:
     SaltedOutpointHasher();
@@ -117,7 +117,11 @@ struct CCoinsCacheEntry
     explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * Entries are stored inline in a flat table instead of one heap node per coin. Coin scripts use the inline storage of
+ * CScript (prevector) for all standard output types, so most coins don't need any allocation at all.
+ */
+typedef flathashmap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -156,6 +160,12 @@ public:
     //! Retrieve the block hash whose state this CCoinsView currently represents
     virtual uint256 GetBestBlock() const;
 
+    //! Retrieve the range of blocks that may have been only partially written.
+    //! If the database is in a consistent state, the result is the empty vector.
+    //! Otherwise, a two-element vector is returned consisting of the new and
+    //! the old block hash, in that order.
+    virtual std::vector<uint256> GetHeadBlocks() const;
+
     //! Do a bulk modification (multiple Coin changes + BestBlock change).
     //! The passed mapCoins can be modified.
     virtual bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock);
@@ -182,6 +192,7 @@ public:
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
+    std::vector<uint256> GetHeadBlocks() const override;
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
@@ -228,10 +239,8 @@ public:
      * more efficient than GetCoin.
      *
      * Generally, do not hold the reference returned for more than a short scope.
-     * While the current implementation allows for modifications to the contents
-     * of the cache while holding the reference, this behavior should not be relied
-     * on! To be safe, best to not hold the returned reference through any other
-     * calls to this cache.
+     * Any call which adds entries to the cache (including other lookups) may move
+     * the cached coins and thus invalidate the returned reference.
      */
     const Coin& AccessCoin(const COutPoint &output) const;
 
@@ -267,6 +276,14 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    /**
+     * Limit the size of the cache table to roughly nBytes. Up to this size the table grows by doubling, after that
+     * only in small steps, so that a cache which is flushed when it reaches its memory limit can use the whole
+     * limit instead of having the last doubling overshoot it. A table that has grown beyond the limit is released
+     * when flushing. 0 means no limit.
+     */
+    void SetMaxTableSize(size_t nBytes);
+
     /** 
      * Amount of cbdhealthnetwork coming in to a transaction
      * Note that lightweight clients may not know anything besides the hash of previous transactions,
@@ -290,10 +307,12 @@ private:
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
-// It assumes that overwrites are only possible for coinbase transactions,
+// When check is false, this assumes that overwrites are only possible for coinbase transactions.
+// When check is true, the underlying view may be queried to determine whether an addition is
+// an overwrite.
 // TODO: pass in a boolean to limit these possible overwrites to known
 // (pre-BIP34) cases.
-void AddCoins(CCoinsViewCache& cache, const CTransaction& tx, int nHeight);
+void AddCoins(CCoinsViewCache& cache, const CTransaction& tx, int nHeight, bool check = false);
 
 //! Utility function to find any unspent output with a given txid.
 // This function can be quite expensive because in the event of a transaction
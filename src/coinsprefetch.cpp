@@ -0,0 +1,200 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsprefetch.h"
+
+#include "primitives/block.h"
+#include "saltedhasher.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+CCoinsViewPrefetch::CCoinsViewPrefetch(CCoinsView* viewIn) : CCoinsViewBacked(viewIn)
+{
+}
+
+CCoinsViewPrefetch::~CCoinsViewPrefetch()
+{
+    Stop();
+}
+
+void CCoinsViewPrefetch::Start(int nThreads)
+{
+    if (nThreads > 0) {
+        workerPool.Start(nThreads, "cbdhealthnetwork-prefetch");
+    }
+}
+
+void CCoinsViewPrefetch::Stop()
+{
+    workerPool.Stop(false);
+
+    std::lock_guard<std::mutex> lock(cs);
+    pendingJobs.clear();
+    stagedCoins.clear();
+}
+
+bool CCoinsViewPrefetch::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        auto it = stagedCoins.find(outpoint);
+        if (it != stagedCoins.end()) {
+            // The tip caches the coin from now on, so we don't need to keep it
+            coin = std::move(it->second);
+            stagedCoins.erase(it);
+            nStagedHits++;
+            return true;
+        }
+    }
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewPrefetch::HaveCoin(const COutPoint& outpoint) const
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (stagedCoins.count(outpoint)) {
+            return true;
+        }
+    }
+    return base->HaveCoin(outpoint);
+}
+
+bool CCoinsViewPrefetch::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    // Fetches which overlap with the write might have read either the old or the new state, make sure that they are
+    // not staged by changing the epoch before and after the write
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nWriteEpoch++;
+        stagedCoins.clear();
+    }
+    bool ret = base->BatchWrite(mapCoins, hashBlock);
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nWriteEpoch++;
+        stagedCoins.clear();
+    }
+    return ret;
+}
+
+void CCoinsViewPrefetch::PrefetchBlock(const CBlock& block, const CCoinsViewCache& tip)
+{
+    if (workerPool.Size() == 0) {
+        return;
+    }
+
+    uint256 blockHash = block.GetHash();
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (pendingJobs.count(blockHash)) {
+            return;
+        }
+    }
+
+    // Inputs which spend outputs of the same block are not in the chainstate yet
+    std::unordered_set<uint256, StaticSaltedHasher> blockTxids;
+    blockTxids.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        blockTxids.emplace(tx->GetHash());
+    }
+
+    auto outpoints = std::make_shared<std::vector<COutPoint> >();
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+        for (const auto& txin : tx->vin) {
+            if (blockTxids.count(txin.prevout.hash) || tip.HaveCoinInCache(txin.prevout)) {
+                continue;
+            }
+            outpoints->emplace_back(txin.prevout);
+        }
+    }
+
+    PrefetchJob job;
+    for (size_t i = 0; i < outpoints->size(); i += FETCH_BATCH_SIZE) {
+        size_t end = std::min(i + FETCH_BATCH_SIZE, outpoints->size());
+        job.emplace_back(workerPool.Push([this, outpoints, i, end](int threadId) {
+            FetchCoins(outpoints, i, end);
+        }));
+    }
+
+    std::lock_guard<std::mutex> lock(cs);
+    if (pendingJobs.size() >= MAX_PENDING_JOBS) {
+        for (auto it = pendingJobs.begin(); it != pendingJobs.end(); ) {
+            bool fDone = std::all_of(it->second.begin(), it->second.end(), [](const std::future<void>& f) {
+                return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            });
+            if (fDone) {
+                it = pendingJobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    pendingJobs.emplace(blockHash, std::move(job));
+}
+
+void CCoinsViewPrefetch::WaitForBlock(const uint256& blockHash)
+{
+    PrefetchJob job;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        auto it = pendingJobs.find(blockHash);
+        if (it == pendingJobs.end()) {
+            return;
+        }
+        job = std::move(it->second);
+        pendingJobs.erase(it);
+    }
+
+    int64_t nTimeStart = GetTimeMicros();
+    for (auto& f : job) {
+        // wait() instead of get(), tasks that were dropped by Stop() leave a broken promise
+        f.wait();
+    }
+    int64_t nTimeWait = GetTimeMicros() - nTimeStart;
+
+    std::lock_guard<std::mutex> lock(cs);
+    LogPrint("bench", "    - Wait for prefetched inputs: %.2fms (%d batches, %u coins fetched, %u staged hits)\n",
+             0.001 * nTimeWait, job.size(), nFetched, nStagedHits);
+}
+
+size_t CCoinsViewPrefetch::GetStagedCount() const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return stagedCoins.size();
+}
+
+void CCoinsViewPrefetch::FetchCoins(std::shared_ptr<const std::vector<COutPoint> > outpoints, size_t begin, size_t end)
+{
+    uint64_t nEpoch;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nEpoch = nWriteEpoch;
+    }
+
+    std::vector<std::pair<COutPoint, Coin> > fetched;
+    fetched.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        Coin coin;
+        if (base->GetCoin((*outpoints)[i], coin) && !coin.IsSpent()) {
+            fetched.emplace_back((*outpoints)[i], std::move(coin));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(cs);
+    if (nEpoch != nWriteEpoch || stagedCoins.size() + fetched.size() > MAX_STAGED_COINS) {
+        return;
+    }
+    for (auto& p : fetched) {
+        stagedCoins.emplace(p.first, std::move(p.second));
+    }
+    nFetched += fetched.size();
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_COINSPREFETCH_H
+#define CHN_COINSPREFETCH_H
+
+#include "coins.h"
+#include "workstealingpool.h"
+
+#include <future>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class CBlock;
+
+/** -utxoprefetchthreads default (number of threads fetching block inputs from the chainstate, 0 = disabled) */
+static const int DEFAULT_UTXO_PREFETCH_THREADS = 4;
+/** Maximum number of threads fetching block inputs */
+static const int MAX_UTXO_PREFETCH_THREADS = 16;
+
+/**
+ * CCoinsView which sits between pcoinsTip and the chainstate database and fetches the inputs of blocks in parallel
+ * before they are connected.
+ *
+ * PrefetchBlock() collects all prevouts of a block which are neither created inside the block itself nor already
+ * cached in the tip, and reads them from the database on a pool of worker threads into a staging area. When the tip
+ * later misses one of these coins, GetCoin() hands out the staged copy instead of doing a synchronous database read.
+ *
+ * Staged coins are only valid as long as the database does not change. Everything that was staged or is still being
+ * fetched is dropped when BatchWrite() writes to the database. Between two writes, the database matches the tip for
+ * every coin the tip does not have an entry for, which are the only coins the tip will ever request from us.
+ */
+class CCoinsViewPrefetch : public CCoinsViewBacked
+{
+private:
+    // Outpoints fetched by a single task
+    static const size_t FETCH_BATCH_SIZE = 32;
+    // Fetched coins are thrown away instead of staged once there are this many staged coins
+    static const size_t MAX_STAGED_COINS = 100000;
+    // Finished jobs of blocks which were never connected are forgotten once there are more jobs than this
+    static const size_t MAX_PENDING_JOBS = 16;
+
+    typedef std::vector<std::future<void> > PrefetchJob;
+
+    CWorkStealingPool workerPool;
+
+    mutable std::mutex cs;
+    mutable std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> stagedCoins;
+    std::map<uint256, PrefetchJob> pendingJobs;
+    // Incremented before and after every write to the database
+    uint64_t nWriteEpoch{0};
+
+    // Statistics
+    mutable uint64_t nStagedHits{0};
+    uint64_t nFetched{0};
+
+public:
+    explicit CCoinsViewPrefetch(CCoinsView* viewIn);
+    ~CCoinsViewPrefetch();
+
+    void Start(int nThreads);
+    void Stop();
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override;
+
+    /**
+     * Starts fetching the inputs of block. tip must be the cache on top of this view, it is used to skip coins which
+     * are already cached. Does nothing if the block is already being prefetched or when no worker threads are running.
+     * Requires cs_main, so that tip can be accessed.
+     */
+    void PrefetchBlock(const CBlock& block, const CCoinsViewCache& tip);
+    /** Waits until all inputs of the block with the given hash are fetched, if it is being prefetched */
+    void WaitForBlock(const uint256& blockHash);
+
+    size_t GetStagedCount() const;
+
+private:
+    void FetchCoins(std::shared_ptr<const std::vector<COutPoint> > outpoints, size_t begin, size_t end);
+};
+
+#endif // CHN_COINSPREFETCH_H
@@ -73,14 +73,16 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const CDBWrapperOptions& dbOptions)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    size_t nBlockCacheSize = nCacheSize / 100 * dbOptions.nBlockCachePercent;
+    options.block_cache = leveldb::NewLRUCache(nBlockCacheSize);
+    options.write_buffer_size = (nCacheSize - nBlockCacheSize) / 2; // up to two write buffers may be held in memory simultaneously
+    options.block_size = dbOptions.nBlockSize;
     options.filter_policy = leveldb::NewBloomFilterPolicy(10);
     options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.max_open_files = dbOptions.nMaxOpenFiles;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -90,14 +92,14 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const CDBWrapperOptions& dbOptions)
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
-    iteroptions.fill_cache = false;
+    iteroptions.fill_cache = dbOptions.fIteratorFillCache;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, dbOptions);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -190,7 +192,7 @@ bool CDBWrapper::IsEmpty()
 }
 
 CDBIterator::~CDBIterator() { delete piter; }
-bool CDBIterator::Valid() { return piter->Valid(); }
+bool CDBIterator::Valid() { return piter->Valid() && (strPrefix.empty() || piter->key().starts_with(strPrefix)); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
 void CDBIterator::Next() { piter->Next(); }
 
@@ -215,4 +217,10 @@ const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w)
     return w.obfuscate_key;
 }
 
+bool IsObfuscated(const CDBWrapper &w)
+{
+    const std::vector<unsigned char>& key = GetObfuscateKey(w);
+    return std::any_of(key.begin(), key.end(), [](unsigned char c) { return c != 0; });
+}
+
 };
@@ -44,6 +44,9 @@ void HandleError(const leveldb::Status& status);
  */
 const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w);
 
+/** Whether the values in the database are obfuscated with a non-zero key */
+bool IsObfuscated(const CDBWrapper &w);
+
 };
 
 /** Batch of changes queued to be written to a CDBWrapper */
@@ -129,6 +132,10 @@ class CDBIterator
 private:
     const CDBWrapper &parent;
     leveldb::Iterator *piter;
+    //! serialized key prefix the iteration is restricted to, empty if it's not restricted
+    std::string strPrefix;
+    //! whether values need to be deobfuscated, otherwise they're deserialized in place
+    bool fObfuscated;
 
 public:
 
@@ -137,7 +144,7 @@ public:
      * @param[in] _piter           The original leveldb iterator.
      */
     CDBIterator(const CDBWrapper &_parent, leveldb::Iterator *_piter) :
-        parent(_parent), piter(_piter) { };
+        parent(_parent), piter(_piter), fObfuscated(dbwrapper_private::IsObfuscated(_parent)) { };
     ~CDBIterator();
 
     bool Valid();
@@ -158,9 +165,22 @@ public:
 
     void Next();
 
+    /**
+     * Restricts the iterator to keys which start with the serialization of prefix. Valid() returns false as soon as
+     * the iterator leaves the range, so the keys don't need to be deserialized to find the end of a prefix scan.
+     * Position the iterator with Seek() afterwards.
+     */
+    template<typename K> void SetPrefix(const K& prefix) {
+        CDataStream ssPrefix(SER_DISK, CLIENT_VERSION);
+        ssPrefix.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssPrefix << prefix;
+        strPrefix.assign(ssPrefix.begin(), ssPrefix.end());
+    }
+
     template<typename K> bool GetKey(K& key) {
+        leveldb::Slice slKey = piter->key();
         try {
-            CDataStream ssKey = GetKey();
+            CSpanReader ssKey(SER_DISK, CLIENT_VERSION, (const unsigned char*)slKey.data(), slKey.size());
             ssKey >> key;
         } catch (const std::exception&) {
             return false;
@@ -180,9 +200,14 @@ public:
     template<typename V> bool GetValue(V& value) {
         leveldb::Slice slValue = piter->value();
         try {
-            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-            ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
-            ssValue >> value;
+            if (fObfuscated) {
+                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+                ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
+                ssValue >> value;
+            } else {
+                CSpanReader ssValue(SER_DISK, CLIENT_VERSION, (const unsigned char*)slValue.data(), slValue.size());
+                ssValue >> value;
+            }
         } catch (const std::exception&) {
             return false;
         }
@@ -195,6 +220,19 @@ public:
 
 };
 
+/** LevelDB tuning of a CDBWrapper, the defaults are the settings used for the block index and the chainstate */
+struct CDBWrapperOptions
+{
+    //! Percentage of the cache size used for the block cache, the rest is split between the two write buffers
+    size_t nBlockCachePercent{50};
+    //! Approximate amount of user data packed per block, bigger blocks make range scans cheaper
+    size_t nBlockSize{4 * 1024};
+    //! Whether blocks read by iterators are added to the block cache
+    bool fIteratorFillCache{false};
+    //! Number of table files LevelDB keeps open
+    int nMaxOpenFiles{64};
+};
+
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
@@ -239,8 +277,9 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] dbOptions   LevelDB tuning for the access pattern of the database.
      */
-    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const CDBWrapperOptions& dbOptions = CDBWrapperOptions());
     ~CDBWrapper();
 
     template <typename K>
@@ -116,30 +116,24 @@ bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev
     int64_t nTime2 = GetTimeMicros(); nTimeDMN += nTime2 - nTime1;
     LogPrint("bench", "            - BuildNewListFromBlock: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeDMN * 0.000001);
 
-    CSimplifiedMNList sml(tmpMNList);
+    // the tree is updated from the list it was last used with, which is usually the list of the previous block or a
+    // block template on the same tip, so only a few leaves need to be re-hashed
+    // (initially both are empty, so the first diff adds all MNs)
+    static CSimplifiedMNListMerkleTree smlTreeCached;
+    static CDeterministicMNList smlTreeCachedList;
 
-    int64_t nTime3 = GetTimeMicros(); nTimeSMNL += nTime3 - nTime2;
-    LogPrint("bench", "            - CSimplifiedMNList: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeSMNL * 0.000001);
-
-    static CSimplifiedMNList smlCached;
-    static uint256 merkleRootCached;
-    static bool mutatedCached{false};
+    smlTreeCached.ApplyDiff(tmpMNList, smlTreeCachedList.BuildDiff(tmpMNList));
+    smlTreeCachedList = tmpMNList;
 
-    if (sml.mnList == smlCached.mnList) {
-        merkleRootRet = merkleRootCached;
-        return !mutatedCached;
-    }
+    int64_t nTime3 = GetTimeMicros(); nTimeSMNL += nTime3 - nTime2;
+    LogPrint("bench", "            - CSimplifiedMNListMerkleTree: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeSMNL * 0.000001);
 
     bool mutated = false;
-    merkleRootRet = sml.CalcMerkleRoot(&mutated);
+    merkleRootRet = smlTreeCached.GetMerkleRoot(&mutated);
 
     int64_t nTime4 = GetTimeMicros(); nTimeMerkle += nTime4 - nTime3;
     LogPrint("bench", "            - CalcMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeMerkle * 0.000001);
 
-    smlCached = std::move(sml);
-    merkleRootCached = merkleRootRet;
-    mutatedCached = mutated;
-
     return !mutated;
 }
 
@@ -8,6 +8,7 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "core_io.h"
+#include "memusage.h"
 #include "script/standard.h"
 #include "ui_interface.h"
 #include "validation.h"
@@ -18,8 +19,15 @@
 
 #include <univalue.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
 static const std::string DB_LIST_SNAPSHOT = "dmn_S";
 static const std::string DB_LIST_DIFF = "dmn_D";
+static const std::string DB_LIST_DIFF_COMPACTED = "dmn_C";
 
 CDeterministicMNManager* deterministicMNManager;
 
@@ -245,24 +253,86 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int
     return result;
 }
 
+// Scoring is split into chunks of at least this size, smaller lists are not worth handing work to other threads
+static const size_t SCORES_MIN_CHUNK_SIZE = 2048;
+static const int SCORES_MAX_THREADS = 8;
+
+// Splits [0, nCount) into chunks and calls func(begin, end) for each of them. The calling thread works on the chunks
+// together with the threads of pool, if there is a pool and enough work. Chunks are claimed one by one, so all of them
+// are done by the calling thread if the pool is busy or gets stopped
+template <typename Callback>
+static std::vector<std::pair<size_t, size_t>> ForEachChunkParallel(CWorkStealingPool* pool, size_t nCount, Callback&& func)
+{
+    size_t nThreads = pool ? std::min(nCount / SCORES_MIN_CHUNK_SIZE, (size_t)pool->Size() + 1) : 1;
+    nThreads = std::max(nThreads, (size_t)1);
+    size_t nChunkSize = std::max((nCount + nThreads - 1) / nThreads, (size_t)1);
+
+    struct ChunksState {
+        std::vector<std::pair<size_t, size_t>> chunks;
+        std::atomic<size_t> nextChunk{0};
+        std::mutex cs;
+        std::condition_variable cond;
+        size_t doneCount{0};
+    };
+    auto state = std::make_shared<ChunksState>();
+    for (size_t i = 0; i < nCount; i += nChunkSize) {
+        state->chunks.emplace_back(i, std::min(nCount, i + nChunkSize));
+    }
+
+    // func is only touched for a claimed chunk, which the calling thread waits for
+    auto pfunc = &func;
+    auto work = [state, pfunc](int threadId) {
+        size_t i;
+        while ((i = state->nextChunk++) < state->chunks.size()) {
+            (*pfunc)(state->chunks[i].first, state->chunks[i].second);
+            std::unique_lock<std::mutex> l(state->cs);
+            if (++state->doneCount == state->chunks.size()) {
+                state->cond.notify_all();
+            }
+        }
+    };
+    for (size_t i = 1; i < state->chunks.size(); i++) {
+        pool->Push(work);
+    }
+    work(-1);
+
+    std::unique_lock<std::mutex> l(state->cs);
+    state->cond.wait(l, [&] { return state->doneCount == state->chunks.size(); });
+    return state->chunks;
+}
+
+// descending order by score. Equal scores should actually never happen, but we should stay compatible with how the
+// non deterministic MNs did the sorting
+static bool CompareScoresDescending(const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b)
+{
+    if (a.first == b.first) {
+        return b.second->collateralOutpoint < a.second->collateralOutpoint;
+    }
+    return b.first < a.first;
+}
+
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t maxSize, const uint256& modifier) const
 {
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
-        if (a.first == b.first) {
-            // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
-        }
-        return a.first < b.first;
+    // only the top maxSize entries of each chunk can make it into the quorum
+    auto chunks = ForEachChunkParallel(deterministicMNManager ? deterministicMNManager->GetScoresPool() : nullptr, scores.size(), [&](size_t begin, size_t end) {
+        std::partial_sort(scores.begin() + begin, scores.begin() + std::min(end, begin + maxSize), scores.begin() + end, CompareScoresDescending);
     });
 
+    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> candidates;
+    candidates.reserve(std::min(scores.size(), chunks.size() * maxSize));
+    for (const auto& c : chunks) {
+        auto begin = scores.begin() + c.first;
+        candidates.insert(candidates.end(), std::make_move_iterator(begin), std::make_move_iterator(begin + std::min(c.second - c.first, maxSize)));
+    }
+
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(std::min(maxSize, candidates.size()));
+    std::partial_sort(candidates.begin(), candidates.begin() + result.size(), candidates.end(), CompareScoresDescending);
     for (size_t i = 0; i < result.size(); i++) {
-        result[i] = std::move(scores[i].second);
+        result[i] = std::move(candidates[i].second);
     }
     return result;
 }
@@ -277,17 +347,23 @@ std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList
             // future quorums
             return;
         }
-        // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
-        // Please note that this is not a double-sha256 but a single-sha256
-        // The first part is already precalculated (confirmedHashWithProRegTxHash)
-        // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
+        scores.emplace_back(arith_uint256(), dmn);
+    });
+
+    ForEachChunkParallel(deterministicMNManager ? deterministicMNManager->GetScoresPool() : nullptr, scores.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto& dmn = scores[i].second;
+            // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
+            // Please note that this is not a double-sha256 but a single-sha256
+            // The first part is already precalculated (confirmedHashWithProRegTxHash)
+            // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
+            uint256 h;
+            CSHA256 sha256;
+            sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
+            sha256.Write(modifier.begin(), modifier.size());
+            sha256.Finalize(h.begin());
+            scores[i].first = UintToArith256(h);
+        }
     });
 
     return scores;
@@ -357,7 +433,7 @@ CDeterministicMNListDiff CDeterministicMNList::BuildDiff(const CDeterministicMNL
         auto fromPtr = GetMN(toPtr->proTxHash);
         if (fromPtr == nullptr) {
             diffRet.addedMNs.emplace(toPtr->proTxHash, toPtr);
-        } else if (*toPtr->pdmnState != *fromPtr->pdmnState) {
+        } else if (toPtr->pdmnState != fromPtr->pdmnState && *toPtr->pdmnState != *fromPtr->pdmnState) {
             diffRet.updatedMNs.emplace(toPtr->proTxHash, toPtr->pdmnState);
         }
     });
@@ -401,7 +477,8 @@ CSimplifiedMNListDiff CDeterministicMNList::BuildSimplifiedDiff(const CDetermini
 
 CDeterministicMNList CDeterministicMNList::ApplyDiff(const CDeterministicMNListDiff& diff) const
 {
-    assert(diff.prevBlockHash == blockHash && diff.nHeight == nHeight + 1);
+    // compacted diffs span multiple blocks
+    assert(diff.prevBlockHash == blockHash && diff.nHeight > nHeight);
 
     CDeterministicMNList result = *this;
     result.blockHash = diff.blockHash;
@@ -410,11 +487,32 @@ CDeterministicMNList CDeterministicMNList::ApplyDiff(const CDeterministicMNListD
     for (const auto& hash : diff.removedMns) {
         result.RemoveMN(hash);
     }
+
+    if (diff.nHeight == nHeight + 1) {
+        for (const auto& p : diff.addedMNs) {
+            result.AddMN(p.second);
+        }
+        for (const auto& p : diff.updatedMNs) {
+            result.UpdateMN(p.first, p.second);
+        }
+        return result;
+    }
+
+    // Over multiple blocks, unique properties might have moved between MNs (e.g. two MNs swapping addresses), so
+    // updating MNs one by one could temporarily produce duplicates. Remove all updated MNs first and then re-add them.
+    std::vector<CDeterministicMNCPtr> updatedDmns;
+    updatedDmns.reserve(diff.updatedMNs.size());
+    for (const auto& p : diff.updatedMNs) {
+        auto dmn = std::make_shared<CDeterministicMN>(*result.GetMN(p.first));
+        dmn->pdmnState = p.second;
+        updatedDmns.emplace_back(dmn);
+        result.RemoveMN(p.first);
+    }
     for (const auto& p : diff.addedMNs) {
         result.AddMN(p.second);
     }
-    for (const auto& p : diff.updatedMNs) {
-        result.UpdateMN(p.first, p.second);
+    for (const auto& dmn : updatedDmns) {
+        result.AddMN(dmn);
     }
 
     return result;
@@ -466,6 +564,15 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
     evoDb(_evoDb)
 {
+    int nThreads = std::min((int)std::thread::hardware_concurrency(), SCORES_MAX_THREADS) - 1;
+    if (nThreads > 0) {
+        scoresPool.Start(nThreads, "cbdhealthnetwork-mnscores");
+    }
+}
+
+CDeterministicMNManager::~CDeterministicMNManager()
+{
+    scoresPool.Stop(false);
 }
 
 bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& _state, bool fJustCheck)
@@ -508,6 +615,13 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, diff.blockHash), newList);
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                 __func__, nHeight, newList.GetAllMNsCount());
+        } else {
+            int nSpan = GetCompactedDiffSpan(nHeight);
+            if (nSpan > 1 && nHeight - nSpan >= consensusParams.DIP0003Height) {
+                // the base list is usually still in the cache
+                auto baseList = GetListForBlock(pindex->GetAncestor(nHeight - nSpan)->GetBlockHash());
+                evoDb.Write(std::make_pair(DB_LIST_DIFF_COMPACTED, diff.blockHash), baseList.BuildDiff(newList));
+            }
         }
     }
 
@@ -551,6 +665,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
         }
 
         evoDb.Erase(std::make_pair(DB_LIST_DIFF, blockHash));
+        evoDb.Erase(std::make_pair(DB_LIST_DIFF_COMPACTED, blockHash));
         evoDb.Erase(std::make_pair(DB_LIST_SNAPSHOT, blockHash));
 
         mnListsCache.erase(blockHash);
@@ -870,8 +985,10 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const uint256& blo
             break;
         }
 
+        // prefer compacted diffs, as these skip over multiple blocks
         CDeterministicMNListDiff diff;
-        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, blockHashTmp), diff)) {
+        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF_COMPACTED, blockHashTmp), diff) &&
+            !evoDb.Read(std::make_pair(DB_LIST_DIFF, blockHashTmp), diff)) {
             snapshot = CDeterministicMNList(blockHashTmp, -1);
             mnListsCache.emplace(blockHashTmp, snapshot);
             break;
@@ -901,6 +1018,33 @@ CDeterministicMNList CDeterministicMNManager::GetListAtChainTip()
     return GetListForBlock(tipBlockHash);
 }
 
+CDeterministicMNManager::Stats CDeterministicMNManager::GetCacheStats()
+{
+    LOCK(cs);
+
+    std::unordered_set<const CDeterministicMN*> seenMNs;
+    std::unordered_set<const CDeterministicMNState*> seenStates;
+    Stats stats{mnListsCache.size(), 0, 0, 0};
+    stats.nUsage = memusage::DynamicUsage(mnListsCache);
+
+    for (const auto& p : mnListsCache) {
+        p.second.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            if (seenMNs.emplace(dmn.get()).second) {
+                stats.nUsage += memusage::MallocUsage(sizeof(CDeterministicMN));
+            }
+            if (seenStates.emplace(dmn->pdmnState.get()).second) {
+                stats.nUsage += memusage::MallocUsage(sizeof(CDeterministicMNState));
+                stats.nUsage += memusage::DynamicUsage(dmn->pdmnState->scriptPayout);
+                stats.nUsage += memusage::DynamicUsage(dmn->pdmnState->scriptOperatorPayout);
+            }
+        });
+    }
+    stats.nUniqueMNs = seenMNs.size();
+    stats.nUniqueStates = seenStates.size();
+
+    return stats;
+}
+
 bool CDeterministicMNManager::IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n)
 {
     if (tx->nVersion != 3 || tx->nType != TRANSACTION_PROVIDER_REGISTER) {
@@ -948,3 +1092,12 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
         mnListsCache.erase(h);
     }
 }
+
+int CDeterministicMNManager::GetCompactedDiffSpan(int nHeight)
+{
+    int nRel = nHeight % SNAPSHOT_LIST_PERIOD;
+    if (nRel == 0) {
+        return 1;
+    }
+    return nRel & -nRel;
+}
@@ -12,6 +12,7 @@
 #include "providertx.h"
 #include "simplifiedmns.h"
 #include "sync.h"
+#include "workstealingpool.h"
 
 #include "immer/map.hpp"
 #include "immer/map_transient.hpp"
@@ -479,6 +480,13 @@ class CDeterministicMNManager
     static const int LISTS_CACHE_SIZE = 576;
 
 public:
+    struct Stats {
+        size_t nCachedLists;
+        size_t nUniqueMNs;
+        size_t nUniqueStates;
+        size_t nUsage;
+    };
+
     CCriticalSection cs;
 
 private:
@@ -488,8 +496,16 @@ private:
     int tipHeight{-1};
     uint256 tipBlockHash;
 
+    // Helps with scoring large MN lists, see CDeterministicMNList::CalculateScores. Started once, so that no threads
+    // have to be created while blocks are validated
+    CWorkStealingPool scoresPool;
+
 public:
     CDeterministicMNManager(CEvoDB& _evoDb);
+    ~CDeterministicMNManager();
+
+    // nullptr if there are no threads to help with scoring
+    CWorkStealingPool* GetScoresPool() { return scoresPool.Size() != 0 ? &scoresPool : nullptr; }
 
     bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck);
     bool UndoBlock(const CBlock& block, const CBlockIndex* pindex);
@@ -504,6 +520,12 @@ public:
     CDeterministicMNList GetListForBlock(const uint256& blockHash);
     CDeterministicMNList GetListAtChainTip();
 
+    /**
+     * Approximate memory used by the in-memory lists cache. Lists in the cache share unchanged MN entries and states,
+     * so these are only counted once.
+     */
+    Stats GetCacheStats();
+
     // Test if given TX is a ProRegTx which also contains the collateral at index n
     bool IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n);
 
@@ -511,6 +533,13 @@ public:
 
 private:
     void CleanupCache(int nHeight);
+
+    /**
+     * Besides the per block diffs, we store compacted diffs which span from an ancestor block to the current block.
+     * The span is the lowest set bit of the height relative to the last snapshot, so any list can be reached from the
+     * last snapshot by applying at most log2(SNAPSHOT_LIST_PERIOD) diffs. Returns 1 when no compacted diff is needed.
+     */
+    static int GetCompactedDiffSpan(int nHeight);
 };
 
 extern CDeterministicMNManager* deterministicMNManager;
@@ -14,9 +14,13 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "consensus/merkle.h"
+#include "hash.h"
 #include "univalue.h"
 #include "validation.h"
 
+#include <algorithm>
+#include <limits>
+
 CSimplifiedMNListEntry::CSimplifiedMNListEntry(const CDeterministicMN& dmn) :
     proRegTxHash(dmn.proTxHash),
     confirmedHash(dmn.pdmnState->confirmedHash),
@@ -88,6 +92,134 @@ uint256 CSimplifiedMNList::CalcMerkleRoot(bool* pmutated) const
     return ComputeMerkleRoot(leaves, pmutated);
 }
 
+CSimplifiedMNListMerkleTree::CSimplifiedMNListMerkleTree() :
+    levels(1)
+{
+}
+
+CSimplifiedMNListMerkleTree::CSimplifiedMNListMerkleTree(const CDeterministicMNList& dmnList) :
+    levels(1)
+{
+    CSimplifiedMNList sml(dmnList);
+    proRegTxHashes.reserve(sml.mnList.size());
+    levels[0].reserve(sml.mnList.size());
+    for (const auto& e : sml.mnList) {
+        proRegTxHashes.emplace_back(e->proRegTxHash);
+        levels[0].emplace_back(e->CalcHash());
+    }
+    Recalc({}, 0);
+}
+
+void CSimplifiedMNListMerkleTree::ApplyDiff(const CDeterministicMNList& newList, const CDeterministicMNListDiff& diff)
+{
+    size_t nFirstChanged = std::numeric_limits<size_t>::max();
+
+    if (!diff.addedMNs.empty() || !diff.removedMns.empty()) {
+        // merge the added entries into the sorted leaves, all leaves after the first added/removed one move
+        std::vector<uint256> newProRegTxHashes;
+        std::vector<uint256> newLeaves;
+        newProRegTxHashes.reserve(proRegTxHashes.size() + diff.addedMNs.size());
+        newLeaves.reserve(proRegTxHashes.size() + diff.addedMNs.size());
+
+        auto itAdded = diff.addedMNs.begin();
+        auto addNext = [&]() {
+            nFirstChanged = std::min(nFirstChanged, newLeaves.size());
+            newProRegTxHashes.emplace_back(itAdded->first);
+            newLeaves.emplace_back(CSimplifiedMNListEntry(*itAdded->second).CalcHash());
+            ++itAdded;
+        };
+        for (size_t i = 0; i < proRegTxHashes.size(); i++) {
+            while (itAdded != diff.addedMNs.end() && itAdded->first < proRegTxHashes[i]) {
+                addNext();
+            }
+            if (diff.removedMns.count(proRegTxHashes[i])) {
+                nFirstChanged = std::min(nFirstChanged, newLeaves.size());
+                continue;
+            }
+            newProRegTxHashes.emplace_back(proRegTxHashes[i]);
+            newLeaves.emplace_back(levels[0][i]);
+        }
+        while (itAdded != diff.addedMNs.end()) {
+            addNext();
+        }
+
+        proRegTxHashes = std::move(newProRegTxHashes);
+        levels[0] = std::move(newLeaves);
+    }
+
+    // most updates (e.g. payments and PoSe penalties) don't touch the fields of the SML entry
+    std::vector<size_t> vDirty;
+    for (const auto& p : diff.updatedMNs) {
+        auto it = std::lower_bound(proRegTxHashes.begin(), proRegTxHashes.end(), p.first);
+        assert(it != proRegTxHashes.end() && *it == p.first);
+        size_t idx = it - proRegTxHashes.begin();
+        uint256 leaf = CSimplifiedMNListEntry(*newList.GetMN(p.first)).CalcHash();
+        if (leaf != levels[0][idx]) {
+            levels[0][idx] = leaf;
+            vDirty.emplace_back(idx);
+        }
+    }
+    // updatedMNs is a map sorted by proRegTxHash, so vDirty is sorted as well
+
+    Recalc(std::move(vDirty), nFirstChanged);
+}
+
+void CSimplifiedMNListMerkleTree::Recalc(std::vector<size_t> vDirty, size_t nFirstChanged)
+{
+    // Same rules as ComputeMerkleRoot: on levels with an odd number of hashes the last hash is paired with itself
+    size_t l = 0;
+    while (levels[l].size() > 1) {
+        if (levels.size() == l + 1) {
+            levels.emplace_back();
+        }
+        const auto& cur = levels[l];
+        auto& next = levels[l + 1];
+        next.resize((cur.size() + 1) / 2);
+
+        auto calcNode = [&](size_t i) {
+            const uint256& left = cur[i * 2];
+            const uint256& right = i * 2 + 1 < cur.size() ? cur[i * 2 + 1] : left;
+            next[i] = Hash(left.begin(), left.end(), right.begin(), right.end());
+        };
+
+        nFirstChanged = std::min(nFirstChanged / 2, next.size());
+        std::vector<size_t> vNextDirty;
+        for (size_t i : vDirty) {
+            size_t parent = i / 2;
+            if (parent < nFirstChanged && (vNextDirty.empty() || vNextDirty.back() != parent)) {
+                calcNode(parent);
+                vNextDirty.emplace_back(parent);
+            }
+        }
+        for (size_t i = nFirstChanged; i < next.size(); i++) {
+            calcNode(i);
+        }
+
+        vDirty = std::move(vNextDirty);
+        l++;
+    }
+    levels.resize(l + 1);
+}
+
+uint256 CSimplifiedMNListMerkleTree::GetMerkleRoot(bool* pmutated) const
+{
+    if (pmutated) {
+        // see the comment about CVE-2012-2459 in consensus/merkle.cpp
+        *pmutated = false;
+        for (size_t l = 0; l + 1 < levels.size(); l++) {
+            for (size_t i = 0; i + 1 < levels[l].size(); i += 2) {
+                if (levels[l][i] == levels[l][i + 1]) {
+                    *pmutated = true;
+                }
+            }
+        }
+    }
+    if (levels[0].empty()) {
+        return uint256();
+    }
+    return levels.back()[0];
+}
+
 CSimplifiedMNListDiff::CSimplifiedMNListDiff()
 {
 }
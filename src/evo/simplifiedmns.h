@@ -14,6 +14,7 @@
 
 class UniValue;
 class CDeterministicMNList;
+class CDeterministicMNListDiff;
 class CDeterministicMN;
 
 namespace llmq
@@ -84,6 +85,32 @@ public:
     uint256 CalcMerkleRoot(bool* pmutated = NULL) const;
 };
 
+/**
+ * Keeps all levels of the merkle tree over the SML entry hashes (sorted by proRegTxHash), so that it can be updated from
+ * a CDeterministicMNListDiff by only re-hashing the changed leaves and their paths. The root is the same as the one
+ * calculated by CSimplifiedMNList::CalcMerkleRoot.
+ */
+class CSimplifiedMNListMerkleTree
+{
+private:
+    std::vector<uint256> proRegTxHashes;
+    // levels[0] are the leaves, levels.back() is the root
+    std::vector<std::vector<uint256>> levels;
+
+public:
+    CSimplifiedMNListMerkleTree();
+    CSimplifiedMNListMerkleTree(const CDeterministicMNList& dmnList);
+
+    // newList is the list the diff was built against
+    void ApplyDiff(const CDeterministicMNList& newList, const CDeterministicMNListDiff& diff);
+
+    uint256 GetMerkleRoot(bool* pmutated = NULL) const;
+
+private:
+    // all leaves from nFirstChanged on and the leaves in vDirty (sorted) have changed
+    void Recalc(std::vector<size_t> vDirty, size_t nFirstChanged);
+};
+
 /// P2P messages
 
 class CGetSimplifiedMNListDiff
@@ -0,0 +1,431 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_FLATHASHMAP_H
+#define CHN_FLATHASHMAP_H
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdint.h>
+#include <tuple>
+#include <utility>
+
+/* Open addressing hash map which stores all entries in a single flat array.
+ *
+ * Compared to std::unordered_map, there is no heap allocation per entry and no bucket array of pointers. Lookups
+ * probe linearly through a separate array of one byte per slot, which holds 7 bits of the hash of occupied slots, so
+ * that most mismatches are resolved without touching the (much larger) entries themselves.
+ *
+ * Supports the subset of the std::unordered_map interface that is needed by CCoinsViewCache, with these differences:
+ * - Inserting may move existing entries and thus invalidates all iterators, pointers and references.
+ * - Erasing never moves other entries, so "map.erase(it++)" is fine while iterating.
+ * - clear() keeps the allocated table, so that a cache that is cleared after flushing does not need to grow again.
+ * - set_growth_limit() caps how far the table grows on its own (see below).
+ */
+template <class K, class T, class Hash = std::hash<K> >
+class flathashmap
+{
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<const K, T> value_type;
+    typedef size_t size_type;
+
+private:
+    // Control bytes of occupied slots have the highest bit cleared and store the lower 7 bits of the hash
+    static const uint8_t CTRL_EMPTY = 0x80;
+    static const uint8_t CTRL_DELETED = 0xfe;
+    static const size_t MIN_CAPACITY = 16;
+
+    // Maximum load factor (including deleted slots) is MAX_LOAD_NUM / MAX_LOAD_DEN
+    static const size_t MAX_LOAD_NUM = 7;
+    static const size_t MAX_LOAD_DEN = 8;
+
+    Hash hasher;
+    uint8_t* ctrl{nullptr};
+    value_type* slots{nullptr};
+    size_t nCapacity{0};
+    size_t nSize{0};
+    size_t nDeleted{0};
+    size_t nGrowthLimit{0};
+
+    template <bool IsConst>
+    class iterator_base
+    {
+        friend class flathashmap;
+        template <bool> friend class iterator_base;
+        typedef typename std::conditional<IsConst, const flathashmap*, flathashmap*>::type map_pointer;
+
+        map_pointer map{nullptr};
+        size_t idx{0};
+
+        iterator_base(map_pointer _map, size_t _idx) : map(_map), idx(_idx) {}
+
+        void SkipFree()
+        {
+            while (idx < map->nCapacity && !IsFull(map->ctrl[idx])) {
+                idx++;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename flathashmap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<IsConst, const value_type*, value_type*>::type pointer;
+        typedef typename std::conditional<IsConst, const value_type&, value_type&>::type reference;
+
+        iterator_base() {}
+        // allow conversion from iterator to const_iterator
+        template <bool OtherConst, typename = typename std::enable_if<IsConst || !OtherConst>::type>
+        iterator_base(const iterator_base<OtherConst>& o) : map(o.map), idx(o.idx) {}
+
+        reference operator*() const { return map->slots[idx]; }
+        pointer operator->() const { return &map->slots[idx]; }
+
+        iterator_base& operator++()
+        {
+            idx++;
+            SkipFree();
+            return *this;
+        }
+        iterator_base operator++(int)
+        {
+            iterator_base tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        template <bool OtherConst>
+        bool operator==(const iterator_base<OtherConst>& o) const { return idx == o.idx && map == o.map; }
+        template <bool OtherConst>
+        bool operator!=(const iterator_base<OtherConst>& o) const { return !(*this == o); }
+    };
+
+public:
+    typedef iterator_base<false> iterator;
+    typedef iterator_base<true> const_iterator;
+
+    explicit flathashmap(const Hash& _hasher = Hash()) : hasher(_hasher) {}
+
+    flathashmap(const flathashmap& o) : hasher(o.hasher), nGrowthLimit(o.nGrowthLimit)
+    {
+        if (o.nSize != 0) {
+            Rehash(o.nCapacity, &o);
+        }
+    }
+
+    flathashmap(flathashmap&& o) noexcept : hasher(o.hasher)
+    {
+        swap(o);
+    }
+
+    ~flathashmap()
+    {
+        DestroyAll();
+        Deallocate(ctrl, slots);
+    }
+
+    flathashmap& operator=(flathashmap o)
+    {
+        swap(o);
+        return *this;
+    }
+
+    iterator begin() { iterator it(this, 0); it.SkipFree(); return it; }
+    const_iterator begin() const { const_iterator it(this, 0); it.SkipFree(); return it; }
+    const_iterator cbegin() const { return begin(); }
+    iterator end() { return iterator(this, nCapacity); }
+    const_iterator end() const { return const_iterator(this, nCapacity); }
+    const_iterator cend() const { return end(); }
+
+    size_type size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+    // Number of slots in the table, including free ones
+    size_type capacity() const { return nCapacity; }
+
+    iterator find(const K& key)
+    {
+        return iterator(this, FindIndex(key, hasher(key)));
+    }
+    const_iterator find(const K& key) const
+    {
+        return const_iterator(this, FindIndex(key, hasher(key)));
+    }
+    size_type count(const K& key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    template <typename KArg, typename... VArgs>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t, std::tuple<KArg> keyArgs, std::tuple<VArgs...> valueArgs)
+    {
+        const K& key = std::get<0>(keyArgs);
+        return EmplaceImpl(key, [&](value_type* p) {
+            new (p) value_type(std::piecewise_construct, std::move(keyArgs), std::move(valueArgs));
+        });
+    }
+
+    template <typename KArg, typename VArg>
+    std::pair<iterator, bool> emplace(KArg&& key, VArg&& v)
+    {
+        const K& k = key;
+        return EmplaceImpl(k, [&](value_type* p) {
+            new (p) value_type(std::forward<KArg>(key), std::forward<VArg>(v));
+        });
+    }
+
+    std::pair<iterator, bool> insert(const value_type& v)
+    {
+        return EmplaceImpl(v.first, [&](value_type* p) {
+            new (p) value_type(v);
+        });
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+        return EmplaceImpl(key, [&](value_type* p) {
+            new (p) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    T& operator[](const K& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_t idx = pos.idx;
+        slots[idx].~value_type();
+        nSize--;
+        // If the next slot is empty, no probe sequence can continue past this slot, so we don't need a tombstone
+        size_t next = idx + 1 == nCapacity ? 0 : idx + 1;
+        if (ctrl[next] == CTRL_EMPTY) {
+            ctrl[idx] = CTRL_EMPTY;
+        } else {
+            ctrl[idx] = CTRL_DELETED;
+            nDeleted++;
+        }
+        iterator it(this, idx);
+        ++it;
+        return it;
+    }
+
+    size_type erase(const K& key)
+    {
+        const_iterator it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    // Removes all entries but keeps the allocated table
+    void clear()
+    {
+        DestroyAll();
+        if (nCapacity != 0) {
+            memset(ctrl, CTRL_EMPTY, nCapacity);
+        }
+        nSize = 0;
+        nDeleted = 0;
+    }
+
+    // Makes sure that n entries can be stored without reallocating the table
+    void reserve(size_type n)
+    {
+        size_t needed = CapacityForSize(n);
+        if (needed > nCapacity) {
+            Rehash(needed);
+        }
+    }
+
+    // Once the table reaches nSlots, it is not grown further by doubling but only by the smallest amount that makes
+    // room for the next entry. This lets users that limit the memory usage of the map (e.g. the coins cache) use
+    // (nearly) all of their budget instead of having the last doubling overshoot it. 0 means no limit.
+    void set_growth_limit(size_type nSlots) { nGrowthLimit = nSlots; }
+    size_type growth_limit() const { return nGrowthLimit; }
+
+    void swap(flathashmap& o)
+    {
+        std::swap(hasher, o.hasher);
+        std::swap(ctrl, o.ctrl);
+        std::swap(slots, o.slots);
+        std::swap(nCapacity, o.nCapacity);
+        std::swap(nSize, o.nSize);
+        std::swap(nDeleted, o.nDeleted);
+        std::swap(nGrowthLimit, o.nGrowthLimit);
+    }
+
+    // Heap usage of the table, without any dynamic usage of the entries themselves
+    size_t table_bytes() const
+    {
+        return nCapacity * (sizeof(value_type) + 1);
+    }
+
+private:
+    static bool IsFull(uint8_t c) { return (c & 0x80) == 0; }
+    static uint8_t CtrlFromHash(size_t h) { return (uint8_t)(h & 0x7f); }
+
+    static size_t CapacityForSize(size_t n)
+    {
+        size_t c = n * MAX_LOAD_DEN / MAX_LOAD_NUM + 1;
+        return c < MIN_CAPACITY ? MIN_CAPACITY : c;
+    }
+
+    // Maps the hash to [0, n) by multiply-shift instead of a modulo, so that the capacity doesn't need to be a power
+    // of two. This uses the upper bits of the hash, while the control byte uses the lower bits.
+    static size_t Reduce(size_t h, size_t n)
+    {
+#if defined(__SIZEOF_INT128__)
+        if (sizeof(size_t) == 8) {
+            return (size_t)(((unsigned __int128)h * n) >> 64);
+        }
+#endif
+        if (sizeof(size_t) == 4) {
+            return (size_t)(((uint64_t)h * n) >> 32);
+        }
+        return h % n;
+    }
+
+    size_t NextIndex(size_t idx) const
+    {
+        return idx + 1 == nCapacity ? 0 : idx + 1;
+    }
+
+    size_t FindIndex(const K& key, size_t h) const
+    {
+        if (nSize == 0) {
+            return nCapacity;
+        }
+        uint8_t c = CtrlFromHash(h);
+        // Terminates because the load factor guarantees at least one empty slot
+        for (size_t idx = Reduce(h, nCapacity); ; idx = NextIndex(idx)) {
+            if (ctrl[idx] == c && slots[idx].first == key) {
+                return idx;
+            }
+            if (ctrl[idx] == CTRL_EMPTY) {
+                return nCapacity;
+            }
+        }
+    }
+
+    size_t FindFreeIndex(size_t h) const
+    {
+        size_t idx = Reduce(h, nCapacity);
+        while (IsFull(ctrl[idx])) {
+            idx = NextIndex(idx);
+        }
+        return idx;
+    }
+
+    template <typename Construct>
+    std::pair<iterator, bool> EmplaceImpl(const K& key, Construct&& construct)
+    {
+        size_t h = hasher(key);
+        size_t idx = FindIndex(key, h);
+        if (idx != nCapacity) {
+            return std::make_pair(iterator(this, idx), false);
+        }
+        if ((nSize + nDeleted + 1) * MAX_LOAD_DEN > nCapacity * MAX_LOAD_NUM) {
+            Grow();
+        }
+        idx = FindFreeIndex(h);
+        construct(&slots[idx]);
+        if (ctrl[idx] == CTRL_DELETED) {
+            nDeleted--;
+        }
+        ctrl[idx] = CtrlFromHash(h);
+        nSize++;
+        return std::make_pair(iterator(this, idx), true);
+    }
+
+    void Grow()
+    {
+        size_t needed = CapacityForSize(nSize + 1);
+        size_t newCapacity;
+        if ((nSize + 1) * 2 <= nCapacity) {
+            // mostly tombstones, clean them up without growing
+            newCapacity = nCapacity;
+        } else {
+            newCapacity = std::max(needed, nCapacity * 2);
+            if (nGrowthLimit != 0 && newCapacity > nGrowthLimit) {
+                newCapacity = std::max(needed, std::max(nGrowthLimit, nCapacity + nCapacity / 8));
+            }
+        }
+        Rehash(newCapacity);
+    }
+
+    static void Allocate(size_t n, uint8_t*& ctrlRet, value_type*& slotsRet)
+    {
+        slotsRet = static_cast<value_type*>(::operator new(n * sizeof(value_type)));
+        try {
+            ctrlRet = new uint8_t[n];
+        } catch (...) {
+            ::operator delete(slotsRet);
+            throw;
+        }
+        memset(ctrlRet, CTRL_EMPTY, n);
+    }
+
+    static void Deallocate(uint8_t* _ctrl, value_type* _slots)
+    {
+        delete[] _ctrl;
+        ::operator delete(_slots);
+    }
+
+    void DestroyAll()
+    {
+        for (size_t i = 0; i < nCapacity && nSize != 0; i++) {
+            if (IsFull(ctrl[i])) {
+                slots[i].~value_type();
+                nSize--;
+            }
+        }
+    }
+
+    // Moves (or copies from "from") all entries into a new table with newCapacity slots
+    void Rehash(size_t newCapacity, const flathashmap* from = nullptr)
+    {
+        uint8_t* newCtrl;
+        value_type* newSlots;
+        Allocate(newCapacity, newCtrl, newSlots);
+
+        const flathashmap& src = from ? *from : *this;
+        size_t newSize = 0;
+        for (size_t i = 0; i < src.nCapacity; i++) {
+            if (!IsFull(src.ctrl[i])) {
+                continue;
+            }
+            size_t h = hasher(src.slots[i].first);
+            size_t idx = Reduce(h, newCapacity);
+            while (newCtrl[idx] != CTRL_EMPTY) {
+                idx = idx + 1 == newCapacity ? 0 : idx + 1;
+            }
+            if (from) {
+                new (&newSlots[idx]) value_type(src.slots[i]);
+            } else {
+                new (&newSlots[idx]) value_type(std::move(slots[i]));
+                slots[i].~value_type();
+            }
+            newCtrl[idx] = CtrlFromHash(h);
+            newSize++;
+        }
+
+        Deallocate(ctrl, slots);
+        ctrl = newCtrl;
+        slots = newSlots;
+        nCapacity = newCapacity;
+        nSize = newSize;
+        nDeleted = 0;
+    }
+};
+
+#endif // CHN_FLATHASHMAP_H
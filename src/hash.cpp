@@ -7,6 +7,8 @@
 #include "crypto/hmac_sha512.h"
 #include "pubkey.h"
 
+#include <algorithm>
+
 
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
@@ -249,3 +251,84 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+void HashX11Batch(const unsigned char* pdata, size_t nLen, size_t nCount, uint256* pout)
+{
+    sph_blake512_context     ctx_blake;
+    sph_bmw512_context       ctx_bmw;
+    sph_groestl512_context   ctx_groestl;
+    sph_jh512_context        ctx_jh;
+    sph_keccak512_context    ctx_keccak;
+    sph_skein512_context     ctx_skein;
+    sph_luffa512_context     ctx_luffa;
+    sph_cubehash512_context  ctx_cubehash;
+    sph_shavite512_context   ctx_shavite;
+    sph_simd512_context      ctx_simd;
+    sph_echo512_context      ctx_echo;
+
+    // two sets of lanes, each stage reads from one and writes into the other
+    uint512 a[X11_BATCH_LANES];
+    uint512 b[X11_BATCH_LANES];
+
+    for (size_t nStart = 0; nStart < nCount; nStart += X11_BATCH_LANES) {
+        const size_t nLanes = std::min(X11_BATCH_LANES, nCount - nStart);
+        size_t i;
+
+        for (i = 0; i < nLanes; i++) {
+            sph_blake512_init(&ctx_blake);
+            sph_blake512(&ctx_blake, pdata + (nStart + i) * nLen, nLen);
+            sph_blake512_close(&ctx_blake, static_cast<void*>(&a[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_bmw512_init(&ctx_bmw);
+            sph_bmw512(&ctx_bmw, static_cast<const void*>(&a[i]), 64);
+            sph_bmw512_close(&ctx_bmw, static_cast<void*>(&b[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_groestl512_init(&ctx_groestl);
+            sph_groestl512(&ctx_groestl, static_cast<const void*>(&b[i]), 64);
+            sph_groestl512_close(&ctx_groestl, static_cast<void*>(&a[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_skein512_init(&ctx_skein);
+            sph_skein512(&ctx_skein, static_cast<const void*>(&a[i]), 64);
+            sph_skein512_close(&ctx_skein, static_cast<void*>(&b[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_jh512_init(&ctx_jh);
+            sph_jh512(&ctx_jh, static_cast<const void*>(&b[i]), 64);
+            sph_jh512_close(&ctx_jh, static_cast<void*>(&a[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_keccak512_init(&ctx_keccak);
+            sph_keccak512(&ctx_keccak, static_cast<const void*>(&a[i]), 64);
+            sph_keccak512_close(&ctx_keccak, static_cast<void*>(&b[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_luffa512_init(&ctx_luffa);
+            sph_luffa512(&ctx_luffa, static_cast<const void*>(&b[i]), 64);
+            sph_luffa512_close(&ctx_luffa, static_cast<void*>(&a[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_cubehash512_init(&ctx_cubehash);
+            sph_cubehash512(&ctx_cubehash, static_cast<const void*>(&a[i]), 64);
+            sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&b[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_shavite512_init(&ctx_shavite);
+            sph_shavite512(&ctx_shavite, static_cast<const void*>(&b[i]), 64);
+            sph_shavite512_close(&ctx_shavite, static_cast<void*>(&a[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_simd512_init(&ctx_simd);
+            sph_simd512(&ctx_simd, static_cast<const void*>(&a[i]), 64);
+            sph_simd512_close(&ctx_simd, static_cast<void*>(&b[i]));
+        }
+        for (i = 0; i < nLanes; i++) {
+            sph_echo512_init(&ctx_echo);
+            sph_echo512(&ctx_echo, static_cast<const void*>(&b[i]), 64);
+            sph_echo512_close(&ctx_echo, static_cast<void*>(&a[i]));
+            pout[nStart + i] = a[i].trim256();
+        }
+    }
+}
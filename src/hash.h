@@ -378,4 +378,14 @@ inline uint256 HashX11(const T1 pbegin, const T1 pend)
     return hash[10].trim256();
 }
 
+/** Number of inputs HashX11Batch pushes through one stage before moving on to the next */
+static const size_t X11_BATCH_LANES = 16;
+
+/** Compute the X11 hashes of nCount inputs of nLen bytes each, stored back to back at pdata.
+ *  Unlike calling HashX11 in a loop, every one of the eleven stages is run over a whole group of
+ *  up to X11_BATCH_LANES inputs before the next stage starts, so the code and lookup tables of
+ *  each sph_* function stay hot in cache. The results are identical to HashX11.
+ */
+void HashX11Batch(const unsigned char* pdata, size_t nLen, size_t nCount, uint256* pout);
+
 #endif // BITCOIN_HASH_H
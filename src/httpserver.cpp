@@ -606,10 +606,30 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
-    // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
+    SendReply(nStatus);
+}
+
+void HTTPRequest::WriteReply(int nStatus, std::vector<unsigned char>&& reply)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    if (!reply.empty()) {
+        // The buffer references the bytes until they are sent and frees them afterwards
+        std::vector<unsigned char>* data = new std::vector<unsigned char>(std::move(reply));
+        evbuffer_add_reference(evb, data->data(), data->size(), [](const void*, size_t, void* extra) {
+            delete static_cast<std::vector<unsigned char>*>(extra);
+        }, data);
+    }
+    SendReply(nStatus);
+}
+
+void HTTPRequest::SendReply(int nStatus)
+{
+    // Send event to main http thread to send reply message
     HTTPEvent* ev = new HTTPEvent(eventBase, true,
         std::bind(evhttp_send_reply, req, nStatus, (const char*)NULL, (struct evbuffer *)NULL));
     ev->trigger(0);
@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -56,6 +57,9 @@ private:
     struct evhttp_request* req;
     bool replySent;
 
+    /** Sends the reply whose body was added to the output buffer already */
+    void SendReply(int nStatus);
+
 public:
     HTTPRequest(struct evhttp_request* req);
     ~HTTPRequest();
@@ -110,6 +114,10 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+    /**
+     * Write HTTP reply without copying the body, the request takes ownership of reply.
+     */
+    void WriteReply(int nStatus, std::vector<unsigned char>&& reply);
 };
 
 /** Event handler closure.
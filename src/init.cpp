@@ -14,13 +14,16 @@
 #include "addrman.h"
 #include "amount.h"
 #include "base58.h"
+#include "blockfilemap.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
+#include "coinsprefetch.h"
 #include "compat/sanity.h"
 #include "consensus/validation.h"
 #include "httpserver.h"
 #include "httprpc.h"
+#include "insightindexer.h"
 #include "key.h"
 #include "validation.h"
 #include "miner.h"
@@ -40,6 +43,7 @@
 #include "ui_interface.h"
 #include "util.h"
 #include "utilmoneystr.h"
+#include "utxosnapshot.h"
 #include "validationinterface.h"
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
@@ -236,7 +240,6 @@ void PrepareShutdown()
     StopREST();
     StopRPC();
     StopHTTPServer();
-    llmq::StopLLMQSystem();
 
     // fRPCInWarmup should be `false` if we completed the loading sequence
     // before a shutdown request was received
@@ -259,6 +262,8 @@ void PrepareShutdown()
         // make sure to stop all threads before g_connman is reset to nullptr as these threads might still be accessing it
         g_connman->Stop();
     }
+    // after the network, so that no message handler waits for BLS verifications anymore
+    llmq::StopLLMQSystem();
     g_connman.reset();
 
     if (!fLiteMode && !fRPCInWarmup) {
@@ -293,6 +298,15 @@ void PrepareShutdown()
         fFeeEstimatesInitialized = false;
     }
 
+    if (pinsightindexer) {
+        UnregisterValidationInterface(pinsightindexer);
+        // Deleted after the last flush, which must not prune the blocks it didn't index yet
+        pinsightindexer->Stop();
+    }
+    if (psnapshotvalidator) {
+        psnapshotvalidator->Stop();
+    }
+
     {
         LOCK(cs_main);
         if (pcoinsTip != NULL) {
@@ -300,10 +314,18 @@ void PrepareShutdown()
         }
         delete pcoinsTip;
         pcoinsTip = NULL;
+        delete pcoinsPrefetch;
+        pcoinsPrefetch = NULL;
         delete pcoinscatcher;
         pcoinscatcher = NULL;
         delete pcoinsdbview;
         pcoinsdbview = NULL;
+        delete pinsightindexer;
+        pinsightindexer = NULL;
+        delete psnapshotvalidator;
+        psnapshotvalidator = NULL;
+        delete pinsightindex;
+        pinsightindex = NULL;
         delete pblocktree;
         pblocktree = NULL;
         llmq::DestroyLLMQSystem();
@@ -432,6 +454,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
+    strUsage += HelpMessageOpt("-blockfilemaps=<n>", strprintf(_("Keep up to <n> block and undo files memory mapped for reading blocks (0 to %d, 0 = disable, default: %d)"),
+        MAX_BLOCK_FILE_MAPS, DEFAULT_BLOCK_FILE_MAPS));
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
     strUsage +=HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)"), Params(CBaseChainParams::MAIN).GetConsensus().defaultAssumeValid.GetHex(), Params(CBaseChainParams::TESTNET).GetConsensus().defaultAssumeValid.GetHex()));
@@ -444,7 +468,10 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-backgroundflush", strprintf(_("Write the chainstate to disk on a background thread while validation continues (default: %u)"), DEFAULT_BACKGROUND_FLUSH));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
+    strUsage += HelpMessageOpt("-loadtxoutset=<file>", _("Bootstrap a new node from a UTXO set snapshot written by dumptxoutset. The blocks up to the snapshot are downloaded and the coins are validated in the background afterwards, the masternode lists and quorums are taken from the snapshot"));
+    strUsage += HelpMessageOpt("-loadtxoutsethash=<hash>", _("Hash of the -loadtxoutset snapshot as reported by dumptxoutset, required to load it. Only use a hash from a source you trust"));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
@@ -459,14 +486,18 @@ std::string HelpMessage(HelpMessageMode mode)
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >%u = automatically prune block files to stay under the specified target size in MiB)"), MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024));
     strUsage += HelpMessageOpt("-reindex-chainstate", _("Rebuild chain state from the currently indexed blocks"));
     strUsage += HelpMessageOpt("-reindex", _("Rebuild chain state and block index from the blk*.dat files on disk"));
+    strUsage += HelpMessageOpt("-reindexthreads=<n>", strprintf(_("Set the number of threads parsing the blk*.dat files during -reindex (up to %d, 0 = auto, <0 = leave that many cores free, 1 = no parallel parsing, default: %d)"),
+        MAX_REINDEX_THREADS, DEFAULT_REINDEX_THREADS));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt("-utxoprefetchthreads=<n>", strprintf(_("Set the number of threads fetching the inputs of new blocks from the chainstate before they are connected (0 to %d, 0 = disable, default: %d)"),
+        MAX_UTXO_PREFETCH_THREADS, DEFAULT_UTXO_PREFETCH_THREADS));
 
-    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
-    strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
-    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
+    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses. It is built in the background, no -reindex is needed to turn it on or off (default: %u)"), DEFAULT_ADDRESSINDEX));
+    strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps. It is built in the background, no -reindex is needed to turn it on or off (default: %u)"), DEFAULT_TIMESTAMPINDEX));
+    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint. It is built in the background, no -reindex is needed to turn it on or off (default: %u)"), DEFAULT_SPENTINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
@@ -540,6 +571,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
+        strUsage += HelpMessageOpt("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
         strUsage += HelpMessageOpt("-testsafemode", strprintf("Force safe mode (default: %u)", DEFAULT_TESTSAFEMODE));
         strUsage += HelpMessageOpt("-dropmessagestest=<n>", "Randomly drop 1 of every <n> network messages");
@@ -756,17 +788,26 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
 
     // -reindex
     if (fReindex) {
-        int nFile = 0;
-        while (true) {
-            CDiskBlockPos pos(nFile, 0);
-            if (!boost::filesystem::exists(GetBlockPosFilename(pos, "blk")))
-                break; // No block files left to reindex
-            FILE *file = OpenBlockFile(pos, true);
-            if (!file)
-                break; // This error is logged in OpenBlockFile
-            LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(chainparams, file, &pos);
-            nFile++;
+        // -reindexthreads=0 means autodetect, a single thread parses the files on this thread
+        int nReindexThreads = GetArg("-reindexthreads", DEFAULT_REINDEX_THREADS);
+        if (nReindexThreads <= 0)
+            nReindexThreads += GetNumCores();
+        nReindexThreads = std::min(nReindexThreads, MAX_REINDEX_THREADS);
+        if (nReindexThreads > 1) {
+            ReindexBlockFiles(chainparams, nReindexThreads);
+        } else {
+            int nFile = 0;
+            while (true) {
+                CDiskBlockPos pos(nFile, 0);
+                if (!boost::filesystem::exists(GetBlockPosFilename(pos, "blk")))
+                    break; // No block files left to reindex
+                FILE *file = OpenBlockFile(pos, true);
+                if (!file)
+                    break; // This error is logged in OpenBlockFile
+                LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+                LoadExternalBlockFile(chainparams, file, &pos);
+                nFile++;
+            }
         }
         pblocktree->WriteReindexing(false);
         fReindex = false;
@@ -976,17 +1017,6 @@ void InitParameterInteraction()
     }
 #endif // ENABLE_WALLET
 
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
-    }
 }
 
 static std::string ResolveErrMsg(const char * const optname, const std::string& strBind)
@@ -1101,6 +1131,15 @@ bool AppInitParameterInteraction()
             return InitError(_("Prune mode is incompatible with -txindex."));
     }
 
+    // a UTXO set snapshot is only loaded with a trusted hash, and the blocks it stands in for can't be indexed
+    if (IsArgSet("-loadtxoutset")) {
+        std::string strHash = GetArg("-loadtxoutsethash", "");
+        if (strHash.size() != 64 || !IsHex(strHash))
+            return InitError(_("-loadtxoutset requires -loadtxoutsethash with the hash of the snapshot."));
+        if (GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) || GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("-loadtxoutset is incompatible with -addressindex, -spentindex and -timestampindex."));
+    }
+
     if (IsArgSet("-devnet")) {
         // Require setting of ports when running devnet
         if (GetArg("-listen", DEFAULT_LISTEN) && !IsArgSet("-port"))
@@ -1482,6 +1521,9 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // same number of threads for checking the proof of work of incoming headers
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadHeaderCheck);
     }
 
     std::vector<std::string> vSporkAddresses;
@@ -1746,6 +1788,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     int64_t nBlockTreeDBCache = nTotalCache / 8;
     nBlockTreeDBCache = std::min(nBlockTreeDBCache, (GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int64_t nInsightIndexDBCache = nMinInsightIndexDBCache << 20;
+    if (GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) || GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
+        nInsightIndexDBCache = std::min(nTotalCache / 4, nMaxInsightIndexDBCache << 20);
+    }
+    nTotalCache -= nInsightIndexDBCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1754,9 +1801,17 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for address, spent and timestamp index database\n", nInsightIndexDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
+    blockFileMaps.SetMaxFiles(std::max(0, std::min((int)GetArg("-blockfilemaps", DEFAULT_BLOCK_FILE_MAPS), MAX_BLOCK_FILE_MAPS)));
+
+    // The address, spent and timestamp indexes are built in the background and can be turned on and off at any time
+    fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+    fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+
     bool fLoaded = false;
     int64_t nStart = GetTimeMillis();
 
@@ -1771,19 +1826,45 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
             try {
                 UnloadBlockIndex();
                 delete pcoinsTip;
+                delete pcoinsPrefetch;
                 delete pcoinsdbview;
                 delete pcoinscatcher;
+                delete pinsightindex;
                 delete pblocktree;
                 llmq::DestroyLLMQSystem();
                 delete deterministicMNManager;
                 delete evoDb;
 
+                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
+                // The blocks below a UTXO set snapshot are not available, the chainstate can't be rebuilt from them.
+                // After an interrupted load it is wiped, so that the snapshot can be loaded again.
+                bool fSnapshotLoading = false;
+                pblocktree->ReadFlag("txoutsetsnapshotloading", fSnapshotLoading);
+                if (fReindexChainState && !fReindex) {
+                    bool fSnapshot = false;
+                    pblocktree->ReadFlag("txoutsetsnapshot", fSnapshot);
+                    if (fSnapshotLoading) {
+                        if (!pblocktree->WriteFlag("txoutsetsnapshot", false) || !pblocktree->WriteFlag("txoutsetsnapshotloading", false)) {
+                            strLoadError = _("Error writing to the block database");
+                            break;
+                        }
+                        fSnapshotLoading = false;
+                    } else if (fSnapshot) {
+                        return InitError(_("The chainstate was loaded from a UTXO set snapshot and can't be rebuilt with -reindex-chainstate. Use -reindex instead."));
+                    }
+                }
                 evoDb = new CEvoDB(nEvoDbCache, false, fReindex || fReindexChainState);
                 deterministicMNManager = new CDeterministicMNManager(*evoDb);
-                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
+                pinsightindex = new CInsightIndexDB(nInsightIndexDBCache, false, fReindex);
                 pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex || fReindexChainState);
+                if (GetBoolArg("-backgroundflush", DEFAULT_BACKGROUND_FLUSH))
+                    pcoinsdbview->StartBackgroundFlush();
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
-                pcoinsTip = new CCoinsViewCache(pcoinscatcher);
+                pcoinsPrefetch = new CCoinsViewPrefetch(pcoinscatcher);
+                pcoinsPrefetch->Start(std::max(0, std::min((int)GetArg("-utxoprefetchthreads", DEFAULT_UTXO_PREFETCH_THREADS), MAX_UTXO_PREFETCH_THREADS)));
+                pcoinsTip = new CCoinsViewCache(pcoinsPrefetch);
+                // FlushStateToDisk accounts the tip cache with DB_PEAK_USAGE_FACTOR, leave some room for scripts
+                pcoinsTip->SetMaxTableSize(nCoinCacheUsage / DB_PEAK_USAGE_FACTOR / 10 * 9);
                 llmq::InitLLMQSystem(*evoDb, &scheduler, false, fReindex || fReindexChainState);
 
                 if (fReindex) {
@@ -1792,11 +1873,20 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     if (fPruneMode)
                         CleanupBlockRevFiles();
                 } else {
+                    // The chainstate of an interrupted snapshot load can't be completed, the blocks it stands for are missing
+                    if (fSnapshotLoading) {
+                        strLoadError = _("Loading the UTXO set snapshot was interrupted. You need to rebuild the database using -reindex-chainstate and load the snapshot again");
+                        break;
+                    }
                     // If necessary, upgrade from older database format.
                     if (!pcoinsdbview->Upgrade()) {
                         strLoadError = _("Error upgrading chainstate database");
                         break;
                     }
+                    if (!pblocktree->MigrateInsightIndexes(*pinsightindex)) {
+                        strLoadError = _("Error moving indexes out of the block database");
+                        break;
+                    }
                 }
                 if (fRequestShutdown) break;
 
@@ -1894,6 +1984,46 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     }
     LogPrintf(" block index %15dms\n", GetTimeMillis() - nStart);
 
+    // Load a UTXO set snapshot into a chainstate which has nothing but the genesis block
+    if (IsArgSet("-loadtxoutset")) {
+        boost::filesystem::path pathSnapshot = boost::filesystem::absolute(GetArg("-loadtxoutset", ""), GetDataDir());
+        if (fReindex) {
+            LogPrintf("Reindexing, not loading the UTXO set snapshot %s\n", pathSnapshot.string());
+        } else if (chainActive.Height() > 0) {
+            LogPrintf("The chain is past the genesis block, not loading the UTXO set snapshot %s\n", pathSnapshot.string());
+        } else {
+            uiInterface.InitMessage(_("Loading UTXO set snapshot..."));
+            nStart = GetTimeMillis();
+            CUTXOSnapshotInfo info;
+            std::string strError;
+            if (!LoadUTXOSnapshot(chainparams, pathSnapshot, uint256S(GetArg("-loadtxoutsethash", "")), info, strError))
+                return InitError(strprintf(_("Error loading the UTXO set snapshot: %s"), strError));
+            LogPrintf("Loaded the UTXO set snapshot %s at block %s, height %d: %u transactions, %u outputs, %u EvoDB entries\n",
+                pathSnapshot.string(), info.hashBaseBlock.ToString(), info.nBaseHeight, info.nTransactions, info.nTransactionOutputs, info.nEvoEntries);
+            LogPrintf(" snapshot    %15dms\n", GetTimeMillis() - nStart);
+        }
+    }
+
+    // The insight indexes are built from the blocks, which are missing below a snapshot
+    if (fLoadedFromSnapshot && (fAddressIndex || fSpentIndex || fTimestampIndex))
+        return InitError(_("The address, spent and timestamp indexes can't be built on a chainstate loaded from a UTXO set snapshot."));
+
+    pinsightindexer = new CInsightIndexer(*pinsightindex);
+    if (!pinsightindexer->Init(fAddressIndex, fSpentIndex, fTimestampIndex))
+        return InitError(_("Error loading the address, spent and timestamp indexes, see debug.log for details"));
+    RegisterValidationInterface(pinsightindexer);
+    pinsightindexer->Start();
+
+    // The blocks below a UTXO set snapshot are downloaded and validated in the background
+    // Only the coins are validated, the EvoDB is taken from the snapshot as it is
+    bool fSnapshotValidated = false;
+    if (fLoadedFromSnapshot && !(pblocktree->ReadFlag("txoutsetsnapshotcoinsvalidated", fSnapshotValidated) && fSnapshotValidated)) {
+        psnapshotvalidator = new CSnapshotValidator(nCoinCacheUsage / 4);
+        if (!psnapshotvalidator->Init())
+            return InitError(_("Error loading the validation of the UTXO set snapshot"));
+        psnapshotvalidator->Start();
+    }
+
     boost::filesystem::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
     CAutoFile est_filein(fopen(est_path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
     // Allowed to fail as this file IS missing on first startup.
@@ -1922,6 +2052,12 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         }
     }
 
+    // the blocks below a UTXO set snapshot can't be served either, until they were downloaded and validated
+    if (fLoadedFromSnapshot && !fSnapshotValidated) {
+        LogPrintf("Unsetting NODE_NETWORK, the chainstate was loaded from a UTXO set snapshot\n");
+        nLocalServices = ServiceFlags(nLocalServices & ~NODE_NETWORK);
+    }
+
     // ********************************************************* Step 10a: Prepare Masternode related stuff
     fMasternodeMode = GetBoolArg("-masternode", false);
     // TODO: masternode should have no wallet
@@ -0,0 +1,440 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "insightindexer.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "hash.h"
+#include "init.h"
+#include "primitives/block.h"
+#include "txdb.h"
+#include "ui_interface.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+#include "warnings.h"
+
+#include <algorithm>
+#include <limits>
+
+CInsightIndexer* pinsightindexer = NULL;
+
+static void FatalError(const std::string& strMessage)
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(_("Error: A fatal internal error occurred, see debug.log for details"), "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+//! Type of the address the script pays to (1 for P2PKH and P2PK, 2 for P2SH), 0 if the address index doesn't know it
+static int GetAddressType(const CScript& script, uint160& hashBytes)
+{
+    if (script.IsPayToScriptHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin() + 2, script.begin() + 22));
+        return 2;
+    } else if (script.IsPayToPublicKeyHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin() + 3, script.begin() + 23));
+        return 1;
+    } else if (script.IsPayToPublicKey()) {
+        hashBytes = Hash160(script.begin() + 1, script.end() - 1);
+        return 1;
+    }
+    hashBytes.SetNull();
+    return 0;
+}
+
+CInsightIndexer::CInsightIndexer(CInsightIndexDB& dbIn) : db(dbIn)
+{
+}
+
+CInsightIndexer::~CInsightIndexer()
+{
+    Stop();
+}
+
+bool CInsightIndexer::Init(bool fAddressIndex, bool fSpentIndex, bool fTimestampIndex)
+{
+    LOCK(cs_main);
+    std::lock_guard<std::mutex> lock(cs);
+
+    std::vector<std::pair<std::string, bool> > vNames{{"addressindex", fAddressIndex}, {"spentindex", fSpentIndex}, {"timestampindex", fTimestampIndex}};
+
+    // Older versions wrote the indexes in ConnectBlock and flushed them before the chainstate, an index with the flag set
+    // covers the tip. Every index is converted on the first start, whether it's enabled or not, as the tip it was
+    // written up to is lost once the node keeps running without it
+    if (chainActive.Tip() != NULL) {
+        for (const auto& p : vNames) {
+            CBlockLocator locator;
+            bool fLegacy = false;
+            if ((db.ReadBestBlock(p.first, locator) && !locator.IsNull()) || !pblocktree->ReadFlag(p.first, fLegacy) || !fLegacy) {
+                continue;
+            }
+            LogPrintf("%s: %s of an older version covers height %d\n", __func__, p.first, chainActive.Height());
+            CInsightIndexBlockUpdate update;
+            update.bestBlocks.emplace_back(p.first, chainActive.GetLocator());
+            if (!db.WriteBlockUpdate(update) || !pblocktree->WriteFlag(p.first, false)) {
+                return error("%s: failed to continue %s", __func__, p.first);
+            }
+        }
+    }
+
+    vIndexes.clear();
+    for (const auto& p : vNames) {
+        if (!p.second) {
+            continue;
+        }
+        IndexState state{p.first, NULL, false};
+
+        CBlockLocator locator;
+        if (db.ReadBestBlock(state.strName, locator) && !locator.IsNull()) {
+            BlockMap::const_iterator it = mapBlockIndex.find(locator.vHave[0]);
+            if (it != mapBlockIndex.end()) {
+                state.pindexBest = it->second;
+            } else {
+                LogPrintf("%s: best block %s of %s is unknown, rebuilding it\n", __func__, locator.vHave[0].ToString(), state.strName);
+                if (!db.WipeIndex(state.strName)) {
+                    return error("%s: failed to erase %s", __func__, state.strName);
+                }
+            }
+        }
+
+        if (fHavePruned && !HaveBlocksToIndex(state.pindexBest)) {
+            return error("%s: blocks which %s needs were pruned, it can only be enabled after a -reindex", __func__, state.strName);
+        }
+
+        LogPrintf("%s: %s enabled, indexed up to height %d\n", __func__, state.strName, state.pindexBest ? state.pindexBest->nHeight : -1);
+        vIndexes.push_back(state);
+    }
+    return true;
+}
+
+bool CInsightIndexer::HaveBlocksToIndex(const CBlockIndex* pindexBest)
+{
+    AssertLockHeld(cs_main);
+
+    // The blocks of a branch which is not active any more are disconnected, the blocks of the active chain after the
+    // fork are connected
+    const CBlockIndex* pindexFork = pindexBest ? chainActive.FindFork(pindexBest) : NULL;
+    for (const CBlockIndex* pindex = pindexBest; pindex != pindexFork; pindex = pindex->pprev) {
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !(pindex->nStatus & BLOCK_HAVE_UNDO)) {
+            return false;
+        }
+    }
+    for (const CBlockIndex* pindex = pindexFork ? chainActive.Next(pindexFork) : chainActive[1]; pindex != NULL; pindex = chainActive.Next(pindex)) {
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !(pindex->nStatus & BLOCK_HAVE_UNDO)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CInsightIndexer::Start()
+{
+    if (vIndexes.empty() || indexThread.joinable()) {
+        return;
+    }
+    fStop = false;
+    indexThread = std::thread(&CInsightIndexer::ThreadMain, this);
+}
+
+void CInsightIndexer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStop = true;
+    }
+    cvUpdate.notify_all();
+    if (indexThread.joinable()) {
+        indexThread.join();
+    }
+}
+
+void CInsightIndexer::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        nTipUpdates++;
+    }
+    cvUpdate.notify_all();
+}
+
+bool CInsightIndexer::IsSyncedTo(const CBlockIndex* pindex) const
+{
+    for (const auto& state : vIndexes) {
+        // Not just a descendant, which could be a block that is about to be disconnected
+        if (state.pindexBest != pindex) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CInsightIndexer::BlockUntilSyncedToCurrentChain(bool fWaitForInitialSync)
+{
+    while (true) {
+        uint64_t nTipUpdatesSeen;
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            nTipUpdatesSeen = nTipUpdates;
+        }
+        const CBlockIndex* pindexTip;
+        {
+            LOCK(cs_main);
+            pindexTip = chainActive.Tip();
+        }
+
+        std::unique_lock<std::mutex> lock(cs);
+        if (!fWaitForInitialSync) {
+            for (const auto& state : vIndexes) {
+                if (!state.fSynced) {
+                    return false;
+                }
+            }
+        }
+        // A new tip might replace the one we wait for, start over with it
+        cvUpdate.wait(lock, [&] { return fStop || fFailed || IsSyncedTo(pindexTip) || nTipUpdates != nTipUpdatesSeen; });
+        if (fStop || fFailed) {
+            return false;
+        }
+        if (IsSyncedTo(pindexTip)) {
+            return true;
+        }
+    }
+}
+
+std::vector<CInsightIndexer::IndexInfo> CInsightIndexer::GetInfo()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    std::vector<IndexInfo> vInfo;
+    for (const auto& state : vIndexes) {
+        vInfo.push_back(IndexInfo{state.strName, state.pindexBest ? state.pindexBest->nHeight : -1, state.fSynced});
+    }
+    return vInfo;
+}
+
+int CInsightIndexer::GetPruneLockHeight()
+{
+    AssertLockHeld(cs_main);
+
+    std::lock_guard<std::mutex> lock(cs);
+    int nHeight = std::numeric_limits<int>::max();
+    for (const auto& state : vIndexes) {
+        // Nothing is read from the genesis block. Blocks on a branch which is not active any more are kept anyway, as
+        // they are above the fork.
+        const CBlockIndex* pindexFork = state.pindexBest ? chainActive.FindFork(state.pindexBest) : NULL;
+        nHeight = std::min(nHeight, pindexFork ? pindexFork->nHeight : 0);
+    }
+    return nHeight;
+}
+
+void CInsightIndexer::ThreadMain()
+{
+    RenameThread("cbdhealthnetwork-index");
+
+    while (true) {
+        uint64_t nTipUpdatesSeen;
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            if (fStop) {
+                return;
+            }
+            nTipUpdatesSeen = nTipUpdates;
+        }
+
+        StepResult result;
+        try {
+            result = Step();
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+            result = STEP_FAILED;
+        }
+
+        std::unique_lock<std::mutex> lock(cs);
+        if (result == STEP_FAILED) {
+            fFailed = true;
+            cvUpdate.notify_all();
+            lock.unlock();
+            FatalError("Failed to update the address, spent or timestamp index");
+            return;
+        }
+        if (result == STEP_IDLE) {
+            cvUpdate.notify_all();
+            cvUpdate.wait(lock, [&] { return fStop || nTipUpdates != nTipUpdatesSeen; });
+        }
+    }
+}
+
+CInsightIndexer::StepResult CInsightIndexer::Step()
+{
+    std::vector<const CBlockIndex*> vBest;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        for (const auto& state : vIndexes) {
+            vBest.push_back(state.pindexBest);
+        }
+    }
+
+    const CBlockIndex* pindexTip;
+    const CBlockIndex* pindex = NULL;
+    const CBlockIndex* pindexNewBest = NULL;
+    bool fConnect = true;
+    CBlockLocator locator;
+    CDiskBlockPos undoPos;
+    {
+        LOCK(cs_main);
+        pindexTip = chainActive.Tip();
+        for (const CBlockIndex* pindexBest : vBest) {
+            if (pindexTip == NULL || pindexBest == pindexTip) {
+                continue;
+            }
+            if (pindexBest != NULL && !chainActive.Contains(pindexBest)) {
+                // Ahead of the tip, which happens with -reindex-chainstate or when the chainstate lost its last
+                // blocks in a crash. Wait for the chain to catch up instead of rebuilding the index.
+                if (!(pindexBest->nStatus & BLOCK_FAILED_MASK) && pindexBest->GetAncestor(pindexTip->nHeight) == pindexTip) {
+                    continue;
+                }
+                pindex = pindexBest;
+                pindexNewBest = pindex->pprev;
+                fConnect = false;
+            } else {
+                pindex = pindexBest ? chainActive.Next(pindexBest) : chainActive.Genesis();
+                pindexNewBest = pindex;
+            }
+            break;
+        }
+        if (pindex != NULL) {
+            locator = chainActive.GetLocator(pindexNewBest);
+            undoPos = pindex->GetUndoPos();
+        }
+    }
+
+    if (pindex == NULL) {
+        std::lock_guard<std::mutex> lock(cs);
+        for (auto& state : vIndexes) {
+            if (!state.fSynced && state.pindexBest == pindexTip) {
+                LogPrintf("%s: %s is synced at height %d\n", __func__, state.strName, pindexTip ? pindexTip->nHeight : -1);
+                state.fSynced = true;
+            }
+        }
+        return STEP_IDLE;
+    }
+
+    // All indexes which are at the same block move along
+    const CBlockIndex* pindexBest = fConnect ? pindex->pprev : pindex;
+    bool fAddressIndex = false, fSpentIndex = false, fTimestampIndex = false;
+    CInsightIndexBlockUpdate update;
+    for (size_t i = 0; i < vIndexes.size(); i++) {
+        if (vBest[i] != pindexBest) {
+            continue;
+        }
+        const std::string& strName = vIndexes[i].strName;
+        fAddressIndex |= strName == "addressindex";
+        fSpentIndex |= strName == "spentindex";
+        fTimestampIndex |= strName == "timestampindex";
+        update.bestBlocks.emplace_back(strName, locator);
+    }
+
+    // Nothing to index in the genesis block, its transactions are not part of the chainstate
+    if (pindex->pprev != NULL) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            return STEP_FAILED;
+        }
+        CBlockUndo blockUndo;
+        if (undoPos.IsNull() || !UndoReadFromDisk(blockUndo, undoPos, pindex->pprev->GetBlockHash())) {
+            LogPrintf("%s: failed to read undo data of block %s\n", __func__, pindex->GetBlockHash().ToString());
+            return STEP_FAILED;
+        }
+        if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
+            LogPrintf("%s: block %s and its undo data are inconsistent\n", __func__, pindex->GetBlockHash().ToString());
+            return STEP_FAILED;
+        }
+        BuildBlockUpdate(block, blockUndo, pindex, fConnect, fAddressIndex, fSpentIndex, fTimestampIndex, update);
+    }
+
+    if (!db.WriteBlockUpdate(update)) {
+        return STEP_FAILED;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        for (size_t i = 0; i < vIndexes.size(); i++) {
+            if (vBest[i] == pindexBest) {
+                vIndexes[i].pindexBest = pindexNewBest;
+            }
+        }
+    }
+    cvUpdate.notify_all();
+    return STEP_DONE;
+}
+
+void CInsightIndexer::BuildBlockUpdate(const CBlock& block, const CBlockUndo& blockUndo, const CBlockIndex* pindex, bool fConnect,
+                                       bool fAddressIndex, bool fSpentIndex, bool fTimestampIndex, CInsightIndexBlockUpdate& update)
+{
+    update.fErase = !fConnect;
+
+    if (fTimestampIndex) {
+        update.timestampIndex.emplace_back(pindex->nTime, pindex->GetBlockHash());
+    }
+    if (!fAddressIndex && !fSpentIndex) {
+        return;
+    }
+
+    // Unspent outputs are updated in block order when connecting and in reverse order when disconnecting, so that
+    // outputs which are spent in the same block are erased in both cases
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        size_t i = fConnect ? n : block.vtx.size() - 1 - n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+        uint160 hashBytes;
+
+        if (!fConnect && fAddressIndex) {
+            for (size_t k = 0; k < tx.vout.size(); k++) {
+                int addressType = GetAddressType(tx.vout[k].scriptPubKey, hashBytes);
+                if (addressType > 0) {
+                    update.addressIndex.emplace_back(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false), tx.vout[k].nValue);
+                    update.addressUnspentIndex.emplace_back(CAddressUnspentKey(addressType, hashBytes, txhash, k), CAddressUnspentValue());
+                }
+            }
+        }
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const Coin& coin = txundo.vprevout[j];
+                int addressType = GetAddressType(coin.out.scriptPubKey, hashBytes);
+
+                if (fAddressIndex && addressType > 0) {
+                    update.addressIndex.emplace_back(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), coin.out.nValue * -1);
+                    if (fConnect) {
+                        update.addressUnspentIndex.emplace_back(CAddressUnspentKey(addressType, hashBytes, prevout.hash, prevout.n), CAddressUnspentValue());
+                    } else {
+                        update.addressUnspentIndex.emplace_back(CAddressUnspentKey(addressType, hashBytes, prevout.hash, prevout.n), CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight));
+                    }
+                }
+
+                if (fSpentIndex) {
+                    if (fConnect) {
+                        update.spentIndex.emplace_back(CSpentIndexKey(prevout.hash, prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, coin.out.nValue, addressType, hashBytes));
+                    } else {
+                        update.spentIndex.emplace_back(CSpentIndexKey(prevout.hash, prevout.n), CSpentIndexValue());
+                    }
+                }
+            }
+        }
+
+        if (fConnect && fAddressIndex) {
+            for (size_t k = 0; k < tx.vout.size(); k++) {
+                int addressType = GetAddressType(tx.vout[k].scriptPubKey, hashBytes);
+                if (addressType > 0) {
+                    update.addressIndex.emplace_back(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false), tx.vout[k].nValue);
+                    update.addressUnspentIndex.emplace_back(CAddressUnspentKey(addressType, hashBytes, txhash, k), CAddressUnspentValue(tx.vout[k].nValue, tx.vout[k].scriptPubKey, pindex->nHeight));
+                }
+            }
+        }
+    }
+}
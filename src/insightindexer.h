@@ -0,0 +1,118 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_INSIGHTINDEXER_H
+#define CHN_INSIGHTINDEXER_H
+
+#include "validationinterface.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
+class CInsightIndexDB;
+struct CInsightIndexBlockUpdate;
+
+/**
+ * Maintains the address, spent and timestamp indexes on a background thread, so that connecting blocks doesn't wait
+ * for them.
+ *
+ * Every index has its own best block, which is stored in the index database together with the entries of the block
+ * it was moved to. The thread moves the best blocks towards the active chain tip one block at a time: blocks which
+ * are not in the active chain any more are disconnected using their undo data, then the following blocks of the
+ * active chain are connected. An index which is ahead of the tip on the same branch waits for the chain instead.
+ * Indexes which are at the same best block are updated together, with one block read.
+ *
+ * This also catches up indexes which were disabled for a while or are enabled for the first time, no -reindex is
+ * needed to turn them on or off. Queries may lag behind the chain tip by a few blocks, BlockUntilSyncedToCurrentChain()
+ * waits until they don't.
+ */
+class CInsightIndexer : public CValidationInterface
+{
+public:
+    struct IndexInfo
+    {
+        std::string strName;
+        //! -1 if nothing is indexed yet
+        int nBestHeight;
+        bool fSynced;
+    };
+
+private:
+    struct IndexState
+    {
+        std::string strName;
+        const CBlockIndex* pindexBest;
+        //! Reached the chain tip at least once since startup
+        bool fSynced;
+    };
+
+    enum StepResult {
+        STEP_DONE,
+        STEP_IDLE,
+        STEP_FAILED
+    };
+
+    CInsightIndexDB& db;
+
+    std::mutex cs;
+    //! The enabled indexes, best blocks are only changed by the indexing thread
+    std::vector<IndexState> vIndexes;
+    //! Signalled when the chain tip changes and when an index made progress
+    std::condition_variable cvUpdate;
+    uint64_t nTipUpdates{0};
+    bool fStop{false};
+    bool fFailed{false};
+    std::thread indexThread;
+
+public:
+    explicit CInsightIndexer(CInsightIndexDB& dbIn);
+    ~CInsightIndexer();
+
+    /**
+     * Loads the best blocks of the enabled indexes. Indexes which were written by ConnectBlock in older versions are
+     * continued at the chain tip. Requires the block index to be loaded.
+     */
+    bool Init(bool fAddressIndex, bool fSpentIndex, bool fTimestampIndex);
+    void Start();
+    void Stop();
+
+    /**
+     * Waits until all enabled indexes include the current chain tip. Returns false right away if some index did not
+     * catch up since startup yet, unless fWaitForInitialSync is set. Must not be called with cs_main held.
+     */
+    bool BlockUntilSyncedToCurrentChain(bool fWaitForInitialSync = false);
+
+    std::vector<IndexInfo> GetInfo();
+
+    /**
+     * The height up to which the blocks were indexed by all enabled indexes, std::numeric_limits<int>::max() if none is
+     * enabled. Pruning must keep the blocks above it, which the indexing thread still has to read. Requires cs_main.
+     */
+    int GetPruneLockHeight();
+
+    /** Collects the index entries of a block, for connecting or disconnecting it */
+    static void BuildBlockUpdate(const CBlock& block, const CBlockUndo& blockUndo, const CBlockIndex* pindex, bool fConnect,
+                                 bool fAddressIndex, bool fSpentIndex, bool fTimestampIndex, CInsightIndexBlockUpdate& update);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+
+private:
+    void ThreadMain();
+    //! Connects or disconnects one block for the first index which is not at the tip, and the indexes at the same block
+    StepResult Step();
+    bool IsSyncedTo(const CBlockIndex* pindex) const;
+    //! Whether the blocks and undo data are there which are needed to move an index from pindexBest to the tip
+    static bool HaveBlocksToIndex(const CBlockIndex* pindexBest);
+};
+
+extern CInsightIndexer* pinsightindexer;
+
+#endif // CHN_INSIGHTINDEXER_H
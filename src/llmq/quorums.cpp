@@ -26,6 +26,7 @@ namespace llmq
 
 static const std::string DB_QUORUM_SK_SHARE = "q_Qsk";
 static const std::string DB_QUORUM_QUORUM_VVEC = "q_Qqvvec";
+static const std::string DB_QUORUM_PUBKEY_SHARES = "q_Qpks";
 
 CQuorumManager* quorumManager;
 
@@ -82,10 +83,47 @@ CBLSPublicKey CQuorum::GetPubKeyShare(size_t memberIdx) const
     if (quorumVvec == nullptr || memberIdx >= members.size() || !qc.validMembers[memberIdx]) {
         return CBLSPublicKey();
     }
+    if (!pubKeyShares.empty()) {
+        return pubKeyShares[memberIdx];
+    }
     auto& m = members[memberIdx];
     return blsCache.BuildPubKeyShare(m->proTxHash, quorumVvec, CBLSId::FromHash(m->proTxHash));
 }
 
+std::shared_ptr<const CBLSLagrangeCoefficients> CQuorum::GetLagrangeCoefficients(const std::vector<uint16_t>& memberIndexes) const
+{
+    CHashWriter hw(SER_GETHASH, 0);
+    hw << memberIndexes;
+    uint256 cacheKey = hw.GetHash();
+
+    std::shared_ptr<const CBLSLagrangeCoefficients> ret;
+    {
+        LOCK(lagrangeCoefficientsCacheCs);
+        if (lagrangeCoefficientsCache.get(cacheKey, ret)) {
+            return ret;
+        }
+    }
+
+    std::vector<CBLSId> ids;
+    ids.reserve(memberIndexes.size());
+    for (auto memberIdx : memberIndexes) {
+        if (memberIdx >= members.size() || !qc.validMembers[memberIdx]) {
+            return nullptr;
+        }
+        ids.emplace_back(CBLSId::FromHash(members[memberIdx]->proTxHash));
+    }
+
+    auto coefficients = std::make_shared<CBLSLagrangeCoefficients>();
+    if (!coefficients->Init(ids)) {
+        return nullptr;
+    }
+    ret = coefficients;
+
+    LOCK(lagrangeCoefficientsCacheCs);
+    lagrangeCoefficientsCache.insert(cacheKey, ret);
+    return ret;
+}
+
 CBLSSecretKey CQuorum::GetSkShare() const
 {
     return skShare;
@@ -128,12 +166,25 @@ bool CQuorum::ReadContributions(CEvoDB& evoDb)
     // member of the quorum but observed the whole DKG process to have the quorum verification vector.
     evoDb.Read(std::make_pair(DB_QUORUM_SK_SHARE, dbKey), skShare);
 
+    // Also not fatal, the shares are then recovered from the quorum vvec again
+    std::vector<CBLSPublicKey> pks;
+    if (evoDb.Read(std::make_pair(DB_QUORUM_PUBKEY_SHARES, dbKey), pks) && pks.size() == members.size()) {
+        pubKeyShares = std::move(pks);
+    }
+
     return true;
 }
 
-void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this)
+void CQuorum::WritePubKeyShares(CEvoDB& evoDb, const std::vector<CBLSPublicKey>& _pubKeyShares)
 {
-    if (_this->quorumVvec == nullptr) {
+    uint256 dbKey = MakeQuorumKey(*this);
+
+    evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_PUBKEY_SHARES, dbKey), _pubKeyShares);
+}
+
+void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this, CEvoDB& evoDb)
+{
+    if (_this->quorumVvec == nullptr || !_this->pubKeyShares.empty()) {
         return;
     }
 
@@ -142,13 +193,18 @@ void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this)
 
     // this thread will exit after some time
     // when then later some other thread tries to get keys, it will be much faster
-    _this->cachePopulatorThread = std::thread([_this, t]() {
+    _this->cachePopulatorThread = std::thread([_this, t, &evoDb]() {
         RenameThread("cbdhealthnetwork-q-cachepop");
-        for (size_t i = 0; i < _this->members.size() && !_this->stopCachePopulatorThread && !ShutdownRequested(); i++) {
+        std::vector<CBLSPublicKey> pks(_this->members.size());
+        size_t i = 0;
+        for (; i < _this->members.size() && !_this->stopCachePopulatorThread && !ShutdownRequested(); i++) {
             if (_this->qc.validMembers[i]) {
-                _this->GetPubKeyShare(i);
+                pks[i] = _this->GetPubKeyShare(i);
             }
         }
+        if (i == _this->members.size()) {
+            _this->WritePubKeyShares(evoDb, pks);
+        }
         LogPrint("llmq", "CQuorum::StartCachePopulatorThread -- done. time=%d\n", t.count());
     });
 }
@@ -251,7 +307,7 @@ bool CQuorumManager::BuildQuorumFromCommitment(const CFinalCommitment& qc, const
         // pre-populate caches in the background
         // recovering public key shares is quite expensive and would result in serious lags for the first few signing
         // sessions if the shares would be calculated on-demand
-        CQuorum::StartCachePopulatorThread(quorum);
+        CQuorum::StartCachePopulatorThread(quorum, evoDb);
     }
 
     return true;
@@ -12,6 +12,7 @@
 #include "validationinterface.h"
 #include "consensus/params.h"
 #include "saltedhasher.h"
+#include "sync.h"
 #include "unordered_lru_cache.h"
 
 #include "bls/bls.h"
@@ -52,6 +53,16 @@ private:
     std::atomic<bool> stopCachePopulatorThread;
     std::thread cachePopulatorThread;
 
+    // Public key shares of all members. Once the cache populator thread built all of them, they are also written to
+    // the evoDb, so that they are loaded with the quorum vvec and don't need to be recovered again after a restart.
+    // Empty when they were not loaded. Only set while the quorum is built, so it's safe to read without locking
+    std::vector<CBLSPublicKey> pubKeyShares;
+
+    // Signatures are recovered from the shares of mostly the same subsets of members, so the Lagrange coefficients of
+    // these subsets are cached
+    mutable CCriticalSection lagrangeCoefficientsCacheCs;
+    mutable unordered_lru_cache<uint256, std::shared_ptr<const CBLSLagrangeCoefficients>, StaticSaltedHasher, 64> lagrangeCoefficientsCache;
+
 public:
     CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker) : params(_params), blsCache(_blsWorker), stopCachePopulatorThread(false) {}
     ~CQuorum();
@@ -64,10 +75,15 @@ public:
     CBLSPublicKey GetPubKeyShare(size_t memberIdx) const;
     CBLSSecretKey GetSkShare() const;
 
+    // Returns the coefficients to recover a signature from the sig shares of the given members, in the order of
+    // memberIndexes. Returns nullptr if any of the members is invalid
+    std::shared_ptr<const CBLSLagrangeCoefficients> GetLagrangeCoefficients(const std::vector<uint16_t>& memberIndexes) const;
+
 private:
     void WriteContributions(CEvoDB& evoDb);
     bool ReadContributions(CEvoDB& evoDb);
-    static void StartCachePopulatorThread(std::shared_ptr<CQuorum> _this);
+    void WritePubKeyShares(CEvoDB& evoDb, const std::vector<CBLSPublicKey>& _pubKeyShares);
+    static void StartCachePopulatorThread(std::shared_ptr<CQuorum> _this, CEvoDB& evoDb);
 };
 typedef std::shared_ptr<CQuorum> CQuorumPtr;
 typedef std::shared_ptr<const CQuorum> CQuorumCPtr;
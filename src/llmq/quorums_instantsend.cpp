@@ -3,10 +3,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "quorums_chainlocks.h"
+#include "quorums_init.h"
 #include "quorums_instantsend.h"
 #include "quorums_utils.h"
 
-#include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "chainparams.h"
 #include "coins.h"
 #include "txmempool.h"
@@ -43,21 +44,109 @@ uint256 CInstantSendLock::GetRequestId() const
 
 ////////////////
 
+CInstantSendDb::CInstantSendDb(CDBWrapper& _db) :
+    db(_db)
+{
+    LoadIndex();
+}
+
+void CInstantSendDb::LoadIndex()
+{
+    auto it = std::unique_ptr<CDBIterator>(db.NewIterator());
+    auto firstKey = std::make_tuple(std::string("is_i"), uint256());
+    it->Seek(firstKey);
+
+    size_t cnt = 0;
+    while (it->Valid()) {
+        decltype(firstKey) curKey;
+        if (!it->GetKey(curKey) || std::get<0>(curKey) != "is_i") {
+            break;
+        }
+        auto islock = std::make_shared<CInstantSendLock>();
+        if (it->GetValue(*islock)) {
+            AddToIndex(std::get<1>(curKey), islock);
+            cnt++;
+        }
+        it->Next();
+    }
+
+    LogPrintf("CInstantSendDb::%s -- loaded %d islocks\n", __func__, cnt);
+}
+
+void CInstantSendDb::AddToIndex(const uint256& hash, const CInstantSendLockPtr& islock)
+{
+    {
+        auto& shard = GetIndexShard(hash);
+        LOCK(shard.cs);
+        shard.islocks[hash] = islock;
+    }
+    {
+        auto& shard = GetIndexShard(islock->txid);
+        LOCK(shard.cs);
+        shard.txids[islock->txid] = hash;
+    }
+    for (auto& in : islock->inputs) {
+        auto& shard = GetIndexShard(in);
+        LOCK(shard.cs);
+        shard.inputs[in] = hash;
+    }
+}
+
+void CInstantSendDb::RemoveFromIndex(const uint256& hash, const CInstantSendLock& islock)
+{
+    {
+        auto& shard = GetIndexShard(hash);
+        LOCK(shard.cs);
+        shard.islocks.erase(hash);
+    }
+    // a conflicting islock might have replaced the entries of this one
+    {
+        auto& shard = GetIndexShard(islock.txid);
+        LOCK(shard.cs);
+        auto it = shard.txids.find(islock.txid);
+        if (it != shard.txids.end() && it->second == hash) {
+            shard.txids.erase(it);
+        }
+    }
+    for (auto& in : islock.inputs) {
+        auto& shard = GetIndexShard(in);
+        LOCK(shard.cs);
+        auto it = shard.inputs.find(in);
+        if (it != shard.inputs.end() && it->second == hash) {
+            shard.inputs.erase(it);
+        }
+    }
+}
+
+static std::tuple<std::string, uint32_t, uint256> BuildInversedISLockKey(const std::string& k, int nHeight, const uint256& islockHash)
+{
+    return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
+}
+
 void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
+{
+    WriteNewInstantSendLocks({std::make_pair(hash, std::make_shared<CInstantSendLock>(islock))}, {});
+}
+
+void CInstantSendDb::WriteNewInstantSendLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& islocks, const std::vector<std::pair<uint256, int>>& mined)
 {
     CDBBatch batch(db);
-    batch.Write(std::make_tuple(std::string("is_i"), hash), islock);
-    batch.Write(std::make_tuple(std::string("is_tx"), islock.txid), hash);
-    for (auto& in : islock.inputs) {
-        batch.Write(std::make_tuple(std::string("is_in"), in), hash);
+    for (auto& p : islocks) {
+        auto& hash = p.first;
+        auto& islock = p.second;
+        batch.Write(std::make_tuple(std::string("is_i"), hash), *islock);
+        batch.Write(std::make_tuple(std::string("is_tx"), islock->txid), hash);
+        for (auto& in : islock->inputs) {
+            batch.Write(std::make_tuple(std::string("is_in"), in), hash);
+        }
+    }
+    for (auto& p : mined) {
+        batch.Write(BuildInversedISLockKey("is_m", p.second, p.first), true);
     }
     db.WriteBatch(batch);
 
-    auto p = std::make_shared<CInstantSendLock>(islock);
-    islockCache.insert(hash, p);
-    txidCache.insert(islock.txid, hash);
-    for (auto& in : islock.inputs) {
-        outpointCache.insert(in, hash);
+    for (auto& p : islocks) {
+        AddToIndex(p.first, p.second);
     }
 }
 
@@ -83,16 +172,7 @@ void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash,
         batch.Erase(std::make_tuple(std::string("is_in"), in));
     }
 
-    islockCache.erase(hash);
-    txidCache.erase(islock->txid);
-    for (auto& in : islock->inputs) {
-        outpointCache.erase(in);
-    }
-}
-
-static std::tuple<std::string, uint32_t, uint256> BuildInversedISLockKey(const std::string& k, int nHeight, const uint256& islockHash)
-{
-    return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
+    RemoveFromIndex(hash, *islock);
 }
 
 void CInstantSendDb::WriteInstantSendLockMined(const uint256& hash, int nHeight)
@@ -187,38 +267,24 @@ bool CInstantSendDb::HasArchivedInstantSendLock(const uint256& islockHash)
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByHash(const uint256& hash)
 {
-    CInstantSendLockPtr ret;
-    if (islockCache.get(hash, ret)) {
-        return ret;
-    }
-
-    ret = std::make_shared<CInstantSendLock>();
-    bool exists = db.Read(std::make_tuple(std::string("is_i"), hash), *ret);
-    if (!exists) {
-        ret = nullptr;
+    auto& shard = GetIndexShard(hash);
+    LOCK(shard.cs);
+    auto it = shard.islocks.find(hash);
+    if (it == shard.islocks.end()) {
+        return nullptr;
     }
-    islockCache.insert(hash, ret);
-    return ret;
+    return it->second;
 }
 
 uint256 CInstantSendDb::GetInstantSendLockHashByTxid(const uint256& txid)
 {
-    uint256 islockHash;
-
-    bool found = txidCache.get(txid, islockHash);
-    if (found && islockHash.IsNull()) {
-        return uint256();
-    }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_tx"), txid), islockHash);
-        txidCache.insert(txid, islockHash);
-    }
-
-    if (!found) {
+    auto& shard = GetIndexShard(txid);
+    LOCK(shard.cs);
+    auto it = shard.txids.find(txid);
+    if (it == shard.txids.end()) {
         return uint256();
     }
-    return islockHash;
+    return it->second;
 }
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid)
@@ -233,18 +299,14 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& outpoint)
 {
     uint256 islockHash;
-    bool found = outpointCache.get(outpoint, islockHash);
-    if (found && islockHash.IsNull()) {
-        return nullptr;
-    }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_in"), outpoint), islockHash);
-        outpointCache.insert(outpoint, islockHash);
-    }
-
-    if (!found) {
-        return nullptr;
+    {
+        auto& shard = GetIndexShard(outpoint);
+        LOCK(shard.cs);
+        auto it = shard.inputs.find(outpoint);
+        if (it == shard.inputs.end()) {
+            return nullptr;
+        }
+        islockHash = it->second;
     }
     return GetInstantSendLockByHash(islockHash);
 }
@@ -735,7 +797,11 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
         tipHeight = chainActive.Height();
     }
 
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+    // Verification is performed by the shared BLS worker, which batches our ISLOCKs together with recovered sigs and
+    // CLSIGs that are verified at the same time
+    std::set<NodeId> badSources;
+    std::set<uint256> badMessages;
+    std::vector<std::tuple<NodeId, uint256, std::future<bool>>> verifyResults;
     std::unordered_map<uint256, std::pair<CQuorumCPtr, CRecoveredSig>> recSigs;
 
     for (const auto& p : pend) {
@@ -743,12 +809,12 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             continue;
         }
 
         if (!islock.sig.Get().IsValid()) {
-            batchVerifier.badSources.emplace(nodeId);
+            badSources.emplace(nodeId);
             continue;
         }
 
@@ -765,7 +831,7 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
             return false;
         }
         uint256 signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc.quorumHash, id, islock.txid);
-        batchVerifier.PushMessage(nodeId, hash, signHash, islock.sig.Get(), quorum->qc.quorumPublicKey);
+        verifyResults.emplace_back(nodeId, hash, blsWorker->AsyncVerifySig(islock.sig.Get(), quorum->qc.quorumPublicKey, signHash));
 
         // We can reconstruct the CRecoveredSig objects from the islock and pass it to the signing manager, which
         // avoids unnecessary double-verification of the signature. We however only do this when verification here
@@ -783,28 +849,42 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
         }
     }
 
-    batchVerifier.Verify();
+    for (auto& r : verifyResults) {
+        if (!std::get<2>(r).get()) {
+            badSources.emplace(std::get<0>(r));
+            badMessages.emplace(std::get<1>(r));
+        }
+    }
 
-    if (!batchVerifier.badSources.empty()) {
+    if (!badSources.empty()) {
         LOCK(cs_main);
-        for (auto& nodeId : batchVerifier.badSources) {
+        for (auto& nodeId : badSources) {
             // Let's not be too harsh, as the peer might simply be unlucky and might have sent us an old lock which
             // does not validate anymore due to changed quorums
             Misbehaving(nodeId, 20);
         }
     }
+    std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>> verified;
+    verified.reserve(pend.size());
     for (const auto& p : pend) {
         auto& hash = p.first;
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badMessages.count(hash)) {
+        if (badMessages.count(hash)) {
             LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: invalid sig in islock, peer=%d\n", __func__,
                      islock.txid.ToString(), hash.ToString(), nodeId);
             continue;
         }
 
-        ProcessInstantSendLock(nodeId, hash, islock);
+        verified.emplace_back(nodeId, hash, std::make_shared<CInstantSendLock>(islock));
+    }
+
+    ProcessInstantSendLocks(verified);
+
+    for (auto& v : verified) {
+        auto& hash = std::get<1>(v);
+        auto& islock = *std::get<2>(v);
 
         // See comment further on top. We pass a reconstructed recovered sig to the signing manager to avoid
         // double-verification of the sig.
@@ -815,7 +895,7 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
             if (!quorumSigningManager->HasRecoveredSigForId(llmqType, recSig.id)) {
                 recSig.UpdateHash();
                 LogPrint("instantsend", "CInstantSendManager::%s -- txid=%s, islock=%s: passing reconstructed recSig to signing mgr, peer=%d\n", __func__,
-                         islock.txid.ToString(), hash.ToString(), nodeId);
+                         islock.txid.ToString(), hash.ToString(), std::get<0>(v));
                 quorumSigningManager->PushReconstructedRecoveredSig(recSig, quorum);
             }
         }
@@ -826,102 +906,267 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
 
 void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLock& islock)
 {
+    ProcessInstantSendLocks({std::make_tuple(from, hash, std::make_shared<CInstantSendLock>(islock))});
+}
+
+void CInstantSendLockBatch::Add(const uint256& hash, const CInstantSendLock& islock)
+{
+    hashes.emplace(hash);
+    txids[islock.txid] = hash;
+    for (auto& in : islock.inputs) {
+        inputs[in] = hash;
+    }
+}
+
+bool CInstantSendLockBatch::HasInstantSendLock(const uint256& hash) const
+{
+    return hashes.count(hash) != 0;
+}
+
+uint256 CInstantSendLockBatch::GetInstantSendLockHashByTxid(const uint256& txid) const
+{
+    auto it = txids.find(txid);
+    if (it == txids.end()) {
+        return uint256();
+    }
+    return it->second;
+}
+
+uint256 CInstantSendLockBatch::GetInstantSendLockHashByInput(const COutPoint& outpoint) const
+{
+    auto it = inputs.find(outpoint);
+    if (it == inputs.end()) {
+        return uint256();
+    }
+    return it->second;
+}
+
+std::vector<size_t> SortInstantSendLocksByDependencies(const std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>>& islocks,
+                                                              std::vector<std::vector<size_t>>& retChildren)
+{
+    std::unordered_map<uint256, size_t, StaticSaltedHasher> txidToIdx;
+    for (size_t i = 0; i < islocks.size(); i++) {
+        txidToIdx.emplace(std::get<2>(islocks[i])->txid, i);
+    }
+
+    retChildren.assign(islocks.size(), std::vector<size_t>());
+    std::vector<size_t> parentCounts(islocks.size(), 0);
+    for (size_t i = 0; i < islocks.size(); i++) {
+        std::set<size_t> parents;
+        for (auto& in : std::get<2>(islocks[i])->inputs) {
+            auto it = txidToIdx.find(in.hash);
+            if (it != txidToIdx.end() && it->second != i) {
+                parents.emplace(it->second);
+            }
+        }
+        for (auto j : parents) {
+            retChildren[j].emplace_back(i);
+            parentCounts[i]++;
+        }
+    }
+
+    std::vector<size_t> ret;
+    ret.reserve(islocks.size());
+    for (size_t i = 0; i < islocks.size(); i++) {
+        if (parentCounts[i] == 0) {
+            ret.emplace_back(i);
+        }
+    }
+    for (size_t pos = 0; pos < ret.size(); pos++) {
+        for (auto i : retChildren[ret[pos]]) {
+            if (--parentCounts[i] == 0) {
+                ret.emplace_back(i);
+            }
+        }
+    }
+    // islocks which depend on each other in a cycle can't belong to valid TXs, but they are still processed
+    for (size_t i = 0; i < islocks.size(); i++) {
+        if (parentCounts[i] != 0) {
+            ret.emplace_back(i);
+        }
+    }
+    return ret;
+}
+
+void SkipInstantSendLockAndChildren(size_t i, const std::vector<std::vector<size_t>>& children, std::vector<bool>& skip)
+{
+    std::vector<size_t> stack{i};
+    while (!stack.empty()) {
+        auto j = stack.back();
+        stack.pop_back();
+        if (skip[j]) {
+            continue;
+        }
+        skip[j] = true;
+        stack.insert(stack.end(), children[j].begin(), children[j].end());
+    }
+}
+
+void CInstantSendManager::ProcessInstantSendLocks(const std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>>& islocks)
+{
+    if (islocks.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<size_t>> children;
+    auto order = SortInstantSendLocksByDependencies(islocks, children);
+
     {
         LOCK(cs_main);
-        g_connman->RemoveAskFor(hash);
+        for (auto& v : islocks) {
+            g_connman->RemoveAskFor(std::get<1>(v));
+        }
     }
 
-    CTransactionRef tx;
-    uint256 hashBlock;
-    const CBlockIndex* pindexMined = nullptr;
-    // we ignore failure here as we must be able to propagate the lock even if we don't have the TX locally
-    if (GetTransaction(islock.txid, tx, Params().GetConsensus(), hashBlock)) {
-        if (!hashBlock.IsNull()) {
-            {
-                LOCK(cs_main);
-                pindexMined = mapBlockIndex.at(hashBlock);
+    std::vector<CTransactionRef> txs(islocks.size());
+    std::vector<uint256> hashBlocks(islocks.size());
+    std::vector<const CBlockIndex*> pindexesMined(islocks.size(), nullptr);
+    for (size_t i = 0; i < islocks.size(); i++) {
+        // we ignore failure here as we must be able to propagate the lock even if we don't have the TX locally
+        GetTransaction(std::get<2>(islocks[i])->txid, txs[i], Params().GetConsensus(), hashBlocks[i]);
+    }
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < islocks.size(); i++) {
+            if (!hashBlocks[i].IsNull()) {
+                pindexesMined[i] = mapBlockIndex.at(hashBlocks[i]);
             }
+        }
+    }
 
-            // Let's see if the TX that was locked by this islock is already mined in a ChainLocked block. If yes,
-            // we can simply ignore the islock, as the ChainLock implies locking of all TXs in that chain
-            if (llmq::chainLocksHandler->HasChainLock(pindexMined->nHeight, pindexMined->GetBlockHash())) {
-                LogPrint("instantsend", "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n", __func__,
-                         islock.txid.ToString(), hash.ToString(), hashBlock.ToString(), from);
-                return;
-            }
+    // islocks which are dropped or were removed again while processing the batch
+    std::vector<bool> skip(islocks.size(), false);
+
+    for (size_t i = 0; i < islocks.size(); i++) {
+        auto pindexMined = pindexesMined[i];
+        // Let's see if the TX that was locked by this islock is already mined in a ChainLocked block. If yes,
+        // we can simply ignore the islock, as the ChainLock implies locking of all TXs in that chain
+        if (pindexMined && llmq::chainLocksHandler->HasChainLock(pindexMined->nHeight, pindexMined->GetBlockHash())) {
+            LogPrint("instantsend", "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n", __func__,
+                     std::get<2>(islocks[i])->txid.ToString(), std::get<1>(islocks[i]).ToString(), hashBlocks[i].ToString(), std::get<0>(islocks[i]));
+            skip[i] = true;
         }
     }
 
+    std::vector<std::pair<uint256, CInstantSendLockPtr>> newIsLocks;
     {
         LOCK(cs);
 
-        LogPrint("instantsend", "CInstantSendManager::%s -- txid=%s, islock=%s: processsing islock, peer=%d\n", __func__,
-                 islock.txid.ToString(), hash.ToString(), from);
+        CInstantSendLockBatch batch;
+        std::vector<std::pair<uint256, int>> mined;
 
-        creatingInstantSendLocks.erase(islock.GetRequestId());
-        txToCreatingInstantSendLocks.erase(islock.txid);
+        for (auto i : order) {
+            if (skip[i]) {
+                continue;
+            }
+            auto from = std::get<0>(islocks[i]);
+            auto& hash = std::get<1>(islocks[i]);
+            auto& islock = *std::get<2>(islocks[i]);
 
-        CInstantSendLockPtr otherIsLock;
-        if (db.GetInstantSendLockByHash(hash)) {
-            return;
-        }
-        otherIsLock = db.GetInstantSendLockByTxid(islock.txid);
-        if (otherIsLock != nullptr) {
-            LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: duplicate islock, other islock=%s, peer=%d\n", __func__,
-                     islock.txid.ToString(), hash.ToString(), ::SerializeHash(*otherIsLock).ToString(), from);
-        }
-        for (auto& in : islock.inputs) {
-            otherIsLock = db.GetInstantSendLockByInput(in);
-            if (otherIsLock != nullptr) {
-                LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: conflicting input in islock. input=%s, other islock=%s, peer=%d\n", __func__,
-                         islock.txid.ToString(), hash.ToString(), in.ToStringShort(), ::SerializeHash(*otherIsLock).ToString(), from);
+            LogPrint("instantsend", "CInstantSendManager::%s -- txid=%s, islock=%s: processsing islock, peer=%d\n", __func__,
+                     islock.txid.ToString(), hash.ToString(), from);
+
+            creatingInstantSendLocks.erase(islock.GetRequestId());
+            txToCreatingInstantSendLocks.erase(islock.txid);
+
+            if (batch.HasInstantSendLock(hash) || db.GetInstantSendLockByHash(hash)) {
+                skip[i] = true;
+                continue;
+            }
+            auto otherIsLock = db.GetInstantSendLockByTxid(islock.txid);
+            uint256 otherHash = otherIsLock ? ::SerializeHash(*otherIsLock) : batch.GetInstantSendLockHashByTxid(islock.txid);
+            if (!otherHash.IsNull()) {
+                LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: duplicate islock, other islock=%s, peer=%d\n", __func__,
+                         islock.txid.ToString(), hash.ToString(), otherHash.ToString(), from);
+            }
+            for (auto& in : islock.inputs) {
+                otherIsLock = db.GetInstantSendLockByInput(in);
+                otherHash = otherIsLock ? ::SerializeHash(*otherIsLock) : batch.GetInstantSendLockHashByInput(in);
+                if (!otherHash.IsNull()) {
+                    LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: conflicting input in islock. input=%s, other islock=%s, peer=%d\n", __func__,
+                             islock.txid.ToString(), hash.ToString(), in.ToStringShort(), otherHash.ToString(), from);
+                }
+            }
+
+            batch.Add(hash, islock);
+            newIsLocks.emplace_back(hash, std::get<2>(islocks[i]));
+            if (pindexesMined[i]) {
+                mined.emplace_back(hash, pindexesMined[i]->nHeight);
             }
         }
 
-        db.WriteNewInstantSendLock(hash, islock);
-        if (pindexMined) {
-            db.WriteInstantSendLockMined(hash, pindexMined->nHeight);
+        db.WriteNewInstantSendLocks(newIsLocks, mined);
+
+        for (auto& p : newIsLocks) {
+            // This will also add children TXs to pendingRetryTxs
+            RemoveNonLockedTx(p.second->txid, true);
         }
+    }
 
-        // This will also add children TXs to pendingRetryTxs
-        RemoveNonLockedTx(islock.txid, true);
+    for (auto i : order) {
+        if (skip[i]) {
+            continue;
+        }
+        CInv inv(MSG_ISLOCK, std::get<1>(islocks[i]));
+        if (txs[i] != nullptr) {
+            g_connman->RelayInvFiltered(inv, *txs[i], LLMQS_PROTO_VERSION);
+        } else {
+            // we don't have the TX yet, so we only filter based on txid. Later when that TX arrives, we will re-announce
+            // with the TX taken into account.
+            g_connman->RelayInvFiltered(inv, std::get<2>(islocks[i])->txid, LLMQS_PROTO_VERSION);
+        }
     }
 
-    CInv inv(MSG_ISLOCK, hash);
-    if (tx != nullptr) {
-        g_connman->RelayInvFiltered(inv, *tx, LLMQS_PROTO_VERSION);
-    } else {
-        // we don't have the TX yet, so we only filter based on txid. Later when that TX arrives, we will re-announce
-        // with the TX taken into account.
-        g_connman->RelayInvFiltered(inv, islock.txid, LLMQS_PROTO_VERSION);
+    RemoveMempoolConflictsForLocks(newIsLocks);
+
+    // Parents are resolved before their children. When an islock gets removed because it conflicts with a ChainLocked
+    // TX, the islocks of this batch which spend from it were removed together with it
+    for (auto i : order) {
+        if (skip[i]) {
+            continue;
+        }
+        if (!ResolveBlockConflicts(std::get<1>(islocks[i]), *std::get<2>(islocks[i]))) {
+            SkipInstantSendLockAndChildren(i, children, skip);
+        }
     }
 
-    RemoveMempoolConflictsForLock(hash, islock);
-    ResolveBlockConflicts(hash, islock);
-    UpdateWalletTransaction(islock.txid, tx);
+    std::vector<std::pair<uint256, CTransactionRef>> lockedTxs;
+    for (auto i : order) {
+        if (!skip[i]) {
+            lockedTxs.emplace_back(std::get<2>(islocks[i])->txid, txs[i]);
+        }
+    }
+    UpdateWalletTransactions(lockedTxs);
 }
 
-void CInstantSendManager::UpdateWalletTransaction(const uint256& txid, const CTransactionRef& tx)
+void CInstantSendManager::UpdateWalletTransactions(const std::vector<std::pair<uint256, CTransactionRef>>& lockedTxs)
 {
 #ifdef ENABLE_WALLET
-    if (!pwalletMain) {
-        return;
-    }
-
-    if (pwalletMain->UpdatedTransaction(txid)) {
+    if (pwalletMain) {
         // notify an external script once threshold is reached
         std::string strCmd = GetArg("-instantsendnotify", "");
-        if (!strCmd.empty()) {
-            boost::replace_all(strCmd, "%s", txid.GetHex());
-            boost::thread t(runCommand, strCmd); // thread runs free
+
+        LOCK(pwalletMain->cs_wallet);
+        for (auto& p : lockedTxs) {
+            if (pwalletMain->UpdatedTransaction(p.first) && !strCmd.empty()) {
+                std::string strCmdTx = strCmd;
+                boost::replace_all(strCmdTx, "%s", p.first.GetHex());
+                boost::thread t(runCommand, strCmdTx); // thread runs free
+            }
         }
     }
 #endif
 
-    if (tx) {
-        GetMainSignals().NotifyTransactionLock(*tx);
+    unsigned int nUpdated = 0;
+    for (auto& p : lockedTxs) {
+        if (p.second) {
+            GetMainSignals().NotifyTransactionLock(*p.second);
+            nUpdated++;
+        }
+    }
+    if (nUpdated != 0) {
         // bump mempool counter to make sure newly mined txes are picked up by getblocktemplate
-        mempool.AddTransactionsUpdated(1);
+        mempool.AddTransactionsUpdated(nUpdated);
     }
 }
 
@@ -1121,23 +1366,30 @@ void CInstantSendManager::HandleFullyConfirmedBlock(const CBlockIndex* pindex)
     }
 }
 
-void CInstantSendManager::RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock)
+void CInstantSendManager::RemoveMempoolConflictsForLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& islocks)
 {
     std::unordered_map<uint256, CTransactionRef> toDelete;
+    // txids of the islocks which had conflicts
+    std::unordered_set<uint256, StaticSaltedHasher> lockedTxids;
 
     {
         LOCK(mempool.cs);
 
-        for (auto& in : islock.inputs) {
-            auto it = mempool.mapNextTx.find(in);
-            if (it == mempool.mapNextTx.end()) {
-                continue;
-            }
-            if (it->second->GetHash() != islock.txid) {
-                toDelete.emplace(it->second->GetHash(), mempool.get(it->second->GetHash()));
+        for (auto& p : islocks) {
+            auto& hash = p.first;
+            auto& islock = *p.second;
+            for (auto& in : islock.inputs) {
+                auto it = mempool.mapNextTx.find(in);
+                if (it == mempool.mapNextTx.end()) {
+                    continue;
+                }
+                if (it->second->GetHash() != islock.txid) {
+                    toDelete.emplace(it->second->GetHash(), mempool.get(it->second->GetHash()));
+                    lockedTxids.emplace(islock.txid);
 
-                LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: mempool TX %s with input %s conflicts with islock\n", __func__,
-                         islock.txid.ToString(), hash.ToString(), it->second->GetHash().ToString(), in.ToStringShort());
+                    LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: mempool TX %s with input %s conflicts with islock\n", __func__,
+                             islock.txid.ToString(), hash.ToString(), it->second->GetHash().ToString(), in.ToStringShort());
+                }
             }
         }
 
@@ -1153,11 +1405,13 @@ void CInstantSendManager::RemoveMempoolConflictsForLock(const uint256& hash, con
                 RemoveConflictedTx(*p.second);
             }
         }
-        AskNodesForLockedTx(islock.txid);
+        for (auto& txid : lockedTxids) {
+            AskNodesForLockedTx(txid);
+        }
     }
 }
 
-void CInstantSendManager::ResolveBlockConflicts(const uint256& islockHash, const llmq::CInstantSendLock& islock)
+bool CInstantSendManager::ResolveBlockConflicts(const uint256& islockHash, const llmq::CInstantSendLock& islock)
 {
     // Lets first collect all non-locked TXs which conflict with the given ISLOCK
     std::unordered_map<const CBlockIndex*, std::unordered_map<uint256, CTransactionRef, StaticSaltedHasher>> conflicts;
@@ -1204,7 +1458,7 @@ void CInstantSendManager::ResolveBlockConflicts(const uint256& islockHash, const
     // and its better to sacrifice individual ISLOCKs then to sacrifice whole ChainLocks.
     if (hasChainLockedConflict) {
         RemoveChainLockConflictingLock(islockHash, islock);
-        return;
+        return false;
     }
 
     bool activateBestChain = false;
@@ -1240,6 +1494,8 @@ void CInstantSendManager::ResolveBlockConflicts(const uint256& islockHash, const
             assert(false);
         }
     }
+
+    return true;
 }
 
 void CInstantSendManager::RemoveChainLockConflictingLock(const uint256& islockHash, const llmq::CInstantSendLock& islock)
@@ -1383,8 +1639,7 @@ bool CInstantSendManager::IsLocked(const uint256& txHash)
         return false;
     }
 
-    LOCK(cs);
-    return db.GetInstantSendLockByTxid(txHash) != nullptr;
+    return !db.GetInstantSendLockHashByTxid(txHash).IsNull();
 }
 
 bool CInstantSendManager::IsConflicted(const CTransaction& tx)
@@ -1398,7 +1653,6 @@ CInstantSendLockPtr CInstantSendManager::GetConflictingLock(const CTransaction&
         return nullptr;
     }
 
-    LOCK(cs);
     for (const auto& in : tx.vin) {
         auto otherIsLock = db.GetInstantSendLockByInput(in.prevout);
         if (!otherIsLock) {
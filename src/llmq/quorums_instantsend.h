@@ -8,9 +8,9 @@
 #include "quorums_signing.h"
 
 #include "coins.h"
-#include "unordered_lru_cache.h"
 #include "primitives/transaction.h"
 
+#include <array>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -43,16 +43,29 @@ typedef std::shared_ptr<CInstantSendLock> CInstantSendLockPtr;
 class CInstantSendDb
 {
 private:
+    static const size_t INDEX_SHARDS = 16;
+
+    // Entries are put into the shard selected by their own key, so the three maps of a shard are unrelated
+    struct IndexShard {
+        CCriticalSection cs;
+        std::unordered_map<uint256, CInstantSendLockPtr, StaticSaltedHasher> islocks;
+        std::unordered_map<uint256, uint256, StaticSaltedHasher> txids;
+        std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> inputs;
+    };
+
     CDBWrapper& db;
 
-    unordered_lru_cache<uint256, CInstantSendLockPtr, StaticSaltedHasher, 10000> islockCache;
-    unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache;
-    unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache;
+    // In-memory index of all islocks in the db (which are the ones not confirmed yet), so that lookups by hash, txid
+    // and input never have to read from the db. Built on startup and updated whenever islocks are written or removed.
+    // Lookups are thread-safe without holding any other lock
+    std::array<IndexShard, INDEX_SHARDS> index;
 
 public:
-    CInstantSendDb(CDBWrapper& _db) : db(_db) {}
+    CInstantSendDb(CDBWrapper& _db);
 
     void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock);
+    // writes the islocks and the heights of the already mined ones with a single leveldb write
+    void WriteNewInstantSendLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& islocks, const std::vector<std::pair<uint256, int>>& mined);
     void RemoveInstantSendLock(const uint256& hash, CInstantSendLockPtr islock);
     void RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock);
 
@@ -70,8 +83,40 @@ public:
 
     std::vector<uint256> GetInstantSendLocksByParent(const uint256& parent);
     std::vector<uint256> RemoveChainedInstantSendLocks(const uint256& islockHash, const uint256& txid, int nHeight);
+
+private:
+    IndexShard& GetIndexShard(const uint256& k) { return index[k.GetCheapHash() % INDEX_SHARDS]; }
+    IndexShard& GetIndexShard(const COutPoint& k) { return index[(k.hash.GetCheapHash() + k.n) % INDEX_SHARDS]; }
+    void LoadIndex();
+    void AddToIndex(const uint256& hash, const CInstantSendLockPtr& islock);
+    void RemoveFromIndex(const uint256& hash, const CInstantSendLock& islock);
+};
+
+// The islocks of a batch are only visible through the db after all of them got written, so conflicts between them are
+// tracked here while the batch is processed
+class CInstantSendLockBatch
+{
+private:
+    std::unordered_set<uint256, StaticSaltedHasher> hashes;
+    std::unordered_map<uint256, uint256, StaticSaltedHasher> txids;
+    std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> inputs;
+
+public:
+    void Add(const uint256& hash, const CInstantSendLock& islock);
+
+    bool HasInstantSendLock(const uint256& hash) const;
+    // these return a null hash if no islock of the batch locks the TX or the input
+    uint256 GetInstantSendLockHashByTxid(const uint256& txid) const;
+    uint256 GetInstantSendLockHashByInput(const COutPoint& outpoint) const;
 };
 
+// Orders the islocks of a batch so that every islock comes after the islocks of the TXs it spends from. Islocks which
+// depend on each other in a cycle come last. retChildren receives the indexes of the islocks which spend from each islock
+std::vector<size_t> SortInstantSendLocksByDependencies(const std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>>& islocks,
+                                                       std::vector<std::vector<size_t>>& retChildren);
+// Marks the islock at index i and all islocks of the batch which spend from it, directly or indirectly, as skipped
+void SkipInstantSendLockAndChildren(size_t i, const std::vector<std::vector<size_t>>& children, std::vector<bool>& skip);
+
 class CInstantSendManager : public CRecoveredSigsListener
 {
 private:
@@ -138,7 +183,9 @@ public:
     bool PreVerifyInstantSendLock(NodeId nodeId, const CInstantSendLock& islock, bool& retBan);
     bool ProcessPendingInstantSendLocks();
     void ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLock& islock);
-    void UpdateWalletTransaction(const uint256& txid, const CTransactionRef& tx);
+    // processes all islocks of a batch together, with a single db write and a single mempool and wallet pass
+    void ProcessInstantSendLocks(const std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>>& islocks);
+    void UpdateWalletTransactions(const std::vector<std::pair<uint256, CTransactionRef>>& lockedTxs);
 
     void SyncTransaction(const CTransaction &tx, const CBlockIndex *pindex, int posInBlock);
     void AddNonLockedTx(const CTransactionRef& tx);
@@ -150,8 +197,9 @@ public:
 
     void HandleFullyConfirmedBlock(const CBlockIndex* pindex);
 
-    void RemoveMempoolConflictsForLock(const uint256& hash, const CInstantSendLock& islock);
-    void ResolveBlockConflicts(const uint256& islockHash, const CInstantSendLock& islock);
+    void RemoveMempoolConflictsForLocks(const std::vector<std::pair<uint256, CInstantSendLockPtr>>& islocks);
+    // returns false if the islock was removed because it conflicts with a ChainLocked TX
+    bool ResolveBlockConflicts(const uint256& islockHash, const CInstantSendLock& islock);
     void RemoveChainLockConflictingLock(const uint256& islockHash, const CInstantSendLock& islock);
     void AskNodesForLockedTx(const uint256& txid);
     bool ProcessPendingRetryLockTxs();
@@ -3,22 +3,27 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "quorums_signing.h"
+#include "quorums_init.h"
 #include "quorums_utils.h"
 #include "quorums_signing_shares.h"
 
 #include "activemasternode.h"
-#include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "cxxtimer.hpp"
 #include "init.h"
 #include "net_processing.h"
 #include "netmessagemaker.h"
 #include "scheduler.h"
+#include "timedata.h"
+#include "utilstrencodings.h"
 #include "validation.h"
 
 #include <algorithm>
 #include <limits>
 #include <unordered_set>
 
+#include <boost/filesystem/operations.hpp>
+
 namespace llmq
 {
 
@@ -36,99 +41,256 @@ UniValue CRecoveredSig::ToJson() const
     return ret;
 }
 
-CRecoveredSigsDb::CRecoveredSigsDb(CDBWrapper& _db) :
-    db(_db)
+CRecoveredSigsSegment::CRecoveredSigsSegment(int64_t _startTime, const boost::filesystem::path& _path, bool fMemory, size_t nExpectedKeys) :
+    startTime(_startTime),
+    path(_path)
 {
-    if (Params().NetworkIDString() == CBaseChainParams::TESTNET) {
-        // TODO this can be completely removed after some time (when we're pretty sure the conversion has been run on most testnet MNs)
-        if (db.Exists(std::string("rs_upgraded"))) {
-            return;
+    // all segments but the newest one are only read from, they don't need many open files
+    CDBWrapperOptions dbOptions;
+    dbOptions.nMaxOpenFiles = 16;
+    db.reset(new CDBWrapper(fMemory ? "" : path, 1 << 20, fMemory, false, false, dbOptions));
+    LoadFilter(nExpectedKeys);
+}
+
+CRecoveredSigsSegment::~CRecoveredSigsSegment()
+{
+    db.reset();
+    if (fDrop && !path.empty()) {
+        try {
+            boost::filesystem::remove_all(path);
+        } catch (const boost::filesystem::filesystem_error& e) {
+            LogPrintf("CRecoveredSigsSegment::%s -- failed to remove %s: %s\n", __func__, path.string(), e.what());
         }
+    }
+}
 
-        ConvertInvalidTimeKeys();
-        AddVoteTimeKeys();
+void CRecoveredSigsSegment::AddKey(const uint256& key)
+{
+    if (keyCount >= filterCapacity) {
+        size_t nKeys = std::max(filterCapacity, (size_t)MIN_FILTER_KEYS);
+        filters.emplace_back(nKeys, 0.001);
+        filterCapacity += nKeys;
+    }
+    filters.back().insert(key);
+    keyCount++;
+}
 
-        db.Write(std::string("rs_upgraded"), (uint8_t)1);
+bool CRecoveredSigsSegment::MayContainKey(const uint256& key) const
+{
+    for (auto& filter : filters) {
+        if (filter.contains(key)) {
+            return true;
+        }
     }
+    return false;
 }
 
-// This converts time values in "rs_t" from host endiannes to big endiannes, which is required to have proper ordering of the keys
-void CRecoveredSigsDb::ConvertInvalidTimeKeys()
+void CRecoveredSigsSegment::LoadFilter(size_t nExpectedKeys)
 {
-    LogPrintf("CRecoveredSigsDb::%s -- converting invalid rs_t keys\n", __func__);
+    std::unique_ptr<CDBIterator> pcursor(db->NewIterator());
 
-    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    // the keys are collected first, so that the filter is sized for all of them
+    std::vector<uint256> keys;
 
-    auto start = std::make_tuple(std::string("rs_t"), (uint32_t)0, (uint8_t)0, uint256());
-    pcursor->Seek(start);
+    // rs_r and rs_v keys start with the llmqType and id. The rs_r keys of a recovered sig are next to each other
+    for (const std::string& prefix : {std::string("rs_r"), std::string("rs_v")}) {
+        auto start = std::make_tuple(prefix, (uint8_t)0, uint256());
+        uint256 prevId;
+        for (pcursor->Seek(start); pcursor->Valid(); pcursor->Next()) {
+            decltype(start) k;
+            if (!pcursor->GetKey(k) || std::get<0>(k) != prefix) {
+                break;
+            }
+            if (std::get<2>(k) != prevId) {
+                prevId = std::get<2>(k);
+                keys.emplace_back(prevId);
+            }
+        }
+    }
+    // rs_h and rs_s keys only consist of a hash
+    for (const std::string& prefix : {std::string("rs_h"), std::string("rs_s")}) {
+        auto start = std::make_tuple(prefix, uint256());
+        for (pcursor->Seek(start); pcursor->Valid(); pcursor->Next()) {
+            decltype(start) k;
+            if (!pcursor->GetKey(k) || std::get<0>(k) != prefix) {
+                break;
+            }
+            keys.emplace_back(std::get<1>(k));
+        }
+    }
 
-    CDBBatch batch(db);
-    size_t cnt = 0;
-    while (pcursor->Valid()) {
-        decltype(start) k;
+    // the newest segment gets more keys after loading
+    filterCapacity = std::max(std::max(nExpectedKeys, keys.size() * 2), (size_t)MIN_FILTER_KEYS);
+    filters.emplace_back(filterCapacity, 0.001);
+    for (auto& key : keys) {
+        AddKey(key);
+    }
+}
+
+CRecoveredSigsDb::CRecoveredSigsDb(CDBWrapper& llmqDb, bool _fMemory, int64_t maxAge) :
+    fMemory(_fMemory),
+    segmentDuration(std::max<int64_t>(maxAge / SEGMENTS_PER_MAX_AGE, 1))
+{
+    if (!fMemory) {
+        segmentsDir = GetDataDir() / "llmq" / "recsigs";
+        TryCreateDirectory(segmentsDir);
+        LoadSegments();
+    }
+
+    MigrateFromLLMQDb(llmqDb);
+}
 
-        if (!pcursor->GetKey(k) || std::get<0>(k) != "rs_t") {
-            break;
+void CRecoveredSigsDb::LoadSegments()
+{
+    cxxtimer::Timer t(true);
+
+    LOCK(cs);
+    for (boost::filesystem::directory_iterator it(segmentsDir); it != boost::filesystem::directory_iterator(); ++it) {
+        int64_t startTime;
+        if (!boost::filesystem::is_directory(it->path()) || !ParseInt64(it->path().filename().string(), &startTime)) {
+            continue;
         }
+        segments.emplace(startTime, std::make_shared<CRecoveredSigsSegment>(startTime, it->path(), false, 0));
+    }
 
-        batch.Erase(k);
-        std::get<1>(k) = htobe32(std::get<1>(k));
-        batch.Write(k, (uint8_t)1);
+    LogPrintf("CRecoveredSigsDb::%s -- loaded %d segments. time=%d\n", __func__, segments.size(), t.count());
+}
 
-        cnt++;
+// Recovered sigs and votes used to be stored in the llmq db, with time keys which were used to delete them one by one.
+// This moves them into segments by the time they were written at and removes them from the llmq db.
+void CRecoveredSigsDb::MigrateFromLLMQDb(CDBWrapper& llmqDb)
+{
+    std::unique_ptr<CDBIterator> pcursor(llmqDb.NewIterator());
 
-        pcursor->Next();
+    // time, true for votes, llmqType, id
+    std::vector<std::tuple<uint32_t, bool, uint8_t, uint256>> entries;
+    for (const std::string& prefix : {std::string("rs_t"), std::string("rs_vt")}) {
+        auto start = std::make_tuple(prefix, (uint32_t)0, (uint8_t)0, uint256());
+        for (pcursor->Seek(start); pcursor->Valid(); pcursor->Next()) {
+            decltype(start) k;
+            if (!pcursor->GetKey(k) || std::get<0>(k) != prefix) {
+                break;
+            }
+            entries.emplace_back(be32toh(std::get<1>(k)), prefix == "rs_vt", std::get<2>(k), std::get<3>(k));
+        }
     }
     pcursor.reset();
 
-    db.WriteBatch(batch);
+    if (entries.empty()) {
+        return;
+    }
 
-    LogPrintf("CRecoveredSigsDb::%s -- converted %d invalid rs_t keys\n", __func__, cnt);
-}
+    LogPrintf("CRecoveredSigsDb::%s -- moving %d recovered sigs and votes into segments\n", __func__, entries.size());
 
-// This adds rs_vt keys for every rs_v entry to the DB. The time in the key is set to the current time.
-// This causes cleanup of all these votes a week later.
-void CRecoveredSigsDb::AddVoteTimeKeys()
-{
-    LogPrintf("CRecoveredSigsDb::%s -- adding rs_vt keys with current time\n", __func__);
+    // segments are only ever appended to, so the entries must be written in the order of time
+    std::stable_sort(entries.begin(), entries.end(), [](const decltype(entries)::value_type& a, const decltype(entries)::value_type& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
 
-    auto curTime = GetAdjustedTime();
+    CDBBatch batch(llmqDb);
+    for (auto& e : entries) {
+        uint32_t time = std::get<0>(e);
+        uint8_t llmqType = std::get<2>(e);
+        const uint256& id = std::get<3>(e);
+
+        if (std::get<1>(e)) {
+            auto k1 = std::make_tuple(std::string("rs_v"), llmqType, id);
+            uint256 msgHash;
+            if (llmqDb.Read(k1, msgHash)) {
+                WriteVoteForId((Consensus::LLMQType)llmqType, id, msgHash, time);
+            }
+            batch.Erase(k1);
+            batch.Erase(std::make_tuple(std::string("rs_vt"), (uint32_t)htobe32(time), llmqType, id));
+        } else {
+            auto k1 = std::make_tuple(std::string("rs_r"), llmqType, id);
+            CRecoveredSig recSig;
+            if (llmqDb.Read(k1, recSig)) {
+                WriteRecoveredSig(recSig, time);
+                batch.Erase(std::make_tuple(std::string("rs_r"), llmqType, id, recSig.msgHash));
+                batch.Erase(std::make_tuple(std::string("rs_h"), recSig.GetHash()));
+                batch.Erase(std::make_tuple(std::string("rs_s"), CLLMQUtils::BuildSignHash(recSig)));
+            }
+            batch.Erase(k1);
+            batch.Erase(std::make_tuple(std::string("rs_t"), (uint32_t)htobe32(time), llmqType, id));
+        }
 
-    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        if (batch.SizeEstimate() >= (1 << 24)) {
+            llmqDb.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    batch.Erase(std::string("rs_upgraded"));
+    llmqDb.WriteBatch(batch);
 
-    auto start = std::make_tuple(std::string("rs_v"), (uint8_t)0, uint256());
-    pcursor->Seek(start);
+    LogPrintf("CRecoveredSigsDb::%s -- done, %d segments\n", __func__, segments.size());
+}
 
-    CDBBatch batch(db);
-    size_t cnt = 0;
-    while (pcursor->Valid()) {
-        decltype(start) k;
+CRecoveredSigsSegmentPtr CRecoveredSigsDb::GetSegmentForWrite(int64_t time)
+{
+    AssertLockHeld(cs);
 
-        if (!pcursor->GetKey(k) || std::get<0>(k) != "rs_v") {
-            break;
+    // segments only roll over with time, so that there are never more than SEGMENTS_PER_MAX_AGE + 1 of them after a
+    // cleanup, no matter how many recovered sigs are written
+    size_t nExpectedKeys = 0;
+    if (!segments.empty()) {
+        auto& segment = segments.rbegin()->second;
+        if (time < segment->startTime + segmentDuration) {
+            return segment;
         }
+        // the filter of the new segment is sized for the rate the newest segment got its keys at, with some headroom
+        int64_t duration = std::max<int64_t>(std::min(time - segment->startTime, segmentDuration), 1);
+        nExpectedKeys = std::min((size_t)((double)segment->keyCount * segmentDuration / duration * 1.25), (size_t)CRecoveredSigsSegment::MAX_FILTER_KEYS);
+    }
 
-        uint8_t llmqType = std::get<1>(k);
-        const uint256& id = std::get<2>(k);
+    // segments are named by their start time, which must be unique
+    int64_t startTime = segments.empty() ? time : std::max(time, segments.rbegin()->first + 1);
+    auto segment = std::make_shared<CRecoveredSigsSegment>(startTime, fMemory ? boost::filesystem::path() : segmentsDir / strprintf("%d", startTime), fMemory, nExpectedKeys);
+    segments.emplace(startTime, segment);
 
-        auto k2 = std::make_tuple(std::string("rs_vt"), (uint32_t)htobe32(curTime), llmqType, id);
-        batch.Write(k2, (uint8_t)1);
+    LogPrint("llmq", "CRecoveredSigsDb::%s -- started new segment %d, filter for %d keys\n", __func__, startTime, segment->filterCapacity);
 
-        cnt++;
+    return segment;
+}
 
-        pcursor->Next();
+std::vector<CRecoveredSigsSegmentPtr> CRecoveredSigsDb::GetSegmentsForKey(const uint256& key)
+{
+    std::vector<CRecoveredSigsSegmentPtr> ret;
+
+    LOCK(cs);
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+        if (it->second->MayContainKey(key)) {
+            ret.emplace_back(it->second);
+        }
     }
-    pcursor.reset();
+    return ret;
+}
 
-    db.WriteBatch(batch);
+template<typename K>
+bool CRecoveredSigsDb::Exists(const uint256& filterKey, const K& k)
+{
+    for (auto& segment : GetSegmentsForKey(filterKey)) {
+        if (segment->db->Exists(k)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    LogPrintf("CRecoveredSigsDb::%s -- added %d rs_vt entries\n", __func__, cnt);
+template<typename K, typename V>
+bool CRecoveredSigsDb::Read(const uint256& filterKey, const K& k, V& v)
+{
+    for (auto& segment : GetSegmentsForKey(filterKey)) {
+        if (segment->db->Read(k, v)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool CRecoveredSigsDb::HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash)
 {
     auto k = std::make_tuple(std::string("rs_r"), (uint8_t)llmqType, id, msgHash);
-    return db.Exists(k);
+    return Exists(id, k);
 }
 
 bool CRecoveredSigsDb::HasRecoveredSigForId(Consensus::LLMQType llmqType, const uint256& id)
@@ -144,7 +306,7 @@ bool CRecoveredSigsDb::HasRecoveredSigForId(Consensus::LLMQType llmqType, const
 
 
     auto k = std::make_tuple(std::string("rs_r"), (uint8_t)llmqType, id);
-    ret = db.Exists(k);
+    ret = Exists(id, k);
 
     LOCK(cs);
     hasSigForIdCache.insert(cacheKey, ret);
@@ -162,7 +324,7 @@ bool CRecoveredSigsDb::HasRecoveredSigForSession(const uint256& signHash)
     }
 
     auto k = std::make_tuple(std::string("rs_s"), signHash);
-    ret = db.Exists(k);
+    ret = Exists(signHash, k);
 
     LOCK(cs);
     hasSigForSessionCache.insert(signHash, ret);
@@ -180,49 +342,50 @@ bool CRecoveredSigsDb::HasRecoveredSigForHash(const uint256& hash)
     }
 
     auto k = std::make_tuple(std::string("rs_h"), hash);
-    ret = db.Exists(k);
+    ret = Exists(hash, k);
 
     LOCK(cs);
     hasSigForHashCache.insert(hash, ret);
     return ret;
 }
 
-bool CRecoveredSigsDb::ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret)
-{
-    auto k = std::make_tuple(std::string("rs_r"), (uint8_t)llmqType, id);
-
-    CDataStream ds(SER_DISK, CLIENT_VERSION);
-    if (!db.ReadDataStream(k, ds)) {
-        return false;
-    }
-
-    try {
-        ret.Unserialize(ds);
-        return true;
-    } catch (std::exception&) {
-        return false;
-    }
-}
-
 bool CRecoveredSigsDb::GetRecoveredSigByHash(const uint256& hash, CRecoveredSig& ret)
 {
     auto k1 = std::make_tuple(std::string("rs_h"), hash);
-    std::pair<uint8_t, uint256> k2;
-    if (!db.Read(k1, k2)) {
-        return false;
+    for (auto& segment : GetSegmentsForKey(hash)) {
+        std::pair<uint8_t, uint256> k2;
+        if (segment->db->Read(k1, k2)) {
+            return segment->db->Read(std::make_tuple(std::string("rs_r"), k2.first, k2.second), ret);
+        }
     }
-
-    return ReadRecoveredSig((Consensus::LLMQType)k2.first, k2.second, ret);
+    return false;
 }
 
 bool CRecoveredSigsDb::GetRecoveredSigById(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret)
 {
-    return ReadRecoveredSig(llmqType, id, ret);
+    auto k = std::make_tuple(std::string("rs_r"), (uint8_t)llmqType, id);
+    return Read(id, k, ret);
 }
 
 void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
 {
-    CDBBatch batch(db);
+    WriteRecoveredSig(recSig, GetAdjustedTime());
+}
+
+void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig, int64_t time)
+{
+    auto signHash = CLLMQUtils::BuildSignHash(recSig);
+
+    CRecoveredSigsSegmentPtr segment;
+    {
+        LOCK(cs);
+        segment = GetSegmentForWrite(time);
+        segment->AddKey(recSig.id);
+        segment->AddKey(recSig.GetHash());
+        segment->AddKey(signHash);
+    }
+
+    CDBBatch batch(*segment->db);
 
     // we put these close to each other to leverage leveldb's key compaction
     // this way, the second key can be used for fast HasRecoveredSig checks while the first key stores the recSig
@@ -236,19 +399,12 @@ void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
     batch.Write(k3, std::make_pair(recSig.llmqType, recSig.id));
 
     // store by signHash
-    auto signHash = CLLMQUtils::BuildSignHash(recSig);
     auto k4 = std::make_tuple(std::string("rs_s"), signHash);
     batch.Write(k4, (uint8_t)1);
 
-    // store by current time. Allows fast cleanup of old recSigs
-    auto k5 = std::make_tuple(std::string("rs_t"), (uint32_t)htobe32(GetAdjustedTime()), recSig.llmqType, recSig.id);
-    batch.Write(k5, (uint8_t)1);
-
-    db.WriteBatch(batch);
+    segment->db->WriteBatch(batch);
 
     {
-        int64_t t = GetTimeMillis();
-
         LOCK(cs);
         hasSigForIdCache.insert(std::make_pair((Consensus::LLMQType)recSig.llmqType, recSig.id), true);
         hasSigForSessionCache.insert(signHash, true);
@@ -256,147 +412,73 @@ void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig& recSig)
     }
 }
 
-void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge)
+void CRecoveredSigsDb::CleanupOldSegments(int64_t maxAge)
 {
-    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
-
-    auto start = std::make_tuple(std::string("rs_t"), (uint32_t)0, (uint8_t)0, uint256());
-    uint32_t endTime = (uint32_t)(GetAdjustedTime() - maxAge);
-    pcursor->Seek(start);
-
-    std::vector<std::pair<Consensus::LLMQType, uint256>> toDelete;
-    std::vector<decltype(start)> toDelete2;
-
-    while (pcursor->Valid()) {
-        decltype(start) k;
-
-        if (!pcursor->GetKey(k) || std::get<0>(k) != "rs_t") {
-            break;
-        }
-        if (be32toh(std::get<1>(k)) >= endTime) {
-            break;
-        }
+    int64_t endTime = GetAdjustedTime() - maxAge;
 
-        toDelete.emplace_back((Consensus::LLMQType)std::get<2>(k), std::get<3>(k));
-        toDelete2.emplace_back(k);
+    LOCK(cs);
 
-        pcursor->Next();
+    // A segment only contains entries which were written before the next segment was started. The newest segment is
+    // kept, even if it's old, as new entries are written to it
+    size_t cnt = 0;
+    while (segments.size() > 1 && std::next(segments.begin())->first < endTime) {
+        // the files are removed as soon as no other thread is reading from the segment anymore
+        segments.begin()->second->fDrop = true;
+        segments.erase(segments.begin());
+        cnt++;
     }
-    pcursor.reset();
 
-    if (toDelete.empty()) {
+    if (cnt == 0) {
         return;
     }
 
-    CDBBatch batch(db);
-    {
-        LOCK(cs);
-        for (auto& e : toDelete) {
-            CRecoveredSig recSig;
-            if (!ReadRecoveredSig(e.first, e.second, recSig)) {
-                continue;
-            }
+    hasSigForIdCache.clear();
+    hasSigForSessionCache.clear();
+    hasSigForHashCache.clear();
 
-            auto signHash = CLLMQUtils::BuildSignHash(recSig);
-
-            auto k1 = std::make_tuple(std::string("rs_r"), recSig.llmqType, recSig.id);
-            auto k2 = std::make_tuple(std::string("rs_r"), recSig.llmqType, recSig.id, recSig.msgHash);
-            auto k3 = std::make_tuple(std::string("rs_h"), recSig.GetHash());
-            auto k4 = std::make_tuple(std::string("rs_s"), signHash);
-            batch.Erase(k1);
-            batch.Erase(k2);
-            batch.Erase(k3);
-            batch.Erase(k4);
-
-            hasSigForIdCache.erase(std::make_pair((Consensus::LLMQType)recSig.llmqType, recSig.id));
-            hasSigForSessionCache.erase(signHash);
-            hasSigForHashCache.erase(recSig.GetHash());
-
-            if (batch.SizeEstimate() >= (1 << 24)) {
-                db.WriteBatch(batch);
-                batch.Clear();
-            }
-        }
-    }
-
-    for (auto& e : toDelete2) {
-        batch.Erase(e);
-    }
-
-    db.WriteBatch(batch);
+    LogPrint("llmq", "CRecoveredSigsDb::%s -- dropped %d segments\n", __func__, cnt);
+}
 
-    LogPrint("llmq", "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, toDelete.size());
+size_t CRecoveredSigsDb::GetSegmentCount()
+{
+    LOCK(cs);
+    return segments.size();
 }
 
 bool CRecoveredSigsDb::HasVotedOnId(Consensus::LLMQType llmqType, const uint256& id)
 {
     auto k = std::make_tuple(std::string("rs_v"), (uint8_t)llmqType, id);
-    return db.Exists(k);
+    return Exists(id, k);
 }
 
 bool CRecoveredSigsDb::GetVoteForId(Consensus::LLMQType llmqType, const uint256& id, uint256& msgHashRet)
 {
     auto k = std::make_tuple(std::string("rs_v"), (uint8_t)llmqType, id);
-    return db.Read(k, msgHashRet);
+    return Read(id, k, msgHashRet);
 }
 
 void CRecoveredSigsDb::WriteVoteForId(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash)
 {
-    auto k1 = std::make_tuple(std::string("rs_v"), (uint8_t)llmqType, id);
-    auto k2 = std::make_tuple(std::string("rs_vt"), (uint32_t)htobe32(GetAdjustedTime()), (uint8_t)llmqType, id);
-
-    CDBBatch batch(db);
-    batch.Write(k1, msgHash);
-    batch.Write(k2, (uint8_t)1);
-
-    db.WriteBatch(batch);
+    WriteVoteForId(llmqType, id, msgHash, GetAdjustedTime());
 }
 
-void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
+void CRecoveredSigsDb::WriteVoteForId(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash, int64_t time)
 {
-    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
-
-    auto start = std::make_tuple(std::string("rs_vt"), (uint32_t)0, (uint8_t)0, uint256());
-    uint32_t endTime = (uint32_t)(GetAdjustedTime() - maxAge);
-    pcursor->Seek(start);
-
-    CDBBatch batch(db);
-    size_t cnt = 0;
-    while (pcursor->Valid()) {
-        decltype(start) k;
-
-        if (!pcursor->GetKey(k) || std::get<0>(k) != "rs_vt") {
-            break;
-        }
-        if (be32toh(std::get<1>(k)) >= endTime) {
-            break;
-        }
-
-        uint8_t llmqType = std::get<2>(k);
-        const uint256& id = std::get<3>(k);
-
-        batch.Erase(k);
-        batch.Erase(std::make_tuple(std::string("rs_v"), llmqType, id));
-
-        cnt++;
-
-        pcursor->Next();
-    }
-    pcursor.reset();
-
-    if (cnt == 0) {
-        return;
+    CRecoveredSigsSegmentPtr segment;
+    {
+        LOCK(cs);
+        segment = GetSegmentForWrite(time);
+        segment->AddKey(id);
     }
 
-    db.WriteBatch(batch);
-
-    LogPrint("llmq", "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, cnt);
+    auto k = std::make_tuple(std::string("rs_v"), (uint8_t)llmqType, id);
+    segment->db->Write(k, msgHash);
 }
 
 //////////////////
 
 CSigningManager::CSigningManager(CDBWrapper& llmqDb, bool fMemory) :
-    db(llmqDb)
+    db(llmqDb, fMemory, GetArg("-recsigsmaxage", DEFAULT_MAX_RECOVERED_SIGS_AGE))
 {
 }
 
@@ -564,10 +646,12 @@ bool CSigningManager::ProcessPendingRecoveredSigs(CConnman& connman)
         return false;
     }
 
-    // It's ok to perform insecure batched verification here as we verify against the quorum public keys, which are not
-    // craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, false);
+    // Verification is performed by the shared BLS worker, which batches our recovered sigs together with ISLOCKs and
+    // CLSIGs that are verified at the same time
+    std::set<NodeId> badSources;
+    std::vector<std::pair<NodeId, std::future<bool>>> verifyResults;
 
+    cxxtimer::Timer verifyTimer(true);
     size_t verifyCount = 0;
     for (auto& p : recSigsByNode) {
         NodeId nodeId = p.first;
@@ -576,18 +660,21 @@ bool CSigningManager::ProcessPendingRecoveredSigs(CConnman& connman)
         for (auto& recSig : v) {
             // we didn't verify the lazy signature until now
             if (!recSig.sig.Get().IsValid()) {
-                batchVerifier.badSources.emplace(nodeId);
+                badSources.emplace(nodeId);
                 break;
             }
 
             const auto& quorum = quorums.at(std::make_pair((Consensus::LLMQType)recSig.llmqType, recSig.quorumHash));
-            batchVerifier.PushMessage(nodeId, recSig.GetHash(), CLLMQUtils::BuildSignHash(recSig), recSig.sig.Get(), quorum->qc.quorumPublicKey);
+            verifyResults.emplace_back(nodeId, blsWorker->AsyncVerifySig(recSig.sig.Get(), quorum->qc.quorumPublicKey, CLLMQUtils::BuildSignHash(recSig)));
             verifyCount++;
         }
     }
 
-    cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    for (auto& r : verifyResults) {
+        if (!r.second.get()) {
+            badSources.emplace(r.first);
+        }
+    }
     verifyTimer.stop();
 
     LogPrint("llmq", "CSigningManager::%s -- verified recovered sig(s). count=%d, vt=%d, nodes=%d\n", __func__, verifyCount, verifyTimer.count(), recSigsByNode.size());
@@ -597,7 +684,7 @@ bool CSigningManager::ProcessPendingRecoveredSigs(CConnman& connman)
         NodeId nodeId = p.first;
         auto& v = p.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             LOCK(cs_main);
             LogPrintf("CSigningManager::%s -- invalid recSig from other node, banning peer=%d\n", __func__, nodeId);
             Misbehaving(nodeId, 100);
@@ -689,8 +776,7 @@ void CSigningManager::Cleanup()
 
     int64_t maxAge = GetArg("-recsigsmaxage", DEFAULT_MAX_RECOVERED_SIGS_AGE);
 
-    db.CleanupOldRecoveredSigs(maxAge);
-    db.CleanupOldVotes(maxAge);
+    db.CleanupOldSegments(maxAge);
 
     lastCleanupTime = GetTimeMillis();
 }
@@ -858,6 +944,7 @@ bool CSigningManager::VerifyRecoveredSig(Consensus::LLMQType llmqType, int signe
     }
 
     uint256 signHash = CLLMQUtils::BuildSignHash(llmqParams.type, quorum->qc.quorumHash, id, msgHash);
+    // verified right away, CLSIGs must not wait behind the DKG and sig share work of the BLS worker
     return sig.VerifyInsecure(quorum->qc.quorumPublicKey, signHash);
 }
 
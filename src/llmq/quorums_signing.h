@@ -7,13 +7,18 @@
 
 #include "llmq/quorums.h"
 
+#include "bloom.h"
 #include "net.h"
 #include "chainparams.h"
 #include "saltedhasher.h"
 #include "univalue.h"
 #include "unordered_lru_cache.h"
 
+#include <map>
 #include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
 
 namespace llmq
 {
@@ -61,21 +66,64 @@ public:
     UniValue ToJson() const;
 };
 
+/**
+ * One segment of the recovered sigs db. Each segment is a separate LevelDB database which holds the recovered sigs and
+ * votes written during one period of time, so that old entries can be removed by dropping the whole segment instead of
+ * deleting them one by one. A bloom filter over the ids and hashes stored in the segment avoids most lookups in
+ * segments which don't have the entry.
+ */
+class CRecoveredSigsSegment
+{
+public:
+    // bounds of the number of ids and hashes the filter of a new segment is sized for
+    static const size_t MIN_FILTER_KEYS = 10000;
+    static const size_t MAX_FILTER_KEYS = 1000000;
+
+    const int64_t startTime;
+    const boost::filesystem::path path;
+    std::unique_ptr<CDBWrapper> db;
+
+    // protected by CRecoveredSigsDb::cs
+    // A rolling bloom filter forgets the oldest keys when it gets more than it was sized for. When the newest filter
+    // is full, one which is as big as all previous ones together takes the new keys.
+    std::vector<CRollingBloomFilter> filters;
+    size_t filterCapacity{0};
+    size_t keyCount{0};
+    bool fDrop{false};
+
+public:
+    CRecoveredSigsSegment(int64_t _startTime, const boost::filesystem::path& _path, bool fMemory, size_t nExpectedKeys);
+    ~CRecoveredSigsSegment();
+
+    void AddKey(const uint256& key);
+    bool MayContainKey(const uint256& key) const;
+
+private:
+    void LoadFilter(size_t nExpectedKeys);
+};
+typedef std::shared_ptr<CRecoveredSigsSegment> CRecoveredSigsSegmentPtr;
+
 class CRecoveredSigsDb
 {
+    // the entries of maxAge are spread over this many segments, bounding the number of segments
+    static const int64_t SEGMENTS_PER_MAX_AGE = 8;
+
 private:
-    CDBWrapper& db;
+    bool fMemory;
+    boost::filesystem::path segmentsDir;
+    // a new segment is started when the newest one is older than this
+    int64_t segmentDuration;
 
     CCriticalSection cs;
+    // by start time
+    std::map<int64_t, CRecoveredSigsSegmentPtr> segments;
+
     unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, bool, StaticSaltedHasher, 30000> hasSigForIdCache;
     unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForSessionCache;
     unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForHashCache;
 
 public:
-    CRecoveredSigsDb(CDBWrapper& _db);
-
-    void ConvertInvalidTimeKeys();
-    void AddVoteTimeKeys();
+    CRecoveredSigsDb(CDBWrapper& llmqDb, bool _fMemory, int64_t maxAge);
 
     bool HasRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash);
     bool HasRecoveredSigForId(Consensus::LLMQType llmqType, const uint256& id);
@@ -85,17 +133,31 @@ public:
     bool GetRecoveredSigById(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret);
     void WriteRecoveredSig(const CRecoveredSig& recSig);
 
-    void CleanupOldRecoveredSigs(int64_t maxAge);
+    // drops all segments which only contain recovered sigs and votes older than maxAge
+    void CleanupOldSegments(int64_t maxAge);
+    size_t GetSegmentCount();
 
-    // votes are removed when the recovered sig is written to the db
+    // votes are removed together with the segment they were written to
     bool HasVotedOnId(Consensus::LLMQType llmqType, const uint256& id);
     bool GetVoteForId(Consensus::LLMQType llmqType, const uint256& id, uint256& msgHashRet);
     void WriteVoteForId(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash);
 
-    void CleanupOldVotes(int64_t maxAge);
-
 private:
-    bool ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256& id, CRecoveredSig& ret);
+    void LoadSegments();
+    void MigrateFromLLMQDb(CDBWrapper& llmqDb);
+
+    // returns the segment new entries written at the given time go to, creating a new one if needed
+    CRecoveredSigsSegmentPtr GetSegmentForWrite(int64_t time);
+    // returns the segments which might contain the key, newest first
+    std::vector<CRecoveredSigsSegmentPtr> GetSegmentsForKey(const uint256& key);
+
+    template<typename K>
+    bool Exists(const uint256& filterKey, const K& k);
+    template<typename K, typename V>
+    bool Read(const uint256& filterKey, const K& k, V& v);
+
+    void WriteRecoveredSig(const CRecoveredSig& recSig, int64_t time);
+    void WriteVoteForId(Consensus::LLMQType llmqType, const uint256& id, const uint256& msgHash, int64_t time);
 };
 
 class CRecoveredSigsListener
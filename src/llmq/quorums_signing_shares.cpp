@@ -191,9 +191,16 @@ void CSigSharesManager::StartWorkerThread()
         assert(false);
     }
 
+    // verification and recovery of different shards run in parallel, there is no use for more workers than shards
+    int workerCount = std::max(1, std::min(CWorkStealingPool::GetNumaNodeThreadCount() / 2, (int)SIG_SHARES_SHARDS));
+    workerPool.Start(workerCount, "cbdhealthnetwork-sigshares");
+
     workThread = std::thread(&TraceThread<std::function<void()> >,
         "sigshares",
         std::function<void()>(std::bind(&CSigSharesManager::WorkThreadMain, this)));
+    sendThread = std::thread(&TraceThread<std::function<void()> >,
+        "sigshares-send",
+        std::function<void()>(std::bind(&CSigSharesManager::SendThreadMain, this)));
 }
 
 void CSigSharesManager::StopWorkerThread()
@@ -206,6 +213,10 @@ void CSigSharesManager::StopWorkerThread()
     if (workThread.joinable()) {
         workThread.join();
     }
+    if (sendThread.joinable()) {
+        sendThread.join();
+    }
+    workerPool.Stop(true);
 }
 
 void CSigSharesManager::RegisterAsRecoveredSigsListener()
@@ -431,7 +442,7 @@ bool CSigSharesManager::ProcessMessageBatchedSigShares(CNode* pfrom, const CBatc
             // It's important to only skip seen *valid* sig shares here. If a node sends us a
             // batch of mostly valid sig shares with a single invalid one and thus batched
             // verification fails, we'd skip the valid ones in the future if received from other nodes
-            if (this->sigShares.Has(sigShare.GetKey())) {
+            if (HasSigShare(sigShare.GetKey())) {
                 continue;
             }
 
@@ -527,7 +538,7 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
             }
             auto& sigShare = *ns.pendingIncomingSigShares.GetFirst();
 
-            bool alreadyHave = this->sigShares.Has(sigShare.GetKey());
+            bool alreadyHave = HasSigShare(sigShare.GetKey());
             if (!alreadyHave) {
                 uniqueSignHashes.emplace(nodeId, sigShare.GetSignHash());
                 retSigShares[nodeId].emplace_back(sigShare);
@@ -568,11 +579,75 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     std::unordered_map<NodeId, std::vector<CSigShare>> sigSharesByNodes;
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
-    CollectPendingSigSharesToVerify(32, sigSharesByNodes, quorums);
+    CollectPendingSigSharesToVerify(32 * workerPool.Size(), sigSharesByNodes, quorums);
     if (sigSharesByNodes.empty()) {
         return false;
     }
 
+    // All shares of a session belong to the same shard, so the shards can be verified and processed in parallel
+    std::array<std::unordered_map<NodeId, std::vector<CSigShare>>, SIG_SHARES_SHARDS> sigSharesByShards;
+    for (auto& p : sigSharesByNodes) {
+        for (auto& sigShare : p.second) {
+            sigSharesByShards[GetShardIndex(sigShare.GetSignHash())][p.first].emplace_back(sigShare);
+        }
+    }
+
+    std::vector<std::future<size_t>> verifyFutures;
+    std::array<std::set<NodeId>, SIG_SHARES_SHARDS> badNodesByShards;
+    cxxtimer::Timer verifyTimer(true);
+    for (size_t i = 0; i < SIG_SHARES_SHARDS; i++) {
+        if (sigSharesByShards[i].empty()) {
+            continue;
+        }
+        verifyFutures.emplace_back(workerPool.Push([&, i](int threadId) {
+            return VerifySigShares(sigSharesByShards[i], quorums, badNodesByShards[i]);
+        }));
+    }
+    size_t verifyCount = 0;
+    for (auto& f : verifyFutures) {
+        verifyCount += f.get();
+    }
+    verifyTimer.stop();
+
+    LogPrint("llmq-sigs", "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d, shards=%d\n", __func__,
+             verifyCount, verifyTimer.count(), sigSharesByNodes.size(), verifyFutures.size());
+
+    std::set<NodeId> badNodes;
+    for (auto& s : badNodesByShards) {
+        badNodes.insert(s.begin(), s.end());
+    }
+    for (auto nodeId : badNodes) {
+        LogPrintf("CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
+                 __func__, nodeId);
+        // this will also cause re-requesting of the shares that were sent by this node
+        BanNode(nodeId);
+    }
+
+    std::vector<std::future<void>> processFutures;
+    for (size_t i = 0; i < SIG_SHARES_SHARDS; i++) {
+        if (sigSharesByShards[i].empty()) {
+            continue;
+        }
+        processFutures.emplace_back(workerPool.Push([&, i](int threadId) {
+            for (auto& p : sigSharesByShards[i]) {
+                if (badNodes.count(p.first)) {
+                    continue;
+                }
+                ProcessPendingSigSharesFromNode(p.first, p.second, quorums, connman);
+            }
+        }));
+    }
+    for (auto& f : processFutures) {
+        f.get();
+    }
+
+    return true;
+}
+
+size_t CSigSharesManager::VerifySigShares(const std::unordered_map<NodeId, std::vector<CSigShare>>& sigSharesByNodes,
+        const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+        std::set<NodeId>& retBadNodes)
+{
     // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
     // which are not craftable by individual entities, making the rogue public key attack impossible
     CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
@@ -590,7 +665,7 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
             // we didn't check this earlier because we use a lazy BLS signature and tried to avoid doing the expensive
             // deserialization in the message thread
             if (!sigShare.sigShare.Get().IsValid()) {
-                BanNode(nodeId);
+                retBadNodes.emplace(nodeId);
                 // don't process any additional shares from this node
                 break;
             }
@@ -610,28 +685,10 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
         }
     }
 
-    cxxtimer::Timer verifyTimer(true);
     batchVerifier.Verify();
-    verifyTimer.stop();
-
-    LogPrint("llmq-sigs", "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d\n", __func__, verifyCount, verifyTimer.count(), sigSharesByNodes.size());
-
-    for (auto& p : sigSharesByNodes) {
-        auto nodeId = p.first;
-        auto& v = p.second;
+    retBadNodes.insert(batchVerifier.badSources.begin(), batchVerifier.badSources.end());
 
-        if (batchVerifier.badSources.count(nodeId)) {
-            LogPrintf("CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
-                     __func__, nodeId);
-            // this will also cause re-requesting of the shares that were sent by this node
-            BanNode(nodeId);
-            continue;
-        }
-
-        ProcessPendingSigSharesFromNode(nodeId, v, quorums, connman);
-    }
-
-    return true;
+    return verifyCount;
 }
 
 // It's ensured that no duplicates are passed to this method
@@ -640,8 +697,6 @@ void CSigSharesManager::ProcessPendingSigSharesFromNode(NodeId nodeId,
         const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
         CConnman& connman)
 {
-    auto& nodeState = nodeStates[nodeId];
-
     cxxtimer::Timer t(true);
     for (auto& sigShare : sigShares) {
         auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash);
@@ -671,42 +726,44 @@ void CSigSharesManager::ProcessSigShare(NodeId nodeId, const CSigShare& sigShare
     }
 
     {
-        LOCK(cs);
+        auto& shard = GetShard(sigShare.GetSignHash());
+        LOCK(shard.cs);
 
-        if (!sigShares.Add(sigShare.GetKey(), sigShare)) {
+        if (!shard.sigShares.Add(sigShare.GetKey(), sigShare)) {
             return;
         }
-        
-        sigSharesToAnnounce.Add(sigShare.GetKey(), true);
 
-        auto it = timeSeenForSessions.find(sigShare.GetSignHash());
-        if (it == timeSeenForSessions.end()) {
+        shard.sigSharesToAnnounce.Add(sigShare.GetKey(), true);
+
+        auto it = shard.timeSeenForSessions.find(sigShare.GetSignHash());
+        if (it == shard.timeSeenForSessions.end()) {
             auto t = GetTimeMillis();
             // insert first-seen and last-seen time
-            timeSeenForSessions.emplace(sigShare.GetSignHash(), std::make_pair(t, t));
+            shard.timeSeenForSessions.emplace(sigShare.GetSignHash(), std::make_pair(t, t));
         } else {
             // update last-seen time
             it->second.second = GetTimeMillis();
         }
 
-        if (!quorumNodes.empty()) {
-            // don't announce and wait for other nodes to request this share and directly send it to them
-            // there is no way the other nodes know about this share as this is the one created on this node
-            for (auto otherNodeId : quorumNodes) {
-                auto& nodeState = nodeStates[otherNodeId];
-                auto& session = nodeState.GetOrCreateSessionFromShare(sigShare);
-                session.quorum = quorum;
-                session.requested.Set(sigShare.quorumMember, true);
-                session.knows.Set(sigShare.quorumMember, true);
-            }
-        }
-
-        size_t sigShareCount = sigShares.CountForSignHash(sigShare.GetSignHash());
+        size_t sigShareCount = shard.sigShares.CountForSignHash(sigShare.GetSignHash());
         if (sigShareCount >= quorum->params.threshold) {
             canTryRecovery = true;
         }
     }
 
+    if (!quorumNodes.empty()) {
+        // don't announce and wait for other nodes to request this share and directly send it to them
+        // there is no way the other nodes know about this share as this is the one created on this node
+        LOCK(cs);
+        for (auto otherNodeId : quorumNodes) {
+            auto& nodeState = nodeStates[otherNodeId];
+            auto& session = nodeState.GetOrCreateSessionFromShare(sigShare);
+            session.quorum = quorum;
+            session.requested.Set(sigShare.quorumMember, true);
+            session.knows.Set(sigShare.quorumMember, true);
+        }
+    }
+
     if (canTryRecovery) {
         TryRecoverSig(quorum, sigShare.id, sigShare.msgHash, connman);
     }
@@ -719,36 +776,43 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
     }
 
     std::vector<CBLSSignature> sigSharesForRecovery;
-    std::vector<CBLSId> idsForRecovery;
+    std::vector<uint16_t> membersForRecovery;
     {
-        LOCK(cs);
-
-        auto k = std::make_pair(quorum->params.type, id);
-
         auto signHash = CLLMQUtils::BuildSignHash(quorum->params.type, quorum->qc.quorumHash, id, msgHash);
-        auto sigShares = this->sigShares.GetAllForSignHash(signHash);
+        auto& shard = GetShard(signHash);
+        LOCK(shard.cs);
+
+        auto sigShares = shard.sigShares.GetAllForSignHash(signHash);
         if (!sigShares) {
             return;
         }
 
-        sigSharesForRecovery.reserve((size_t) quorum->params.threshold);
-        idsForRecovery.reserve((size_t) quorum->params.threshold);
-        for (auto it = sigShares->begin(); it != sigShares->end() && sigSharesForRecovery.size() < quorum->params.threshold; ++it) {
-            auto& sigShare = it->second;
-            sigSharesForRecovery.emplace_back(sigShare.sigShare.Get());
-            idsForRecovery.emplace_back(CBLSId::FromHash(quorum->members[sigShare.quorumMember]->proTxHash));
-        }
-
         // check if we can recover the final signature
-        if (sigSharesForRecovery.size() < quorum->params.threshold) {
+        size_t threshold = (size_t) quorum->params.threshold;
+        if (sigShares->size() < threshold) {
             return;
         }
+
+        // Use the shares of the members with the lowest indexes. Mostly the same members are online and sign, so this
+        // results in the same few member subsets, for which the Lagrange coefficients are cached by the quorum
+        membersForRecovery.reserve(sigShares->size());
+        for (auto& p : *sigShares) {
+            membersForRecovery.emplace_back(p.first);
+        }
+        std::partial_sort(membersForRecovery.begin(), membersForRecovery.begin() + threshold, membersForRecovery.end());
+        membersForRecovery.resize(threshold);
+
+        sigSharesForRecovery.reserve(threshold);
+        for (auto quorumMember : membersForRecovery) {
+            sigSharesForRecovery.emplace_back(sigShares->at(quorumMember).sigShare.Get());
+        }
     }
 
     // now recover it
     cxxtimer::Timer t(true);
     CBLSSignature recoveredSig;
-    if (!recoveredSig.Recover(sigSharesForRecovery, idsForRecovery)) {
+    auto coefficients = quorum->GetLagrangeCoefficients(membersForRecovery);
+    if (!coefficients || !recoveredSig.Recover(sigSharesForRecovery, *coefficients)) {
         LogPrintf("CSigSharesManager::%s -- failed to recover signature. id=%s, msgHash=%s, time=%d\n", __func__,
                   id.ToString(), msgHash.ToString(), t.count());
         return;
@@ -832,7 +896,7 @@ void CSigSharesManager::CollectSigSharesToRequest(std::unordered_map<NodeId, std
                     continue;
                 }
                 auto k = std::make_pair(signHash, (uint16_t) i);
-                if (sigShares.Has(k)) {
+                if (HasSigShare(k)) {
                     // we already have it
                     session.announced.inv[i] = false;
                     continue;
@@ -909,14 +973,14 @@ void CSigSharesManager::CollectSigSharesToSend(std::unordered_map<NodeId, std::u
                 session.requested.inv[i] = false;
 
                 auto k = std::make_pair(signHash, (uint16_t)i);
-                const CSigShare* sigShare = sigShares.Get(k);
-                if (!sigShare) {
+                CSigShare sigShare;
+                if (!GetSigShare(k, sigShare)) {
                     // he requested something we don'have
                     session.requested.inv[i] = false;
                     continue;
                 }
 
-                batchedSigShares.sigShares.emplace_back((uint16_t)i, sigShare->sigShare);
+                batchedSigShares.sigShares.emplace_back((uint16_t)i, sigShare.sigShare);
             }
 
             if (!batchedSigShares.sigShares.empty()) {
@@ -934,18 +998,27 @@ void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, st
 {
     AssertLockHeld(cs);
 
+    // take the shares to announce out of all shards, they won't be announced again
+    std::vector<CSigShare> newSigShares;
+    for (auto& shard : shards) {
+        LOCK(shard.cs);
+        shard.sigSharesToAnnounce.ForEach([&](const SigShareKey& sigShareKey, bool) {
+            const CSigShare* sigShare = shard.sigShares.Get(sigShareKey);
+            if (sigShare) {
+                newSigShares.emplace_back(*sigShare);
+            }
+        });
+        shard.sigSharesToAnnounce.Clear();
+    }
+
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, std::unordered_set<NodeId>, StaticSaltedHasher> quorumNodesMap;
 
-    this->sigSharesToAnnounce.ForEach([&](const SigShareKey& sigShareKey, bool) {
-        auto& signHash = sigShareKey.first;
-        auto quorumMember = sigShareKey.second;
-        const CSigShare* sigShare = sigShares.Get(sigShareKey);
-        if (!sigShare) {
-            return;
-        }
+    for (auto& sigShare : newSigShares) {
+        auto& signHash = sigShare.GetSignHash();
+        auto quorumMember = sigShare.quorumMember;
 
         // announce to the nodes which we know through the intra-quorum-communication system
-        auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare->llmqType, sigShare->quorumHash);
+        auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash);
         auto it = quorumNodesMap.find(quorumKey);
         if (it == quorumNodesMap.end()) {
             auto nodeIds = g_connman->GetMasternodeQuorumNodes(quorumKey.first, quorumKey.second);
@@ -961,7 +1034,7 @@ void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, st
                 continue;
             }
 
-            auto& session = nodeState.GetOrCreateSessionFromShare(*sigShare);
+            auto& session = nodeState.GetOrCreateSessionFromShare(sigShare);
 
             if (session.knows.inv[quorumMember]) {
                 // he already knows that one
@@ -970,16 +1043,13 @@ void CSigSharesManager::CollectSigSharesToAnnounce(std::unordered_map<NodeId, st
 
             auto& inv = sigSharesToAnnounce[nodeId][signHash];
             if (inv.inv.empty()) {
-                const auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)sigShare->llmqType);
+                const auto& params = Params().GetConsensus().llmqs.at((Consensus::LLMQType)sigShare.llmqType);
                 inv.Init((size_t)params.size);
             }
             inv.inv[quorumMember] = true;
             session.knows.inv[quorumMember] = true;
         }
-    });
-
-    // don't announce these anymore
-    this->sigSharesToAnnounce.Clear();
+    }
 }
 
 bool CSigSharesManager::SendMessages()
@@ -1129,6 +1199,25 @@ bool CSigSharesManager::SendMessages()
     return didSend;
 }
 
+bool CSigSharesManager::HasSigShare(const SigShareKey& k)
+{
+    auto& shard = GetShard(k.first);
+    LOCK(shard.cs);
+    return shard.sigShares.Has(k);
+}
+
+bool CSigSharesManager::GetSigShare(const SigShareKey& k, CSigShare& ret)
+{
+    auto& shard = GetShard(k.first);
+    LOCK(shard.cs);
+    const CSigShare* sigShare = shard.sigShares.Get(k);
+    if (!sigShare) {
+        return false;
+    }
+    ret = *sigShare;
+    return true;
+}
+
 bool CSigSharesManager::GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo)
 {
     LOCK(cs);
@@ -1158,16 +1247,29 @@ void CSigSharesManager::Cleanup()
     }
 
     // This map is first filled with all quorums found in all sig shares. Then we remove all inactive quorums and
-    // loop through all sig shares again to find the ones belonging to the inactive quorums. We then delete the
-    // sessions belonging to the sig shares. At the same time, we use this map as a cache when we later need to resolve
+    // delete the sessions belonging to them. At the same time, we use this map as a cache when we later need to resolve
     // quorumHash -> quorumPtr (as GetQuorum() requires cs_main, leading to deadlocks with cs held)
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
-
-    {
-        LOCK(cs);
-        sigShares.ForEach([&](const SigShareKey& k, const CSigShare& sigShare) {
-            quorums.emplace(std::make_pair((Consensus::LLMQType) sigShare.llmqType, sigShare.quorumHash), nullptr);
+    // signHash -> quorum of all sessions that we have sig shares for
+    std::unordered_map<uint256, std::pair<Consensus::LLMQType, uint256>, StaticSaltedHasher> sessions;
+    std::unordered_set<uint256, StaticSaltedHasher> timeoutSessions;
+
+    for (auto& shard : shards) {
+        LOCK(shard.cs);
+        shard.sigShares.ForEach([&](const SigShareKey& k, const CSigShare& sigShare) {
+            auto quorumKey = std::make_pair((Consensus::LLMQType) sigShare.llmqType, sigShare.quorumHash);
+            sessions.emplace(sigShare.GetSignHash(), quorumKey);
+            quorums.emplace(quorumKey, nullptr);
         });
+        for (auto& p : shard.timeSeenForSessions) {
+            auto& signHash = p.first;
+            int64_t firstSeenTime = p.second.first;
+            int64_t lastSeenTime = p.second.second;
+
+            if (now - firstSeenTime >= SESSION_TOTAL_TIMEOUT || now - lastSeenTime >= SESSION_NEW_SHARES_TIMEOUT) {
+                timeoutSessions.emplace(signHash);
+            }
+        }
     }
 
     // Find quorums which became inactive
@@ -1180,81 +1282,66 @@ void CSigSharesManager::Cleanup()
         }
     }
 
-    {
-        // Now delete sessions which are for inactive quorums
-        LOCK(cs);
-        std::unordered_set<uint256, StaticSaltedHasher> inactiveQuorumSessions;
-        sigShares.ForEach([&](const SigShareKey& k, const CSigShare& sigShare) {
-            if (!quorums.count(std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash))) {
-                inactiveQuorumSessions.emplace(sigShare.GetSignHash());
-            }
-        });
-        for (auto& signHash : inactiveQuorumSessions) {
-            RemoveSigSharesForSession(signHash);
+    // Find sessions which are for inactive quorums or which were succesfully recovered
+    std::unordered_set<uint256, StaticSaltedHasher> doneSessions;
+    for (auto& p : sessions) {
+        if (!quorums.count(p.second) || quorumSigningManager->HasRecoveredSigForSession(p.first)) {
+            doneSessions.emplace(p.first);
         }
     }
 
     {
         LOCK(cs);
 
-        // Remove sessions which were succesfully recovered
-        std::unordered_set<uint256, StaticSaltedHasher> doneSessions;
-        sigShares.ForEach([&](const SigShareKey& k, const CSigShare& sigShare) {
-            if (doneSessions.count(sigShare.GetSignHash())) {
-                return;
-            }
-            if (quorumSigningManager->HasRecoveredSigForSession(sigShare.GetSignHash())) {
-                doneSessions.emplace(sigShare.GetSignHash());
-            }
-        });
         for (auto& signHash : doneSessions) {
             RemoveSigSharesForSession(signHash);
         }
 
         // Remove sessions which timed out
-        std::unordered_set<uint256, StaticSaltedHasher> timeoutSessions;
-        for (auto& p : timeSeenForSessions) {
-            auto& signHash = p.first;
-            int64_t firstSeenTime = p.second.first;
-            int64_t lastSeenTime = p.second.second;
-
-            if (now - firstSeenTime >= SESSION_TOTAL_TIMEOUT || now - lastSeenTime >= SESSION_NEW_SHARES_TIMEOUT) {
-                timeoutSessions.emplace(signHash);
-            }
-        }
         for (auto& signHash : timeoutSessions) {
-            size_t count = sigShares.CountForSignHash(signHash);
-
-            if (count > 0) {
-                auto m = sigShares.GetAllForSignHash(signHash);
-                assert(m);
-
-                auto& oneSigShare = m->begin()->second;
-
-                std::string strMissingMembers;
-                if (LogAcceptCategory("llmq")) {
-                    auto quorumIt = quorums.find(std::make_pair((Consensus::LLMQType)oneSigShare.llmqType, oneSigShare.quorumHash));
-                    if (quorumIt != quorums.end()) {
-                        auto& quorum = quorumIt->second;
-                        for (size_t i = 0; i < quorum->members.size(); i++) {
-                            if (!m->count((uint16_t)i)) {
-                                auto& dmn = quorum->members[i];
-                                strMissingMembers += strprintf("\n  %s", dmn->proTxHash.ToString());
+            if (doneSessions.count(signHash)) {
+                continue;
+            }
+
+            {
+                auto& shard = GetShard(signHash);
+                LOCK(shard.cs);
+
+                size_t count = shard.sigShares.CountForSignHash(signHash);
+
+                if (count > 0) {
+                    auto m = shard.sigShares.GetAllForSignHash(signHash);
+                    assert(m);
+
+                    auto& oneSigShare = m->begin()->second;
+
+                    std::string strMissingMembers;
+                    if (LogAcceptCategory("llmq")) {
+                        auto quorumIt = quorums.find(std::make_pair((Consensus::LLMQType)oneSigShare.llmqType, oneSigShare.quorumHash));
+                        if (quorumIt != quorums.end()) {
+                            auto& quorum = quorumIt->second;
+                            for (size_t i = 0; i < quorum->members.size(); i++) {
+                                if (!m->count((uint16_t)i)) {
+                                    auto& dmn = quorum->members[i];
+                                    strMissingMembers += strprintf("\n  %s", dmn->proTxHash.ToString());
+                                }
                             }
                         }
                     }
-                }
 
-                LogPrint("llmq-sigs", "CSigSharesManager::%s -- signing session timed out. signHash=%s, id=%s, msgHash=%s, sigShareCount=%d, missingMembers=%s\n", __func__,
-                          signHash.ToString(), oneSigShare.id.ToString(), oneSigShare.msgHash.ToString(), count, strMissingMembers);
-            } else {
-                LogPrint("llmq-sigs", "CSigSharesManager::%s -- signing session timed out. signHash=%s, sigShareCount=%d\n", __func__,
-                          signHash.ToString(), count);
+                    LogPrint("llmq-sigs", "CSigSharesManager::%s -- signing session timed out. signHash=%s, id=%s, msgHash=%s, sigShareCount=%d, missingMembers=%s\n", __func__,
+                              signHash.ToString(), oneSigShare.id.ToString(), oneSigShare.msgHash.ToString(), count, strMissingMembers);
+                } else {
+                    LogPrint("llmq-sigs", "CSigSharesManager::%s -- signing session timed out. signHash=%s, sigShareCount=%d\n", __func__,
+                              signHash.ToString(), count);
+                }
             }
             RemoveSigSharesForSession(signHash);
         }
     }
 
+    LOCK(cs);
+
     // Find node states for peers that disappeared from CConnman
     std::unordered_set<NodeId> nodeStatesToDelete;
     for (auto& p : nodeStates) {
@@ -1265,7 +1352,6 @@ void CSigSharesManager::Cleanup()
     });
 
     // Now delete these node states
-    LOCK(cs);
     for (auto nodeId : nodeStatesToDelete) {
         auto& nodeState = nodeStates[nodeId];
         // remove global requested state to force a re-request from another node
@@ -1280,15 +1366,20 @@ void CSigSharesManager::Cleanup()
 
 void CSigSharesManager::RemoveSigSharesForSession(const uint256& signHash)
 {
+    AssertLockHeld(cs);
+
     for (auto& p : nodeStates) {
         auto& ns = p.second;
         ns.RemoveSession(signHash);
     }
 
     sigSharesRequested.EraseAllForSignHash(signHash);
-    sigSharesToAnnounce.EraseAllForSignHash(signHash);
-    sigShares.EraseAllForSignHash(signHash);
-    timeSeenForSessions.erase(signHash);
+
+    auto& shard = GetShard(signHash);
+    LOCK(shard.cs);
+    shard.sigSharesToAnnounce.EraseAllForSignHash(signHash);
+    shard.sigShares.EraseAllForSignHash(signHash);
+    shard.timeSeenForSessions.erase(signHash);
 }
 
 void CSigSharesManager::RemoveBannedNodeStates()
@@ -1339,8 +1430,6 @@ void CSigSharesManager::BanNode(NodeId nodeId)
 
 void CSigSharesManager::WorkThreadMain()
 {
-    int64_t lastSendTime = 0;
-
     while (!workInterrupt) {
         if (!quorumSigningManager || !g_connman) {
             if (!workInterrupt.sleep_for(std::chrono::milliseconds(100))) {
@@ -1356,11 +1445,6 @@ void CSigSharesManager::WorkThreadMain()
         didWork |= ProcessPendingSigShares(*g_connman);
         didWork |= SignPendingSigShares();
 
-        if (GetTimeMillis() - lastSendTime > 100) {
-            SendMessages();
-            lastSendTime = GetTimeMillis();
-        }
-
         Cleanup();
         quorumSigningManager->Cleanup();
 
@@ -1373,6 +1457,19 @@ void CSigSharesManager::WorkThreadMain()
     }
 }
 
+void CSigSharesManager::SendThreadMain()
+{
+    while (!workInterrupt) {
+        if (quorumSigningManager && g_connman) {
+            SendMessages();
+        }
+
+        if (!workInterrupt.sleep_for(std::chrono::milliseconds(100))) {
+            return;
+        }
+    }
+}
+
 void CSigSharesManager::AsyncSign(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash)
 {
     LOCK(cs);
@@ -14,9 +14,12 @@
 #include "sync.h"
 #include "tinyformat.h"
 #include "uint256.h"
+#include "workstealingpool.h"
 
 #include "llmq/quorums.h"
 
+#include <array>
+#include <set>
 #include <thread>
 #include <mutex>
 #include <unordered_map>
@@ -327,8 +330,13 @@ public:
     void RemoveSession(const uint256& signHash);
 };
 
+// Sig shares are stored in shards by signHash. Shares of different shards are verified, stored and recovered in
+// parallel on a pool of worker threads, while the per-node session state stays behind a single lock. Messages are
+// collected and sent on a separate thread, so that sending doesn't wait for verification and recovery.
 class CSigSharesManager : public CRecoveredSigsListener
 {
+    static const size_t SIG_SHARES_SHARDS = 16;
+
     static const int64_t SESSION_NEW_SHARES_TIMEOUT = 60 * 1000;
     static const int64_t SESSION_TOTAL_TIMEOUT = 5 * 60 * 1000;
     static const int64_t SIG_SHARE_REQUEST_TIMEOUT = 5 * 1000;
@@ -341,19 +349,31 @@ class CSigSharesManager : public CRecoveredSigsListener
     const size_t MAX_MSGS_TOTAL_BATCHED_SIGS = 400;
 
 private:
+    // The sessions of one shard. When both are needed, cs must be locked before the lock of a shard
+    struct Shard
+    {
+        CCriticalSection cs;
+
+        SigShareMap<CSigShare> sigShares;
+
+        // stores time of first and last receivedSigShare. Used to detect timeouts
+        std::unordered_map<uint256, std::pair<int64_t, int64_t>, StaticSaltedHasher> timeSeenForSessions;
+
+        SigShareMap<bool> sigSharesToAnnounce;
+    };
+
+    // protects the node states, the requests and the pending signs
     CCriticalSection cs;
 
     std::thread workThread;
+    std::thread sendThread;
     CThreadInterrupt workInterrupt;
+    CWorkStealingPool workerPool;
 
-    SigShareMap<CSigShare> sigShares;
-
-    // stores time of first and last receivedSigShare. Used to detect timeouts
-    std::unordered_map<uint256, std::pair<int64_t, int64_t>, StaticSaltedHasher> timeSeenForSessions;
+    std::array<Shard, SIG_SHARES_SHARDS> shards;
 
     std::unordered_map<NodeId, CSigSharesNodeState> nodeStates;
     SigShareMap<std::pair<NodeId, int64_t>> sigSharesRequested;
-    SigShareMap<bool> sigSharesToAnnounce;
 
     std::vector<std::tuple<const CQuorumCPtr, uint256, uint256>> pendingSigns;
 
@@ -395,6 +415,10 @@ private:
             std::unordered_map<NodeId, std::vector<CSigShare>>& retSigShares,
             std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& retQuorums);
     bool ProcessPendingSigShares(CConnman& connman);
+    // returns the number of verified sig shares, nodes which sent invalid ones are added to retBadNodes
+    size_t VerifySigShares(const std::unordered_map<NodeId, std::vector<CSigShare>>& sigSharesByNodes,
+            const std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& quorums,
+            std::set<NodeId>& retBadNodes);
 
     void ProcessPendingSigSharesFromNode(NodeId nodeId,
             const std::vector<CSigShare>& sigShares,
@@ -405,6 +429,11 @@ private:
     void TryRecoverSig(const CQuorumCPtr& quorum, const uint256& id, const uint256& msgHash, CConnman& connman);
 
 private:
+    static size_t GetShardIndex(const uint256& signHash) { return signHash.GetCheapHash() % SIG_SHARES_SHARDS; }
+    Shard& GetShard(const uint256& signHash) { return shards[GetShardIndex(signHash)]; }
+    bool HasSigShare(const SigShareKey& k);
+    bool GetSigShare(const SigShareKey& k, CSigShare& ret);
+
     bool GetSessionInfoByRecvId(NodeId nodeId, uint32_t sessionId, CSigSharesNodeState::SessionInfo& retInfo);
     CSigShare RebuildSigShare(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, size_t idx);
 
@@ -420,6 +449,7 @@ private:
     void CollectSigSharesToAnnounce(std::unordered_map<NodeId, std::unordered_map<uint256, CSigSharesInv, StaticSaltedHasher>>& sigSharesToAnnounce);
     bool SignPendingSigShares();
     void WorkThreadMain();
+    void SendThreadMain();
 };
 
 extern CSigSharesManager* quorumSigSharesManager;
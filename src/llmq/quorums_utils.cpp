@@ -7,17 +7,41 @@
 
 #include "chainparams.h"
 #include "random.h"
+#include "saltedhasher.h"
+#include "unordered_lru_cache.h"
 #include "validation.h"
 
 namespace llmq
 {
 
+static const size_t QUORUM_MEMBERS_CACHE_SIZE = 500;
+
 std::vector<CDeterministicMNCPtr> CLLMQUtils::GetAllQuorumMembers(Consensus::LLMQType llmqType, const uint256& blockHash)
 {
+    // Signing, DKG, ChainLocks and InstantSend all ask for the members of the same few quorums over and over again
+    static CCriticalSection cs_members;
+    static unordered_lru_cache<std::pair<uint8_t, uint256>, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher> mapQuorumMembers(QUORUM_MEMBERS_CACHE_SIZE);
+
+    auto key = std::make_pair((uint8_t)llmqType, blockHash);
+    {
+        LOCK(cs_members);
+        std::vector<CDeterministicMNCPtr> members;
+        if (mapQuorumMembers.get(key, members)) {
+            return members;
+        }
+    }
+
     auto& params = Params().GetConsensus().llmqs.at(llmqType);
     auto allMns = deterministicMNManager->GetListForBlock(blockHash);
-    auto modifier = ::SerializeHash(std::make_pair((uint8_t)llmqType, blockHash));
-    return allMns.CalculateQuorum(params.size, modifier);
+    auto modifier = ::SerializeHash(key);
+    auto members = allMns.CalculateQuorum(params.size, modifier);
+
+    // we might not know the block yet, in which case the list is empty and must not be cached
+    if (allMns.GetHeight() != -1) {
+        LOCK(cs_members);
+        mapQuorumMembers.insert(key, members);
+    }
+    return members;
 }
 
 uint256 CLLMQUtils::BuildCommitmentHash(uint8_t llmqType, const uint256& blockHash, const std::vector<bool>& validMembers, const CBLSPublicKey& pubKey, const uint256& vvecHash)
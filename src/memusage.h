@@ -5,7 +5,9 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include "flathashmap.h"
 #include "indirectmap.h"
+#include "prevector.h"
 
 #include <stdlib.h>
 
@@ -181,6 +183,14 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+// Flat tables are two allocations, the entries and one control byte per slot
+
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const flathashmap<X, Y, Z>& m)
+{
+    return MallocUsage(sizeof(std::pair<const X, Y>) * m.capacity()) + MallocUsage(m.capacity());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
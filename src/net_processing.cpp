@@ -29,6 +29,7 @@
 #include "util.h"
 #include "utilmoneystr.h"
 #include "utilstrencodings.h"
+#include "utxosnapshot.h"
 #include "validationinterface.h"
 
 #include "spork.h"
@@ -590,6 +591,37 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
     }
 }
 
+/** Add the blocks below the base of a UTXO set snapshot which the background validation needs next and which are not
+ *  in flight to vBlocks, until it has at most count entries. They are not part of the window of FindNextBlocksToDownload,
+ *  which starts at the base. Only peers which have the base block are asked. */
+void FindNextSnapshotBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks) {
+    if (psnapshotvalidator == NULL || psnapshotvalidator->IsComplete() || vBlocks.size() >= count)
+        return;
+
+    CNodeState *state = State(nodeid);
+    assert(state != NULL);
+    const CBlockIndex* pindexBase = psnapshotvalidator->GetBase();
+    if (state->pindexBestKnownBlock == NULL || state->pindexBestKnownBlock->GetAncestor(pindexBase->nHeight) != pindexBase)
+        return;
+
+    int nWindowStart = psnapshotvalidator->GetHeight() + 1;
+    int nWindowEnd = std::min<int>(nWindowStart + BLOCK_DOWNLOAD_WINDOW - 1, pindexBase->nHeight);
+    if (nWindowStart > nWindowEnd)
+        return;
+    std::vector<const CBlockIndex*> vWindow(nWindowEnd - nWindowStart + 1);
+    const CBlockIndex* pindexWalk = pindexBase->GetAncestor(nWindowEnd);
+    for (size_t i = vWindow.size(); i-- > 0; pindexWalk = pindexWalk->pprev) {
+        vWindow[i] = pindexWalk;
+    }
+    for (const CBlockIndex* pindex : vWindow) {
+        if (pindex->nStatus & BLOCK_HAVE_DATA || mapBlocksInFlight.count(pindex->GetBlockHash()))
+            continue;
+        vBlocks.push_back(pindex);
+        if (vBlocks.size() == count)
+            return;
+    }
+}
+
 } // anon namespace
 
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
@@ -1120,8 +1152,13 @@ void static ProcessGetBlockData(CNode* pfrom, const Consensus::Params& consensus
     if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
     {
         std::shared_ptr<const CBlock> pblock;
+        std::vector<unsigned char> blockData;
         if (a_recent_block && a_recent_block->GetHash() == (*mi).second->GetBlockHash()) {
             pblock = a_recent_block;
+        } else if (inv.type == MSG_BLOCK) {
+            // Send block from disk as it is, it's stored in the wire format already
+            if (!ReadRawBlockFromDisk(blockData, (*mi).second, Params().MessageStart()))
+                assert(!"cannot load block from disk");
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -1129,8 +1166,12 @@ void static ProcessGetBlockData(CNode* pfrom, const Consensus::Params& consensus
                 assert(!"cannot load block from disk");
             pblock = pblockRead;
         }
-        if (inv.type == MSG_BLOCK)
-            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
+        if (inv.type == MSG_BLOCK) {
+            if (pblock)
+                connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
+            else
+                connman.PushMessage(pfrom, msgMaker.MakeRaw(NetMsgType::BLOCK, std::move(blockData)));
+        }
         else if (inv.type == MSG_FILTERED_BLOCK)
         {
             bool sendMerkleBlock = false;
@@ -2637,6 +2678,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Hash the whole message and check its proof of work before taking cs_main, X11 is the expensive part here
+        std::vector<uint256> headerHashes;
+        bool fPoWChecked = PreVerifyBlockHeaders(headers, headerHashes, chainparams.GetConsensus());
+
         const CBlockIndex *pindexLast = NULL;
         {
         LOCK(cs_main);
@@ -2654,14 +2699,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             nodestate->nUnconnectingHeaders++;
             connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
             LogPrint("net", "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    headerHashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->id, nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom->GetId(), headerHashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom->GetId(), 20);
@@ -2669,18 +2714,16 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
-        uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 1; i < headers.size(); i++) {
+            if (headers[i].hashPrevBlock != headerHashes[i - 1]) {
                 Misbehaving(pfrom->GetId(), 20);
                 return error("non-continuous headers sequence");
             }
-            hashLastBlock = header.GetHash();
         }
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, headerHashes, fPoWChecked, state, chainparams, &pindexLast)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
@@ -3704,6 +3747,7 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
             FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            FindNextSnapshotBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload);
             BOOST_FOREACH(const CBlockIndex *pindex, vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), consensusParams, pindex);
@@ -30,6 +30,15 @@ public:
         return Make(0, std::move(sCommand), std::forward<Args>(args)...);
     }
 
+    /** Makes a message out of a payload which is serialized already, e.g. a block as it is stored on disk */
+    CSerializedNetMsg MakeRaw(std::string sCommand, std::vector<unsigned char>&& data) const
+    {
+        CSerializedNetMsg msg;
+        msg.command = std::move(sCommand);
+        msg.data = std::move(data);
+        return msg;
+    }
+
 private:
     const int nVersion;
 };
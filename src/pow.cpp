@@ -9,10 +9,19 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "primitives/block.h"
+#include "saltedhasher.h"
+#include "sync.h"
 #include "uint256.h"
+#include "unordered_lru_cache.h"
 
 #include <math.h>
 
+// Apart from the min difficulty special cases, the result of DGW only depends on pindexLast and its
+// ancestors, so every header building on the same parent gets the same target. This caches it per parent,
+// which saves the walk over the past blocks for competing/re-checked headers and for every block template.
+static CCriticalSection cs_dgwCache;
+static unordered_lru_cache<uint256, std::pair<const Consensus::Params*, unsigned int>, StaticSaltedHasher, 64> dgwCache;
+
 unsigned int static KimotoGravityWell(const CBlockIndex* pindexLast, const Consensus::Params& params) {
     const CBlockIndex *BlockLastSolved = pindexLast;
     const CBlockIndex *BlockReading = pindexLast;
@@ -104,6 +113,15 @@ unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const CBlockH
         }
     }
 
+    // CBlockIndex objects without a hash are only used in tests, don't cache those
+    if (pindexLast->phashBlock) {
+        LOCK(cs_dgwCache);
+        std::pair<const Consensus::Params*, unsigned int> cached;
+        if (dgwCache.get(pindexLast->GetBlockHash(), cached) && cached.first == &params) {
+            return cached.second;
+        }
+    }
+
     const CBlockIndex *pindex = pindexLast;
     arith_uint256 bnPastTargetAvg;
 
@@ -113,7 +131,9 @@ unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const CBlockH
             bnPastTargetAvg = bnTarget;
         } else {
             // NOTE: that's not an average really...
-            bnPastTargetAvg = (bnPastTargetAvg * nCountBlocks + bnTarget) / (nCountBlocks + 1);
+            bnPastTargetAvg *= nCountBlocks;
+            bnPastTargetAvg += bnTarget;
+            bnPastTargetAvg.DivideBy(nCountBlocks + 1);
         }
 
         if(nCountBlocks != nPastBlocks) {
@@ -141,7 +161,13 @@ unsigned int static DarkGravityWave(const CBlockIndex* pindexLast, const CBlockH
         bnNew = bnPowLimit;
     }
 
-    return bnNew.GetCompact();
+    unsigned int nBits = bnNew.GetCompact();
+    if (pindexLast->phashBlock) {
+        LOCK(cs_dgwCache);
+        dgwCache.insert(pindexLast->GetBlockHash(), std::make_pair(&params, nBits));
+    }
+
+    return nBits;
 }
 
 unsigned int GetNextWorkRequiredBTC(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
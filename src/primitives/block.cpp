@@ -11,12 +11,40 @@
 #include "utilstrencodings.h"
 #include "crypto/common.h"
 
+void CBlockHeader::WriteHeader(unsigned char* buf) const
+{
+    // same layout as the serialization of the header
+    WriteLE32(buf, (uint32_t)nVersion);
+    memcpy(buf + 4, hashPrevBlock.begin(), 32);
+    memcpy(buf + 36, hashMerkleRoot.begin(), 32);
+    WriteLE32(buf + 68, nTime);
+    WriteLE32(buf + 72, nBits);
+    WriteLE32(buf + 76, nNonce);
+}
+
 uint256 CBlockHeader::GetHash() const
 {
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+    unsigned char header[HEADER_SIZE];
+    WriteHeader(header);
+    return HashX11(header, header + HEADER_SIZE);
+}
+
+void GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet)
+{
+    hashesRet.resize(headers.size());
+    GetBlockHeaderHashes(headers.data(), headers.size(), hashesRet.data());
+}
+
+void GetBlockHeaderHashes(const CBlockHeader* headers, size_t nCount, uint256* hashesRet)
+{
+    const size_t HEADER_SIZE = CBlockHeader::HEADER_SIZE;
+
+    std::vector<unsigned char> vch(nCount * HEADER_SIZE);
+    for (size_t i = 0; i < nCount; i++) {
+        headers[i].WriteHeader(vch.data() + i * HEADER_SIZE);
+    }
+
+    HashX11Batch(vch.data(), HEADER_SIZE, nCount, hashesRet);
 }
 
 std::string CBlock::ToString() const
@@ -19,7 +19,11 @@
  */
 class CBlockHeader
 {
+    friend void GetBlockHeaderHashes(const CBlockHeader* headers, size_t nCount, uint256* hashesRet);
+
 public:
+    static const size_t HEADER_SIZE = 80;
+
     // header
     int32_t nVersion;
     uint256 hashPrevBlock;
@@ -66,6 +70,10 @@ public:
     {
         return (int64_t)nTime;
     }
+
+private:
+    // Writes the 80 serialized header bytes to buf
+    void WriteHeader(unsigned char* buf) const;
 };
 
 
@@ -120,6 +128,13 @@ public:
 };
 
 
+/** Compute the hashes of a sequence of headers at once through HashX11Batch.
+ *  This is equivalent to, but considerably cheaper than, calling GetHash() on each header.
+ */
+void GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet);
+void GetBlockHeaderHashes(const CBlockHeader* headers, size_t nCount, uint256* hashesRet);
+
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -52,6 +52,7 @@ void RPCNestedTests::rpcNestedTests()
     //mempool.setSanityCheck(1.0);
     evoDb = new CEvoDB(1 << 20, true, true);
     pblocktree = new CBlockTreeDB(1 << 20, true);
+    pinsightindex = new CInsightIndexDB(1 << 20, true);
     pcoinsdbview = new CCoinsViewDB(1 << 23, true);
     deterministicMNManager = new CDeterministicMNManager(*evoDb);
     llmq::InitLLMQSystem(*evoDb, nullptr, true);
@@ -159,6 +160,7 @@ void RPCNestedTests::rpcNestedTests()
     llmq::DestroyLLMQSystem();
     delete deterministicMNManager;
     delete pcoinsdbview;
+    delete pinsightindex;
     delete pblocktree;
     delete evoDb;
 
@@ -214,6 +214,8 @@ static bool rest_block(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
     CBlock block;
+    // The binary and hex formats don't need the deserialized block, the bytes on disk are served as they are
+    std::vector<unsigned char> rawBlock;
     CBlockIndex* pblockindex = NULL;
     {
         LOCK(cs_main);
@@ -221,26 +223,27 @@ static bool rest_block(HTTPRequest* req,
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
 
         pblockindex = mapBlockIndex[hash];
-        if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+        if ((fHavePruned || fLoadedFromSnapshot) && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        if (rf == RF_JSON) {
+            if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        } else {
+            if (!ReadRawBlockFromDisk(rawBlock, pblockindex, Params().MessageStart()))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryBlock = ssBlock.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, std::move(rawBlock));
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::string strHex = HexStr(rawBlock.begin(), rawBlock.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
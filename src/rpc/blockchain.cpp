@@ -12,6 +12,7 @@
 #include "coins.h"
 #include "core_io.h"
 #include "consensus/validation.h"
+#include "insightindexer.h"
 #include "instantx.h"
 #include "validation.h"
 #include "policy/policy.h"
@@ -23,6 +24,7 @@
 #include "txmempool.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include "utxosnapshot.h"
 #include "hash.h"
 
 #include "evo/specialtx.h"
@@ -35,6 +37,7 @@
 
 #include <univalue.h>
 
+#include <boost/filesystem.hpp>
 #include <boost/thread/thread.hpp> // boost::thread::interrupt
 
 #include <mutex>
@@ -653,6 +656,9 @@ UniValue getblockhashes(const JSONRPCRequest& request)
     unsigned int low = request.params[1].get_int();
     std::vector<uint256> blockHashes;
 
+    if (pinsightindexer) {
+        pinsightindexer->BlockUntilSyncedToCurrentChain();
+    }
     if (!GetTimestampIndex(high, low, blockHashes)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
     }
@@ -891,6 +897,11 @@ UniValue getblock(const JSONRPCRequest& request)
             + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
+    // The spent index entries which TxToJSON adds must include the blocks which are already connected
+    if (pinsightindexer) {
+        pinsightindexer->BlockUntilSyncedToCurrentChain();
+    }
+
     LOCK(cs_main);
 
     std::string strHash = request.params[0].get_str();
@@ -910,7 +921,7 @@ UniValue getblock(const JSONRPCRequest& request)
     CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
 
-    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+    if ((fHavePruned || fLoadedFromSnapshot) && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
 
     if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
@@ -945,56 +956,32 @@ struct CCoinsStats
     CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nTotalAmount(0) {}
 };
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
-{
-    assert(!outputs.empty());
-    ss << hash;
-    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
-    stats.nTransactions++;
-    for (const auto output : outputs) {
-        ss << VARINT(output.first + 1);
-        ss << *(const CScriptBase*)(&output.second.out.scriptPubKey);
-        ss << VARINT(output.second.out.nValue);
-        stats.nTransactionOutputs++;
-        stats.nTotalAmount += output.second.out.nValue;
-    }
-    ss << VARINT(0);
-}
-
 //! Calculate statistics about the unspent transaction output set
 static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
 
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     stats.hashBlock = pcursor->GetBestBlock();
     {
         LOCK(cs_main);
         stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->nHeight;
     }
-    ss << stats.hashBlock;
-    uint256 prevkey;
-    std::map<uint32_t, Coin> outputs;
+    CTxOutSetHasher hasher(stats.hashBlock);
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         COutPoint key;
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
-                outputs.clear();
-            }
-            prevkey = key.hash;
-            outputs[key.n] = std::move(coin);
+            hasher.Add(key, coin);
         } else {
             return error("%s: unable to read value", __func__);
         }
         pcursor->Next();
     }
-    if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
-    }
-    stats.hashSerialized = ss.GetHash();
+    stats.hashSerialized = hasher.GetHash();
+    stats.nTransactions = hasher.nTransactions;
+    stats.nTransactionOutputs = hasher.nTransactionOutputs;
+    stats.nTotalAmount = hasher.nTotalAmount;
     stats.nDiskSize = view->EstimateSize();
     return true;
 }
@@ -1088,6 +1075,135 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites the unspent transaction output set, the EvoDB and the block headers at the chain tip to a snapshot file,\n"
+            "which a new node can load with -loadtxoutset instead of downloading and validating the blocks up to the tip.\n"
+            "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) The file to write, relative paths are relative to the data directory\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"base_hash\": \"hex\",           (string) The hash of the block the snapshot was taken at\n"
+            "  \"base_height\": n,              (numeric) The height of that block\n"
+            "  \"transactions\": n,             (numeric) The number of transactions with unspent outputs\n"
+            "  \"txouts\": n,                   (numeric) The number of unspent transaction outputs\n"
+            "  \"total_amount\": x.xxx,         (numeric) The total amount\n"
+            "  \"evodb_entries\": n,            (numeric) The number of EvoDB entries\n"
+            "  \"hash_serialized_2\": \"hash\",   (string) The serialized hash of the UTXO set, like in gettxoutsetinfo\n"
+            "  \"snapshot_hash\": \"hash\",       (string) The hash of the file, to be passed to -loadtxoutsethash\n"
+            "  \"path\": \"path\"                 (string) The absolute path of the file\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    boost::filesystem::path path = boost::filesystem::absolute(request.params[0].get_str(), GetDataDir());
+
+    CUTXOSnapshotInfo info;
+    std::string strError;
+    if (!DumpUTXOSnapshot(path, info, strError))
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("base_hash", info.hashBaseBlock.GetHex()));
+    ret.push_back(Pair("base_height", info.nBaseHeight));
+    ret.push_back(Pair("transactions", (int64_t)info.nTransactions));
+    ret.push_back(Pair("txouts", (int64_t)info.nTransactionOutputs));
+    ret.push_back(Pair("total_amount", ValueFromAmount(info.nTotalAmount)));
+    ret.push_back(Pair("evodb_entries", (int64_t)info.nEvoEntries));
+    ret.push_back(Pair("hash_serialized_2", info.hashSerialized.GetHex()));
+    ret.push_back(Pair("snapshot_hash", info.hashSnapshot.GetHex()));
+    ret.push_back(Pair("path", path.string()));
+    return ret;
+}
+
+UniValue getchainstateflushinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getchainstateflushinfo\n"
+            "\nReturns statistics about writes of the coins cache to the chainstate database.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"background\": true|false,    (boolean) Whether coins are written on a background thread\n"
+            "  \"inprogress\": true|false,    (boolean) Whether a write is in progress\n"
+            "  \"flushes\": n,                (numeric) Number of completed writes since startup\n"
+            "  \"last\": {                    (json object) The last completed write, if any\n"
+            "    \"bestblock\": \"hex\",        (string) The best block hash of the written state\n"
+            "    \"time\": ttt,               (numeric) The time the write started, in seconds since epoch (Jan 1 1970 GMT)\n"
+            "    \"duration\": n,             (numeric) Total duration of the write in milliseconds\n"
+            "    \"blocking\": n,             (numeric) Milliseconds validation was blocked by the write\n"
+            "    \"written\": n,              (numeric) Number of written coins\n"
+            "    \"erased\": n,               (numeric) Number of erased coins\n"
+            "    \"bytes\": n,                (numeric) Estimated size of the written batches\n"
+            "    \"batches\": n               (numeric) Number of written batches\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getchainstateflushinfo", "")
+            + HelpExampleRpc("getchainstateflushinfo", "")
+        );
+
+    LOCK(cs_main);
+
+    uint64_t nFlushCount;
+    CCoinsFlushStats stats = pcoinsdbview->GetLastFlushStats(&nFlushCount);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("background", GetBoolArg("-backgroundflush", DEFAULT_BACKGROUND_FLUSH)));
+    ret.push_back(Pair("inprogress", pcoinsdbview->IsFlushing()));
+    ret.push_back(Pair("flushes", nFlushCount));
+    if (nFlushCount != 0) {
+        UniValue last(UniValue::VOBJ);
+        last.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+        last.push_back(Pair("time", stats.nTime));
+        last.push_back(Pair("duration", stats.nWriteMicros / 1000));
+        last.push_back(Pair("blocking", stats.nBlockingMicros / 1000));
+        last.push_back(Pair("written", (uint64_t)stats.nCoinsWritten));
+        last.push_back(Pair("erased", (uint64_t)stats.nCoinsErased));
+        last.push_back(Pair("bytes", (uint64_t)stats.nBytes));
+        last.push_back(Pair("batches", (uint64_t)stats.nBatches));
+        ret.push_back(Pair("last", last));
+    }
+    return ret;
+}
+
+UniValue getindexinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getindexinfo\n"
+            "\nReturns the state of the address, spent and timestamp indexes which are enabled.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {                  (json object) The index, \"addressindex\", \"spentindex\" or \"timestampindex\"\n"
+            "    \"synced\": true|false,    (boolean) Whether the index caught up with the chain tip since startup\n"
+            "    \"best_block_height\": n   (numeric) The height of the last indexed block, -1 if there is none\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getindexinfo", "")
+            + HelpExampleRpc("getindexinfo", "")
+        );
+
+    UniValue ret(UniValue::VOBJ);
+    if (pinsightindexer) {
+        for (const auto& info : pinsightindexer->GetInfo()) {
+            UniValue index(UniValue::VOBJ);
+            index.push_back(Pair("synced", info.fSynced));
+            index.push_back(Pair("best_block_height", info.nBestHeight));
+            ret.push_back(Pair(info.strName, index));
+        }
+    }
+    return ret;
+}
+
 UniValue gettxout(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
@@ -1675,6 +1791,11 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
             + HelpExampleRpc("getspecialtxes", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
+    // The spent index entries which TxToJSON adds must include the blocks which are already connected
+    if (pinsightindexer) {
+        pinsightindexer->BlockUntilSyncedToCurrentChain();
+    }
+
     LOCK(cs_main);
 
     std::string strHash = request.params[0].get_str();
@@ -1713,7 +1834,7 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
     CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
 
-    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+    if ((fHavePruned || fLoadedFromSnapshot) && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Block not available (pruned data)");
 
     if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
@@ -1762,6 +1883,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
     { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"} },
+    { "blockchain",         "getchainstateflushinfo", &getchainstateflushinfo, true,  {} },
+    { "blockchain",         "getindexinfo",           &getindexinfo,           true,  {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"} },
@@ -1771,6 +1894,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         true,  {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           true,  {"path"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
 
@@ -8,10 +8,12 @@
 #include "base58.h"
 #include "clientversion.h"
 #include "init.h"
+#include "insightindexer.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/server.h"
 #include "timedata.h"
+#include "txdb.h"
 #include "txmempool.h"
 #include "util.h"
 #include "utilstrencodings.h"
@@ -22,6 +24,7 @@
 #include "wallet/walletdb.h"
 #endif
 
+#include "evo/deterministicmns.h"
 #include "masternode-sync.h"
 #include "spork.h"
 
@@ -693,6 +696,93 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/** Number of results per call of the paged address index queries if no limit is given */
+static const int DEFAULT_ADDRESS_PAGE_SIZE = 1000;
+/** Maximum number of results per call of the paged address index queries */
+static const int MAX_ADDRESS_PAGE_SIZE = 100000;
+
+/**
+ * Reads the height range and the paging parameters of the address index queries. Returns true if the results are to
+ * be paged, which is the case if a limit or a cursor is given.
+ */
+static bool getAddressPagingFromParams(const UniValue& params, int& start, int& end, int& limit, std::string& cursor)
+{
+    if (!params[0].isObject()) {
+        return false;
+    }
+    const UniValue& obj = params[0].get_obj();
+    UniValue startValue = find_value(obj, "start");
+    UniValue endValue = find_value(obj, "end");
+    UniValue limitValue = find_value(obj, "limit");
+    UniValue cursorValue = find_value(obj, "cursor");
+    if (limitValue.isNull() && cursorValue.isNull()) {
+        return false;
+    }
+
+    start = startValue.isNum() ? startValue.get_int() : 0;
+    end = endValue.isNum() ? endValue.get_int() : 0;
+    if (start > 0 && end > 0 && end < start) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "End value is expected to be greater than start");
+    }
+    limit = limitValue.isNull() ? DEFAULT_ADDRESS_PAGE_SIZE : limitValue.get_int();
+    if (limit < 1 || limit > MAX_ADDRESS_PAGE_SIZE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Limit is expected to be between 1 and %d", MAX_ADDRESS_PAGE_SIZE));
+    }
+    cursor = cursorValue.isNull() ? "" : cursorValue.get_str();
+    return true;
+}
+
+/** Waits until the indexes include the blocks which are already connected, so that the results cover the chain tip */
+static void syncInsightIndexes()
+{
+    if (pinsightindexer) {
+        pinsightindexer->BlockUntilSyncedToCurrentChain();
+    }
+}
+
+template <typename Cursor>
+static std::unique_ptr<Cursor> checkAddressCursor(std::unique_ptr<Cursor> pcursor)
+{
+    if (pcursor->HasError()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    return pcursor;
+}
+
+static UniValue addressUnspentToJSON(const CAddressUnspentKey& key, const CAddressUnspentValue& value)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue output(UniValue::VOBJ);
+    output.push_back(Pair("address", address));
+    output.push_back(Pair("txid", key.txhash.GetHex()));
+    output.push_back(Pair("outputIndex", (int)key.index));
+    output.push_back(Pair("script", HexStr(value.script.begin(), value.script.end())));
+    output.push_back(Pair("satoshis", value.satoshis));
+    output.push_back(Pair("height", value.blockHeight));
+    return output;
+}
+
+static UniValue addressDeltaToJSON(const CAddressIndexKey& key, CAmount amount)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.push_back(Pair("satoshis", amount));
+    delta.push_back(Pair("txid", key.txhash.GetHex()));
+    delta.push_back(Pair("index", (int)key.index));
+    delta.push_back(Pair("blockindex", (int)key.txindex));
+    delta.push_back(Pair("height", key.blockHeight));
+    delta.push_back(Pair("address", address));
+    return delta;
+}
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -777,6 +867,10 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            "  \"start\" (number, optional) Only outputs created at or above this height (paged results only)\n"
+            "  \"end\" (number, optional) Only outputs created at or below this height (paged results only)\n"
+            "  \"limit\" (number, optional) Return at most this many outputs, ordered by txid, and a cursor for the rest\n"
+            "  \"cursor\" (string, optional) Continue a paged query with the same addresses where the last call stopped\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -789,8 +883,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (if limit or cursor is given):\n"
+            "{\n"
+            "  \"utxos\"  (array) The outputs as above\n"
+            "  \"cursor\"  (string) Pass this to get the next outputs, only present if there are more\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -800,6 +900,34 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    syncInsightIndexes();
+
+    int start = 0;
+    int end = 0;
+    int limit = 0;
+    std::string cursor;
+    if (getAddressPagingFromParams(request.params, start, end, limit, cursor)) {
+        if (!fAddressIndex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+
+        std::unique_ptr<CAddressUnspentCursor> pcursor = checkAddressCursor(pinsightindex->NewAddressUnspentCursor(addresses, start, end, cursor));
+        UniValue utxos(UniValue::VARR);
+        for (; pcursor->Valid() && (int)utxos.size() < limit; pcursor->Next()) {
+            utxos.push_back(addressUnspentToJSON(pcursor->GetKey(), pcursor->GetValue()));
+        }
+        if (pcursor->HasError()) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("utxos", utxos));
+        if (pcursor->Valid()) {
+            result.push_back(Pair("cursor", pcursor->GetToken()));
+        }
+        return result;
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -813,19 +941,7 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
-        UniValue output(UniValue::VOBJ);
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        output.push_back(Pair("address", address));
-        output.push_back(Pair("txid", it->first.txhash.GetHex()));
-        output.push_back(Pair("outputIndex", (int)it->first.index));
-        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
-        output.push_back(Pair("satoshis", it->second.satoshis));
-        output.push_back(Pair("height", it->second.blockHeight));
-        result.push_back(output);
+        result.push_back(addressUnspentToJSON(it->first, it->second));
     }
 
     return result;
@@ -846,6 +962,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many deltas, ordered by height, and a cursor for the rest\n"
+            "  \"cursor\" (string, optional) Continue a paged query with the same addresses where the last call stopped\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -858,12 +976,17 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (if limit or cursor is given):\n"
+            "{\n"
+            "  \"deltas\"  (array) The deltas as above\n"
+            "  \"cursor\"  (string) Pass this to get the next deltas, only present if there are more\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
-
     UniValue startValue = find_value(request.params[0].get_obj(), "start");
     UniValue endValue = find_value(request.params[0].get_obj(), "end");
 
@@ -884,6 +1007,32 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    syncInsightIndexes();
+
+    int limit = 0;
+    std::string cursor;
+    if (getAddressPagingFromParams(request.params, start, end, limit, cursor)) {
+        if (!fAddressIndex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+
+        std::unique_ptr<CAddressIndexCursor> pcursor = checkAddressCursor(pinsightindex->NewAddressIndexCursor(addresses, start, end, cursor));
+        UniValue deltas(UniValue::VARR);
+        for (; pcursor->Valid() && (int)deltas.size() < limit; pcursor->Next()) {
+            deltas.push_back(addressDeltaToJSON(pcursor->GetKey(), pcursor->GetValue()));
+        }
+        if (pcursor->HasError()) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("deltas", deltas));
+        if (pcursor->Valid()) {
+            result.push_back(Pair("cursor", pcursor->GetToken()));
+        }
+        return result;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -901,19 +1050,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        result.push_back(delta);
+        result.push_back(addressDeltaToJSON(it->first, it->second));
     }
 
     return result;
@@ -949,22 +1086,26 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    syncInsightIndexes();
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
+    if (!fAddressIndex) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
     }
 
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    // Sums up the histories while they are read instead of loading them first
+    std::unique_ptr<CAddressIndexCursor> pcursor = pinsightindex->NewAddressIndexCursor(addresses, 0, 0, "");
+    for (; pcursor->Valid(); pcursor->Next()) {
+        CAmount amount = pcursor->GetValue();
+        if (amount > 0) {
+            received += amount;
         }
-        balance += it->second;
+        balance += amount;
+    }
+    if (pcursor->HasError()) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
     }
 
     UniValue result(UniValue::VOBJ);
@@ -990,14 +1131,22 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many txids, ordered by height, and a cursor for the rest\n"
+            "  \"cursor\" (string, optional) Continue a paged query with the same addresses where the last call stopped\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (if limit or cursor is given):\n"
+            "{\n"
+            "  \"txids\"  (array) The transaction ids as above\n"
+            "  \"cursor\"  (string) Pass this to get the next txids, only present if there are more\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -1007,8 +1156,45 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    syncInsightIndexes();
+
     int start = 0;
     int end = 0;
+    int limit = 0;
+    std::string cursor;
+    if (getAddressPagingFromParams(request.params, start, end, limit, cursor)) {
+        if (!fAddressIndex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+
+        // All entries of a transaction are next to each other in the merged histories, so duplicates are skipped by
+        // comparing with the last txid only, and a page never ends in the middle of a transaction
+        std::unique_ptr<CAddressIndexCursor> pcursor = checkAddressCursor(pinsightindex->NewAddressIndexCursor(addresses, start, end, cursor));
+        UniValue txids(UniValue::VARR);
+        uint256 lastTxid;
+        for (; pcursor->Valid(); pcursor->Next()) {
+            const uint256& txid = pcursor->GetKey().txhash;
+            if (txid == lastTxid) {
+                continue;
+            }
+            if ((int)txids.size() == limit) {
+                break;
+            }
+            txids.push_back(txid.GetHex());
+            lastTxid = txid;
+        }
+        if (pcursor->HasError()) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("txids", txids));
+        if (pcursor->Valid()) {
+            result.push_back(Pair("cursor", pcursor->GetToken()));
+        }
+        return result;
+    }
+
     if (request.params[0].isObject()) {
         UniValue startValue = find_value(request.params[0].get_obj(), "start");
         UniValue endValue = find_value(request.params[0].get_obj(), "end");
@@ -1093,6 +1279,7 @@ UniValue getspentinfo(const JSONRPCRequest& request)
     CSpentIndexKey key(txid, outputIndex);
     CSpentIndexValue value;
 
+    syncInsightIndexes();
     if (!GetSpentIndex(key, value)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
     }
@@ -1118,6 +1305,17 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCMNListsMemoryInfo()
+{
+    auto stats = deterministicMNManager->GetCacheStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("lists", uint64_t(stats.nCachedLists)));
+    obj.push_back(Pair("masternodes", uint64_t(stats.nUniqueMNs)));
+    obj.push_back(Pair("states", uint64_t(stats.nUniqueStates)));
+    obj.push_back(Pair("usage", uint64_t(stats.nUsage)));
+    return obj;
+}
+
 UniValue getmemoryinfo(const JSONRPCRequest& request)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -1136,6 +1334,12 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"mnlists\": {              (json object) Information about cached deterministic masternode lists\n"
+            "    \"lists\": xxxxx,         (numeric) Number of cached lists\n"
+            "    \"masternodes\": xxxxx,   (numeric) Number of distinct masternode entries shared by the cached lists\n"
+            "    \"states\": xxxxx,        (numeric) Number of distinct masternode states shared by the cached lists\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated number of bytes used by the shared entries and states\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -1144,6 +1348,9 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
         );
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+    if (deterministicMNManager) {
+        obj.push_back(Pair("mnlists", RPCMNListsMemoryInfo()));
+    }
     return obj;
 }
 
@@ -10,6 +10,7 @@
 #include "consensus/validation.h"
 #include "core_io.h"
 #include "init.h"
+#include "insightindexer.h"
 #include "keystore.h"
 #include "validation.h"
 #include "merkleblock.h"
@@ -280,6 +281,11 @@ UniValue getrawtransaction(const JSONRPCRequest& request)
             + HelpExampleRpc("getrawtransaction", "\"mytxid\", true")
         );
 
+    // The spent index entries which TxToJSON adds must include the blocks which are already connected
+    if (pinsightindexer) {
+        pinsightindexer->BlockUntilSyncedToCurrentChain();
+    }
+
     LOCK(cs_main);
 
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
@@ -95,6 +95,67 @@ private:
     size_t nPos;
 };
 
+/** Minimal stream for reading from a range of bytes owned by someone else, e.g. a memory mapped file
+ *
+ * Nothing is copied, the referenced bytes must outlive the reader.
+ */
+class CSpanReader
+{
+public:
+/*
+ * @param[in]  nTypeIn Serialization Type
+ * @param[in]  nVersionIn Serialization Version (including any flags)
+ * @param[in]  pbeginIn Start of the bytes to read
+ * @param[in]  nSizeIn Number of bytes to read
+*/
+    CSpanReader(int nTypeIn, int nVersionIn, const unsigned char* pbeginIn, size_t nSizeIn) :
+        nType(nTypeIn), nVersion(nVersionIn), pbegin(pbeginIn), pend(pbeginIn + nSizeIn) {}
+
+    void read(char* pch, size_t nSize)
+    {
+        if (nSize > size()) {
+            throw std::ios_base::failure("CSpanReader::read(): end of data");
+        }
+        memcpy(pch, pbegin, nSize);
+        pbegin += nSize;
+    }
+    void ignore(size_t nSize)
+    {
+        if (nSize > size()) {
+            throw std::ios_base::failure("CSpanReader::ignore(): end of data");
+        }
+        pbegin += nSize;
+    }
+    template<typename T>
+    CSpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+    int GetVersion() const
+    {
+        return nVersion;
+    }
+    int GetType() const
+    {
+        return nType;
+    }
+    size_t size() const
+    {
+        return pend - pbegin;
+    }
+    bool empty() const
+    {
+        return pbegin == pend;
+    }
+private:
+    const int nType;
+    const int nVersion;
+    const unsigned char* pbegin;
+    const unsigned char* const pend;
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
@@ -11,8 +11,10 @@
 #include "uint256.h"
 #include "arith_uint256.h"
 #include <string>
+#include "random.h"
 #include "version.h"
 #include "test/test_cbdhealthnetwork.h"
+#include "test/test_random.h"
 
 BOOST_FIXTURE_TEST_SUITE(arith_uint256_tests, BasicTestingSetup)
 
@@ -368,6 +370,22 @@ BOOST_AUTO_TEST_CASE( divide )
     BOOST_CHECK_THROW(R2L / ZeroL, uint_error);
 }
 
+BOOST_AUTO_TEST_CASE( divideBy ) // DivideBy must match operator/ with the widened divisor
+{
+    BOOST_CHECK(arith_uint256(R1L).DivideBy(1) == R1L);
+    BOOST_CHECK(arith_uint256(MaxL).DivideBy(0xffffffff) == MaxL / arith_uint256(0xffffffff));
+    BOOST_CHECK(arith_uint256(ZeroL).DivideBy(7) == ZeroL);
+    BOOST_CHECK_THROW(arith_uint256(R1L).DivideBy(0), uint_error);
+    for (int i = 0; i < 1000; i++) {
+        arith_uint256 num = UintToArith256(GetRandHash()) >> (insecure_rand() % 256);
+        uint32_t div = insecure_rand() >> (insecure_rand() % 32);
+        if (div == 0) div = 1;
+        arith_uint256 quot = num;
+        quot.DivideBy(div);
+        BOOST_CHECK(quot == num / arith_uint256(div));
+    }
+}
+
 
 bool almostEqual(double d1, double d2)
 {
@@ -0,0 +1,151 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilemap.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "consensus/consensus.h"
+#include "streams.h"
+#include "validation.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilemap_tests, TestingSetup)
+
+static uint256 ReadMappedBlockHash(const CDiskBlockPos& pos)
+{
+    CMappedBlockRecord record;
+    if (!blockFileMaps.GetRecord(pos, false, 0, record)) {
+        return uint256();
+    }
+    CBlock block;
+    CSpanReader reader(SER_DISK, CLIENT_VERSION, record.data, record.size);
+    reader >> block;
+    BOOST_CHECK(reader.empty());
+    return block.GetHash();
+}
+
+BOOST_AUTO_TEST_CASE(blockfilemap_records)
+{
+    const CChainParams& chainparams = Params();
+    blockFileMaps.SetMaxFiles(2);
+
+    CBlock block1 = chainparams.GenesisBlock();
+    CBlock block2 = block1;
+    block2.nNonce++;
+
+    CDiskBlockPos pos1(100, 0);
+    BOOST_CHECK(WriteBlockToDisk(block1, pos1, chainparams.MessageStart()));
+    BOOST_CHECK(ReadMappedBlockHash(pos1) == block1.GetHash());
+
+    // Appended after the file was mapped
+    CDiskBlockPos pos2(100, pos1.nPos + ::GetSerializeSize(block1, SER_DISK, CLIENT_VERSION));
+    BOOST_CHECK(WriteBlockToDisk(block2, pos2, chainparams.MessageStart()));
+    BOOST_CHECK(ReadMappedBlockHash(pos2) == block2.GetHash());
+    BOOST_CHECK(ReadMappedBlockHash(pos1) == block1.GetHash());
+
+    // Records outside of the file or in files which don't exist are not found
+    CMappedBlockRecord record;
+    BOOST_CHECK(!blockFileMaps.GetRecord(CDiskBlockPos(100, pos2.nPos + 1000000), false, 0, record));
+    BOOST_CHECK(!blockFileMaps.GetRecord(CDiskBlockPos(101, 8), false, 0, record));
+
+    // Records stay readable when their mapping is evicted or removed
+    BOOST_CHECK(blockFileMaps.GetRecord(pos1, false, 0, record));
+    CDiskBlockPos pos3(102, 0);
+    CDiskBlockPos pos4(103, 0);
+    BOOST_CHECK(WriteBlockToDisk(block1, pos3, chainparams.MessageStart()));
+    BOOST_CHECK(WriteBlockToDisk(block2, pos4, chainparams.MessageStart()));
+    BOOST_CHECK(ReadMappedBlockHash(pos3) == block1.GetHash());
+    BOOST_CHECK(ReadMappedBlockHash(pos4) == block2.GetHash());
+    blockFileMaps.Remove(100);
+    CBlock block;
+    CSpanReader(SER_DISK, CLIENT_VERSION, record.data, record.size) >> block;
+    BOOST_CHECK(block.GetHash() == block1.GetHash());
+
+    // ReadBlockFromDisk goes through the mapping and falls back to reading the file when it's disabled
+    const CBlockIndex* pindexGenesis = chainActive.Genesis();
+    BOOST_CHECK(ReadBlockFromDisk(block, pindexGenesis, chainparams.GetConsensus()));
+    BOOST_CHECK(block.GetHash() == pindexGenesis->GetBlockHash());
+    blockFileMaps.SetMaxFiles(0);
+    BOOST_CHECK(!blockFileMaps.GetRecord(pindexGenesis->GetBlockPos(), false, 0, record));
+    BOOST_CHECK(ReadBlockFromDisk(block, pindexGenesis, chainparams.GetConsensus()));
+    BOOST_CHECK(block.GetHash() == pindexGenesis->GetBlockHash());
+}
+
+BOOST_AUTO_TEST_CASE(blockfilemap_raw_block)
+{
+    const CChainParams& chainparams = Params();
+    const CBlockIndex* pindexGenesis = chainActive.Genesis();
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << chainparams.GenesisBlock();
+    std::vector<unsigned char> expected(ssBlock.begin(), ssBlock.end());
+
+    // The raw bytes are the network serialization, with and without the mapping
+    std::vector<unsigned char> raw;
+    blockFileMaps.SetMaxFiles(2);
+    BOOST_CHECK(ReadRawBlockFromDisk(raw, pindexGenesis, chainparams.MessageStart()));
+    BOOST_CHECK(raw == expected);
+    blockFileMaps.SetMaxFiles(0);
+    BOOST_CHECK(ReadRawBlockFromDisk(raw, pindexGenesis, chainparams.MessageStart()));
+    BOOST_CHECK(raw == expected);
+
+    // Data which doesn't belong to the index entry is rejected
+    CMessageHeader::MessageStartChars wrongStart = {0, 0, 0, 0};
+    BOOST_CHECK(!ReadRawBlockFromDisk(raw, pindexGenesis, wrongStart));
+    CBlockIndex index(*pindexGenesis);
+    index.nTx++;
+    BOOST_CHECK(!ReadRawBlockFromDisk(raw, &index, chainparams.MessageStart()));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilemap_find_records)
+{
+    const CChainParams& chainparams = Params();
+    const unsigned char* messageStart = chainparams.MessageStart();
+    CBlock block1 = chainparams.GenesisBlock();
+    CBlock block2 = block1;
+    block2.nNonce++;
+    unsigned int nBlockSize = ::GetSerializeSize(block1, SER_DISK, CLIENT_VERSION);
+
+    CDiskBlockPos pos(110, 0);
+    size_t nPos1, nPos2;
+    {
+        CAutoFile file(fopen(GetBlockPosFilename(pos, "blk").string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_REQUIRE(!file.IsNull());
+        // Garbage, a block, a message start with an implausible size, the first byte of a message start, a block and a
+        // block which is cut off by the end of the file
+        file << (unsigned char)0x42 << (unsigned char)0x43;
+        file << FLATDATA(chainparams.MessageStart()) << nBlockSize << block1;
+        nPos1 = 2 + 8;
+        file << FLATDATA(chainparams.MessageStart()) << (unsigned int)79;
+        file << messageStart[0] << (unsigned char)0x42;
+        file << FLATDATA(chainparams.MessageStart()) << nBlockSize << block2;
+        nPos2 = nPos1 + nBlockSize + 8 + 2 + 8;
+        file << FLATDATA(chainparams.MessageStart()) << nBlockSize << (unsigned char)0x42;
+    }
+
+    std::shared_ptr<const CMappedBlockFile> file = CMappedBlockFile::Open(GetBlockPosFilename(pos, "blk"));
+    BOOST_REQUIRE(file);
+    std::vector<CBlockFileRecord> records = FindBlockRecords(*file, 0, messageStart, MaxBlockSize(true));
+    BOOST_REQUIRE_EQUAL(records.size(), 2);
+    BOOST_CHECK_EQUAL(records[0].nStart, nPos1 - 8);
+    BOOST_CHECK_EQUAL(records[0].nPos, nPos1);
+    BOOST_CHECK_EQUAL(records[1].nPos, nPos2);
+    for (size_t i = 0; i < records.size(); i++) {
+        BOOST_CHECK_EQUAL(records[i].nSize, nBlockSize);
+        CBlock block;
+        CSpanReader(SER_DISK, CLIENT_VERSION, file->data() + records[i].nPos, records[i].nSize) >> block;
+        BOOST_CHECK(block.GetHash() == (i == 0 ? block1 : block2).GetHash());
+    }
+
+    // Scanning again from inside a block, e.g. when it failed to deserialize
+    records = FindBlockRecords(*file, nPos1 - 7, messageStart, MaxBlockSize(true));
+    BOOST_REQUIRE_EQUAL(records.size(), 1);
+    BOOST_CHECK_EQUAL(records[0].nPos, nPos2);
+    // Sizes above the maximum are implausible
+    BOOST_CHECK(FindBlockRecords(*file, 0, messageStart, nBlockSize - 1).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
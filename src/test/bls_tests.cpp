@@ -4,6 +4,7 @@
 
 #include "bls/bls.h"
 #include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "test/test_cbdhealthnetwork.h"
 
 #include <boost/test/unit_test.hpp>
@@ -46,6 +47,99 @@ BOOST_AUTO_TEST_CASE(bls_sig_tests)
     BOOST_CHECK(sig2.VerifyInsecure(sk2.GetPublicKey(), msgHash1));
 }
 
+BOOST_AUTO_TEST_CASE(bls_recover_tests)
+{
+    const size_t threshold = 5;
+    BLSSecretKeyVector msk(threshold);
+    for (auto& sk : msk) {
+        sk.MakeNewKey();
+    }
+    CBLSPublicKey pk = msk[0].GetPublicKey();
+
+    uint256 msgHash = uint256S("0000000000000000000000000000000000000000000000000000000000000001");
+
+    std::vector<CBLSId> ids;
+    std::vector<CBLSSignature> sigShares;
+    for (size_t i = 0; i < threshold + 2; i++) {
+        CBLSId id = CBLSId::FromInt(i + 1);
+        CBLSSecretKey skShare;
+        BOOST_REQUIRE(skShare.SecretKeyShare(msk, id));
+        ids.emplace_back(id);
+        sigShares.emplace_back(skShare.Sign(msgHash));
+    }
+
+    // any threshold shares recover the same signature, with and without precomputed coefficients
+    std::vector<CBLSId> ids2(ids.begin() + 2, ids.end());
+    std::vector<CBLSSignature> sigShares2(sigShares.begin() + 2, sigShares.end());
+    CBLSSignature sig1;
+    BOOST_CHECK(sig1.Recover(sigShares2, ids2));
+    BOOST_CHECK(sig1.VerifyInsecure(pk, msgHash));
+
+    CBLSLagrangeCoefficients coefficients;
+    BOOST_REQUIRE(coefficients.Init(ids2));
+    BOOST_CHECK_EQUAL(coefficients.size(), threshold);
+    CBLSSignature sig2;
+    BOOST_CHECK(sig2.Recover(sigShares2, coefficients));
+    BOOST_CHECK(sig2 == sig1);
+
+    // the coefficients are reusable for other messages signed by the same members
+    uint256 msgHash2 = uint256S("0000000000000000000000000000000000000000000000000000000000000002");
+    std::vector<CBLSSignature> sigShares3;
+    for (size_t i = 2; i < ids.size(); i++) {
+        CBLSSecretKey skShare;
+        BOOST_REQUIRE(skShare.SecretKeyShare(msk, ids[i]));
+        sigShares3.emplace_back(skShare.Sign(msgHash2));
+    }
+    CBLSSignature sig3;
+    BOOST_CHECK(sig3.Recover(sigShares3, coefficients));
+    BOOST_CHECK(sig3.VerifyInsecure(pk, msgHash2));
+
+    // the shares must match the coefficients
+    sigShares3.pop_back();
+    BOOST_CHECK(!sig3.Recover(sigShares3, coefficients));
+    BOOST_CHECK(!sig3.IsValid());
+
+    ids2[0] = ids2[1];
+    BOOST_CHECK(!coefficients.Init(ids2));
+    BOOST_CHECK_EQUAL(coefficients.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(bls_lazy_tests)
+{
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    CBLSPublicKey pk = sk.GetPublicKey();
+
+    CBLSLazyPublicKey lazyFromObj;
+    lazyFromObj.Set(pk);
+
+    CDataStream ds(SER_DISK, 0);
+    ds << lazyFromObj;
+    CBLSLazyPublicKey lazyFromBuf;
+    ds >> lazyFromBuf;
+
+    // comparing, hashing and printing must give the same results for the serialized and the decompressed form
+    BOOST_CHECK(lazyFromBuf == lazyFromObj);
+    BOOST_CHECK(lazyFromObj == lazyFromBuf);
+    BOOST_CHECK(lazyFromBuf.GetHash() == lazyFromObj.GetHash());
+    BOOST_CHECK(lazyFromBuf.GetHash() == ::SerializeHash(pk));
+    BOOST_CHECK_EQUAL(lazyFromBuf.ToString(), pk.ToString());
+    BOOST_CHECK(lazyFromBuf.Get() == pk);
+
+    CBLSLazyPublicKey lazyCopy(lazyFromBuf);
+    BOOST_CHECK(lazyCopy == lazyFromObj);
+    BOOST_CHECK(lazyCopy.Get() == pk);
+
+    CBLSSecretKey sk2;
+    sk2.MakeNewKey();
+    CBLSLazyPublicKey lazyOther;
+    lazyOther.Set(sk2.GetPublicKey());
+    BOOST_CHECK(lazyOther != lazyFromBuf);
+    BOOST_CHECK(CBLSLazyPublicKey() != lazyFromBuf);
+    BOOST_CHECK(!CBLSLazyPublicKey().Get().IsValid());
+    BOOST_CHECK(CBLSLazyPublicKey() == CBLSLazyPublicKey());
+}
+
 struct Message
 {
     uint32_t sourceId;
@@ -154,4 +248,66 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     Verify(msgs);
 }
 
+static void VerifyAsync(CBLSWorker& worker, const std::vector<Message>& vec)
+{
+    std::vector<std::future<bool>> futures;
+    for (auto& m : vec) {
+        futures.emplace_back(worker.AsyncVerifySig(m.sig, m.pk, m.msgHash));
+        // the same signature received twice must only be verified once but still complete both jobs
+        futures.emplace_back(worker.AsyncVerifySig(m.sig, m.pk, m.msgHash));
+    }
+    for (size_t i = 0; i < vec.size(); i++) {
+        BOOST_CHECK_EQUAL(futures[i * 2].get(), vec[i].valid);
+        BOOST_CHECK_EQUAL(futures[i * 2 + 1].get(), vec[i].valid);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(worker_verify_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    std::vector<Message> msgs;
+    for (uint32_t i = 0; i < 100; i++) {
+        AddMessage(msgs, i, i, i, (i % 17) != 5);
+    }
+    // same message, signed by multiple keys, one of them invalid
+    AddMessage(msgs, 100, 100, 1, true);
+    AddMessage(msgs, 101, 101, 1, false);
+
+    for (size_t batchSize : {1, 8, 64, 1000}) {
+        worker.SetSigVerifyBatchSize(batchSize);
+        VerifyAsync(worker, msgs);
+    }
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(worker_verify_stop_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    std::vector<Message> msgs;
+    for (uint32_t i = 0; i < 200; i++) {
+        AddMessage(msgs, i, i, i, true);
+    }
+    std::vector<std::future<bool>> futures;
+    for (auto& m : msgs) {
+        futures.emplace_back(worker.AsyncVerifySig(m.sig, m.pk, m.msgHash));
+    }
+
+    // jobs which are still queued when the worker is stopped complete with false, nobody waits forever
+    worker.Stop();
+    for (auto& f : futures) {
+        BOOST_CHECK(f.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        BOOST_CHECK_NO_THROW(f.get());
+    }
+    BOOST_CHECK(!worker.IsAsyncVerifyInProgress());
+
+    auto f = worker.AsyncVerifySig(msgs[0].sig, msgs[0].pk, msgs[0].msgHash);
+    BOOST_CHECK(f.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    BOOST_CHECK(!f.get());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,356 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "coins.h"
+#include "consensus/validation.h"
+#include "keystore.h"
+#include "random.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(coinsflush_tests, BasicTestingSetup)
+
+class CCoinsViewDBTest : public CCoinsViewDB
+{
+public:
+    CCoinsViewDBTest() : CCoinsViewDB(1 << 20, true, true) {}
+
+    // What is left on disk when the process dies right after BatchWrite started
+    bool WriteOnlyHeadBlocks(const uint256& hashBlock)
+    {
+        return WriteHeadBlocks(hashBlock, ReadBestBlock());
+    }
+};
+
+static Coin MakeCoin(CAmount nValue)
+{
+    Coin coin;
+    coin.out.nValue = nValue;
+    coin.out.scriptPubKey = CScript() << OP_TRUE;
+    coin.nHeight = 1;
+    return coin;
+}
+
+static void CheckFlushes(bool fBackground)
+{
+    // Small batches, so that every write is split up
+    ForceSetArg("-dbbatchsize", "1000");
+
+    CCoinsViewDBTest db;
+    if (fBackground) {
+        db.StartBackgroundFlush();
+    }
+
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 1000; i++) {
+        outpoints.emplace_back(GetRandHash(), 0);
+    }
+
+    uint256 hashBlock1 = GetRandHash();
+    {
+        CCoinsViewCache cache(&db);
+        for (size_t i = 0; i < outpoints.size(); i++) {
+            cache.AddCoin(outpoints[i], MakeCoin(i + 1), false);
+        }
+        cache.SetBestBlock(hashBlock1);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.GetBestBlock() == hashBlock1);
+    BOOST_CHECK(db.WaitForFlush());
+    BOOST_CHECK(!db.IsFlushing());
+    BOOST_CHECK_EQUAL(db.DynamicMemoryUsage(), 0);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+
+    uint64_t nFlushCount;
+    CCoinsFlushStats stats = db.GetLastFlushStats(&nFlushCount);
+    BOOST_CHECK_EQUAL(nFlushCount, 1);
+    BOOST_CHECK(stats.hashBlock == hashBlock1);
+    BOOST_CHECK_EQUAL(stats.nCoinsWritten, 1000);
+    BOOST_CHECK_EQUAL(stats.nCoinsErased, 0);
+    BOOST_CHECK(stats.nBatches > 1);
+    BOOST_CHECK(stats.nBytes > 1000 * 32);
+
+    // Spend half of the coins. Whether the write is still in flight or not, lookups see the new state.
+    uint256 hashBlock2 = GetRandHash();
+    {
+        CCoinsViewCache cache(&db);
+        for (size_t i = 0; i < outpoints.size(); i += 2) {
+            BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+        }
+        cache.SetBestBlock(hashBlock2);
+        BOOST_CHECK(cache.Flush());
+    }
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        Coin coin;
+        BOOST_CHECK_EQUAL(db.GetCoin(outpoints[i], coin), i % 2 == 1);
+        BOOST_CHECK_EQUAL(db.HaveCoin(outpoints[i]), i % 2 == 1);
+        if (i % 2 == 1) {
+            BOOST_CHECK_EQUAL(coin.out.nValue, i + 1);
+        }
+    }
+    BOOST_CHECK(db.GetBestBlock() == hashBlock2);
+
+    // The cursor only sees the database, it has to wait for the write
+    std::unique_ptr<CCoinsViewCursor> cursor(db.Cursor());
+    BOOST_CHECK(cursor->GetBestBlock() == hashBlock2);
+    size_t nCoins = 0;
+    for (; cursor->Valid(); cursor->Next()) {
+        nCoins++;
+    }
+    BOOST_CHECK_EQUAL(nCoins, 500);
+
+    stats = db.GetLastFlushStats(&nFlushCount);
+    BOOST_CHECK_EQUAL(nFlushCount, 2);
+    BOOST_CHECK_EQUAL(stats.nCoinsWritten, 0);
+    BOOST_CHECK_EQUAL(stats.nCoinsErased, 500);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+
+    db.StopBackgroundFlush();
+    ForceSetArg("-dbbatchsize", std::to_string(nDefaultDbBatchSize));
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_sync)
+{
+    CheckFlushes(false);
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_background)
+{
+    CheckFlushes(true);
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_head_blocks)
+{
+    CCoinsViewDBTest db;
+    COutPoint outpoint(GetRandHash(), 0);
+
+    uint256 hashBlock1 = GetRandHash();
+    {
+        CCoinsViewCache cache(&db);
+        cache.AddCoin(outpoint, MakeCoin(1), false);
+        cache.SetBestBlock(hashBlock1);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+
+    // An interrupted write leaves both the old and the new best block behind, but no best block
+    uint256 hashBlock2 = GetRandHash();
+    BOOST_CHECK(db.WriteOnlyHeadBlocks(hashBlock2));
+    std::vector<uint256> hashHeads = db.GetHeadBlocks();
+    BOOST_CHECK_EQUAL(hashHeads.size(), 2);
+    BOOST_CHECK(hashHeads[0] == hashBlock2);
+    BOOST_CHECK(hashHeads[1] == hashBlock1);
+    BOOST_CHECK(db.GetBestBlock().IsNull());
+
+    // Replaying writes the new best block again, the old one is taken over from the markers
+    {
+        CCoinsViewCache cache(&db);
+        BOOST_CHECK(cache.SpendCoin(outpoint));
+        cache.SetBestBlock(hashBlock2);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+    BOOST_CHECK(db.GetBestBlock() == hashBlock2);
+    BOOST_CHECK(!db.HaveCoin(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(coinsflush_add_coins_check)
+{
+    CCoinsViewDBTest db;
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(GetRandHash(), 0));
+    tx.vout.emplace_back(MakeCoin(1).out);
+    COutPoint outpoint(tx.GetHash(), 0);
+    {
+        CCoinsViewCache cache(&db);
+        AddCoins(cache, tx, 1);
+        cache.SetBestBlock(GetRandHash());
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.HaveCoin(outpoint));
+
+    // Adding the outputs again without the check marks them as fresh, spending them then never reaches the database
+    {
+        CCoinsViewCache cache(&db);
+        AddCoins(cache, tx, 2);
+        BOOST_CHECK(cache.SpendCoin(outpoint));
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.HaveCoin(outpoint));
+
+    // A replay has to check for the outputs being there already
+    {
+        CCoinsViewCache cache(&db);
+        AddCoins(cache, tx, 2, true);
+        BOOST_CHECK_EQUAL(cache.AccessCoin(outpoint).nHeight, 2);
+        BOOST_CHECK(cache.SpendCoin(outpoint));
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(!db.HaveCoin(outpoint));
+}
+
+typedef std::map<COutPoint, Coin> CoinsMap;
+
+static CoinsMap ReadCoins(CCoinsView& view)
+{
+    CoinsMap coins;
+    std::unique_ptr<CCoinsViewCursor> cursor(view.Cursor());
+    for (; cursor->Valid(); cursor->Next()) {
+        COutPoint key;
+        Coin coin;
+        BOOST_CHECK(cursor->GetKey(key) && cursor->GetValue(coin));
+        coins.emplace(key, std::move(coin));
+    }
+    return coins;
+}
+
+static CoinsMap FlushAndReadCoins(CCoinsViewDB* pcoinsdbview)
+{
+    FlushStateToDisk();
+    BOOST_CHECK(pcoinsdbview->GetBestBlock() == chainActive.Tip()->GetBlockHash());
+    return ReadCoins(*pcoinsdbview);
+}
+
+static bool SameCoins(const CoinsMap& a, const CoinsMap& b)
+{
+    if (a.size() != b.size()) return false;
+    for (auto ita = a.begin(), itb = b.begin(); ita != a.end(); ++ita, ++itb) {
+        if (ita->first != itb->first || ita->second.out != itb->second.out ||
+            ita->second.nHeight != itb->second.nHeight || ita->second.fCoinBase != itb->second.fCoinBase) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * What is left on disk when the process dies while the coins of hashNew are written over the ones of hashOld: every
+ * second change made it, the best block is still the old one and the head blocks are {new, old}.
+ */
+static void WriteInterruptedFlush(CCoinsViewDBTest& db, const CoinsMap& coinsOld, const uint256& hashOld, const CoinsMap& coinsNew, const uint256& hashNew)
+{
+    {
+        CCoinsViewCache cache(&db);
+        for (auto& p : coinsOld) {
+            cache.AddCoin(p.first, Coin(p.second), false);
+        }
+        cache.SetBestBlock(hashOld);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    size_t nChanges = 0;
+    {
+        CCoinsViewCache cache(&db);
+        for (auto& p : coinsOld) {
+            if (!coinsNew.count(p.first) && nChanges++ % 2 == 0) {
+                BOOST_CHECK(cache.SpendCoin(p.first));
+            }
+        }
+        for (auto& p : coinsNew) {
+            if (!coinsOld.count(p.first) && nChanges++ % 2 == 0) {
+                cache.AddCoin(p.first, Coin(p.second), false);
+            }
+        }
+        cache.SetBestBlock(hashOld);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(nChanges > 2);
+    BOOST_CHECK(db.WriteOnlyHeadBlocks(hashNew));
+    BOOST_CHECK_EQUAL(db.GetHeadBlocks().size(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(coinsflush_replay_blocks, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    CScript coinbaseScript = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CBasicKeyStore keystore;
+    keystore.AddKey(coinbaseKey);
+
+    // Splits a mature coinbase output into two
+    auto spendCoinbase = [&](int i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint(coinbaseTxns[i].GetHash(), 0));
+        CAmount nValue = coinbaseTxns[i].vout[0].nValue / 2 - 1000;
+        tx.vout.emplace_back(nValue, coinbaseScript);
+        tx.vout.emplace_back(nValue, GetScriptForDestination(CScriptID(coinbaseScript)));
+        BOOST_CHECK(SignSignature(keystore, coinbaseTxns[i], tx, 0, SIGHASH_ALL));
+        return tx;
+    };
+
+    CoinsMap coins0 = FlushAndReadCoins(pcoinsdbview);
+    uint256 hash0 = chainActive.Tip()->GetBlockHash();
+
+    for (int i = 0; i < 3; i++) {
+        CreateAndProcessBlock({spendCoinbase(i)}, coinbaseScript);
+    }
+    CoinsMap coins1 = FlushAndReadCoins(pcoinsdbview);
+    uint256 hash1 = chainActive.Tip()->GetBlockHash();
+    BOOST_CHECK_EQUAL(chainActive.Height(), 103);
+
+    // Rolling forward has to put up with the coins of the new blocks which were written already
+    {
+        CCoinsViewDBTest db;
+        WriteInterruptedFlush(db, coins0, hash0, coins1, hash1);
+        BOOST_CHECK(db.GetBestBlock().IsNull());
+        {
+            LOCK(cs_main);
+            BOOST_CHECK(ReplayBlocks(chainparams, &db));
+        }
+        BOOST_CHECK(db.GetHeadBlocks().empty());
+        BOOST_CHECK(db.GetBestBlock() == hash1);
+        BOOST_CHECK(SameCoins(ReadCoins(db), coins1));
+    }
+
+    // Reorg to a longer branch which forks off below the old tip
+    CValidationState state;
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(InvalidateBlock(state, chainparams, chainActive[102]));
+    }
+    BOOST_CHECK(ActivateBestChain(state, chainparams));
+    BOOST_CHECK_EQUAL(chainActive.Height(), 101);
+    CScript otherScript = GetScriptForDestination(CScriptID(coinbaseScript));
+    for (int i = 3; i < 6; i++) {
+        CreateAndProcessBlock({spendCoinbase(i)}, otherScript);
+    }
+    CoinsMap coins2 = FlushAndReadCoins(pcoinsdbview);
+    uint256 hash2 = chainActive.Tip()->GetBlockHash();
+    BOOST_CHECK_EQUAL(chainActive.Height(), 104);
+
+    // The blocks of the old branch are rolled back on top of a partly written new branch
+    {
+        CCoinsViewDBTest db;
+        WriteInterruptedFlush(db, coins1, hash1, coins2, hash2);
+        {
+            LOCK(cs_main);
+            BOOST_CHECK(ReplayBlocks(chainparams, &db));
+        }
+        BOOST_CHECK(db.GetHeadBlocks().empty());
+        BOOST_CHECK(db.GetBestBlock() == hash2);
+        BOOST_CHECK(SameCoins(ReadCoins(db), coins2));
+    }
+
+    // The same for an interrupted reorg back to the old branch
+    {
+        CCoinsViewDBTest db;
+        WriteInterruptedFlush(db, coins2, hash2, coins1, hash1);
+        {
+            LOCK(cs_main);
+            BOOST_CHECK(ReplayBlocks(chainparams, &db));
+        }
+        BOOST_CHECK(db.GetBestBlock() == hash1);
+        BOOST_CHECK(SameCoins(ReadCoins(db), coins1));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinsprefetch.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(coinsprefetch_tests, BasicTestingSetup)
+
+static Coin MakeCoin(CAmount nValue)
+{
+    Coin coin;
+    coin.out.nValue = nValue;
+    coin.out.scriptPubKey = CScript() << OP_TRUE;
+    coin.nHeight = 1;
+    return coin;
+}
+
+static CMutableTransaction MakeSpend(const std::vector<COutPoint>& prevouts)
+{
+    CMutableTransaction tx;
+    for (const auto& prevout : prevouts) {
+        tx.vin.emplace_back(prevout);
+    }
+    tx.vout.emplace_back(1, CScript() << OP_TRUE);
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(coinsprefetch_block)
+{
+    // stands in for the chainstate database
+    CCoinsView viewDummy;
+    CCoinsViewCache db(&viewDummy);
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 100; i++) {
+        outpoints.emplace_back(GetRandHash(), 0);
+        db.AddCoin(outpoints.back(), MakeCoin(i + 1), false);
+    }
+
+    CCoinsViewPrefetch prefetch(&db);
+    prefetch.Start(2);
+    CCoinsViewCache tip(&prefetch);
+
+    // already cached in the tip, must not be fetched again
+    BOOST_CHECK(!tip.AccessCoin(outpoints[0]).IsSpent());
+
+    CBlock block;
+    block.nNonce = 1;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.emplace_back(1, CScript() << OP_TRUE);
+    block.vtx.emplace_back(MakeTransactionRef(coinbase));
+    block.vtx.emplace_back(MakeTransactionRef(MakeSpend(std::vector<COutPoint>(outpoints.begin(), outpoints.begin() + 60))));
+    // spends an output of the previous transaction in the same block and one coin which does not exist
+    block.vtx.emplace_back(MakeTransactionRef(MakeSpend({COutPoint(block.vtx[1]->GetHash(), 0), COutPoint(GetRandHash(), 0)})));
+
+    prefetch.PrefetchBlock(block, tip);
+    prefetch.WaitForBlock(block.GetHash());
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 59);
+
+    // staged coins are handed over to the tip
+    CCoinsViewCache view(&tip);
+    for (int i = 0; i < 60; i++) {
+        BOOST_CHECK_EQUAL(view.AccessCoin(outpoints[i]).out.nValue, i + 1);
+    }
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 0);
+
+    // writing to the database invalidates everything that was staged
+    CBlock block2;
+    block2.nNonce = 2;
+    block2.vtx.emplace_back(block.vtx[0]);
+    block2.vtx.emplace_back(MakeTransactionRef(MakeSpend(std::vector<COutPoint>(outpoints.begin() + 60, outpoints.end()))));
+    prefetch.PrefetchBlock(block2, tip);
+    prefetch.WaitForBlock(block2.GetHash());
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 40);
+    BOOST_CHECK(tip.SpendCoin(outpoints[0]));
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 0);
+    BOOST_CHECK(db.AccessCoin(outpoints[0]).IsSpent());
+    BOOST_CHECK_EQUAL(tip.AccessCoin(outpoints[99]).out.nValue, 100);
+
+    prefetch.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -234,6 +234,42 @@ BOOST_AUTO_TEST_CASE(iterator_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(iterator_prefix)
+{
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CDBWrapperOptions dbOptions;
+    dbOptions.nBlockCachePercent = 75;
+    dbOptions.nBlockSize = 16 * 1024;
+    CDBWrapper dbw(ph, (1 << 20), true, false, false, dbOptions);
+    for (uint8_t x = 0; x < 4; ++x) {
+        for (uint32_t y = 0; y < 100; ++y) {
+            BOOST_CHECK(dbw.Write(std::make_pair(x, y), x * y));
+        }
+    }
+
+    std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper*>(&dbw)->NewIterator());
+    it->SetPrefix((uint8_t)2);
+    it->Seek(std::make_pair((uint8_t)2, (uint32_t)0));
+    for (uint32_t y = 0; y < 100; ++y) {
+        std::pair<uint8_t, uint32_t> key;
+        uint32_t value;
+        BOOST_CHECK(it->Valid());
+        if (!it->Valid())
+            break;
+        BOOST_CHECK(it->GetKey(key));
+        BOOST_CHECK(it->GetValue(value));
+        BOOST_CHECK(key.first == 2 && key.second == y);
+        BOOST_CHECK_EQUAL(value, 2 * y);
+        it->Next();
+    }
+    // The next key would be (3, 0)
+    BOOST_CHECK(!it->Valid());
+
+    // Seeking before the prefix doesn't make keys outside of it visible
+    it->Seek(std::make_pair((uint8_t)1, (uint32_t)0));
+    BOOST_CHECK(!it->Valid());
+}
+
 struct StringContentsSerializer {
     // Used to make two serialized objects the same while letting them have a different lengths
     // This is a terrible idea
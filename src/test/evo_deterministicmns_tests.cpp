@@ -399,6 +399,55 @@ BOOST_FIXTURE_TEST_CASE(dip3_protx, TestChainDIP3Setup)
     }
     BOOST_ASSERT(foundRevived);
 
+    // lists rebuilt from disk (mostly through compacted diffs) must be identical to the ones built block by block
+    CDeterministicMNManager freshManager(*evoDb);
+    for (int h = Params().GetConsensus().DIP0003Height; h <= chainActive.Height(); h++) {
+        const uint256& blockHash = chainActive[h]->GetBlockHash();
+        auto mnList = deterministicMNManager->GetListForBlock(blockHash);
+        auto mnListFromDisk = freshManager.GetListForBlock(blockHash);
+        BOOST_CHECK_EQUAL(mnListFromDisk.GetHeight(), h);
+        BOOST_CHECK(::SerializeHash(mnListFromDisk) == ::SerializeHash(mnList));
+    }
+
     const_cast<Consensus::Params&>(Params().GetConsensus()).DIP0003EnforcementHeight = DIP0003EnforcementHeightBackup;
 }
+
+BOOST_FIXTURE_TEST_CASE(dip3_calculate_quorum, BasicTestingSetup)
+{
+    // large enough to be scored and selected in multiple chunks
+    CDeterministicMNList mnList(uint256(), 1);
+    for (size_t i = 0; i < 10000; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>();
+        dmn->proTxHash = GetRandHash();
+        dmn->collateralOutpoint = COutPoint(GetRandHash(), 0);
+        dmn->nOperatorReward = 0;
+
+        CDeterministicMNState state;
+        state.keyIDOwner.SetHex(strprintf("%040x", i + 1));
+        if (i % 10 != 0) {
+            state.UpdateConfirmedHash(dmn->proTxHash, GetRandHash());
+        }
+        dmn->pdmnState = std::make_shared<CDeterministicMNState>(state);
+        mnList.AddMN(dmn);
+    }
+
+    uint256 modifier = GetRandHash();
+    auto scores = mnList.CalculateScores(modifier);
+    BOOST_CHECK_EQUAL(scores.size(), (size_t)9000);
+
+    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+        if (a.first == b.first) {
+            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+        }
+        return a.first < b.first;
+    });
+
+    for (size_t quorumSize : {10, 400, 9000, 20000}) {
+        auto quorum = mnList.CalculateQuorum(quorumSize, modifier);
+        BOOST_CHECK_EQUAL(quorum.size(), std::min(quorumSize, scores.size()));
+        for (size_t i = 0; i < quorum.size(); i++) {
+            BOOST_CHECK(quorum[i] == scores[i].second);
+        }
+    }
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,8 +5,10 @@
 #include "test/test_cbdhealthnetwork.h"
 
 #include "bls/bls.h"
+#include "evo/deterministicmns.h"
 #include "evo/simplifiedmns.h"
 #include "netbase.h"
+#include "test/test_random.h"
 
 #include <boost/test/unit_test.hpp>
 
@@ -70,4 +72,71 @@ BOOST_AUTO_TEST_CASE(simplifiedmns_merkleroots)
 
     BOOST_CHECK(expectedMerkleRoot == calculatedMerkleRoot);
 }
+
+static CDeterministicMNCPtr MakeTestDmn(uint32_t n)
+{
+    auto dmn = std::make_shared<CDeterministicMN>();
+    dmn->proTxHash = GetRandHash();
+    dmn->collateralOutpoint = COutPoint(GetRandHash(), 0);
+    dmn->nOperatorReward = 0;
+
+    CDeterministicMNState state;
+    state.keyIDOwner.SetHex(strprintf("%040x", n + 1));
+    state.keyIDVoting = state.keyIDOwner;
+    state.confirmedHash = GetRandHash();
+    dmn->pdmnState = std::make_shared<CDeterministicMNState>(state);
+    return dmn;
+}
+
+BOOST_AUTO_TEST_CASE(simplifiedmns_incremental_merkleroot)
+{
+    CDeterministicMNList mnList;
+    uint32_t nextMN = 0;
+    for (size_t i = 0; i < 20; i++) {
+        mnList.AddMN(MakeTestDmn(nextMN++));
+    }
+
+    CSimplifiedMNListMerkleTree tree;
+    tree.ApplyDiff(mnList, CDeterministicMNList().BuildDiff(mnList));
+    BOOST_CHECK(tree.GetMerkleRoot() == CSimplifiedMNList(mnList).CalcMerkleRoot());
+
+    for (size_t i = 0; i < 200; i++) {
+        CDeterministicMNList newList = mnList;
+
+        std::vector<uint256> proTxHashes;
+        newList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            proTxHashes.emplace_back(dmn->proTxHash);
+        });
+
+        // a mix of updates which do and don't change the SML entries, removals and additions
+        for (size_t j = 0; j < proTxHashes.size(); j++) {
+            switch (insecure_rand() % 8) {
+            case 0: {
+                auto newState = std::make_shared<CDeterministicMNState>(*newList.GetMN(proTxHashes[j])->pdmnState);
+                newState->nLastPaidHeight++;
+                newList.UpdateMN(proTxHashes[j], newState);
+                break;
+            }
+            case 1: {
+                auto newState = std::make_shared<CDeterministicMNState>(*newList.GetMN(proTxHashes[j])->pdmnState);
+                newState->nPoSeBanHeight = newState->nPoSeBanHeight == -1 ? (int)i : -1;
+                newList.UpdateMN(proTxHashes[j], newState);
+                break;
+            }
+            case 2:
+                if (insecure_rand() % 4 == 0) {
+                    newList.RemoveMN(proTxHashes[j]);
+                }
+                break;
+            }
+        }
+        for (size_t j = insecure_rand() % 3; j > 0; j--) {
+            newList.AddMN(MakeTestDmn(nextMN++));
+        }
+
+        tree.ApplyDiff(newList, mnList.BuildDiff(newList));
+        BOOST_CHECK(tree.GetMerkleRoot() == CSimplifiedMNList(newList).CalcMerkleRoot());
+        mnList = newList;
+    }
+}
 BOOST_AUTO_TEST_SUITE_END()
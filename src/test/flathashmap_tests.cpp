@@ -0,0 +1,143 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flathashmap.h"
+#include "memusage.h"
+#include "test/test_cbdhealthnetwork.h"
+#include "test/test_random.h"
+
+#include <map>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+// Maps many keys to the same few hashes, which results in long probe sequences which wrap around the end of the table
+struct CollidingHasher
+{
+    size_t operator()(uint32_t k) const { return (size_t)(k % 5) * ((size_t)-1 / 5) + (k % 3); }
+};
+
+template <typename Hash>
+static void CompareMaps(const flathashmap<uint32_t, std::string, Hash>& m, const std::map<uint32_t, std::string>& ref)
+{
+    BOOST_CHECK_EQUAL(m.size(), ref.size());
+    size_t count = 0;
+    for (auto it = m.begin(); it != m.end(); ++it) {
+        auto it2 = ref.find(it->first);
+        BOOST_CHECK(it2 != ref.end() && it2->second == it->second);
+        count++;
+    }
+    BOOST_CHECK_EQUAL(count, ref.size());
+    for (const auto& p : ref) {
+        auto it = m.find(p.first);
+        BOOST_CHECK(it != m.end() && it->second == p.second);
+    }
+}
+
+template <typename Hash>
+static void RandomOps(size_t keyRange, size_t growthLimit)
+{
+    flathashmap<uint32_t, std::string, Hash> m;
+    m.set_growth_limit(growthLimit);
+    std::map<uint32_t, std::string> ref;
+
+    for (int i = 0; i < 20000; i++) {
+        uint32_t k = insecure_rand() % keyRange;
+        switch (insecure_rand() % 4) {
+        case 0: {
+            std::string v = std::to_string(insecure_rand());
+            bool inserted = m.emplace(k, v).second;
+            BOOST_CHECK_EQUAL(inserted, ref.emplace(k, v).second);
+            break;
+        }
+        case 1:
+            m[k] = std::to_string(i);
+            ref[k] = std::to_string(i);
+            break;
+        case 2:
+            BOOST_CHECK_EQUAL(m.erase(k), ref.erase(k));
+            break;
+        case 3:
+            BOOST_CHECK_EQUAL(m.count(k), ref.count(k));
+            break;
+        }
+        if (i % 5000 == 0) {
+            CompareMaps(m, ref);
+        }
+    }
+    CompareMaps(m, ref);
+
+    // copies and moves keep the content
+    flathashmap<uint32_t, std::string, Hash> m2(m);
+    CompareMaps(m2, ref);
+    flathashmap<uint32_t, std::string, Hash> m3(std::move(m2));
+    CompareMaps(m3, ref);
+    BOOST_CHECK(m2.empty());
+
+    // erase while iterating, the way BatchWrite does it
+    for (auto it = m.begin(); it != m.end();) {
+        if (it->first % 2 == 0) {
+            ref.erase(it->first);
+            m.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    CompareMaps(m, ref);
+
+    size_t capacity = m.capacity();
+    m.clear();
+    BOOST_CHECK(m.empty() && m.begin() == m.end());
+    BOOST_CHECK_EQUAL(m.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_random)
+{
+    seed_insecure_rand(true);
+    RandomOps<std::hash<uint32_t> >(100, 0);
+    RandomOps<std::hash<uint32_t> >(5000, 0);
+    RandomOps<std::hash<uint32_t> >(5000, 1000);
+    RandomOps<CollidingHasher>(300, 0);
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_growth)
+{
+    flathashmap<uint32_t, uint64_t> m;
+    BOOST_CHECK_EQUAL(m.capacity(), 0);
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(m), 0);
+
+    m.reserve(1000);
+    size_t capacity = m.capacity();
+    BOOST_CHECK(capacity >= 1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+        m.emplace(i, i);
+    }
+    BOOST_CHECK_EQUAL(m.capacity(), capacity);
+    for (uint32_t i = 0; i < 600; i++) {
+        m.erase(i);
+    }
+
+    // Tombstones of erased entries don't make the table grow
+    for (uint32_t i = 1000; i < 100000; i++) {
+        m.erase(i - 400);
+        m.emplace(i, i);
+    }
+    BOOST_CHECK_EQUAL(m.size(), 400);
+    BOOST_CHECK_EQUAL(m.capacity(), capacity);
+
+    // Beyond the growth limit the table grows in small steps only
+    flathashmap<uint32_t, uint64_t> m2;
+    m2.set_growth_limit(10000);
+    for (uint32_t i = 0; i < 8750; i++) {
+        m2.emplace(i, i);
+    }
+    BOOST_CHECK_EQUAL(m2.capacity(), 10000);
+    m2.emplace(8750, 8750);
+    BOOST_CHECK(m2.capacity() > 10000 && m2.capacity() <= 11250);
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(m2), memusage::MallocUsage(m2.capacity() * sizeof(std::pair<const uint32_t, uint64_t>)) + memusage::MallocUsage(m2.capacity()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
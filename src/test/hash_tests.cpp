@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "hash.h"
+#include "primitives/block.h"
+#include "streams.h"
 #include "utilstrencodings.h"
 #include "test/test_cbdhealthnetwork.h"
 
@@ -149,4 +151,63 @@ BOOST_AUTO_TEST_CASE(siphash)
     BOOST_CHECK_EQUAL(SipHashUint256(1, 2, ss.GetHash()), 0x79751e980c2a0a35ULL);
 }
 
+BOOST_AUTO_TEST_CASE(x11_batch)
+{
+    // HashX11Batch must agree with HashX11 for partial, full and multiple groups of lanes
+    for (size_t nCount : {1, 3, 15, 16, 17, 40}) {
+        std::vector<unsigned char> data(nCount * 80);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = (unsigned char)(i * 7 + nCount);
+        }
+        std::vector<uint256> hashes(nCount);
+        HashX11Batch(data.data(), 80, nCount, hashes.data());
+        for (size_t i = 0; i < nCount; i++) {
+            BOOST_CHECK(hashes[i] == HashX11(data.begin() + i * 80, data.begin() + (i + 1) * 80));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockheader_hash)
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = uint256S("0x1234");
+    header.hashMerkleRoot = uint256S("0x5678");
+    header.nTime = 1500000000;
+    header.nBits = 0x1e0ffff0;
+    header.nNonce = 42;
+
+    auto streamHash = [](const CBlockHeader& h) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << h;
+        BOOST_CHECK(ss.size() == CBlockHeader::HEADER_SIZE);
+        return HashX11(ss.begin(), ss.end());
+    };
+
+    uint256 hash = header.GetHash();
+    BOOST_CHECK(hash == streamHash(header));
+
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == hash);
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == hash);
+
+    header.nNonce++;
+    BOOST_CHECK(header.GetHash() != hash);
+    BOOST_CHECK(header.GetHash() == streamHash(header));
+    block.hashMerkleRoot = uint256S("0x9abc");
+    BOOST_CHECK(block.GetHash() == streamHash(block));
+
+    // batch hashing gives the same results
+    std::vector<CBlockHeader> headers(20, header);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nNonce = i;
+    }
+    std::vector<uint256> hashes;
+    GetBlockHeaderHashes(headers, hashes);
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+        BOOST_CHECK(hashes[i] == streamHash(headers[i]));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "random.h"
+#include "txdb.h"
+#include "utilstrencodings.h"
+#include "validation.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(insightindex_tests, TestingSetup)
+
+static std::vector<std::pair<CAddressIndexKey, CAmount> > MakeHistory(int type, const uint160& addressHash, int nEntries)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+    for (int i = 0; i < nEntries; i++) {
+        history.emplace_back(CAddressIndexKey(type, addressHash, i + 1, 0, GetRandHash(), 0, false), i + 1);
+    }
+    return history;
+}
+
+BOOST_AUTO_TEST_CASE(insightindex_address_ranges)
+{
+    uint160 addressHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314"));
+    uint160 nextHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121315"));
+    BOOST_CHECK(pinsightindex->WriteAddressIndex(MakeHistory(1, addressHash, 50)));
+    // Neighbouring keys which must not show up in the history of addressHash
+    BOOST_CHECK(pinsightindex->WriteAddressIndex(MakeHistory(1, nextHash, 10)));
+    BOOST_CHECK(pinsightindex->WriteAddressIndex(MakeHistory(2, addressHash, 10)));
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(addressHash, 1, history));
+    BOOST_CHECK_EQUAL(history.size(), 50);
+    for (size_t i = 0; i < history.size(); i++) {
+        BOOST_CHECK(history[i].first.type == 1 && history[i].first.hashBytes == addressHash);
+        BOOST_CHECK_EQUAL(history[i].first.blockHeight, i + 1);
+    }
+
+    history.clear();
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(addressHash, 1, history, 10, 19));
+    BOOST_CHECK_EQUAL(history.size(), 10);
+    BOOST_CHECK(!history.empty() && history.front().first.blockHeight == 10 && history.back().first.blockHeight == 19);
+
+    history.clear();
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(nextHash, 1, history));
+    BOOST_CHECK_EQUAL(history.size(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(insightindex_merge_cursor)
+{
+    std::vector<std::pair<uint160, int> > addresses;
+    std::vector<CAddressIndexKey> expected;
+    for (int i = 0; i < 3; i++) {
+        addresses.emplace_back(uint160(std::vector<unsigned char>(20, (unsigned char)(i + 1))), 1);
+        // Every address has entries at every third height, the first two also share height 100
+        std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+        for (int h = i + 1; h <= 90; h += 3) {
+            history.emplace_back(CAddressIndexKey(1, addresses.back().first, h, 0, GetRandHash(), 0, false), 1);
+        }
+        if (i < 2) {
+            history.emplace_back(CAddressIndexKey(1, addresses.back().first, 100, 0, GetRandHash(), 0, false), 1);
+        }
+        BOOST_CHECK(pinsightindex->WriteAddressIndex(history));
+        for (const auto& entry : history) {
+            expected.push_back(entry.first);
+        }
+    }
+    std::sort(expected.begin(), expected.end(), [](const CAddressIndexKey& a, const CAddressIndexKey& b) {
+        return a.blockHeight != b.blockHeight ? a.blockHeight < b.blockHeight : a.txhash < b.txhash;
+    });
+
+    // Pages of 7 entries which are resumed with the token, the result is ordered by height
+    std::vector<CAddressIndexKey> entries;
+    std::string token;
+    do {
+        std::unique_ptr<CAddressIndexCursor> pcursor = pinsightindex->NewAddressIndexCursor(addresses, 0, 0, token);
+        token.clear();
+        for (int n = 0; pcursor->Valid(); pcursor->Next(), n++) {
+            if (n == 7) {
+                token = pcursor->GetToken();
+                break;
+            }
+            entries.push_back(pcursor->GetKey());
+        }
+        BOOST_CHECK(!pcursor->HasError());
+    } while (!token.empty());
+    BOOST_CHECK_EQUAL(entries.size(), expected.size());
+    for (size_t i = 0; i < entries.size() && i < expected.size(); i++) {
+        BOOST_CHECK(entries[i].blockHeight == expected[i].blockHeight && entries[i].txhash == expected[i].txhash);
+    }
+
+    // Height range
+    size_t nCount = 0;
+    for (auto pcursor = pinsightindex->NewAddressIndexCursor(addresses, 10, 20, ""); pcursor->Valid(); pcursor->Next()) {
+        BOOST_CHECK(pcursor->GetKey().blockHeight >= 10 && pcursor->GetKey().blockHeight <= 20);
+        nCount++;
+    }
+    BOOST_CHECK_EQUAL(nCount, 11);
+
+    BOOST_CHECK(pinsightindex->NewAddressIndexCursor(addresses, 0, 0, "zz")->HasError());
+    BOOST_CHECK(pinsightindex->NewAddressIndexCursor(addresses, 0, 0, "00")->HasError());
+}
+
+BOOST_AUTO_TEST_CASE(insightindex_migration)
+{
+    // Entries as older versions wrote them into the block database, keyed with the same prefixes
+    uint160 addressHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314"));
+    for (const auto& entry : MakeHistory(1, addressHash, 20)) {
+        BOOST_CHECK(pblocktree->Write(std::make_pair('a', entry.first), entry.second));
+    }
+    CSpentIndexKey spentKey(GetRandHash(), 1);
+    CSpentIndexValue spentValue(GetRandHash(), 0, 10, 5 * COIN, 1, addressHash);
+    BOOST_CHECK(pblocktree->Write(std::make_pair('p', spentKey), spentValue));
+    CTimestampIndexKey timestampKey(1000, GetRandHash());
+    BOOST_CHECK(pblocktree->Write(std::make_pair('s', timestampKey), 0));
+    BOOST_CHECK(pblocktree->WriteFlag("addressindex", true));
+
+    BOOST_CHECK(pblocktree->MigrateInsightIndexes(*pinsightindex));
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(addressHash, 1, history));
+    BOOST_CHECK_EQUAL(history.size(), 20);
+    CSpentIndexValue value;
+    BOOST_CHECK(pinsightindex->ReadSpentIndex(spentKey, value));
+    BOOST_CHECK(value.txid == spentValue.txid && value.satoshis == spentValue.satoshis);
+    std::vector<uint256> hashes;
+    BOOST_CHECK(pinsightindex->ReadTimestampIndex(2000, 0, hashes));
+    BOOST_CHECK(hashes.size() == 1 && hashes[0] == timestampKey.blockHash);
+
+    // The entries are gone from the block database, everything else is still there
+    BOOST_CHECK(!pblocktree->Exists(std::make_pair('p', spentKey)));
+    BOOST_CHECK(!pblocktree->Exists(std::make_pair('a', history[0].first)));
+    bool fValue = false;
+    BOOST_CHECK(pblocktree->ReadFlag("addressindex", fValue) && fValue);
+
+    // Nothing left to do the next time
+    BOOST_CHECK(pblocktree->MigrateInsightIndexes(*pinsightindex));
+    history.clear();
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(addressHash, 1, history));
+    BOOST_CHECK_EQUAL(history.size(), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
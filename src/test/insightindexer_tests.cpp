@@ -0,0 +1,258 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "insightindexer.h"
+#include "random.h"
+#include "script/interpreter.h"
+#include "script/standard.h"
+#include "txdb.h"
+#include "undo.h"
+#include "validation.h"
+#include "validationinterface.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(insightindexer_tests, TestChain100Setup)
+
+static size_t CountUnspent(const uint160& hash, int type)
+{
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspent;
+    BOOST_CHECK(pinsightindex->ReadAddressUnspentIndex(hash, type, unspent));
+    return unspent.size();
+}
+
+static size_t CountHistory(const uint160& hash, int type)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > history;
+    BOOST_CHECK(pinsightindex->ReadAddressIndex(hash, type, history));
+    return history.size();
+}
+
+BOOST_AUTO_TEST_CASE(insightindexer_block_update)
+{
+    CKey keyA, keyC;
+    keyA.MakeNewKey(true);
+    keyC.MakeNewKey(true);
+    uint160 hashA = keyA.GetPubKey().GetID();
+    uint160 hashC = keyC.GetPubKey().GetID();
+    CScript scriptB = CScript() << OP_TRUE;
+    uint160 hashB = CScriptID(scriptB);
+
+    // An output of an earlier block, paying to the P2SH address B
+    COutPoint prevout(GetRandHash(), 0);
+    Coin prevCoin(CTxOut(5 * COIN, GetScriptForDestination(CScriptID(scriptB))), 10, false);
+    BOOST_CHECK(pinsightindex->UpdateAddressUnspentIndex({{CAddressUnspentKey(2, hashB, prevout.hash, prevout.n), CAddressUnspentValue(prevCoin.out.nValue, prevCoin.out.scriptPubKey, 10)}}));
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.emplace_back(50 * COIN, GetScriptForDestination(keyA.GetPubKey().GetID()));
+    // Pays to A and to the P2PK script of C
+    CMutableTransaction tx1;
+    tx1.vin.emplace_back(prevout);
+    tx1.vout.emplace_back(3 * COIN, GetScriptForDestination(keyA.GetPubKey().GetID()));
+    tx1.vout.emplace_back(1 * COIN, CScript() << ToByteVector(keyC.GetPubKey()) << OP_CHECKSIG);
+    // Spends the first output of tx1 in the same block
+    CMutableTransaction tx2;
+    tx2.vin.emplace_back(COutPoint(tx1.GetHash(), 0));
+    tx2.vout.emplace_back(3 * COIN, GetScriptForDestination(CScriptID(scriptB)));
+
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(tx1), MakeTransactionRef(tx2)};
+    CBlockUndo blockUndo;
+    blockUndo.vtxundo.resize(2);
+    blockUndo.vtxundo[0].vprevout.push_back(prevCoin);
+    blockUndo.vtxundo[1].vprevout.push_back(Coin(tx1.vout[0], 150, false));
+
+    uint256 hashBlock = GetRandHash();
+    CBlockIndex index;
+    index.nHeight = 150;
+    index.nTime = 1500000000;
+    index.phashBlock = &hashBlock;
+
+    CInsightIndexBlockUpdate update;
+    CInsightIndexer::BuildBlockUpdate(block, blockUndo, &index, true, true, true, true, update);
+    BOOST_CHECK(pinsightindex->WriteBlockUpdate(update));
+
+    // The output spent in the same block is gone from the unspent index, but it's in the history
+    BOOST_CHECK_EQUAL(CountUnspent(hashA, 1), 1);
+    BOOST_CHECK_EQUAL(CountHistory(hashA, 1), 3);
+    BOOST_CHECK_EQUAL(CountUnspent(hashB, 2), 1);
+    BOOST_CHECK_EQUAL(CountHistory(hashB, 2), 2);
+    BOOST_CHECK_EQUAL(CountUnspent(hashC, 1), 1);
+    CSpentIndexKey spentKey(prevout.hash, prevout.n);
+    CSpentIndexValue spentValue;
+    BOOST_CHECK(pinsightindex->ReadSpentIndex(spentKey, spentValue));
+    BOOST_CHECK(spentValue.txid == tx1.GetHash() && spentValue.blockHeight == 150 && spentValue.satoshis == 5 * COIN);
+    BOOST_CHECK(spentValue.addressType == 2 && spentValue.addressHash == hashB);
+    std::vector<uint256> hashes;
+    BOOST_CHECK(pinsightindex->ReadTimestampIndex(index.nTime, index.nTime, hashes));
+    BOOST_CHECK(hashes.size() == 1 && hashes[0] == hashBlock);
+
+    // Disconnecting restores the output of the earlier block and removes everything else
+    update = CInsightIndexBlockUpdate();
+    CInsightIndexer::BuildBlockUpdate(block, blockUndo, &index, false, true, true, true, update);
+    BOOST_CHECK(pinsightindex->WriteBlockUpdate(update));
+
+    BOOST_CHECK_EQUAL(CountUnspent(hashA, 1), 0);
+    BOOST_CHECK_EQUAL(CountHistory(hashA, 1), 0);
+    BOOST_CHECK_EQUAL(CountHistory(hashB, 2), 0);
+    BOOST_CHECK_EQUAL(CountUnspent(hashC, 1), 0);
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspent;
+    BOOST_CHECK(pinsightindex->ReadAddressUnspentIndex(hashB, 2, unspent));
+    BOOST_CHECK(unspent.size() == 1 && unspent[0].first.txhash == prevout.hash && unspent[0].second.blockHeight == 10);
+    BOOST_CHECK(!pinsightindex->ReadSpentIndex(spentKey, spentValue));
+    hashes.clear();
+    BOOST_CHECK(pinsightindex->ReadTimestampIndex(index.nTime, index.nTime, hashes));
+    BOOST_CHECK(hashes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(insightindexer_follows_chain)
+{
+    const CChainParams& chainparams = Params();
+    CScript coinbaseScript = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    uint160 coinbaseHash = coinbaseKey.GetPubKey().GetID();
+
+    CInsightIndexer indexer(*pinsightindex);
+    BOOST_CHECK(indexer.Init(true, true, false));
+    RegisterValidationInterface(&indexer);
+    indexer.Start();
+    BOOST_CHECK(indexer.BlockUntilSyncedToCurrentChain(true));
+
+    size_t nCoinbaseOutputs = 0;
+    for (const auto& tx : coinbaseTxns) {
+        for (const auto& out : tx.vout) {
+            nCoinbaseOutputs += out.scriptPubKey == coinbaseScript;
+        }
+    }
+    BOOST_CHECK_EQUAL(CountHistory(coinbaseHash, 1), nCoinbaseOutputs);
+    BOOST_CHECK_EQUAL(CountUnspent(coinbaseHash, 1), nCoinbaseOutputs);
+
+    // A block which spends a coinbase to a new address
+    CKey key;
+    key.MakeNewKey(true);
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint(coinbaseTxns[0].GetHash(), 0));
+    spend.vout.emplace_back(coinbaseTxns[0].vout[0].nValue - 1000, GetScriptForDestination(key.GetPubKey().GetID()));
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbaseScript, spend, 0, SIGHASH_ALL);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CBlock block = CreateAndProcessBlock({spend}, coinbaseScript);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    BOOST_CHECK(indexer.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(CountUnspent(key.GetPubKey().GetID(), 1), 1);
+    CSpentIndexKey spentKey(coinbaseTxns[0].GetHash(), 0);
+    CSpentIndexValue spentValue;
+    BOOST_CHECK(pinsightindex->ReadSpentIndex(spentKey, spentValue) && spentValue.txid == spend.GetHash());
+
+    // The indexes follow the chain back when the block is disconnected
+    CValidationState state;
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(InvalidateBlock(state, chainparams, chainActive.Tip()));
+    }
+    BOOST_CHECK(ActivateBestChain(state, chainparams));
+    BOOST_CHECK(indexer.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(CountHistory(key.GetPubKey().GetID(), 1), 0);
+    BOOST_CHECK(!pinsightindex->ReadSpentIndex(spentKey, spentValue));
+    BOOST_CHECK_EQUAL(CountUnspent(coinbaseHash, 1), nCoinbaseOutputs);
+
+    UnregisterValidationInterface(&indexer);
+    indexer.Stop();
+
+    // The best blocks are kept, an index which is enabled later catches up on its own
+    CInsightIndexer indexer2(*pinsightindex);
+    BOOST_CHECK(indexer2.Init(true, true, true));
+    std::vector<CInsightIndexer::IndexInfo> vInfo = indexer2.GetInfo();
+    BOOST_CHECK_EQUAL(vInfo.size(), 3);
+    BOOST_CHECK_EQUAL(vInfo[0].nBestHeight, chainActive.Height());
+    BOOST_CHECK_EQUAL(vInfo[1].nBestHeight, chainActive.Height());
+    BOOST_CHECK_EQUAL(vInfo[2].nBestHeight, -1);
+    indexer2.Start();
+    BOOST_CHECK(indexer2.BlockUntilSyncedToCurrentChain(true));
+    std::vector<uint256> hashes;
+    BOOST_CHECK(pinsightindex->ReadTimestampIndex(std::numeric_limits<unsigned int>::max(), 0, hashes));
+    BOOST_CHECK_EQUAL(hashes.size(), chainActive.Height());
+    indexer2.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(insightindexer_prune_lock)
+{
+    const CChainParams& chainparams = Params();
+
+    {
+        CInsightIndexer indexer(*pinsightindex);
+        BOOST_CHECK(indexer.Init(false, false, false));
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(indexer.GetPruneLockHeight(), std::numeric_limits<int>::max());
+    }
+
+    CInsightIndexer indexer(*pinsightindex);
+    BOOST_CHECK(indexer.Init(true, false, false));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(indexer.GetPruneLockHeight(), 0);
+    }
+    indexer.Start();
+    BOOST_CHECK(indexer.BlockUntilSyncedToCurrentChain(true));
+    indexer.Stop();
+
+    // An index at a block which is not active any more needs the blocks above the fork to disconnect it
+    CValidationState state;
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(indexer.GetPruneLockHeight(), chainActive.Height());
+        BOOST_CHECK(InvalidateBlock(state, chainparams, chainActive.Tip()));
+        BOOST_CHECK_EQUAL(indexer.GetPruneLockHeight(), chainActive.Height());
+    }
+
+    // An index can't be enabled when blocks it needs were pruned
+    {
+        LOCK(cs_main);
+        CBlockIndex* pindex = chainActive[chainActive.Height() / 2];
+        fHavePruned = true;
+        pindex->nStatus &= ~BLOCK_HAVE_DATA;
+        CInsightIndexer indexer2(*pinsightindex);
+        BOOST_CHECK(!indexer2.Init(false, true, false));
+        pindex->nStatus |= BLOCK_HAVE_DATA;
+        BOOST_CHECK(indexer2.Init(false, true, false));
+        fHavePruned = false;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(insightindexer_legacy_flag)
+{
+    // An index written by an older version, which is disabled on the first start after the upgrade
+    BOOST_CHECK(pblocktree->WriteFlag("timestampindex", true));
+    int nUpgradeHeight = chainActive.Height();
+    {
+        CInsightIndexer indexer(*pinsightindex);
+        BOOST_CHECK(indexer.Init(false, false, false));
+    }
+    bool fLegacy = true;
+    BOOST_CHECK(pblocktree->ReadFlag("timestampindex", fLegacy) && !fLegacy);
+    CBlockLocator locator;
+    BOOST_CHECK(pinsightindex->ReadBestBlock("timestampindex", locator));
+    BOOST_CHECK(locator.vHave[0] == chainActive.Tip()->GetBlockHash());
+
+    // Enabled later, it continues from where the older version stopped instead of the tip of that start
+    CScript coinbaseScript = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CreateAndProcessBlock({}, coinbaseScript);
+    BOOST_CHECK_EQUAL(chainActive.Height(), nUpgradeHeight + 1);
+    CInsightIndexer indexer(*pinsightindex);
+    BOOST_CHECK(indexer.Init(false, false, true));
+    std::vector<CInsightIndexer::IndexInfo> vInfo = indexer.GetInfo();
+    BOOST_CHECK_EQUAL(vInfo.size(), 1);
+    BOOST_CHECK_EQUAL(vInfo[0].nBestHeight, nUpgradeHeight);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dbwrapper.h"
+#include "random.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include "llmq/quorums_instantsend.h"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_instantsend_tests, BasicTestingSetup)
+
+static std::pair<uint256, CInstantSendLockPtr> MakeInstantSendLock()
+{
+    auto islock = std::make_shared<CInstantSendLock>();
+    islock->txid = GetRandHash();
+    islock->inputs.emplace_back(GetRandHash(), 0);
+    islock->inputs.emplace_back(GetRandHash(), 1);
+    return std::make_pair(::SerializeHash(*islock), islock);
+}
+
+static bool HasInstantSendLock(CInstantSendDb& db, const std::pair<uint256, CInstantSendLockPtr>& p)
+{
+    auto& hash = p.first;
+    auto& islock = *p.second;
+    bool ret = db.GetInstantSendLockByHash(hash) != nullptr;
+    BOOST_CHECK_EQUAL(ret, db.GetInstantSendLockHashByTxid(islock.txid) == hash);
+    for (auto& in : islock.inputs) {
+        auto islock2 = db.GetInstantSendLockByInput(in);
+        BOOST_CHECK_EQUAL(ret, islock2 != nullptr && islock2->txid == islock.txid);
+    }
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_index)
+{
+    CDBWrapper llmqDb("", 1 << 20, true);
+
+    auto islock1 = MakeInstantSendLock();
+    auto islock2 = MakeInstantSendLock();
+    auto islock3 = MakeInstantSendLock();
+    {
+        CInstantSendDb db(llmqDb);
+        BOOST_CHECK(!HasInstantSendLock(db, islock1));
+        db.WriteNewInstantSendLock(islock1.first, *islock1.second);
+        db.WriteNewInstantSendLocks({islock2, islock3}, {std::make_pair(islock2.first, 10)});
+        BOOST_CHECK(HasInstantSendLock(db, islock1));
+        BOOST_CHECK(HasInstantSendLock(db, islock2));
+        BOOST_CHECK(HasInstantSendLock(db, islock3));
+    }
+
+    // the index is rebuilt from the db
+    CInstantSendDb db(llmqDb);
+    BOOST_CHECK(HasInstantSendLock(db, islock1));
+    BOOST_CHECK(HasInstantSendLock(db, islock2));
+    BOOST_CHECK(HasInstantSendLock(db, islock3));
+
+    db.WriteInstantSendLockMined(islock3.first, 20);
+    auto removed = db.RemoveConfirmedInstantSendLocks(10);
+    BOOST_CHECK_EQUAL(removed.size(), 1);
+    BOOST_CHECK(removed.count(islock2.first));
+    BOOST_CHECK(!HasInstantSendLock(db, islock2));
+    BOOST_CHECK(db.HasArchivedInstantSendLock(islock2.first));
+    BOOST_CHECK(HasInstantSendLock(db, islock3));
+
+    db.RemoveInstantSendLock(islock1.first, nullptr);
+    BOOST_CHECK(!HasInstantSendLock(db, islock1));
+    BOOST_CHECK(HasInstantSendLock(db, islock3));
+}
+
+// islock i spends from the TXs of the islocks in parents[i]
+static std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>> MakeInstantSendLockBatch(const std::vector<std::vector<size_t>>& parents)
+{
+    std::vector<std::tuple<NodeId, uint256, CInstantSendLockPtr>> ret;
+    for (size_t i = 0; i < parents.size(); i++) {
+        ret.emplace_back(0, uint256(), MakeInstantSendLock().second);
+    }
+    for (size_t i = 0; i < parents.size(); i++) {
+        auto& islock = *std::get<2>(ret[i]);
+        for (auto j : parents[i]) {
+            islock.inputs.emplace_back(std::get<2>(ret[j])->txid, (uint32_t)i);
+        }
+        std::get<1>(ret[i]) = ::SerializeHash(islock);
+    }
+    return ret;
+}
+
+static std::vector<size_t> PositionsInOrder(const std::vector<size_t>& order)
+{
+    std::vector<size_t> ret(order.size());
+    for (size_t pos = 0; pos < order.size(); pos++) {
+        ret[order[pos]] = pos;
+    }
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_batch_order)
+{
+    // 0 spends from 2, 1 and 2 spend from 3, 3 spends from 4 and 5 is unrelated. Children come before their parents.
+    std::vector<std::vector<size_t>> parents{{2}, {3}, {3}, {4}, {}, {}};
+    auto islocks = MakeInstantSendLockBatch(parents);
+
+    std::vector<std::vector<size_t>> children;
+    auto order = SortInstantSendLocksByDependencies(islocks, children);
+    BOOST_CHECK_EQUAL(order.size(), islocks.size());
+    auto positions = PositionsInOrder(order);
+    for (size_t i = 0; i < parents.size(); i++) {
+        for (auto j : parents[i]) {
+            BOOST_CHECK(positions[j] < positions[i]);
+        }
+    }
+    BOOST_CHECK(children[3] == std::vector<size_t>({1, 2}));
+    BOOST_CHECK(children[4] == std::vector<size_t>({3}));
+    BOOST_CHECK(children[5].empty());
+
+    // removing an islock drops everything which spends from it, directly or through other islocks of the batch
+    std::vector<bool> skip(islocks.size(), false);
+    SkipInstantSendLockAndChildren(3, children, skip);
+    BOOST_CHECK(skip == std::vector<bool>({true, true, true, true, false, false}));
+    skip.assign(islocks.size(), false);
+    SkipInstantSendLockAndChildren(2, children, skip);
+    BOOST_CHECK(skip == std::vector<bool>({true, false, true, false, false, false}));
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_batch_order_cycle)
+{
+    // 0 and 1 spend from each other, 2 spends from 1 and 3 is unrelated
+    std::vector<std::vector<size_t>> parents{{1}, {0}, {1}, {}};
+    auto islocks = MakeInstantSendLockBatch(parents);
+
+    // the cycle can't be ordered, but its islocks and the ones depending on it are still part of the result
+    std::vector<std::vector<size_t>> children;
+    auto order = SortInstantSendLocksByDependencies(islocks, children);
+    BOOST_CHECK_EQUAL(order.size(), islocks.size());
+    BOOST_CHECK_EQUAL(order[0], 3);
+    std::sort(order.begin(), order.end());
+    BOOST_CHECK(order == std::vector<size_t>({0, 1, 2, 3}));
+
+    // skipping a member of the cycle terminates
+    std::vector<bool> skip(islocks.size(), false);
+    SkipInstantSendLockAndChildren(0, children, skip);
+    BOOST_CHECK(skip == std::vector<bool>({true, true, true, false}));
+}
+
+BOOST_AUTO_TEST_CASE(instantsend_batch_conflicts)
+{
+    auto islock1 = MakeInstantSendLock();
+    auto islock2 = MakeInstantSendLock();
+    CInstantSendLockBatch batch;
+    batch.Add(islock1.first, *islock1.second);
+
+    BOOST_CHECK(batch.HasInstantSendLock(islock1.first));
+    BOOST_CHECK(!batch.HasInstantSendLock(islock2.first));
+    BOOST_CHECK(batch.GetInstantSendLockHashByTxid(islock1.second->txid) == islock1.first);
+    BOOST_CHECK(batch.GetInstantSendLockHashByTxid(islock2.second->txid).IsNull());
+    for (auto& in : islock1.second->inputs) {
+        BOOST_CHECK(batch.GetInstantSendLockHashByInput(in) == islock1.first);
+    }
+    for (auto& in : islock2.second->inputs) {
+        BOOST_CHECK(batch.GetInstantSendLockHashByInput(in).IsNull());
+    }
+
+    // a second islock for the same TX, or one that spends an input locked by an earlier islock of the batch
+    auto islock3 = std::make_shared<CInstantSendLock>(*islock2.second);
+    islock3->txid = islock1.second->txid;
+    BOOST_CHECK(batch.GetInstantSendLockHashByTxid(islock3->txid) == islock1.first);
+    auto islock4 = std::make_shared<CInstantSendLock>(*islock2.second);
+    islock4->inputs.emplace_back(islock1.second->inputs[1]);
+    BOOST_CHECK(batch.GetInstantSendLockHashByInput(islock4->inputs[0]).IsNull());
+    BOOST_CHECK(batch.GetInstantSendLockHashByInput(islock4->inputs[2]) == islock1.first);
+
+    batch.Add(islock2.first, *islock2.second);
+    BOOST_CHECK(batch.GetInstantSendLockHashByInput(islock4->inputs[0]) == islock2.first);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compat/endian.h"
+#include "dbwrapper.h"
+#include "random.h"
+#include "utiltime.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include "llmq/quorums_signing.h"
+#include "llmq/quorums_utils.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_signing_tests, BasicTestingSetup)
+
+static CRecoveredSig MakeRecoveredSig()
+{
+    CRecoveredSig recSig;
+    recSig.llmqType = Consensus::LLMQ_50_60;
+    recSig.quorumHash = GetRandHash();
+    recSig.id = GetRandHash();
+    recSig.msgHash = GetRandHash();
+    recSig.UpdateHash();
+    return recSig;
+}
+
+static bool HasRecoveredSig(CRecoveredSigsDb& db, const CRecoveredSig& recSig)
+{
+    auto llmqType = (Consensus::LLMQType)recSig.llmqType;
+    CRecoveredSig recSig2;
+    bool ret = db.HasRecoveredSig(llmqType, recSig.id, recSig.msgHash);
+    BOOST_CHECK_EQUAL(ret, db.HasRecoveredSigForId(llmqType, recSig.id));
+    BOOST_CHECK_EQUAL(ret, db.HasRecoveredSigForSession(CLLMQUtils::BuildSignHash(recSig)));
+    BOOST_CHECK_EQUAL(ret, db.HasRecoveredSigForHash(recSig.GetHash()));
+    BOOST_CHECK_EQUAL(ret, db.GetRecoveredSigById(llmqType, recSig.id, recSig2) && recSig2.GetHash() == recSig.GetHash());
+    BOOST_CHECK_EQUAL(ret, db.GetRecoveredSigByHash(recSig.GetHash(), recSig2) && recSig2.GetHash() == recSig.GetHash());
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(recovered_sigs_segments)
+{
+    const int64_t day = 60 * 60 * 24;
+    const int64_t maxAge = 7 * day;
+    const int64_t startTime = 1500000000;
+
+    CDBWrapper llmqDb("", 1 << 20, true);
+    CRecoveredSigsDb db(llmqDb, true, maxAge);
+
+    SetMockTime(startTime);
+    auto recSig1 = MakeRecoveredSig();
+    auto recSig2 = MakeRecoveredSig();
+    uint256 voteId = GetRandHash();
+    uint256 voteMsgHash = GetRandHash();
+    uint256 msgHash;
+    BOOST_CHECK(!HasRecoveredSig(db, recSig1));
+    BOOST_CHECK(!db.HasVotedOnId(Consensus::LLMQ_50_60, voteId));
+    db.WriteRecoveredSig(recSig1);
+    db.WriteVoteForId(Consensus::LLMQ_50_60, voteId, voteMsgHash);
+    BOOST_CHECK(HasRecoveredSig(db, recSig1));
+    BOOST_CHECK(!db.HasRecoveredSig(Consensus::LLMQ_50_60, recSig1.id, recSig2.msgHash));
+    BOOST_CHECK(db.GetVoteForId(Consensus::LLMQ_50_60, voteId, msgHash) && msgHash == voteMsgHash);
+
+    // starts a new segment
+    SetMockTime(startTime + day + 1);
+    db.WriteRecoveredSig(recSig2);
+    BOOST_CHECK(HasRecoveredSig(db, recSig1));
+    BOOST_CHECK(HasRecoveredSig(db, recSig2));
+
+    // the first segment is kept as long as anything written to it might be younger than maxAge
+    SetMockTime(startTime + day + maxAge);
+    auto recSig3 = MakeRecoveredSig();
+    db.WriteRecoveredSig(recSig3);
+    db.CleanupOldSegments(maxAge);
+    BOOST_CHECK(HasRecoveredSig(db, recSig1));
+    BOOST_CHECK(db.HasVotedOnId(Consensus::LLMQ_50_60, voteId));
+
+    SetMockTime(startTime + day + maxAge + 2);
+    db.CleanupOldSegments(maxAge);
+    BOOST_CHECK(!HasRecoveredSig(db, recSig1));
+    BOOST_CHECK(!db.HasVotedOnId(Consensus::LLMQ_50_60, voteId));
+    BOOST_CHECK(HasRecoveredSig(db, recSig2));
+    BOOST_CHECK(HasRecoveredSig(db, recSig3));
+
+    // the newest segment is never dropped
+    SetMockTime(startTime + 100 * day);
+    db.CleanupOldSegments(maxAge);
+    BOOST_CHECK(!HasRecoveredSig(db, recSig2));
+    BOOST_CHECK(HasRecoveredSig(db, recSig3));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(recovered_sigs_segment_count)
+{
+    const int64_t hour = 60 * 60;
+    const int64_t maxAge = 7 * 24 * hour;
+    const int64_t startTime = 1500000000;
+
+    CDBWrapper llmqDb("", 1 << 20, true);
+    CRecoveredSigsDb db(llmqDb, true, maxAge);
+
+    // the number of segments only depends on maxAge, not on the number of recovered sigs
+    for (int64_t time = startTime; time < startTime + 5 * maxAge; time += hour) {
+        SetMockTime(time);
+        for (int i = 0; i < 10; i++) {
+            db.WriteRecoveredSig(MakeRecoveredSig());
+        }
+        db.CleanupOldSegments(maxAge);
+        BOOST_CHECK_LE(db.GetSegmentCount(), 10);
+    }
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(recovered_sigs_filter_growth)
+{
+    CDBWrapper llmqDb("", 1 << 20, true);
+    CRecoveredSigsDb db(llmqDb, true, 7 * 24 * 60 * 60);
+
+    // more keys than the filter of the first segment is sized for, none of them may be forgotten by the filters
+    std::vector<CRecoveredSig> recSigs;
+    for (size_t i = 0; i < CRecoveredSigsSegment::MIN_FILTER_KEYS; i++) {
+        recSigs.emplace_back(MakeRecoveredSig());
+        db.WriteRecoveredSig(recSigs.back());
+    }
+    BOOST_CHECK_EQUAL(db.GetSegmentCount(), 1);
+    for (auto& recSig : recSigs) {
+        BOOST_CHECK(db.HasRecoveredSig((Consensus::LLMQType)recSig.llmqType, recSig.id, recSig.msgHash));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recovered_sigs_migration)
+{
+    CDBWrapper llmqDb("", 1 << 20, true);
+
+    // the layout recovered sigs and votes were stored with in the llmq db
+    auto recSig = MakeRecoveredSig();
+    uint8_t llmqType = recSig.llmqType;
+    uint32_t time = htobe32((uint32_t)GetAdjustedTime());
+    uint256 voteId = GetRandHash();
+    uint256 voteMsgHash = GetRandHash();
+    llmqDb.Write(std::make_tuple(std::string("rs_r"), llmqType, recSig.id), recSig);
+    llmqDb.Write(std::make_tuple(std::string("rs_r"), llmqType, recSig.id, recSig.msgHash), (uint8_t)1);
+    llmqDb.Write(std::make_tuple(std::string("rs_h"), recSig.GetHash()), std::make_pair(llmqType, recSig.id));
+    llmqDb.Write(std::make_tuple(std::string("rs_s"), CLLMQUtils::BuildSignHash(recSig)), (uint8_t)1);
+    llmqDb.Write(std::make_tuple(std::string("rs_t"), time, llmqType, recSig.id), (uint8_t)1);
+    llmqDb.Write(std::make_tuple(std::string("rs_v"), llmqType, voteId), voteMsgHash);
+    llmqDb.Write(std::make_tuple(std::string("rs_vt"), time, llmqType, voteId), (uint8_t)1);
+
+    CRecoveredSigsDb db(llmqDb, true, 7 * 24 * 60 * 60);
+    uint256 msgHash;
+    BOOST_CHECK(HasRecoveredSig(db, recSig));
+    BOOST_CHECK(db.GetVoteForId(Consensus::LLMQ_50_60, voteId, msgHash) && msgHash == voteMsgHash);
+
+    std::unique_ptr<CDBIterator> pcursor(llmqDb.NewIterator());
+    pcursor->SeekToFirst();
+    BOOST_CHECK(!pcursor->Valid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,7 +7,9 @@
 #include "pow.h"
 #include "random.h"
 #include "util.h"
+#include "validation.h"
 #include "test/test_cbdhealthnetwork.h"
+#include "test/test_random.h"
 
 #include <boost/test/unit_test.hpp>
 
@@ -208,4 +210,125 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* DGW as it was before the result got cached and the averaging used DivideBy, without the min difficulty rules */
+static unsigned int DarkGravityWaveReference(const CBlockIndex* pindexLast, const Consensus::Params& params)
+{
+    const arith_uint256 bnPowLimit = UintToArith256(params.powLimit);
+    int64_t nPastBlocks = 24;
+
+    const CBlockIndex *pindex = pindexLast;
+    arith_uint256 bnPastTargetAvg;
+
+    for (unsigned int nCountBlocks = 1; nCountBlocks <= nPastBlocks; nCountBlocks++) {
+        arith_uint256 bnTarget = arith_uint256().SetCompact(pindex->nBits);
+        if (nCountBlocks == 1) {
+            bnPastTargetAvg = bnTarget;
+        } else {
+            bnPastTargetAvg = (bnPastTargetAvg * nCountBlocks + bnTarget) / (nCountBlocks + 1);
+        }
+
+        if(nCountBlocks != nPastBlocks) {
+            pindex = pindex->pprev;
+        }
+    }
+
+    arith_uint256 bnNew(bnPastTargetAvg);
+
+    int64_t nActualTimespan = pindexLast->GetBlockTime() - pindex->GetBlockTime();
+    int64_t nTargetTimespan = nPastBlocks * params.nPowTargetSpacing;
+
+    if (nActualTimespan < nTargetTimespan/3)
+        nActualTimespan = nTargetTimespan/3;
+    if (nActualTimespan > nTargetTimespan*3)
+        nActualTimespan = nTargetTimespan*3;
+
+    bnNew *= nActualTimespan;
+    bnNew /= nTargetTimespan;
+
+    if (bnNew > bnPowLimit) {
+        bnNew = bnPowLimit;
+    }
+
+    return bnNew.GetCompact();
+}
+
+/* The cached DGW result must match the uncached calculation and the old implementation bit for bit */
+BOOST_AUTO_TEST_CASE(get_next_work_cache)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = Params().GetConsensus();
+
+    // build a mainnet-like chain past the DGW activation with jittery block times, where every block
+    // uses the target DGW asks for. The second chain is identical but has no hashes, so it's never cached
+    const int nBlocks = 1000;
+    std::vector<uint256> hashes(nBlocks);
+    std::vector<CBlockIndex> blocks(nBlocks);
+    std::vector<CBlockIndex> blocksUncached(nBlocks);
+    for (int i = 0; i < nBlocks; i++) {
+        hashes[i] = GetRandHash();
+        CBlockIndex& block = blocks[i];
+        block.phashBlock = &hashes[i];
+        block.pprev = i ? &blocks[i - 1] : NULL;
+        block.nHeight = 100000 + i;
+        block.nTime = 1500000000 + i * params.nPowTargetSpacing + (int)(insecure_rand() % 600) - 300;
+        if (i < 30) {
+            block.nBits = 0x1b1418d4;
+        } else {
+            CBlockHeader header = block.GetBlockHeader();
+            block.nBits = GetNextWorkRequired(block.pprev, &header, params);
+            BOOST_CHECK_EQUAL(block.nBits, DarkGravityWaveReference(block.pprev, params));
+        }
+
+        blocksUncached[i] = block;
+        blocksUncached[i].phashBlock = NULL;
+        blocksUncached[i].pprev = i ? &blocksUncached[i - 1] : NULL;
+    }
+
+    for (int i = 30; i < nBlocks; i++) {
+        CBlockHeader header = blocks[i].GetBlockHeader();
+        unsigned int nBitsUncached = GetNextWorkRequired(&blocksUncached[i - 1], &header, params);
+        BOOST_CHECK_EQUAL(blocks[i].nBits, nBitsUncached);
+        BOOST_CHECK_EQUAL(DarkGravityWaveReference(&blocksUncached[i - 1], params), nBitsUncached);
+        // a sibling with a different time must get the cached result
+        header.nTime += 17;
+        BOOST_CHECK_EQUAL(GetNextWorkRequired(&blocks[i - 1], &header, params), nBitsUncached);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pre_verify_block_headers)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& params = Params().GetConsensus();
+
+    // grind a chain of headers that satisfy the regtest limit
+    std::vector<CBlockHeader> headers(50);
+    for (size_t i = 0; i < headers.size(); i++) {
+        CBlockHeader& header = headers[i];
+        header.nVersion = 4;
+        header.hashPrevBlock = i ? headers[i - 1].GetHash() : params.hashGenesisBlock;
+        header.nTime = 1500000000 + i;
+        header.nBits = UintToArith256(params.powLimit).GetCompact();
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, params)) {
+            header.nNonce++;
+        }
+    }
+
+    std::vector<uint256> hashes;
+    BOOST_CHECK(PreVerifyBlockHeaders(headers, hashes, params));
+    BOOST_CHECK_EQUAL(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+    }
+
+    // a single bad header fails the batch, but all hashes are still returned
+    headers[20].nBits = 0x03000001;
+    BOOST_CHECK(!PreVerifyBlockHeaders(headers, hashes, params));
+    BOOST_CHECK_EQUAL(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+    }
+
+    SelectParams(CBaseChainParams::MAIN);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -72,6 +72,44 @@ BOOST_AUTO_TEST_CASE(streams_vector_writer)
     vch.clear();
 }
 
+BOOST_AUTO_TEST_CASE(streams_span_reader)
+{
+    std::vector<unsigned char> vch = {1, 255, 3, 4, 5, 6};
+
+    CSpanReader reader(SER_NETWORK, INIT_PROTO_VERSION, vch.data(), vch.size());
+    BOOST_CHECK_EQUAL(reader.size(), 6);
+    BOOST_CHECK(!reader.empty());
+
+    // Read a single byte as an unsigned char.
+    unsigned char a;
+    reader >> a;
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(reader.size(), 5);
+
+    // Read a single byte as a signed char.
+    signed char b;
+    reader >> b;
+    BOOST_CHECK_EQUAL(b, -1);
+
+    // Read a 4 bytes as an unsigned int.
+    unsigned int c;
+    reader >> c;
+    BOOST_CHECK_EQUAL(c, 100992003); // 3,4,5,6 in little-endian base-256
+    BOOST_CHECK(reader.empty());
+
+    // Reading past the end throws and doesn't move the position
+    BOOST_CHECK_THROW(reader >> a, std::ios_base::failure);
+
+    // The bytes are only referenced, not copied
+    CSpanReader reader2(SER_NETWORK, INIT_PROTO_VERSION, vch.data(), 4);
+    vch[0] = 7;
+    reader2 >> a;
+    BOOST_CHECK_EQUAL(a, 7);
+    reader2.ignore(2);
+    BOOST_CHECK_EQUAL(reader2.size(), 1);
+    BOOST_CHECK_THROW(reader2.ignore(2), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
 {
     std::vector<char> in;
@@ -81,6 +81,7 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337)); // Deterministic randomness for tests.
         connman = g_connman.get();
         pblocktree = new CBlockTreeDB(1 << 20, true);
+        pinsightindex = new CInsightIndexDB(1 << 20, true);
         pcoinsdbview = new CCoinsViewDB(1 << 23, true);
         llmq::InitLLMQSystem(*evoDb, nullptr, true);
         pcoinsTip = new CCoinsViewCache(pcoinsdbview);
@@ -106,6 +107,7 @@ TestingSetup::~TestingSetup()
         delete pcoinsTip;
         llmq::DestroyLLMQSystem();
         delete pcoinsdbview;
+        delete pinsightindex;
         delete pblocktree;
         boost::filesystem::remove_all(pathTemp);
 }
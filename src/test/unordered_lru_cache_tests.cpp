@@ -0,0 +1,60 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "unordered_lru_cache.h"
+
+#include "test/test_cbdhealthnetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(unordered_lru_cache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(unordered_lru_cache_test)
+{
+    unordered_lru_cache<int, int, std::hash<int>, 10> cache;
+
+    for (int i = 0; i < 10; i++) {
+        cache.insert(i, i + 1);
+    }
+    BOOST_CHECK_EQUAL(cache.size(), 10);
+
+    // touching 0 makes 1 the least recently used entry
+    int v;
+    BOOST_CHECK(cache.get(0, v) && v == 1);
+    cache.insert(10, 11);
+    BOOST_CHECK_EQUAL(cache.size(), 10);
+    BOOST_CHECK(!cache.exists(1));
+    BOOST_CHECK(cache.exists(0));
+
+    // updating an entry doesn't grow the cache, but makes it the most recently used one
+    cache.insert(2, 5);
+    BOOST_CHECK(cache.get(2, v) && v == 5);
+    BOOST_CHECK_EQUAL(cache.size(), 10);
+    cache.insert(11, 12);
+    BOOST_CHECK(!cache.exists(3));
+    BOOST_CHECK(cache.exists(2));
+
+    cache.erase(2);
+    BOOST_CHECK(!cache.get(2, v));
+    BOOST_CHECK_EQUAL(cache.size(), 9);
+    // erasing a missing entry does nothing
+    cache.erase(2);
+    BOOST_CHECK_EQUAL(cache.size(), 9);
+
+    // the cache never holds more than maxSize entries
+    for (int i = 100; i < 200; i++) {
+        cache.emplace(i, i + 1);
+        BOOST_CHECK(cache.size() <= 10);
+    }
+    for (int i = 190; i < 200; i++) {
+        BOOST_CHECK(cache.get(i, v) && v == i + 1);
+    }
+    BOOST_CHECK(!cache.exists(189));
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK(!cache.exists(190));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
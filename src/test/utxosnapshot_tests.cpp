@@ -0,0 +1,147 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "random.h"
+#include "script/interpreter.h"
+#include "txdb.h"
+#include "utiltime.h"
+#include "utxosnapshot.h"
+#include "validation.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include "evo/deterministicmns.h"
+#include "evo/evodb.h"
+#include "llmq/quorums_init.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(utxosnapshot_tests, TestChain100Setup)
+
+static uint256 HashChainstate()
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(pcoinsdbview->Cursor());
+    CTxOutSetHasher hasher(pcursor->GetBestBlock());
+    for (; pcursor->Valid(); pcursor->Next()) {
+        COutPoint key;
+        Coin coin;
+        BOOST_REQUIRE(pcursor->GetKey(key) && pcursor->GetValue(coin));
+        hasher.Add(key, coin);
+    }
+    return hasher.GetHash();
+}
+
+BOOST_AUTO_TEST_CASE(utxosnapshot_dump_load)
+{
+    const CChainParams& chainparams = Params();
+    boost::filesystem::path path = pathTemp / "utxo.dat";
+
+    CUTXOSnapshotInfo info;
+    std::string strError;
+    BOOST_REQUIRE_MESSAGE(DumpUTXOSnapshot(path, info, strError), strError);
+    BOOST_CHECK(info.hashBaseBlock == chainActive.Tip()->GetBlockHash());
+    BOOST_CHECK_EQUAL(info.nBaseHeight, 100);
+    BOOST_CHECK(info.hashSerialized == HashChainstate());
+    BOOST_CHECK(info.nTransactions >= 100 && info.nTransactionOutputs >= info.nTransactions);
+    BOOST_CHECK(info.nEvoEntries > 0);
+
+    // An existing file is never overwritten
+    CUTXOSnapshotInfo info2;
+    BOOST_CHECK(!DumpUTXOSnapshot(path, info2, strError));
+
+    // The blocks are sent to the new node later, for the validation of the snapshot
+    std::vector<std::shared_ptr<const CBlock> > vBlocks;
+    for (int nHeight = 1; nHeight <= chainActive.Height(); nHeight++) {
+        auto pblock = std::make_shared<CBlock>();
+        BOOST_REQUIRE(ReadBlockFromDisk(*pblock, chainActive[nHeight], chainparams.GetConsensus()));
+        vBlocks.push_back(pblock);
+    }
+
+    // Start over as a new node which only has the genesis block
+    UnloadBlockIndex();
+    delete pcoinsTip;
+    llmq::DestroyLLMQSystem();
+    delete pcoinsdbview;
+    delete pblocktree;
+    delete deterministicMNManager;
+    delete evoDb;
+    evoDb = new CEvoDB(1 << 20, true, true);
+    deterministicMNManager = new CDeterministicMNManager(*evoDb);
+    pblocktree = new CBlockTreeDB(1 << 20, true, true);
+    pcoinsdbview = new CCoinsViewDB(1 << 23, true, true);
+    llmq::InitLLMQSystem(*evoDb, nullptr, true);
+    pcoinsTip = new CCoinsViewCache(pcoinsdbview);
+    BOOST_REQUIRE(InitBlockIndex(chainparams));
+    // The genesis block is only connected by the import thread, which runs after the snapshot was loaded in init
+    BOOST_REQUIRE_EQUAL(chainActive.Height(), -1);
+
+    // Nothing is loaded without the right hash
+    BOOST_CHECK(!LoadUTXOSnapshot(chainparams, path, GetRandHash(), info2, strError));
+    BOOST_CHECK_EQUAL(chainActive.Height(), -1);
+    BOOST_CHECK_EQUAL(mapBlockIndex.size(), 1);
+
+    bool fLoading = true;
+    BOOST_CHECK(!pblocktree->ReadFlag("txoutsetsnapshotloading", fLoading) || !fLoading);
+
+    BOOST_REQUIRE_MESSAGE(LoadUTXOSnapshot(chainparams, path, info.hashSnapshot, info2, strError), strError);
+    BOOST_CHECK(fLoadedFromSnapshot);
+    // Init only asks for -reindex-chainstate while the load is not complete
+    BOOST_CHECK(pblocktree->ReadFlag("txoutsetsnapshotloading", fLoading) && !fLoading);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == info.hashBaseBlock);
+    BOOST_CHECK(chainActive.Genesis()->GetBlockHash() == chainparams.GetConsensus().hashGenesisBlock);
+    BOOST_CHECK(chainActive.Genesis()->IsValid(BLOCK_VALID_SCRIPTS));
+    BOOST_CHECK(pcoinsTip->GetBestBlock() == info.hashBaseBlock);
+    BOOST_CHECK(info2.hashSerialized == info.hashSerialized);
+    BOOST_CHECK_EQUAL(info2.nTransactionOutputs, info.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(info2.nEvoEntries, info.nEvoEntries);
+    BOOST_CHECK(HashChainstate() == info.hashSerialized);
+    BOOST_CHECK(evoDb->VerifyBestBlock(info.hashBaseBlock));
+    // The blocks below the base are known but were never downloaded
+    const CBlockIndex* pindex = chainActive[50];
+    BOOST_CHECK(!(pindex->nStatus & BLOCK_HAVE_DATA) && pindex->nTx > 0 && pindex->IsValid(BLOCK_VALID_SCRIPTS));
+    BOOST_CHECK(pcoinsTip->HaveCoin(COutPoint(coinbaseTxns[0].GetHash(), 0)));
+
+    // The blocks below the base are stored when they were requested, and connected to a chainstate of their own in the
+    // background, which must end up at the snapshot
+    CSnapshotValidator validator(1 << 20);
+    BOOST_REQUIRE(validator.Init());
+    BOOST_CHECK(validator.GetBase() == chainActive.Tip());
+    BOOST_CHECK_EQUAL(validator.GetHeight(), 0);
+    for (const auto& pblock : vBlocks) {
+        BOOST_CHECK(ProcessNewBlock(chainparams, pblock, true, NULL));
+    }
+    BOOST_CHECK(chainActive[50]->nStatus & BLOCK_HAVE_DATA);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == info.hashBaseBlock);
+    validator.Start();
+    int64_t nDeadline = GetTimeMillis() + 60 * 1000;
+    while (!validator.IsComplete() && GetTimeMillis() < nDeadline) {
+        MilliSleep(10);
+    }
+    validator.Stop();
+    BOOST_CHECK(validator.IsComplete());
+    BOOST_CHECK_EQUAL(validator.GetHeight(), info.nBaseHeight);
+    bool fValidated = false;
+    BOOST_CHECK(pblocktree->ReadFlag("txoutsetsnapshotcoinsvalidated", fValidated) && fValidated);
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "snapshotcheck"));
+
+    // The chain continues from the snapshot, with a block which spends a coinbase of the snapshot
+    CScript coinbaseScript = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint(coinbaseTxns[0].GetHash(), 0));
+    spend.vout.emplace_back(coinbaseTxns[0].vout[0].nValue - 1000, coinbaseScript);
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbaseScript, spend, 0, SIGHASH_ALL);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CBlock block = CreateAndProcessBlock({spend}, coinbaseScript);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    BOOST_CHECK_EQUAL(chainActive.Height(), 101);
+    BOOST_CHECK(!pcoinsTip->HaveCoin(COutPoint(coinbaseTxns[0].GetHash(), 0)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "workstealingpool.h"
+#include "test/test_cbdhealthnetwork.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(workstealingpool_tests, BasicTestingSetup)
+
+// Recursively splits [0, count) the same way the BLS aggregator does and sums up the indexes
+static void SumRange(CWorkStealingPool& pool, std::atomic<uint64_t>& sum, std::atomic<int>& pending, uint64_t start, uint64_t count)
+{
+    while (count > 4) {
+        uint64_t half = count / 2;
+        pending++;
+        pool.Push([&pool, &sum, &pending, start, half, count](int threadId) {
+            SumRange(pool, sum, pending, start + half, count - half);
+        });
+        count = half;
+    }
+    for (uint64_t i = start; i < start + count; i++) {
+        sum += i;
+    }
+    pending--;
+}
+
+BOOST_AUTO_TEST_CASE(workstealingpool_recursive)
+{
+    CWorkStealingPool pool;
+    pool.Start(4, "test-pool");
+    BOOST_CHECK_EQUAL(pool.Size(), 4);
+
+    std::atomic<uint64_t> sum{0};
+    std::atomic<int> pending{1};
+    const uint64_t count = 100000;
+    pool.Push([&](int threadId) {
+        SumRange(pool, sum, pending, 0, count);
+    });
+    while (pending != 0) {
+        std::this_thread::yield();
+    }
+    BOOST_CHECK_EQUAL(sum, count * (count - 1) / 2);
+
+    // futures deliver results and the index of the executing thread
+    auto f = pool.Push([](int threadId, int a, int b) {
+        BOOST_CHECK(threadId >= 0 && threadId < 4);
+        return a + b;
+    }, 1, 2);
+    BOOST_CHECK_EQUAL(f.get(), 3);
+
+    pool.Stop(true);
+    BOOST_CHECK_EQUAL(pool.Size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(workstealingpool_push_before_start)
+{
+    CWorkStealingPool pool;
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 10; i++) {
+        futures.emplace_back(pool.Push([i](int threadId) { return i; }));
+    }
+    pool.Start(2, "test-pool");
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK_EQUAL(futures[i].get(), i);
+    }
+    pool.Stop(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,8 +11,11 @@
 #include "uint256.h"
 #include "ui_interface.h"
 #include "init.h"
+#include "util.h"
+#include "utiltime.h"
 
 #include <stdint.h>
+#include <functional>
 
 #include <boost/thread.hpp>
 
@@ -27,9 +30,11 @@ static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
+static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_TXOUTSET_SNAPSHOT = 'S';
 
 namespace {
 
@@ -55,50 +60,297 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) 
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe, const std::string& strDirName) : db(GetDataDir() / strDirName, nCacheSize, fMemory, fWipe, true)
 {
 }
 
+CCoinsViewDB::~CCoinsViewDB()
+{
+    StopBackgroundFlush();
+}
+
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
+    {
+        std::lock_guard<std::mutex> lock(csFlush);
+        if (flushingCoins) {
+            CCoinsMap::const_iterator it = flushingCoins->find(outpoint);
+            if (it != flushingCoins->end()) {
+                if (it->second.coin.IsSpent())
+                    return false;
+                coin = it->second.coin;
+                return true;
+            }
+        }
+    }
     return db.Read(CoinEntry(&outpoint), coin);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
+    {
+        std::lock_guard<std::mutex> lock(csFlush);
+        if (flushingCoins) {
+            CCoinsMap::const_iterator it = flushingCoins->find(outpoint);
+            if (it != flushingCoins->end())
+                return !it->second.coin.IsSpent();
+        }
+    }
     return db.Exists(CoinEntry(&outpoint));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
+    {
+        std::lock_guard<std::mutex> lock(csFlush);
+        if (flushingCoins)
+            return hashFlushingBlock;
+    }
+    return ReadBestBlock();
+}
+
+uint256 CCoinsViewDB::ReadBestBlock() const {
     uint256 hashBestChain;
     if (!db.Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
     return hashBestChain;
 }
 
+std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
+    std::vector<uint256> vhashHeadBlocks;
+    if (!db.Read(DB_HEAD_BLOCKS, vhashHeadBlocks)) {
+        return std::vector<uint256>();
+    }
+    return vhashHeadBlocks;
+}
+
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    int64_t nTimeStart = GetTimeMicros();
+    bool fBackground;
+    {
+        // Only one write is in flight at any time
+        std::unique_lock<std::mutex> lock(csFlush);
+        cvFlush.wait(lock, [this] { return !flushingCoins || fFlushFailed; });
+        if (fFlushFailed)
+            return false;
+        fBackground = fFlushThreadRunning;
+    }
+
+    CCoinsFlushStats stats;
+    stats.nTime = GetTime();
+    stats.hashBlock = ReadBestBlock();
+    if (!hashBlock.IsNull()) {
+        uint256 hashOld = stats.hashBlock;
+        if (hashOld.IsNull()) {
+            // We may be in the middle of replaying
+            std::vector<uint256> vhashHeadBlocks = GetHeadBlocks();
+            if (vhashHeadBlocks.size() == 2) {
+                assert(vhashHeadBlocks[0] == hashBlock);
+                hashOld = vhashHeadBlocks[1];
+            }
+        }
+        if (!WriteHeadBlocks(hashBlock, hashOld))
+            return false;
+        stats.hashBlock = hashBlock;
+    }
+
+    // Take over the coins, the caller gets back an empty map
+    std::unique_ptr<CCoinsMap> coins(new CCoinsMap());
+    coins->set_growth_limit(mapCoins.growth_limit());
+    coins->swap(mapCoins);
+
+    if (!fBackground) {
+        bool ret = WriteCoins(*coins, hashBlock, stats);
+        stats.nBlockingMicros = stats.nWriteMicros = GetTimeMicros() - nTimeStart;
+        if (ret) {
+            std::lock_guard<std::mutex> lock(csFlush);
+            lastFlushStats = stats;
+            nFlushCount++;
+        }
+        return ret;
+    }
+
+    size_t nUsage = memusage::DynamicUsage(*coins);
+    for (CCoinsMap::const_iterator it = coins->begin(); it != coins->end(); ++it) {
+        nUsage += it->second.coin.DynamicMemoryUsage();
+    }
+
+    stats.nBlockingMicros = stats.nWriteMicros = GetTimeMicros() - nTimeStart;
+    {
+        std::lock_guard<std::mutex> lock(csFlush);
+        flushingCoins = std::move(coins);
+        nFlushingUsage = nUsage;
+        hashFlushingBlock = stats.hashBlock;
+        flushingStats = stats;
+    }
+    cvFlush.notify_all();
+    return true;
+}
+
+bool CCoinsViewDB::WriteHeadBlocks(const uint256 &hashBlock, const uint256 &hashOld) {
+    // The best block is only valid again once all coins are written
+    CDBBatch batch(db);
+    batch.Erase(DB_BEST_BLOCK);
+    batch.Write(DB_HEAD_BLOCKS, std::vector<uint256>{hashBlock, hashOld});
+    return db.WriteBatch(batch, true);
+}
+
+bool CCoinsViewDB::WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock, CCoinsFlushStats &stats) {
     CDBBatch batch(db);
     size_t count = 0;
-    size_t changed = 0;
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    size_t batch_size = (size_t)GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); ++it) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
-            if (it->second.coin.IsSpent())
+            if (it->second.coin.IsSpent()) {
                 batch.Erase(entry);
-            else
+                stats.nCoinsErased++;
+            } else {
                 batch.Write(entry, it->second.coin);
-            changed++;
+                stats.nCoinsWritten++;
+            }
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
+        if (batch.SizeEstimate() > batch_size) {
+            LogPrint("coindb", "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+            stats.nBytes += batch.SizeEstimate();
+            stats.nBatches++;
+            if (!db.WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
     }
-    if (!hashBlock.IsNull())
+    if (!hashBlock.IsNull()) {
+        batch.Erase(DB_HEAD_BLOCKS);
         batch.Write(DB_BEST_BLOCK, hashBlock);
+    }
+    stats.nBytes += batch.SizeEstimate();
+    stats.nBatches++;
 
     bool ret = db.WriteBatch(batch);
-    LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
+    LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)(stats.nCoinsWritten + stats.nCoinsErased), (unsigned int)count);
     return ret;
 }
 
+void CCoinsViewDB::StartBackgroundFlush()
+{
+    std::lock_guard<std::mutex> lock(csFlush);
+    if (fFlushThreadRunning)
+        return;
+    fStopFlushThread = false;
+    fFlushThreadRunning = true;
+    flushThread = std::thread(&TraceThread<std::function<void()> >, "coinsflush", std::function<void()>(std::bind(&CCoinsViewDB::FlushThreadMain, this)));
+}
+
+void CCoinsViewDB::StopBackgroundFlush()
+{
+    {
+        std::lock_guard<std::mutex> lock(csFlush);
+        if (!fFlushThreadRunning)
+            return;
+        fStopFlushThread = true;
+    }
+    cvFlush.notify_all();
+    flushThread.join();
+
+    std::lock_guard<std::mutex> lock(csFlush);
+    fFlushThreadRunning = false;
+}
+
+bool CCoinsViewDB::BeginBulkLoad(const uint256 &hashBlock)
+{
+    if (!WaitForFlush())
+        return false;
+    return WriteHeadBlocks(hashBlock, ReadBestBlock());
+}
+
+bool CCoinsViewDB::BulkLoadCoins(const std::vector<std::pair<COutPoint, Coin> > &vCoins)
+{
+    CDBBatch batch(db);
+    for (const auto& p : vCoins) {
+        batch.Write(CoinEntry(&p.first), p.second);
+    }
+    LogPrint("coindb", "Writing %u snapshot coins, %.2f MiB\n", vCoins.size(), batch.SizeEstimate() * (1.0 / 1048576.0));
+    return db.WriteBatch(batch);
+}
+
+bool CCoinsViewDB::WaitForFlush() const
+{
+    std::unique_lock<std::mutex> lock(csFlush);
+    cvFlush.wait(lock, [this] { return !flushingCoins || fFlushFailed; });
+    return !fFlushFailed;
+}
+
+bool CCoinsViewDB::IsFlushing() const
+{
+    std::lock_guard<std::mutex> lock(csFlush);
+    return flushingCoins != nullptr;
+}
+
+bool CCoinsViewDB::HasFlushFailed() const
+{
+    std::lock_guard<std::mutex> lock(csFlush);
+    return fFlushFailed;
+}
+
+size_t CCoinsViewDB::DynamicMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(csFlush);
+    return flushingCoins ? nFlushingUsage : 0;
+}
+
+CCoinsFlushStats CCoinsViewDB::GetLastFlushStats(uint64_t* pnFlushCount) const
+{
+    std::lock_guard<std::mutex> lock(csFlush);
+    if (pnFlushCount)
+        *pnFlushCount = nFlushCount;
+    return lastFlushStats;
+}
+
+void CCoinsViewDB::FlushThreadMain()
+{
+    std::unique_lock<std::mutex> lock(csFlush);
+    while (true) {
+        cvFlush.wait(lock, [this] { return fStopFlushThread || (flushingCoins && !fFlushFailed); });
+        if (!flushingCoins || fFlushFailed) {
+            // Stop was requested and there is nothing left to write
+            break;
+        }
+
+        // The map is not modified while it is installed, lookups only read it
+        const CCoinsMap& coins = *flushingCoins;
+        uint256 hashBlock = hashFlushingBlock;
+        CCoinsFlushStats stats = flushingStats;
+        lock.unlock();
+
+        int64_t nTimeStart = GetTimeMicros();
+        bool fOk;
+        try {
+            fOk = WriteCoins(coins, hashBlock, stats);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+            fOk = false;
+        }
+        stats.nWriteMicros += GetTimeMicros() - nTimeStart;
+
+        std::unique_ptr<CCoinsMap> written;
+        lock.lock();
+        if (fOk) {
+            written = std::move(flushingCoins);
+            nFlushingUsage = 0;
+            lastFlushStats = stats;
+            nFlushCount++;
+        } else {
+            // Keep the coins around, lookups must still see them
+            LogPrintf("%s: Failed to write coins of block %s to the coin database\n", __func__, hashBlock.ToString());
+            fFlushFailed = true;
+        }
+        cvFlush.notify_all();
+
+        // Free the written coins without blocking lookups
+        lock.unlock();
+        written.reset();
+        lock.lock();
+    }
+}
+
 size_t CCoinsViewDB::EstimateSize() const
 {
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
@@ -129,6 +381,8 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
+    // The cursor iterates over the database only, it has to contain all coins
+    WaitForFlush();
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper*>(&db)->NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
@@ -204,11 +458,147 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
+bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
+    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
+}
+
+bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
+    char ch;
+    if (!Read(std::make_pair(DB_FLAG, name), ch))
+        return false;
+    fValue = ch == '1';
+    return true;
+}
+
+bool CBlockTreeDB::WriteTxOutSetSnapshot(const uint256 &hashBaseBlock, const uint256 &hashSerialized) {
+    return Write(DB_TXOUTSET_SNAPSHOT, std::make_pair(hashBaseBlock, hashSerialized));
+}
+
+bool CBlockTreeDB::ReadTxOutSetSnapshot(uint256 &hashBaseBlock, uint256 &hashSerialized) {
+    std::pair<uint256, uint256> p;
+    if (!Read(DB_TXOUTSET_SNAPSHOT, p))
+        return false;
+    hashBaseBlock = p.first;
+    hashSerialized = p.second;
+    return true;
+}
+
+bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+
+    // Load mapBlockIndex
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, uint256> key;
+        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
+            CDiskBlockIndex diskindex;
+            if (pcursor->GetValue(diskindex)) {
+                // Construct block index object
+                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
+                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
+                pindexNew->nHeight        = diskindex.nHeight;
+                pindexNew->nFile          = diskindex.nFile;
+                pindexNew->nDataPos       = diskindex.nDataPos;
+                pindexNew->nUndoPos       = diskindex.nUndoPos;
+                pindexNew->nVersion       = diskindex.nVersion;
+                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+                pindexNew->nTime          = diskindex.nTime;
+                pindexNew->nBits          = diskindex.nBits;
+                pindexNew->nNonce         = diskindex.nNonce;
+                pindexNew->nStatus        = diskindex.nStatus;
+                pindexNew->nTx            = diskindex.nTx;
+
+                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, Params().GetConsensus()))
+                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+
+                pcursor->Next();
+            } else {
+                return error("%s: failed to read value", __func__);
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+template <typename K, typename V>
+static bool MigrateIndexEntries(CDBWrapper& from, CDBWrapper& to, char prefix, size_t& nMigrated)
+{
+    std::unique_ptr<CDBIterator> pcursor(from.NewIterator());
+    pcursor->SetPrefix(prefix);
+    pcursor->Seek(prefix);
+
+    CDBBatch batchWrite(to);
+    CDBBatch batchErase(from);
+    while (true) {
+        boost::this_thread::interruption_point();
+        bool fValid = pcursor->Valid();
+        if (fValid) {
+            std::pair<char, K> key;
+            V value;
+            if (!pcursor->GetKey(key) || !pcursor->GetValue(value))
+                return error("%s: unable to read index entry", __func__);
+            batchWrite.Write(key, value);
+            batchErase.Erase(key);
+            nMigrated++;
+            pcursor->Next();
+        }
+        if (!fValid || batchWrite.SizeEstimate() > nDefaultDbBatchSize) {
+            // Entries are written to the new database before they are erased from the old one, an interrupted
+            // migration continues with whatever is left in the old one
+            if (!to.WriteBatch(batchWrite, true) || !from.WriteBatch(batchErase, true))
+                return false;
+            batchWrite.Clear();
+            batchErase.Clear();
+        }
+        if (!fValid)
+            break;
+    }
+    return true;
+}
+
+bool CBlockTreeDB::MigrateInsightIndexes(CInsightIndexDB& indexDB)
+{
+    size_t nMigrated = 0;
+    int64_t nStart = GetTimeMillis();
+    if (!MigrateIndexEntries<CAddressIndexKey, CAmount>(*this, indexDB, DB_ADDRESSINDEX, nMigrated) ||
+        !MigrateIndexEntries<CAddressUnspentKey, CAddressUnspentValue>(*this, indexDB, DB_ADDRESSUNSPENTINDEX, nMigrated) ||
+        !MigrateIndexEntries<CTimestampIndexKey, int>(*this, indexDB, DB_TIMESTAMPINDEX, nMigrated) ||
+        !MigrateIndexEntries<CSpentIndexKey, CSpentIndexValue>(*this, indexDB, DB_SPENTINDEX, nMigrated)) {
+        return error("%s: failed to move index entries", __func__);
+    }
+    if (nMigrated != 0) {
+        // Give the space of the erased entries back. The range covers all four key prefixes, its end is past every key
+        // starting with DB_ADDRESSUNSPENTINDEX
+        CompactRange(DB_ADDRESSINDEX, (char)(DB_ADDRESSUNSPENTINDEX + 1));
+        LogPrintf("%s: moved %u index entries to their own database in %dms\n", __func__, nMigrated, GetTimeMillis() - nStart);
+    }
+    return true;
+}
+
+CInsightIndexDB::CInsightIndexDB(size_t nCacheSize, bool fMemory, bool fWipe, const CDBWrapperOptions& dbOptions) : CDBWrapper(GetDataDir() / "indexes", nCacheSize, fMemory, fWipe, false, dbOptions) {
+}
+
+CDBWrapperOptions CInsightIndexDB::DefaultOptions() {
+    CDBWrapperOptions dbOptions;
+    // Mostly read by prefix scans over the history of an address, which profit from bigger blocks and from keeping
+    // what they read in the cache. Writes happen once per block only, so most of the cache goes to the block cache.
+    dbOptions.nBlockCachePercent = 75;
+    dbOptions.nBlockSize = 16 * 1024;
+    dbOptions.fIteratorFillCache = true;
+    return dbOptions;
+}
+
+bool CInsightIndexDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
     return Read(std::make_pair(DB_SPENTINDEX, key), value);
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
+bool CInsightIndexDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
@@ -220,7 +610,7 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
+bool CInsightIndexDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
@@ -232,17 +622,18 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+bool CInsightIndexDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
+                                              std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
+    pcursor->SetPrefix(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
     pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key)) {
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
                 unspentOutputs.push_back(std::make_pair(key.second, nValue));
@@ -258,26 +649,27 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+bool CInsightIndexDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+bool CInsightIndexDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
-                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
+bool CInsightIndexDB::ReadAddressIndex(uint160 addressHash, int type,
+                                       std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                       int start, int end) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
+    pcursor->SetPrefix(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
     if (start > 0 && end > 0) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
@@ -287,7 +679,7 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key)) {
             if (end > 0 && key.second.blockHeight > end) {
                 break;
             }
@@ -306,22 +698,23 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
+bool CInsightIndexDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
+bool CInsightIndexDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
+    pcursor->SetPrefix(DB_TIMESTAMPINDEX);
     pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, CTimestampIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
+        if (pcursor->GetKey(key) && key.second.timestamp <= high) {
             hashes.push_back(key.second.blockHash);
             pcursor->Next();
         } else {
@@ -332,58 +725,119 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
     return true;
 }
 
-bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
-    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
+std::unique_ptr<CAddressIndexCursor> CInsightIndexDB::NewAddressIndexCursor(const std::vector<std::pair<uint160, int> >& addresses,
+                                                                            int start, int end, const std::string& token) const {
+    // Keys continue with the big endian height, so the scans can start at the first entry of the start height
+    std::string seekSuffix;
+    if (start > 0) {
+        CDataStream ssHeight(SER_DISK, CLIENT_VERSION);
+        ser_writedata32be(ssHeight, start);
+        seekSuffix.assign(ssHeight.begin(), ssHeight.end());
+    }
+    CAddressIndexCursor::Filter filter;
+    if (end > 0) {
+        filter = [end](const CAddressIndexKey& key, const CAmount&) {
+            return key.blockHeight > end ? CAddressIndexCursor::FILTER_END : CAddressIndexCursor::FILTER_ACCEPT;
+        };
+    }
+    return std::unique_ptr<CAddressIndexCursor>(new CAddressIndexCursor(*this, DB_ADDRESSINDEX, addresses, seekSuffix, token, filter));
+}
+
+std::unique_ptr<CAddressUnspentCursor> CInsightIndexDB::NewAddressUnspentCursor(const std::vector<std::pair<uint160, int> >& addresses,
+                                                                                int start, int end, const std::string& token) const {
+    // Unspent outputs are keyed by txid, the height is only known from the value
+    CAddressUnspentCursor::Filter filter;
+    if (start > 0 || end > 0) {
+        filter = [start, end](const CAddressUnspentKey&, const CAddressUnspentValue& value) {
+            bool fInRange = value.blockHeight >= start && (end <= 0 || value.blockHeight <= end);
+            return fInRange ? CAddressUnspentCursor::FILTER_ACCEPT : CAddressUnspentCursor::FILTER_SKIP;
+        };
+    }
+    return std::unique_ptr<CAddressUnspentCursor>(new CAddressUnspentCursor(*this, DB_ADDRESSUNSPENTINDEX, addresses, std::string(), token, filter));
 }
 
-bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
-    char ch;
-    if (!Read(std::make_pair(DB_FLAG, name), ch))
-        return false;
-    fValue = ch == '1';
-    return true;
+bool CInsightIndexDB::Sync() {
+    CDBBatch batch(*this);
+    return WriteBatch(batch, true);
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
-{
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+bool CInsightIndexDB::ReadBestBlock(const std::string& strIndex, CBlockLocator& locator) {
+    return Read(std::make_pair(DB_BEST_BLOCK, strIndex), locator);
+}
 
-    // Load mapBlockIndex
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
+bool CInsightIndexDB::WriteBlockUpdate(const CInsightIndexBlockUpdate& update) {
+    CDBBatch batch(*this);
+    for (const auto& entry : update.addressIndex) {
+        if (update.fErase) {
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, entry.first), entry.second);
+        }
+    }
+    for (const auto& key : update.timestampIndex) {
+        if (update.fErase) {
+            batch.Erase(std::make_pair(DB_TIMESTAMPINDEX, key));
+        } else {
+            batch.Write(std::make_pair(DB_TIMESTAMPINDEX, key), 0);
+        }
+    }
+    // In block order when connecting, in reverse order when disconnecting, so outputs which are created and spent in
+    // the same block end up erased either way
+    for (const auto& entry : update.addressUnspentIndex) {
+        if (entry.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first), entry.second);
+        }
+    }
+    for (const auto& entry : update.spentIndex) {
+        if (entry.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_SPENTINDEX, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_SPENTINDEX, entry.first), entry.second);
+        }
+    }
+    for (const auto& bestBlock : update.bestBlocks) {
+        batch.Write(std::make_pair(DB_BEST_BLOCK, bestBlock.first), bestBlock.second);
+    }
+    return WriteBatch(batch);
+}
 
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, Params().GetConsensus()))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+bool CInsightIndexDB::WipeIndex(const std::string& strIndex) {
+    std::vector<char> vPrefixes;
+    if (strIndex == "addressindex") {
+        vPrefixes = {DB_ADDRESSINDEX, DB_ADDRESSUNSPENTINDEX};
+    } else if (strIndex == "spentindex") {
+        vPrefixes = {DB_SPENTINDEX};
+    } else if (strIndex == "timestampindex") {
+        vPrefixes = {DB_TIMESTAMPINDEX};
+    } else {
+        return error("%s: unknown index %s", __func__, strIndex);
+    }
 
-                pcursor->Next();
-            } else {
-                return error("%s: failed to read value", __func__);
+    size_t nErased = 0;
+    CDBBatch batch(*this);
+    for (char chPrefix : vPrefixes) {
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->SetPrefix(chPrefix);
+        for (pcursor->Seek(chPrefix); pcursor->Valid(); pcursor->Next()) {
+            boost::this_thread::interruption_point();
+            CDataStream ssKey = pcursor->GetKey();
+            batch.Erase(ssKey);
+            nErased++;
+            if (batch.SizeEstimate() > nDefaultDbBatchSize) {
+                if (!WriteBatch(batch)) {
+                    return false;
+                }
+                batch.Clear();
             }
-        } else {
-            break;
         }
     }
-
+    batch.Erase(std::make_pair(DB_BEST_BLOCK, strIndex));
+    if (!WriteBatch(batch, true)) {
+        return false;
+    }
+    LogPrintf("%s: erased %u entries of %s\n", __func__, nErased, strIndex);
     return true;
 }
 
@@ -11,14 +11,21 @@
 #include "chain.h"
 #include "spentindex.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <boost/function.hpp>
 
 class CBlockIndex;
+class CInsightIndexDB;
 class CCoinsViewDBCursor;
 class uint256;
 
@@ -38,8 +45,16 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
+//! Max memory allocated to the address, spent and timestamp index DB cache (MiB)
+static const int64_t nMaxInsightIndexDBCache = 1024;
+//! Memory allocated to the address, spent and timestamp index DB cache if none of these indexes is enabled (MiB)
+static const int64_t nMinInsightIndexDBCache = 1;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -dbbatchsize default (bytes)
+static const int64_t nDefaultDbBatchSize = 16 << 20;
+//! -backgroundflush default
+static const bool DEFAULT_BACKGROUND_FLUSH = true;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -66,24 +81,96 @@ struct CDiskTxPos : public CDiskBlockPos
     }
 };
 
-/** CCoinsView backed by the coin database (chainstate/) */
+/** Statistics about a write of the coins cache to the coin database */
+struct CCoinsFlushStats
+{
+    uint256 hashBlock;
+    int64_t nTime{0};           //!< Time the flush was started
+    int64_t nBlockingMicros{0}; //!< Time the caller of BatchWrite was blocked
+    int64_t nWriteMicros{0};    //!< Time it took to write all coins, including the blocking part
+    size_t nCoinsWritten{0};
+    size_t nCoinsErased{0};
+    size_t nBytes{0};           //!< Estimated size of all written batches
+    size_t nBatches{0};
+};
+
+/**
+ * CCoinsView backed by the coin database (chainstate/)
+ *
+ * Changes are written in batches of at most -dbbatchsize bytes. Before the first batch, DB_BEST_BLOCK is replaced by
+ * DB_HEAD_BLOCKS, which records the old and the new best block, and only the last batch writes DB_BEST_BLOCK again. If
+ * the process dies in between, GetHeadBlocks() returns both hashes and ReplayBlocks() brings the database to the new
+ * best block on the next start.
+ *
+ * After StartBackgroundFlush(), BatchWrite() only writes the DB_HEAD_BLOCKS marker itself and hands the coins over to
+ * a writer thread. Until they are written, lookups are answered from the handed over coins first, so that validation
+ * can continue against a consistent state while the database catches up. Only one write is in flight at any time, a
+ * BatchWrite() that comes in while the previous one is still being written waits for it.
+ *
+ * The handed over coins still take up memory until they are written, DynamicMemoryUsage() reports it. Callers count it
+ * against -dbcache together with the cache on top, so the cache has to stay smaller while a write is in flight and the
+ * total never exceeds the limit by more than the usual overshoot of a single cache.
+ */
 class CCoinsViewDB : public CCoinsView
 {
 protected:
     CDBWrapper db;
-public:
-    CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
+    mutable std::mutex csFlush;
+    mutable std::condition_variable cvFlush;
+    std::thread flushThread;
+    bool fFlushThreadRunning{false};
+    bool fStopFlushThread{false};
+    //! Coins handed over to the writer thread, which are not completely written yet
+    std::unique_ptr<CCoinsMap> flushingCoins;
+    size_t nFlushingUsage{0};
+    uint256 hashFlushingBlock;
+    bool fFlushFailed{false};
+    CCoinsFlushStats flushingStats;
+    CCoinsFlushStats lastFlushStats;
+    uint64_t nFlushCount{0};
+
+public:
+    CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, const std::string& strDirName = "chainstate");
+    ~CCoinsViewDB();
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
+    std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
+
+    //! Write coins on a background thread from now on
+    void StartBackgroundFlush();
+    //! Finish the write in flight and go back to synchronous writes
+    void StopBackgroundFlush();
+    //! Wait until no write is in flight. Returns false if a background write failed.
+    bool WaitForFlush() const;
+    bool IsFlushing() const;
+    bool HasFlushFailed() const;
+    //! Memory used by the coins of the write in flight
+    size_t DynamicMemoryUsage() const;
+    //! Statistics of the last completed write and the number of completed writes
+    CCoinsFlushStats GetLastFlushStats(uint64_t* pnFlushCount = nullptr) const;
+
+    /**
+     * Marks the database as being written up to hashBlock, like a BatchWrite() which was interrupted. The coins of a
+     * snapshot are then written with BulkLoadCoins(), the next BatchWrite() to hashBlock completes the write.
+     */
+    bool BeginBulkLoad(const uint256 &hashBlock);
+    //! Writes coins directly to the database, the cache on top of it must not have them
+    bool BulkLoadCoins(const std::vector<std::pair<COutPoint, Coin> > &vCoins);
+
+protected:
+    uint256 ReadBestBlock() const;
+    bool WriteHeadBlocks(const uint256 &hashBlock, const uint256 &hashOld);
+    bool WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock, CCoinsFlushStats &stats);
+    void FlushThreadMain();
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
@@ -124,6 +211,208 @@ public:
     bool ReadReindexing(bool &fReindex);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
+    bool WriteFlag(const std::string &name, bool fValue);
+    bool ReadFlag(const std::string &name, bool &fValue);
+    //! The base block and the hash_serialized_2 value of the UTXO set snapshot the chainstate was loaded from
+    bool WriteTxOutSetSnapshot(const uint256 &hashBaseBlock, const uint256 &hashSerialized);
+    bool ReadTxOutSetSnapshot(uint256 &hashBaseBlock, uint256 &hashSerialized);
+    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /**
+     * Moves the address, spent and timestamp index entries which were written by older versions into the block
+     * database to indexDB. Does nothing if there are no such entries.
+     */
+    bool MigrateInsightIndexes(CInsightIndexDB& indexDB);
+};
+
+/**
+ * Merges the address index or address unspent index entries of several addresses into one sequence, ordered like the
+ * index keys without the address: by height, block index and txid for the address index, by txid and output index for
+ * the unspent index. Every address is scanned by its own iterator and the current entries of all iterators are kept
+ * in a heap, so only one entry per address is held in memory at a time, no matter how long the histories are.
+ *
+ * GetToken() describes the position of the current entry. A cursor over the same addresses which is created with
+ * this token continues at that entry.
+ */
+template <typename K, typename V>
+class CAddressIndexMergeCursor
+{
+public:
+    enum FilterResult {
+        FILTER_ACCEPT,
+        FILTER_SKIP,
+        //! The entry and all following entries of the same address are skipped
+        FILTER_END
+    };
+    typedef std::function<FilterResult(const K&, const V&)> Filter;
+
+private:
+    struct AddressScan
+    {
+        std::unique_ptr<CDBIterator> pcursor;
+        size_t nPrefixSize;
+        //! Key of the current entry without the address prefix, this is what the scans are merged by
+        std::string suffix;
+        K key;
+        V value;
+    };
+
+    std::vector<AddressScan> scans;
+    //! Indexes of the scans which have a current entry, ordered as a heap with the smallest entry in front
+    std::vector<size_t> heap;
+    Filter filter;
+    bool fError;
+
+    bool HeapCompare(size_t a, size_t b) const
+    {
+        // std heaps put the largest element in front
+        int cmp = scans[a].suffix.compare(scans[b].suffix);
+        return cmp > 0 || (cmp == 0 && a > b);
+    }
+
+    void PushHeap(size_t n)
+    {
+        heap.push_back(n);
+        std::push_heap(heap.begin(), heap.end(), [this](size_t a, size_t b) { return HeapCompare(a, b); });
+    }
+
+    //! Moves the scan n to its next accepted entry, skipping entries before the resume position
+    void Advance(size_t n, const std::string& resumeSuffix, size_t nResumeAddress)
+    {
+        AddressScan& scan = scans[n];
+        for (; scan.pcursor->Valid(); scan.pcursor->Next()) {
+            CDataStream ssKey = scan.pcursor->GetKey();
+            std::pair<char, K> key;
+            if (ssKey.size() < scan.nPrefixSize || !scan.pcursor->GetKey(key) || !scan.pcursor->GetValue(scan.value)) {
+                fError = true;
+                return;
+            }
+            scan.suffix.assign(ssKey.begin() + scan.nPrefixSize, ssKey.end());
+            if (n < nResumeAddress && scan.suffix == resumeSuffix) {
+                continue;
+            }
+            scan.key = key.second;
+            FilterResult result = filter ? filter(scan.key, scan.value) : FILTER_ACCEPT;
+            if (result == FILTER_END) {
+                return;
+            }
+            if (result == FILTER_ACCEPT) {
+                PushHeap(n);
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * @param[in] db          Database which contains the index
+     * @param[in] chPrefix    Key prefix of the index
+     * @param[in] addresses   (hash, type) of the addresses to scan
+     * @param[in] seekSuffix  Serialized key (without the address prefix) to start every scan at, may be empty
+     * @param[in] token       Position to resume at as returned by GetToken(), may be empty
+     * @param[in] filterIn    Decides about every entry, all entries are accepted if it's empty
+     */
+    CAddressIndexMergeCursor(const CDBWrapper& db, char chPrefix, const std::vector<std::pair<uint160, int> >& addresses,
+                             const std::string& seekSuffix, const std::string& token, const Filter& filterIn) :
+        filter(filterIn), fError(false)
+    {
+        std::string resumeSuffix;
+        uint32_t nResumeAddress = 0;
+        if (!token.empty() && !ParseToken(token, resumeSuffix, nResumeAddress)) {
+            fError = true;
+            return;
+        }
+        const std::string& startSuffix = std::max(seekSuffix, resumeSuffix);
+
+        scans.resize(addresses.size());
+        heap.reserve(addresses.size());
+        for (size_t n = 0; n < addresses.size(); n++) {
+            AddressScan& scan = scans[n];
+            auto prefix = std::make_pair(chPrefix, CAddressIndexIteratorKey(addresses[n].second, addresses[n].first));
+            CDataStream ssSeek(SER_DISK, CLIENT_VERSION);
+            ssSeek << prefix;
+            scan.nPrefixSize = ssSeek.size();
+            ssSeek.write(startSuffix.data(), startSuffix.size());
+
+            scan.pcursor.reset(const_cast<CDBWrapper&>(db).NewIterator());
+            scan.pcursor->SetPrefix(prefix);
+            scan.pcursor->Seek(ssSeek);
+            Advance(n, resumeSuffix, nResumeAddress);
+        }
+    }
+
+    static bool ParseToken(const std::string& token, std::string& suffix, uint32_t& nAddress)
+    {
+        if (!IsHex(token)) {
+            return false;
+        }
+        std::vector<unsigned char> data = ParseHex(token);
+        CDataStream ss(data, SER_DISK, CLIENT_VERSION);
+        try {
+            ss >> LIMITED_STRING(suffix, 256) >> nAddress;
+        } catch (const std::exception&) {
+            return false;
+        }
+        return ss.empty();
+    }
+
+    bool Valid() const { return !fError && !heap.empty(); }
+    //! Whether the token was invalid or an entry could not be read
+    bool HasError() const { return fError; }
+
+    const K& GetKey() const { return scans[heap.front()].key; }
+    const V& GetValue() const { return scans[heap.front()].value; }
+
+    std::string GetToken() const
+    {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << scans[heap.front()].suffix << (uint32_t)heap.front();
+        return HexStr(ss.begin(), ss.end());
+    }
+
+    void Next()
+    {
+        std::pop_heap(heap.begin(), heap.end(), [this](size_t a, size_t b) { return HeapCompare(a, b); });
+        size_t n = heap.back();
+        heap.pop_back();
+        scans[n].pcursor->Next();
+        Advance(n, std::string(), 0);
+    }
+};
+
+typedef CAddressIndexMergeCursor<CAddressIndexKey, CAmount> CAddressIndexCursor;
+typedef CAddressIndexMergeCursor<CAddressUnspentKey, CAddressUnspentValue> CAddressUnspentCursor;
+
+/**
+ * Access to the address, spent and timestamp index database (indexes/).
+ *
+ * These indexes are only read by the explorer RPCs, which do many prefix scans over the histories of addresses. They
+ * live in their own database, so that they get a block cache of their own and can be tuned for range scans without
+ * affecting the block index.
+ */
+/** Index entries of one block, as the insight indexer writes them when it connects or disconnects the block */
+struct CInsightIndexBlockUpdate
+{
+    //! Written, or erased if fErase is set
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<CTimestampIndexKey> timestampIndex;
+    bool fErase{false};
+    //! Entries with a null value are erased
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    //! New best blocks of the updated indexes, by index name
+    std::vector<std::pair<std::string, CBlockLocator> > bestBlocks;
+};
+
+class CInsightIndexDB : public CDBWrapper
+{
+public:
+    CInsightIndexDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, const CDBWrapperOptions& dbOptions = DefaultOptions());
+private:
+    CInsightIndexDB(const CInsightIndexDB&);
+    void operator=(const CInsightIndexDB&);
+public:
+    static CDBWrapperOptions DefaultOptions();
+
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
     bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
@@ -136,9 +425,24 @@ public:
                           int start = 0, int end = 0);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
-    bool WriteFlag(const std::string &name, bool fValue);
-    bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /**
+     * Scans the address index entries of addresses between the heights start and end (0 for no limit), resuming at
+     * token if it's not empty.
+     */
+    std::unique_ptr<CAddressIndexCursor> NewAddressIndexCursor(const std::vector<std::pair<uint160, int> >& addresses,
+                                                               int start, int end, const std::string& token) const;
+    /** Scans the unspent outputs of addresses created between the heights start and end (0 for no limit) */
+    std::unique_ptr<CAddressUnspentCursor> NewAddressUnspentCursor(const std::vector<std::pair<uint160, int> >& addresses,
+                                                                   int start, int end, const std::string& token) const;
+    //! Makes sure that everything written so far survives a crash
+    bool Sync();
+
+    //! Best block of the index strIndex ("addressindex", "spentindex" or "timestampindex")
+    bool ReadBestBlock(const std::string& strIndex, CBlockLocator& locator);
+    //! Writes the entries of a block together with the new best blocks in one batch
+    bool WriteBlockUpdate(const CInsightIndexBlockUpdate& update);
+    //! Erases all entries and the best block of the index strIndex
+    bool WipeIndex(const std::string& strIndex);
 };
 
 #endif // BITCOIN_TXDB_H
@@ -5,45 +5,54 @@
 #ifndef CHN_UNORDERED_LRU_CACHE_H
 #define CHN_UNORDERED_LRU_CACHE_H
 
+#include <assert.h>
+#include <cstddef>
+#include <list>
 #include <unordered_map>
 
-template<typename Key, typename Value, typename Hasher, size_t MaxSize = 0, size_t TruncateThreshold = 0>
+// Keeps at most maxSize entries. All operations are constant time: entries are kept in a list ordered by last access,
+// which is updated on every access by moving the entry to the front, and the least recently used entry is evicted from
+// the back when the cache is full
+template<typename Key, typename Value, typename Hasher, size_t MaxSize = 0>
 class unordered_lru_cache
 {
 private:
-    typedef std::unordered_map<Key, std::pair<Value, int64_t>, Hasher> MapType;
+    typedef std::list<std::pair<Key, Value>> ListType;
+    typedef std::unordered_map<Key, typename ListType::iterator, Hasher> MapType;
 
+    ListType items;
     MapType cacheMap;
     size_t maxSize;
-    size_t truncateThreshold;
-    int64_t accessCounter{0};
 
 public:
-    unordered_lru_cache(size_t _maxSize = MaxSize, size_t _truncateThreshold = TruncateThreshold) :
-        maxSize(_maxSize),
-        truncateThreshold(_truncateThreshold == 0 ? _maxSize * 2 : _truncateThreshold)
+    explicit unordered_lru_cache(size_t _maxSize = MaxSize) :
+        maxSize(_maxSize)
     {
         // either specify maxSize through template arguments or the contructor and fail otherwise
         assert(_maxSize != 0);
     }
 
-
     template<typename Value2>
     void _emplace(const Key& key, Value2&& v)
     {
-        truncate_if_needed();
         auto it = cacheMap.find(key);
-        if (it == cacheMap.end()) {
-            cacheMap.emplace(key, std::make_pair(std::forward<Value2>(v), accessCounter++));
-        } else {
-            it->second.first = std::forward<Value2>(v);
-            it->second.second = accessCounter++;
+        if (it != cacheMap.end()) {
+            it->second->second = std::forward<Value2>(v);
+            items.splice(items.begin(), items, it->second);
+            return;
+        }
+
+        items.emplace_front(key, std::forward<Value2>(v));
+        cacheMap.emplace(key, items.begin());
+        if (items.size() > maxSize) {
+            cacheMap.erase(items.back().first);
+            items.pop_back();
         }
     }
 
     void emplace(const Key& key, Value&& v)
     {
-        _emplace(key, v);
+        _emplace(key, std::move(v));
     }
 
     void insert(const Key& key, const Value& v)
@@ -55,8 +64,8 @@ public:
     {
         auto it = cacheMap.find(key);
         if (it != cacheMap.end()) {
-            it->second.second = accessCounter++;
-            value = it->second.first;
+            items.splice(items.begin(), items, it->second);
+            value = it->second->second;
             return true;
         }
         return false;
@@ -66,7 +75,7 @@ public:
     {
         auto it = cacheMap.find(key);
         if (it != cacheMap.end()) {
-            it->second.second = accessCounter++;
+            items.splice(items.begin(), items, it->second);
             return true;
         }
         return false;
@@ -74,36 +83,22 @@ public:
 
     void erase(const Key& key)
     {
-        cacheMap.erase(key);
+        auto it = cacheMap.find(key);
+        if (it != cacheMap.end()) {
+            items.erase(it->second);
+            cacheMap.erase(it);
+        }
     }
 
     void clear()
     {
         cacheMap.clear();
+        items.clear();
     }
 
-private:
-    void truncate_if_needed()
+    size_t size() const
     {
-        typedef typename MapType::iterator Iterator;
-
-        if (cacheMap.size() <= truncateThreshold) {
-            return;
-        }
-
-        std::vector<Iterator> vec;
-        vec.reserve(cacheMap.size());
-        for (auto it = cacheMap.begin(); it != cacheMap.end(); ++it) {
-            vec.emplace_back(it);
-        }
-        // sort by last access time (descending order)
-        std::sort(vec.begin(), vec.end(), [](const Iterator& it1, const Iterator& it2) {
-            return it1->second.second > it2->second.second;
-        });
-
-        for (size_t i = maxSize; i < vec.size(); i++) {
-            cacheMap.erase(vec[i]);
-        }
+        return items.size();
     }
 };
 
@@ -0,0 +1,696 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "utxosnapshot.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "consensus/validation.h"
+#include "dbwrapper.h"
+#include "governance-classes.h"
+#include "init.h"
+#include "serialize.h"
+#include "streams.h"
+#include "txdb.h"
+#include "ui_interface.h"
+#include "util.h"
+#include "validation.h"
+#include "warnings.h"
+
+#include "evo/evodb.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * Snapshot file format, all of it in SER_DISK serialization:
+ *
+ * - magic, version, network magic, base block hash, base block height
+ * - for every block from height 1 to the base: header, VARINT(transaction count)
+ * - for every transaction with unspent outputs, in chainstate database order: VARINT(output count), txid,
+ *   (VARINT(n), Coin) per output. VARINT(0) ends the list.
+ * - every EvoDB entry as (key, value) byte vectors. An empty key ends the list.
+ * - transaction count, output count, total amount, EvoDB entry count, hash_serialized_2
+ * - double SHA256 of everything before it
+ */
+
+static const unsigned char UTXO_SNAPSHOT_MAGIC[5] = {'u', 't', 'x', 'o', 0xff};
+
+/** Number of coins written to the chainstate database in one batch while loading */
+static const size_t UTXO_SNAPSHOT_LOAD_BATCH = 100000;
+
+/** LevelDB cache of the chainstate the blocks below the snapshot base are connected to */
+static const size_t SNAPSHOT_VALIDATION_DB_CACHE = 8 << 20;
+
+CSnapshotValidator* psnapshotvalidator = nullptr;
+
+namespace {
+
+/** Writes data to an underlying stream, while hashing the written data. */
+template<typename Target>
+class CHashingWriter : public CHashWriter
+{
+private:
+    Target* target;
+
+public:
+    CHashingWriter(Target* target_) : CHashWriter(target_->GetType(), target_->GetVersion()), target(target_) {}
+
+    void write(const char* pch, size_t nSize)
+    {
+        target->write(pch, nSize);
+        CHashWriter::write(pch, nSize);
+    }
+
+    template<typename T>
+    CHashingWriter<Target>& operator<<(const T& obj)
+    {
+        // Serialize to this stream
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
+} // namespace
+
+CTxOutSetHasher::CTxOutSetHasher(const uint256& hashBlock) : ss(SER_GETHASH, PROTOCOL_VERSION)
+{
+    ss << hashBlock;
+}
+
+void CTxOutSetHasher::Add(const COutPoint& outpoint, const Coin& coin)
+{
+    if (!outputs.empty() && outpoint.hash != hashPrevTx) {
+        FinishTx();
+    }
+    hashPrevTx = outpoint.hash;
+    outputs[outpoint.n] = coin;
+}
+
+void CTxOutSetHasher::FinishTx()
+{
+    ss << hashPrevTx;
+    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
+    nTransactions++;
+    for (const auto& output : outputs) {
+        ss << VARINT(output.first + 1);
+        ss << *(const CScriptBase*)(&output.second.out.scriptPubKey);
+        ss << VARINT(output.second.out.nValue);
+        nTransactionOutputs++;
+        nTotalAmount += output.second.out.nValue;
+    }
+    ss << VARINT(0);
+    outputs.clear();
+}
+
+uint256 CTxOutSetHasher::GetHash()
+{
+    if (!outputs.empty()) {
+        FinishTx();
+    }
+    return ss.GetHash();
+}
+
+bool DumpUTXOSnapshot(const boost::filesystem::path& path, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    if (boost::filesystem::exists(path)) {
+        strError = strprintf("%s already exists", path.string());
+        return false;
+    }
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<CDBIterator> pevoCursor;
+    std::vector<std::pair<CBlockHeader, unsigned int> > vHeaders;
+    {
+        LOCK(cs_main);
+        // The cursors see the databases as they are when they are created, everything up to the tip must be written
+        FlushStateToDisk();
+        const CBlockIndex* pindexBase = chainActive.Tip();
+        pcursor.reset(pcoinsdbview->Cursor());
+        if (pcursor->GetBestBlock() != pindexBase->GetBlockHash()) {
+            strError = "The chainstate database is not at the chain tip";
+            return false;
+        }
+        pevoCursor.reset(evoDb->GetRawDB().NewIterator());
+
+        info.hashBaseBlock = pindexBase->GetBlockHash();
+        info.nBaseHeight = pindexBase->nHeight;
+        vHeaders.reserve(pindexBase->nHeight);
+        for (int nHeight = 1; nHeight <= pindexBase->nHeight; nHeight++) {
+            const CBlockIndex* pindex = chainActive[nHeight];
+            vHeaders.emplace_back(pindex->GetBlockHeader(), pindex->nTx);
+        }
+    }
+
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".incomplete";
+    CAutoFile file(fopen(pathTmp.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        strError = strprintf("Unable to open %s for writing", pathTmp.string());
+        return false;
+    }
+
+    try {
+        CHashingWriter<CAutoFile> writer(&file);
+        writer << FLATDATA(UTXO_SNAPSHOT_MAGIC) << UTXO_SNAPSHOT_VERSION << FLATDATA(Params().MessageStart());
+        writer << info.hashBaseBlock << info.nBaseHeight;
+        for (auto& header : vHeaders) {
+            writer << header.first << VARINT(header.second);
+        }
+
+        CTxOutSetHasher hasher(info.hashBaseBlock);
+        uint256 hashTx;
+        std::vector<std::pair<uint32_t, Coin> > vOutputs;
+        auto writeTx = [&]() {
+            uint64_t nOutputs = vOutputs.size();
+            writer << VARINT(nOutputs) << hashTx;
+            for (auto& output : vOutputs) {
+                writer << VARINT(output.first) << output.second;
+            }
+            vOutputs.clear();
+        };
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            COutPoint key;
+            Coin coin;
+            if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+                throw std::runtime_error("unable to read the chainstate database");
+            }
+            hasher.Add(key, coin);
+            if (!vOutputs.empty() && key.hash != hashTx) {
+                writeTx();
+            }
+            hashTx = key.hash;
+            vOutputs.emplace_back(key.n, std::move(coin));
+            pcursor->Next();
+        }
+        if (!vOutputs.empty()) {
+            writeTx();
+        }
+        uint64_t nEnd = 0;
+        writer << VARINT(nEnd);
+
+        for (pevoCursor->SeekToFirst(); pevoCursor->Valid(); pevoCursor->Next()) {
+            boost::this_thread::interruption_point();
+            CDataStream ssKey = pevoCursor->GetKey();
+            std::vector<unsigned char> vchKey(ssKey.begin(), ssKey.end());
+            std::vector<unsigned char> vchValue(pevoCursor->GetValueSize());
+            CFlatData value(vchValue);
+            if (vchKey.empty() || !pevoCursor->GetValue(value)) {
+                throw std::runtime_error("unable to read the EvoDB");
+            }
+            writer << vchKey << vchValue;
+            info.nEvoEntries++;
+        }
+        writer << std::vector<unsigned char>();
+
+        info.hashSerialized = hasher.GetHash();
+        info.nTransactions = hasher.nTransactions;
+        info.nTransactionOutputs = hasher.nTransactionOutputs;
+        info.nTotalAmount = hasher.nTotalAmount;
+        writer << info.nTransactions << info.nTransactionOutputs << info.nTotalAmount << info.nEvoEntries << info.hashSerialized;
+
+        info.hashSnapshot = writer.GetHash();
+        file << info.hashSnapshot;
+    } catch (const std::exception& e) {
+        strError = strprintf("Error dumping to %s: %s", pathTmp.string(), e.what());
+        file.fclose();
+        boost::filesystem::remove(pathTmp);
+        return false;
+    }
+
+    FileCommit(file.Get());
+    file.fclose();
+    if (!RenameOver(pathTmp, path)) {
+        strError = strprintf("Unable to rename %s to %s", pathTmp.string(), path.string());
+        return false;
+    }
+    return true;
+}
+
+/** Hashes everything but the hash at the end of the file, and checks it against that hash */
+static bool HashSnapshotFile(const boost::filesystem::path& path, uint256& hashRet, std::string& strError)
+{
+    CAutoFile file(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        strError = strprintf("Unable to open %s", path.string());
+        return false;
+    }
+    try {
+        uint64_t nSize = boost::filesystem::file_size(path);
+        if (nSize < sizeof(uint256)) {
+            strError = strprintf("%s is not a UTXO set snapshot", path.string());
+            return false;
+        }
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+        std::vector<char> vBuf(1 << 20);
+        for (uint64_t nLeft = nSize - sizeof(uint256); nLeft > 0; ) {
+            boost::this_thread::interruption_point();
+            size_t nRead = std::min<uint64_t>(nLeft, vBuf.size());
+            file.read(vBuf.data(), nRead);
+            hasher.write(vBuf.data(), nRead);
+            nLeft -= nRead;
+        }
+        uint256 hashStored;
+        file >> hashStored;
+        hashRet = hasher.GetHash();
+        if (hashRet != hashStored) {
+            strError = strprintf("%s is corrupted", path.string());
+            return false;
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf("Error reading %s: %s", path.string(), e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const boost::filesystem::path& path, const uint256& hashExpected, CUTXOSnapshotInfo& info, std::string& strError)
+{
+    // Nothing is written before the whole file is known to be the trusted one
+    if (!HashSnapshotFile(path, info.hashSnapshot, strError))
+        return false;
+    if (info.hashSnapshot != hashExpected) {
+        strError = strprintf("The hash of %s is %s, expected %s", path.string(), info.hashSnapshot.ToString(), hashExpected.ToString());
+        return false;
+    }
+
+    FlushStateToDisk();
+    {
+        LOCK(cs_main);
+        std::unique_ptr<CCoinsViewCursor> pcursor(pcoinsdbview->Cursor());
+        // The genesis block is not connected yet on a new datadir
+        bool fGenesisOnly = chainActive.Height() == 0 || (chainActive.Tip() == NULL && mapBlockIndex.count(chainparams.GetConsensus().hashGenesisBlock));
+        if (!fGenesisOnly || pcoinsTip->GetCacheSize() != 0 || pcursor->Valid()) {
+            strError = "A snapshot can only be loaded into a chainstate which has nothing but the genesis block";
+            return false;
+        }
+    }
+
+    CAutoFile file(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        strError = strprintf("Unable to open %s", path.string());
+        return false;
+    }
+    std::vector<unsigned int> vTxCounts;
+    try {
+        CHashVerifier<CAutoFile> verifier(&file);
+
+        unsigned char magic[sizeof(UTXO_SNAPSHOT_MAGIC)];
+        uint32_t nVersion;
+        CMessageHeader::MessageStartChars messageStart;
+        verifier >> FLATDATA(magic) >> nVersion >> FLATDATA(messageStart);
+        if (memcmp(magic, UTXO_SNAPSHOT_MAGIC, sizeof(magic)) != 0 || nVersion != UTXO_SNAPSHOT_VERSION) {
+            strError = strprintf("%s is not a UTXO set snapshot of a supported version", path.string());
+            return false;
+        }
+        if (memcmp(messageStart, chainparams.MessageStart(), sizeof(messageStart)) != 0) {
+            strError = strprintf("%s is a snapshot of a different network", path.string());
+            return false;
+        }
+        verifier >> info.hashBaseBlock >> info.nBaseHeight;
+        if (info.nBaseHeight <= 0) {
+            strError = "The snapshot has no blocks";
+            return false;
+        }
+
+        // The headers are validated like headers from the network, in batches of the size a peer would send
+        vTxCounts.reserve(info.nBaseHeight);
+        std::vector<CBlockHeader> vHeaders;
+        const CBlockIndex* pindexLast = nullptr;
+        for (int nHeight = 1; nHeight <= info.nBaseHeight; nHeight++) {
+            CBlockHeader header;
+            unsigned int nTx;
+            verifier >> header >> VARINT(nTx);
+            if (nTx == 0) {
+                strError = strprintf("The snapshot has no transactions for block %s", header.GetHash().ToString());
+                return false;
+            }
+            vHeaders.push_back(header);
+            vTxCounts.push_back(nTx);
+            if (vHeaders.size() == MAX_HEADERS_RESULTS || nHeight == info.nBaseHeight) {
+                boost::this_thread::interruption_point();
+                CValidationState state;
+                if (!ProcessNewBlockHeaders(vHeaders, state, chainparams, &pindexLast)) {
+                    strError = strprintf("Invalid block header in the snapshot: %s", FormatStateMessage(state));
+                    return false;
+                }
+                vHeaders.clear();
+            }
+        }
+        if (!pindexLast || pindexLast->GetBlockHash() != info.hashBaseBlock || pindexLast->nHeight != info.nBaseHeight) {
+            strError = "The block headers of the snapshot don't lead to its base block";
+            return false;
+        }
+
+        // From here on the chainstate is marked as being in the middle of a write, which ReplayBlocks can't finish
+        // without the blocks. The flag makes init ask for -reindex-chainstate when the load is interrupted.
+        if (!pblocktree->WriteFlag("txoutsetsnapshotloading", true)) {
+            strError = "Failed to write to the block index database";
+            return false;
+        }
+        if (!pcoinsdbview->BeginBulkLoad(info.hashBaseBlock)) {
+            strError = "Failed to write to the chainstate database";
+            return false;
+        }
+        CTxOutSetHasher hasher(info.hashBaseBlock);
+        std::vector<std::pair<COutPoint, Coin> > vCoins;
+        vCoins.reserve(UTXO_SNAPSHOT_LOAD_BATCH);
+        uint256 hashPrevTx;
+        while (true) {
+            boost::this_thread::interruption_point();
+            uint64_t nOutputs;
+            verifier >> VARINT(nOutputs);
+            if (nOutputs == 0)
+                break;
+            uint256 hashTx;
+            verifier >> hashTx;
+            // Keeps the outputs of a transaction together, the hasher relies on that
+            if (!hashPrevTx.IsNull() && !(hashPrevTx < hashTx)) {
+                strError = "The coins of the snapshot are not sorted";
+                return false;
+            }
+            hashPrevTx = hashTx;
+            for (uint64_t i = 0; i < nOutputs; i++) {
+                uint32_t n;
+                Coin coin;
+                verifier >> VARINT(n) >> coin;
+                COutPoint outpoint(hashTx, n);
+                hasher.Add(outpoint, coin);
+                vCoins.emplace_back(outpoint, std::move(coin));
+                if (vCoins.size() >= UTXO_SNAPSHOT_LOAD_BATCH) {
+                    if (!pcoinsdbview->BulkLoadCoins(vCoins)) {
+                        strError = "Failed to write to the chainstate database";
+                        return false;
+                    }
+                    vCoins.clear();
+                }
+            }
+        }
+        if (!vCoins.empty() && !pcoinsdbview->BulkLoadCoins(vCoins)) {
+            strError = "Failed to write to the chainstate database";
+            return false;
+        }
+
+        // The deterministic masternode lists and the quorums are needed to validate the blocks after the base
+        CDBWrapper& evoRawDB = evoDb->GetRawDB();
+        CDBBatch batch(evoRawDB);
+        while (true) {
+            boost::this_thread::interruption_point();
+            std::vector<unsigned char> vchKey, vchValue;
+            verifier >> vchKey;
+            if (vchKey.empty())
+                break;
+            verifier >> vchValue;
+            CDataStream ssKey(vchKey, SER_DISK, CLIENT_VERSION);
+            batch.Write(ssKey, CFlatData(vchValue));
+            info.nEvoEntries++;
+            if (batch.SizeEstimate() > nDefaultDbBatchSize) {
+                if (!evoRawDB.WriteBatch(batch)) {
+                    strError = "Failed to write to the EvoDB";
+                    return false;
+                }
+                batch.Clear();
+            }
+        }
+        if (!evoRawDB.WriteBatch(batch, true)) {
+            strError = "Failed to write to the EvoDB";
+            return false;
+        }
+
+        uint64_t nTransactions, nTransactionOutputs, nEvoEntries;
+        CAmount nTotalAmount;
+        verifier >> nTransactions >> nTransactionOutputs >> nTotalAmount >> nEvoEntries >> info.hashSerialized;
+        uint256 hashSerialized = hasher.GetHash();
+        info.nTransactions = hasher.nTransactions;
+        info.nTransactionOutputs = hasher.nTransactionOutputs;
+        info.nTotalAmount = hasher.nTotalAmount;
+        if (hashSerialized != info.hashSerialized || nTransactions != info.nTransactions || nTransactionOutputs != info.nTransactionOutputs ||
+            nTotalAmount != info.nTotalAmount || nEvoEntries != info.nEvoEntries || verifier.GetHash() != info.hashSnapshot) {
+            strError = "The contents of the snapshot don't match its summary";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf("Error reading %s: %s", path.string(), e.what());
+        return false;
+    }
+
+    // The background validation compares the chainstate it builds from the blocks with this
+    if (!pblocktree->WriteTxOutSetSnapshot(info.hashBaseBlock, info.hashSerialized)) {
+        strError = "Failed to write to the block index database";
+        return false;
+    }
+    if (!ActivateSnapshotChain(info.hashBaseBlock, vTxCounts)) {
+        strError = "Failed to activate the snapshot chain";
+        return false;
+    }
+    FlushStateToDisk();
+    if (!pblocktree->WriteFlag("txoutsetsnapshotloading", false)) {
+        strError = "Failed to write to the block index database";
+        return false;
+    }
+    return true;
+}
+
+static void FatalError(const std::string& strMessage)
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(_("Error: A fatal internal error occurred, see debug.log for details"), "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+CSnapshotValidator::CSnapshotValidator(size_t nCacheSizeIn) : nCacheSize(nCacheSizeIn)
+{
+}
+
+CSnapshotValidator::~CSnapshotValidator()
+{
+    Stop();
+}
+
+bool CSnapshotValidator::Init()
+{
+    LOCK(cs_main);
+
+    uint256 hashBase;
+    if (!pblocktree->ReadTxOutSetSnapshot(hashBase, hashSerialized))
+        return error("%s: the UTXO set snapshot is unknown", __func__);
+    BlockMap::const_iterator it = mapBlockIndex.find(hashBase);
+    if (it == mapBlockIndex.end())
+        return error("%s: the base block %s of the UTXO set snapshot is unknown", __func__, hashBase.ToString());
+    pindexBase = it->second;
+
+    // An interrupted write is not replayed, the blocks are connected again from the start
+    pcoinsdb.reset(new CCoinsViewDB(SNAPSHOT_VALIDATION_DB_CACHE, false, false, "snapshotcheck"));
+    const CBlockIndex* pindexBest = nullptr;
+    uint256 hashBest = pcoinsdb->GetBestBlock();
+    if (!hashBest.IsNull() && mapBlockIndex.count(hashBest)) {
+        pindexBest = mapBlockIndex[hashBest];
+    }
+    bool fConsistent = pcoinsdb->GetHeadBlocks().empty() && (hashBest.IsNull() || (pindexBest && pindexBase->GetAncestor(pindexBest->nHeight) == pindexBest));
+    if (!fConsistent) {
+        LogPrintf("%s: starting over with the blocks below the snapshot base\n", __func__);
+        pcoinsdb.reset();
+        pcoinsdb.reset(new CCoinsViewDB(SNAPSHOT_VALIDATION_DB_CACHE, false, true, "snapshotcheck"));
+        pindexBest = nullptr;
+    }
+    nHeight = pindexBest ? pindexBest->nHeight : 0;
+
+    LogPrintf("%s: validating the blocks below the snapshot base %s (%d) from height %d\n", __func__,
+        pindexBase->GetBlockHash().ToString(), pindexBase->nHeight, nHeight + 1);
+    return true;
+}
+
+void CSnapshotValidator::Start()
+{
+    if (!pcoinsdb || validationThread.joinable()) {
+        return;
+    }
+    fStop = false;
+    validationThread = std::thread(&CSnapshotValidator::ThreadMain, this);
+}
+
+void CSnapshotValidator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStop = true;
+    }
+    cvStop.notify_all();
+    if (validationThread.joinable()) {
+        validationThread.join();
+    }
+}
+
+bool CSnapshotValidator::Wait()
+{
+    std::unique_lock<std::mutex> lock(cs);
+    cvStop.wait_for(lock, std::chrono::seconds(1), [this] { return fStop; });
+    return !fStop;
+}
+
+void CSnapshotValidator::ThreadMain()
+{
+    RenameThread("cbdhealthnetwork-snapshotcheck");
+
+    {
+        CCoinsViewCache view(pcoinsdb.get());
+        const CBlockIndex* pindex = pindexBase->GetAncestor(nHeight);
+        while (pindex != pindexBase) {
+            const CBlockIndex* pindexNext = pindexBase->GetAncestor(pindex->nHeight + 1);
+            bool fHaveData;
+            {
+                LOCK(cs_main);
+                if (pindexNext->nStatus & BLOCK_FAILED_MASK) {
+                    FatalError(strprintf("Block %s below the UTXO set snapshot is invalid. Restart with -reindex to drop the snapshot.", pindexNext->GetBlockHash().ToString()));
+                    return;
+                }
+                fHaveData = (pindexNext->nStatus & BLOCK_HAVE_DATA) != 0;
+            }
+            if (!fHaveData) {
+                // Nothing connected so far is lost when the node is stopped while waiting
+                if (pindex->nHeight > nHeight) {
+                    if (!view.Flush()) {
+                        FatalError("Failed to write the chainstate of the snapshot validation");
+                        return;
+                    }
+                    nHeight = pindex->nHeight;
+                }
+                if (!Wait()) {
+                    return;
+                }
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(cs);
+                if (fStop) {
+                    if (pindex->nHeight > nHeight) {
+                        view.Flush();
+                    }
+                    return;
+                }
+            }
+
+            if (!ConnectBlock(pindexNext, view)) {
+                FatalError(strprintf("Block %s below the UTXO set snapshot is invalid. Restart with -reindex to drop the snapshot.", pindexNext->GetBlockHash().ToString()));
+                return;
+            }
+            pindex = pindexNext;
+
+            // The blocks after the last write are still needed after a restart, they must not be pruned before
+            if (view.DynamicMemoryUsage() > nCacheSize || pindex == pindexBase) {
+                if (!view.Flush()) {
+                    FatalError("Failed to write the chainstate of the snapshot validation");
+                    return;
+                }
+                nHeight = pindex->nHeight;
+                LogPrintf("%s: validated the blocks below the snapshot base up to height %d\n", __func__, nHeight);
+            }
+        }
+    }
+
+    if (!CheckSnapshotHash()) {
+        FatalError("The chainstate built from the blocks doesn't match the UTXO set snapshot. Restart with -reindex to drop the snapshot.");
+        return;
+    }
+    // The EvoDB of the snapshot is not validated, see CSnapshotValidator
+    if (!pblocktree->WriteFlag("txoutsetsnapshotcoinsvalidated", true)) {
+        FatalError("Failed to write to the block index database");
+        return;
+    }
+    LogPrintf("%s: the coins of the UTXO set snapshot at block %s are valid\n", __func__, pindexBase->GetBlockHash().ToString());
+    pcoinsdb.reset();
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(GetDataDir() / "snapshotcheck", ec);
+    fComplete = true;
+}
+
+// The part of IsBlockValueValid which doesn't need the governance objects of the time, what a node which is not synced
+// checks. Old budget blocks can't be checked at all.
+static bool CheckBlockValueBounds(const CBlock& block, int nBlockHeight, CAmount blockReward, const Consensus::Params& consensusParams, std::string& strErrorRet)
+{
+    CAmount nLimit = blockReward;
+    if (nBlockHeight >= consensusParams.nBudgetPaymentsStartBlock && nBlockHeight < consensusParams.nSuperblockStartBlock &&
+        nBlockHeight % consensusParams.nBudgetPaymentsCycleBlocks < consensusParams.nBudgetPaymentsWindowBlocks) {
+        return true;
+    }
+    if (nBlockHeight >= consensusParams.nSuperblockStartBlock && CSuperblock::IsValidBlockHeight(nBlockHeight)) {
+        nLimit += CSuperblock::GetPaymentsLimit(nBlockHeight);
+    }
+    if (block.vtx[0]->GetValueOut() > nLimit) {
+        strErrorRet = strprintf("coinbase pays too much at height %d (actual=%d vs limit=%d)", nBlockHeight, block.vtx[0]->GetValueOut(), nLimit);
+        return false;
+    }
+    return true;
+}
+
+bool CSnapshotValidator::ConnectBlock(const CBlockIndex* pindex, CCoinsViewCache& view)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    // AcceptBlock did the checks which don't need the coins when the block was stored
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, consensusParams))
+        return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+
+    int nLockTimeFlags;
+    unsigned int flags;
+    {
+        LOCK(cs_main);
+        flags = GetBlockScriptFlags(pindex, consensusParams, nLockTimeFlags);
+    }
+
+    // CheckInputs takes the spend height from the best block of the view
+    view.SetBestBlock(pindex->pprev->GetBlockHash());
+    std::vector<int> prevheights;
+    CAmount nFees = 0;
+    for (const auto& ptx : block.vtx) {
+        const CTransaction& tx = *ptx;
+        if (!tx.IsCoinBase()) {
+            if (!view.HaveInputs(tx))
+                return error("%s: inputs of %s are missing or spent", __func__, tx.GetHash().ToString());
+
+            prevheights.resize(tx.vin.size());
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                prevheights[j] = view.AccessCoin(tx.vin[j].prevout).nHeight;
+            }
+            if (!SequenceLocks(tx, nLockTimeFlags, &prevheights, *pindex))
+                return error("%s: %s is not BIP68 final", __func__, tx.GetHash().ToString());
+
+            CValidationState state;
+            if (!CheckInputs(tx, state, view, true, flags, false))
+                return error("%s: CheckInputs on %s failed with %s", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
+            nFees += view.GetValueIn(tx) - tx.GetValueOut();
+        }
+        UpdateCoins(tx, view, pindex->nHeight);
+    }
+
+    CAmount blockReward = nFees + GetBlockSubsidy(pindex->pprev->nBits, pindex->pprev->nHeight, consensusParams);
+    std::string strError;
+    if (!CheckBlockValueBounds(block, pindex->nHeight, blockReward, consensusParams, strError))
+        return error("%s: %s", __func__, strError);
+
+    view.SetBestBlock(pindex->GetBlockHash());
+    return true;
+}
+
+bool CSnapshotValidator::CheckSnapshotHash()
+{
+    CTxOutSetHasher hasher(pindexBase->GetBlockHash());
+    std::unique_ptr<CCoinsViewCursor> pcursor(pcoinsdb->Cursor());
+    while (pcursor->Valid()) {
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin))
+            return error("%s: unable to read the chainstate of the snapshot validation", __func__);
+        hasher.Add(key, coin);
+        pcursor->Next();
+    }
+    uint256 hash = hasher.GetHash();
+    if (hash != hashSerialized)
+        return error("%s: hash_serialized_2 is %s at the base block, the snapshot has %s", __func__, hash.ToString(), hashSerialized.ToString());
+    return true;
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_UTXOSNAPSHOT_H
+#define CHN_UTXOSNAPSHOT_H
+
+#include "amount.h"
+#include "coins.h"
+#include "hash.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem/path.hpp>
+
+class CBlockIndex;
+class CChainParams;
+class CCoinsViewDB;
+
+/** Version of the UTXO set snapshot format written by dumptxoutset */
+static const uint32_t UTXO_SNAPSHOT_VERSION = 1;
+
+/**
+ * Computes the hash_serialized_2 value of gettxoutsetinfo. Coins must be added in the order of the chainstate database,
+ * which keeps the outputs of a transaction together.
+ */
+class CTxOutSetHasher
+{
+private:
+    CHashWriter ss;
+    uint256 hashPrevTx;
+    std::map<uint32_t, Coin> outputs;
+
+public:
+    uint64_t nTransactions{0};
+    uint64_t nTransactionOutputs{0};
+    CAmount nTotalAmount{0};
+
+    explicit CTxOutSetHasher(const uint256& hashBlock);
+
+    void Add(const COutPoint& outpoint, const Coin& coin);
+    //! Invalidates the object
+    uint256 GetHash();
+
+private:
+    void FinishTx();
+};
+
+/** Summary of a UTXO set snapshot */
+struct CUTXOSnapshotInfo
+{
+    uint256 hashBaseBlock;
+    int nBaseHeight{-1};
+    uint64_t nTransactions{0};
+    uint64_t nTransactionOutputs{0};
+    CAmount nTotalAmount{0};
+    uint64_t nEvoEntries{0};
+    //! hash_serialized_2 of gettxoutsetinfo at the base block
+    uint256 hashSerialized;
+    //! Hash of the whole file, the value which must be trusted to load the snapshot
+    uint256 hashSnapshot;
+};
+
+/**
+ * Writes the chainstate and the EvoDB as they are at the chain tip, together with the headers of the active chain, to a
+ * snapshot file. cs_main is only held while the state is flushed, the databases are read through LevelDB snapshots
+ * afterwards.
+ */
+bool DumpUTXOSnapshot(const boost::filesystem::path& path, CUTXOSnapshotInfo& info, std::string& strError);
+
+/**
+ * Loads a snapshot written by DumpUTXOSnapshot into the chainstate of a node which has nothing but the genesis block and
+ * makes the snapshot base block the chain tip. The headers are validated like headers from the network. The blocks up
+ * to the base are treated like pruned blocks, until CSnapshotValidator downloaded them. Nothing is loaded unless the hash of the file
+ * matches hashExpected, which must come from a trusted source.
+ */
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const boost::filesystem::path& path, const uint256& hashExpected, CUTXOSnapshotInfo& info, std::string& strError);
+
+/**
+ * Validates the blocks below the base of the UTXO set snapshot the chainstate was loaded from, on a background thread.
+ *
+ * The blocks are downloaded from peers like the blocks of the active chain (see FindNextBlocksToDownload) and connected
+ * to a chainstate of their own in the snapshotcheck directory, with all input and script checks. At the base block
+ * the hash_serialized_2 value of that chainstate must match the one of the snapshot. The progress is kept across
+ * restarts, the chainstate is deleted once the coins of the snapshot are validated.
+ *
+ * Only the coins are validated. The coinbase of each block is checked against the bounds a node which is not synced
+ * checks as well (block reward, fees and superblock limit), but not against the masternode payees and the governance
+ * objects of the time. The special transactions are not processed, so the deterministic masternode lists, the quorums
+ * and the CbTx merkle roots are not rebuilt. They are taken from the snapshot as they are, which is why its hash must
+ * come from a trusted source.
+ */
+class CSnapshotValidator
+{
+private:
+    const CBlockIndex* pindexBase{nullptr};
+    uint256 hashSerialized;
+    size_t nCacheSize;
+    std::unique_ptr<CCoinsViewDB> pcoinsdb;
+
+    //! Height of the last validated block
+    std::atomic<int> nHeight{0};
+    std::atomic<bool> fComplete{false};
+
+    std::mutex cs;
+    std::condition_variable cvStop;
+    bool fStop{false};
+    std::thread validationThread;
+
+public:
+    explicit CSnapshotValidator(size_t nCacheSizeIn);
+    ~CSnapshotValidator();
+
+    /** Looks up the snapshot in the block index and continues where the last run stopped. Requires the block index to be loaded. */
+    bool Init();
+    void Start();
+    void Stop();
+
+    const CBlockIndex* GetBase() const { return pindexBase; }
+    //! Blocks up to this height were validated, the ones above it are still needed
+    int GetHeight() const { return nHeight; }
+    //! The coins built from all blocks up to the base match the ones of the snapshot
+    bool IsComplete() const { return fComplete; }
+
+private:
+    void ThreadMain();
+    //! Waits a second for blocks to arrive, returns false when stopped
+    bool Wait();
+    bool ConnectBlock(const CBlockIndex* pindex, CCoinsViewCache& view);
+    bool CheckSnapshotHash();
+};
+
+extern CSnapshotValidator* psnapshotvalidator;
+
+#endif // CHN_UTXOSNAPSHOT_H
@@ -10,14 +10,17 @@
 #include "alert.h"
 #include "arith_uint256.h"
 #include "blockencodings.h"
+#include "blockfilemap.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
+#include "coinsprefetch.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
 #include "hash.h"
 #include "init.h"
+#include "insightindexer.h"
 #include "policy/policy.h"
 #include "pow.h"
 #include "primitives/block.h"
@@ -32,12 +35,14 @@
 #include "ui_interface.h"
 #include "undo.h"
 #include "util.h"
+#include "utxosnapshot.h"
 #include "spork.h"
 #include "utilmoneystr.h"
 #include "utilstrencodings.h"
 #include "validationinterface.h"
 #include "versionbits.h"
 #include "warnings.h"
+#include "workstealingpool.h"
 
 #include "instantx.h"
 #include "masternode-payments.h"
@@ -51,6 +56,9 @@
 #include "llmq/quorums_chainlocks.h"
 
 #include <atomic>
+#include <deque>
+#include <future>
+#include <limits>
 #include <sstream>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -85,6 +93,7 @@ bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fHavePruned = false;
 bool fPruneMode = false;
+bool fLoadedFromSnapshot = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 unsigned int nBytesPerSigOp = DEFAULT_BYTES_PER_SIGOP;
@@ -228,7 +237,9 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 
 CCoinsViewDB *pcoinsdbview = NULL;
 CCoinsViewCache *pcoinsTip = NULL;
+CCoinsViewPrefetch *pcoinsPrefetch = NULL;
 CBlockTreeDB *pblocktree = NULL;
+CInsightIndexDB *pinsightindex = NULL;
 
 enum FlushStateMode {
     FLUSH_STATE_NONE,
@@ -942,7 +953,7 @@ bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::v
     if (!fTimestampIndex)
         return error("Timestamp index not enabled");
 
-    if (!pblocktree->ReadTimestampIndex(high, low, hashes))
+    if (!pinsightindex->ReadTimestampIndex(high, low, hashes))
         return error("Unable to get hashes for timestamps");
 
     return true;
@@ -956,7 +967,7 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     if (mempool.getSpentIndex(key, value))
         return true;
 
-    if (!pblocktree->ReadSpentIndex(key, value))
+    if (!pinsightindex->ReadSpentIndex(key, value))
         return false;
 
     return true;
@@ -968,7 +979,7 @@ bool GetAddressIndex(uint160 addressHash, int type,
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!pinsightindex->ReadAddressIndex(addressHash, type, addressIndex, start, end))
         return error("unable to get txids for address");
 
     return true;
@@ -980,7 +991,7 @@ bool GetAddressUnspent(uint160 addressHash, int type,
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!pinsightindex->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
         return error("unable to get txids for address");
 
     return true;
@@ -1080,14 +1091,19 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-
     // Read block
     try {
-        filein >> block;
+        CMappedBlockRecord record;
+        if (blockFileMaps.GetRecord(pos, false, 0, record)) {
+            CSpanReader reader(SER_DISK, CLIENT_VERSION, record.data, record.size);
+            reader >> block;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            filein >> block;
+        }
     }
     catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
@@ -1110,6 +1126,58 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart)
+{
+    CDiskBlockPos pos = pindex->GetBlockPos();
+    block.clear();
+    if (pos.nPos < 8)
+        return error("ReadRawBlockFromDisk: Invalid position %s", pos.ToString());
+
+    try {
+        CMappedBlockRecord record;
+        if (blockFileMaps.GetRecord(pos, false, 0, record)) {
+            // The message start precedes the length of the record
+            if (memcmp(record.data - 8, messageStart, CMessageHeader::MESSAGE_START_SIZE))
+                return error("ReadRawBlockFromDisk: Block magic mismatch for %s at %s", pindex->ToString(), pos.ToString());
+            block.assign(record.data, record.data + record.size);
+        } else {
+            // Open history file to read, starting at the message start
+            pos.nPos -= 8;
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("ReadRawBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+
+            CMessageHeader::MessageStartChars blkStart;
+            unsigned int nSize;
+            filein >> FLATDATA(blkStart) >> nSize;
+            if (memcmp(blkStart, messageStart, CMessageHeader::MESSAGE_START_SIZE))
+                return error("ReadRawBlockFromDisk: Block magic mismatch for %s at %s", pindex->ToString(), pos.ToString());
+            if (nSize > MAX_SIZE)
+                return error("ReadRawBlockFromDisk: Block data is larger than maximum deserialization size for %s at %s", pindex->ToString(), pos.ToString());
+            block.resize(nSize);
+            filein.read((char*)block.data(), nSize);
+        }
+    }
+    catch (const std::exception& e) {
+        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    // The bytes are passed on without being deserialized, make sure they are the block we expect
+    try {
+        CSpanReader reader(SER_DISK, CLIENT_VERSION, block.data(), block.size());
+        CBlockHeader header;
+        reader >> header;
+        uint64_t nTx = ReadCompactSize(reader);
+        if (header.GetHash() != pindex->GetBlockHash() || nTx != pindex->nTx)
+            return error("ReadRawBlockFromDisk: Block data doesn't match index for %s at %s", pindex->ToString(), pos.ToString());
+    }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize error - %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
 double ConvertBitsToDouble(unsigned int nBits)
 {
     int nShift = (nBits >> 24) & 0xff;
@@ -1482,32 +1550,49 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
+template <typename Stream>
+static bool UndoReadFromStream(CBlockUndo& blockundo, Stream& filein, const uint256& hashBlock)
 {
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("%s: OpenUndoFile failed", __func__);
-
     // Read block
     uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    CHashVerifier<Stream> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
         verifier << hashBlock;
         verifier >> blockundo;
         filein >> hashChecksum;
     }
     catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        return error("UndoReadFromDisk: Deserialize or I/O error - %s", e.what());
     }
 
     // Verify checksum
     if (hashChecksum != verifier.GetHash())
-        return error("%s: Checksum mismatch", __func__);
+        return error("UndoReadFromDisk: Checksum mismatch");
 
     return true;
 }
 
+} // anon namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
+{
+    // The checksum follows the undo data
+    CMappedBlockRecord record;
+    if (blockFileMaps.GetRecord(pos, true, sizeof(uint256), record)) {
+        CSpanReader reader(SER_DISK, CLIENT_VERSION, record.data, record.size);
+        return UndoReadFromStream(blockundo, reader, hashBlock);
+    }
+
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenUndoFile failed", __func__);
+
+    return UndoReadFromStream(blockundo, filein, hashBlock);
+}
+
+namespace {
+
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
 {
@@ -1597,10 +1682,6 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     if (!UndoSpecialTxsInBlock(block, pindex)) {
         return DISCONNECT_FAILED;
     }
@@ -1611,41 +1692,6 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
-        if (fAddressIndex) {
-
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, k), CAddressUnspentValue()));
-                } else {
-                    continue;
-                }
-
-            }
-
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -1668,49 +1714,9 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
             }
             for (unsigned int j = tx.vin.size(); j-- > 0;) {
                 const COutPoint &out = tx.vin[j].prevout;
-                int undoHeight = txundo.vprevout[j].nHeight;
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-                }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
-                    } else {
-                        continue;
-                    }
-                }
-
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
@@ -1719,17 +1725,6 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
-    if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            AbortNode(state, "Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode(state, "Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     // make sure the flag is reset in case of a chain reorg
     // (we reused the DIP3 deployment)
     instantsend.isAutoLockBip9Active = pindex->nHeight >= Params().GetConsensus().DIP0003Height;
@@ -1771,6 +1766,14 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+// Each check already covers X11_BATCH_LANES headers, so a 2000 headers message is only 125 checks
+static CCheckQueue<CBlockHeaderCheck> headercheckqueue(4);
+
+void ThreadHeaderCheck() {
+    RenameThread("cbdhealthnetwork-headerch");
+    headercheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -1845,6 +1848,40 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 
+unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consensus::Params& consensusparams, int& nLockTimeFlags)
+{
+    AssertLockHeld(cs_main);
+
+    // BIP16 didn't become active until Apr 1 2012
+    int64_t nBIP16SwitchTime = 1333238400;
+    bool fStrictPayToScriptHash = (pindex->GetBlockTime() >= nBIP16SwitchTime);
+
+    unsigned int flags = fStrictPayToScriptHash ? SCRIPT_VERIFY_P2SH : SCRIPT_VERIFY_NONE;
+
+    // Start enforcing the DERSIG (BIP66) rule
+    if (pindex->nHeight >= consensusparams.BIP66Height) {
+        flags |= SCRIPT_VERIFY_DERSIG;
+    }
+
+    // Start enforcing CHECKLOCKTIMEVERIFY (BIP65) rule
+    if (pindex->nHeight >= consensusparams.BIP65Height) {
+        flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
+    }
+
+    // Start enforcing BIP68 (sequence locks) and BIP112 (CHECKSEQUENCEVERIFY) using versionbits logic.
+    nLockTimeFlags = 0;
+    if (VersionBitsState(pindex->pprev, consensusparams, Consensus::DEPLOYMENT_CSV, versionbitscache) == THRESHOLD_ACTIVE) {
+        flags |= SCRIPT_VERIFY_CHECKSEQUENCEVERIFY;
+        nLockTimeFlags |= LOCKTIME_VERIFY_SEQUENCE;
+    }
+
+    if (VersionBitsState(pindex->pprev, consensusparams, Consensus::DEPLOYMENT_BIP147, versionbitscache) == THRESHOLD_ACTIVE) {
+        flags |= SCRIPT_VERIFY_NULLDUMMY;
+    }
+
+    return flags;
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
@@ -1854,8 +1891,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     AssertLockHeld(cs_main);
     assert(pindex);
     // pindex->phashBlock can be null if called by CreateNewBlock/TestBlockValidity
+    const uint256 blockHash = block.GetHash();
     assert((pindex->phashBlock == NULL) ||
-           (*pindex->phashBlock == block.GetHash()));
+           (*pindex->phashBlock == blockHash));
     int64_t nTimeStart = GetTimeMicros();
 
     // Check it again in case a previous version let a bad block in
@@ -1882,7 +1920,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
     // Special case for the genesis block, skipping connection of its transactions
     // (its coinbase is unspendable)
-    if (block.GetHash() == chainparams.GetConsensus().hashGenesisBlock) {
+    if (blockHash == chainparams.GetConsensus().hashGenesisBlock) {
         if (!fJustCheck)
             view.SetBestBlock(pindex->GetBlockHash());
         return true;
@@ -1959,38 +1997,15 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     // make sure old budget is the real one
     if (pindex->nHeight == chainparams.GetConsensus().nSuperblockStartBlock &&
         chainparams.GetConsensus().nSuperblockStartHash != uint256() &&
-        block.GetHash() != chainparams.GetConsensus().nSuperblockStartHash)
+        blockHash != chainparams.GetConsensus().nSuperblockStartHash)
             return state.DoS(100, error("ConnectBlock(): invalid superblock start"),
                              REJECT_INVALID, "bad-sb-start");
 
     /// END CHN
 
-    // BIP16 didn't become active until Apr 1 2012
-    int64_t nBIP16SwitchTime = 1333238400;
-    bool fStrictPayToScriptHash = (pindex->GetBlockTime() >= nBIP16SwitchTime);
-
-    unsigned int flags = fStrictPayToScriptHash ? SCRIPT_VERIFY_P2SH : SCRIPT_VERIFY_NONE;
-
-    // Start enforcing the DERSIG (BIP66) rule
-    if (pindex->nHeight >= chainparams.GetConsensus().BIP66Height) {
-        flags |= SCRIPT_VERIFY_DERSIG;
-    }
-
-    // Start enforcing CHECKLOCKTIMEVERIFY (BIP65) rule
-    if (pindex->nHeight >= chainparams.GetConsensus().BIP65Height) {
-        flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
-    }
-
-    // Start enforcing BIP68 (sequence locks) and BIP112 (CHECKSEQUENCEVERIFY) using versionbits logic.
-    int nLockTimeFlags = 0;
-    if (VersionBitsState(pindex->pprev, chainparams.GetConsensus(), Consensus::DEPLOYMENT_CSV, versionbitscache) == THRESHOLD_ACTIVE) {
-        flags |= SCRIPT_VERIFY_CHECKSEQUENCEVERIFY;
-        nLockTimeFlags |= LOCKTIME_VERIFY_SEQUENCE;
-    }
-
-    if (VersionBitsState(pindex->pprev, chainparams.GetConsensus(), Consensus::DEPLOYMENT_BIP147, versionbitscache) == THRESHOLD_ACTIVE) {
-        flags |= SCRIPT_VERIFY_NULLDUMMY;
-    }
+    int nLockTimeFlags;
+    unsigned int flags = GetBlockScriptFlags(pindex, chainparams.GetConsensus(), nLockTimeFlags);
+    bool fStrictPayToScriptHash = (flags & SCRIPT_VERIFY_P2SH) != 0;
 
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint("bench", "    - Fork checks: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeForks * 0.000001);
@@ -2007,9 +2022,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     std::vector<std::pair<uint256, CDiskTxPos> > vPos;
     vPos.reserve(block.vtx.size());
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
 
@@ -2043,46 +2055,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                                  REJECT_INVALID, "bad-txns-nonfinal");
             }
 
-            if (fAddressIndex || fSpentIndex)
-            {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    uint160 hashBytes;
-                    int addressType;
-
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22));
-                        addressType = 2;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
-                        addressType = 1;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        hashBytes = Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1);
-                        addressType = 1;
-                    } else {
-                        hashBytes.SetNull();
-                        addressType = 0;
-                    }
-
-                    if (fAddressIndex && addressType > 0) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, hashBytes)));
-                    }
-                }
-
-            }
-
             if (fStrictPayToScriptHash)
             {
                 // Add in sigops done by pay-to-script-hash inputs;
@@ -2104,39 +2076,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-                } else {
-                    continue;
-                }
-
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2177,7 +2116,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                     // The node which relayed this should switch to correct chain.
                     // TODO: relay instantsend data/proof.
                     LOCK(cs_main);
-                    mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
+                    mapRejectedBlocks.insert(std::make_pair(blockHash, GetTime()));
                     return state.DoS(10, error("ConnectBlock(CHN): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), hashLocked.ToString()),
                                      REJECT_INVALID, "conflict-tx-lock");
                 }
@@ -2193,7 +2132,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                 // The node which relayed this should switch to correct chain.
                 // TODO: relay instantsend data/proof.
                 LOCK(cs_main);
-                mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
+                mapRejectedBlocks.insert(std::make_pair(blockHash, GetTime()));
                 return state.DoS(10, error("ConnectBlock(CHN): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), conflictLock->txid.ToString()),
                                  REJECT_INVALID, "conflict-tx-lock");
             }
@@ -2222,7 +2161,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     LogPrint("bench", "      - IsBlockValueValid: %.2fms [%.2fs]\n", 0.001 * (nTime5_3 - nTime5_2), nTimeValueValid * 0.000001);
 
     if (!IsBlockPayeeValid(*block.vtx[0], pindex->nHeight, blockReward)) {
-        mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
+        mapRejectedBlocks.insert(std::make_pair(blockHash, GetTime()));
         return state.DoS(0, error("ConnectBlock(CHN): couldn't find masternode or superblock payments"),
                                 REJECT_INVALID, "bad-cb-payee");
     }
@@ -2269,23 +2208,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         if (!pblocktree->WriteTxIndex(vPos))
             return AbortNode(state, "Failed to write transaction index");
 
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
-    }
-
-    if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
+    // The address, spent and timestamp indexes are written by CInsightIndexer once the block is connected
 
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2322,6 +2245,9 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
     std::set<int> setFilesToPrune;
     bool fFlushForPrune = false;
     try {
+    if (pcoinsdbview->HasFlushFailed()) {
+        return AbortNode(state, "Failed to write to coin database");
+    }
     if (fPruneMode && (fCheckForPruning || nManualPruneHeight > 0) && !fReindex) {
         if (nManualPruneHeight > 0) {
             FindFilesToPruneManual(setFilesToPrune, nManualPruneHeight);
@@ -2350,6 +2276,8 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
     }
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR;
+    // Coins which are still being written in the background, they don't grow anymore
+    cacheSize += pcoinsdbview->DynamicMemoryUsage();
     cacheSize += evoDb->GetMemoryUsage() * DB_PEAK_USAGE_FACTOR;
     int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
     // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
@@ -2387,9 +2315,6 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
                 return AbortNode(state, "Failed to write to block index database");
             }
         }
-        // Finally remove any pruned files
-        if (fFlushForPrune)
-            UnlinkPrunedFiles(setFilesToPrune);
         nLastWrite = nNow;
     }
     // Flush best chain related state. This can only be done if the blocks / block index write was also done.
@@ -2407,6 +2332,14 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         if (!evoDb->CommitRootTransaction()) {
             return AbortNode(state, "Failed to commit EvoDB");
         }
+        // The coins are written in the background. Blocks up to the new tip are needed to replay them if we crash
+        // before they are complete, so they can only be pruned afterwards. Callers of FLUSH_STATE_ALWAYS expect
+        // everything to be on disk.
+        if ((fFlushForPrune || mode == FLUSH_STATE_ALWAYS) && !pcoinsdbview->WaitForFlush())
+            return AbortNode(state, "Failed to write to coin database");
+        // Finally remove any pruned files
+        if (fFlushForPrune)
+            UnlinkPrunedFiles(setFilesToPrune);
         nLastFlush = nNow;
     }
     if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
@@ -2588,6 +2521,13 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     int64_t nTime3;
     LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
     {
+        if (pcoinsPrefetch) {
+            // No-op if the inputs were already requested when the block was accepted. Otherwise (e.g. block was
+            // read from disk) this still fetches them in parallel instead of one after another in ConnectBlock
+            pcoinsPrefetch->PrefetchBlock(blockConnecting, *pcoinsTip);
+            pcoinsPrefetch->WaitForBlock(pindexNew->GetBlockHash());
+        }
+
         auto dbTx = evoDb->BeginTransaction();
 
         CCoinsViewCache view(pcoinsTip);
@@ -3221,15 +3161,20 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
 }
 
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+{
+    return CheckBlockHeader(block, block.GetHash(), state, consensusParams, fCheckPOW);
+}
+
+bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(hash, block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     // Check DevNet
     if (!consensusParams.hashDevnetGenesisBlock.IsNull() &&
             block.hashPrevBlock == consensusParams.hashGenesisBlock &&
-            block.GetHash() != consensusParams.hashDevnetGenesisBlock) {
+            hash != consensusParams.hashDevnetGenesisBlock) {
         return state.DoS(100, error("CheckBlockHeader(): wrong devnet genesis"),
                          REJECT_INVALID, "devnet-genesis");
     }
@@ -3410,11 +3355,10 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = NULL;
 
@@ -3431,7 +3375,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, hash, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3476,14 +3420,63 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
     return true;
 }
 
-// Exposed wrapper for AcceptBlockHeader
+// Hashes the headers of the run and checks each hash against the proof of work its header claims
+bool CBlockHeaderCheck::operator()()
+{
+    GetBlockHeaderHashes(pheaders, nCount, phashes);
+    for (size_t i = 0; i < nCount; i++) {
+        if (!CheckProofOfWork(phashes[i], pheaders[i].nBits, *pparams)) {
+            *pfPoWValid = false;
+        }
+    }
+    return true;
+}
+
+bool PreVerifyBlockHeaders(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet, const Consensus::Params& consensusParams)
+{
+    AssertLockNotHeld(cs_main);
+
+    hashesRet.resize(headers.size());
+    std::atomic<bool> fPoWValid(true);
+
+    std::vector<CBlockHeaderCheck> vChecks;
+    vChecks.reserve((headers.size() + X11_BATCH_LANES - 1) / X11_BATCH_LANES);
+    for (size_t i = 0; i < headers.size(); i += X11_BATCH_LANES) {
+        size_t nCount = std::min(X11_BATCH_LANES, headers.size() - i);
+        vChecks.emplace_back(&headers[i], nCount, &hashesRet[i], consensusParams, fPoWValid);
+    }
+
+    if (nScriptCheckThreads && vChecks.size() > 1) {
+        CCheckQueueControl<CBlockHeaderCheck> control(&headercheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (CBlockHeaderCheck& check : vChecks) {
+            check();
+        }
+    }
+
+    return fPoWValid;
+}
+
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
 {
+    std::vector<uint256> hashes;
+    bool fPoWChecked = PreVerifyBlockHeaders(headers, hashes, chainparams.GetConsensus());
+    return ProcessNewBlockHeaders(headers, hashes, fPoWChecked, state, chainparams, ppindex);
+}
+
+// Exposed wrapper for AcceptBlockHeader
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes, bool fPoWChecked, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+{
+    assert(headers.size() == hashes.size());
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
             CBlockIndex *pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            // If some header failed the proof of work check, check all of them again here so that
+            // the headers in front of the offending one still get accepted, same as without pre-verification
+            if (!AcceptBlockHeader(headers[i], hashes[i], state, chainparams, &pindex, !fPoWChecked)) {
                 return false;
             }
             if (ppindex) {
@@ -3506,7 +3499,7 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
     CBlockIndex *pindexDummy = NULL;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, block.GetHash(), state, chainparams, &pindex))
         return false;
 
     // Try to process all requested blocks that we don't have, but only
@@ -3598,6 +3591,11 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
             GetMainSignals().BlockChecked(*pblock, state);
             return error("%s: AcceptBlock FAILED: %s", __func__, FormatStateMessage(state));
         }
+
+        if (pcoinsPrefetch && pindex && pindex->pprev == chainActive.Tip()) {
+            // The block is likely to be connected next, start fetching its inputs while ActivateBestChain gets there
+            pcoinsPrefetch->PrefetchBlock(*pblock, *pcoinsTip);
+        }
     }
 
     NotifyHeaderTip();
@@ -3696,12 +3694,29 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileMaps.Remove(*it);
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
     }
 }
 
+/* The blocks above this height are still needed by the jobs which read blocks in the background: the address, spent
+   and timestamp indexes and the validation of the blocks below a UTXO set snapshot */
+static int GetPruneLockHeight()
+{
+    AssertLockHeld(cs_main);
+
+    int nHeight = std::numeric_limits<int>::max();
+    if (pinsightindexer) {
+        nHeight = std::min(nHeight, pinsightindexer->GetPruneLockHeight());
+    }
+    if (psnapshotvalidator && !psnapshotvalidator->IsComplete()) {
+        nHeight = std::min(nHeight, psnapshotvalidator->GetHeight());
+    }
+    return nHeight;
+}
+
 /* Calculate the block/rev files to delete based on height specified by user with RPC command pruneblockchain */
 void FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPruneHeight)
 {
@@ -3713,6 +3728,7 @@ void FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPruneHeig
 
     // last block to prune is the lesser of (user-specified height, MIN_BLOCKS_TO_KEEP from the tip)
     unsigned int nLastBlockWeCanPrune = std::min((unsigned)nManualPruneHeight, chainActive.Tip()->nHeight - MIN_BLOCKS_TO_KEEP);
+    nLastBlockWeCanPrune = std::min(nLastBlockWeCanPrune, (unsigned)GetPruneLockHeight());
     int count=0;
     for (int fileNumber = 0; fileNumber < nLastBlockFile; fileNumber++) {
         if (vinfoBlockFile[fileNumber].nSize == 0 || vinfoBlockFile[fileNumber].nHeightLast > nLastBlockWeCanPrune)
@@ -3743,6 +3759,7 @@ void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight
     }
 
     unsigned int nLastBlockWeCanPrune = chainActive.Tip()->nHeight - MIN_BLOCKS_TO_KEEP;
+    nLastBlockWeCanPrune = std::min(nLastBlockWeCanPrune, (unsigned)GetPruneLockHeight());
     uint64_t nCurrentUsage = CalculateCurrentUsage();
     // We don't check to prune until after we've allocated new space for files
     // So we should leave a buffer under our target to account for another allocation
@@ -3846,6 +3863,134 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
     return pindexNew;
 }
 
+/** Undo the coin changes of a block for ReplayBlocks. Unlike DisconnectBlock, this leaves the indexes and evodb alone and
+ *  doesn't expect the coins to be in the state the block left them in, as the chainstate can be any mix of the old and
+ *  the new state. Both spending and restoring a coin are idempotent. */
+static bool RollbackBlockCoins(const CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& params)
+{
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, params.GetConsensus())) {
+        return error("RollbackBlockCoins(): ReadBlockFromDisk() failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+    }
+    CBlockUndo blockUndo;
+    CDiskBlockPos pos = pindex->GetUndoPos();
+    if (pos.IsNull() || !UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash())) {
+        return error("RollbackBlockCoins(): failure reading undo data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+    }
+    if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("RollbackBlockCoins(): block and undo data inconsistent");
+    }
+
+    for (int i = block.vtx.size() - 1; i >= 0; i--) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& hash = tx.GetHash();
+        for (size_t o = 0; o < tx.vout.size(); o++) {
+            if (!tx.vout[o].scriptPubKey.IsUnspendable()) {
+                view.SpendCoin(COutPoint(hash, o));
+            }
+        }
+        if (i > 0) {
+            CTxUndo& txundo = blockUndo.vtxundo[i-1];
+            if (txundo.vprevout.size() != tx.vin.size()) {
+                return error("RollbackBlockCoins(): transaction and undo data inconsistent");
+            }
+            for (unsigned int j = tx.vin.size(); j-- > 0;) {
+                const COutPoint& out = tx.vin[j].prevout;
+                // The coin might have been restored already
+                view.SpendCoin(out);
+                if (ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out) == DISCONNECT_FAILED) {
+                    return error("RollbackBlockCoins(): failed to restore %s at %d", out.ToString(), pindex->nHeight);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/** Apply the coin changes of a block for ReplayBlocks. Every addition may be an overwrite. */
+static bool RollforwardBlockCoins(const CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& params)
+{
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, params.GetConsensus())) {
+        return error("RollforwardBlockCoins(): ReadBlockFromDisk() failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+    }
+
+    for (const CTransactionRef& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                view.SpendCoin(txin.prevout);
+            }
+        }
+        AddCoins(view, *tx, pindex->nHeight, true);
+    }
+    return true;
+}
+
+/** Finish a write of the chainstate that was interrupted, see CCoinsViewDB. The coins of all blocks between the old
+ *  and the new best block are rolled back along the old branch and forward along the new one. */
+bool ReplayBlocks(const CChainParams& params, CCoinsView* view)
+{
+    std::vector<uint256> hashHeads = view->GetHeadBlocks();
+    if (hashHeads.empty()) return true; // We're already in a consistent state.
+    if (hashHeads.size() != 2) return error("ReplayBlocks(): unknown inconsistent state");
+
+    uiInterface.ShowProgress(_("Replaying blocks..."), 0);
+    LogPrintf("Replaying blocks\n");
+
+    const CBlockIndex* pindexOld = NULL;  // Old tip during the interrupted flush.
+    const CBlockIndex* pindexNew;         // New tip during the interrupted flush.
+    const CBlockIndex* pindexFork = NULL; // Latest block common to both the old and the new tip.
+
+    BlockMap::iterator it = mapBlockIndex.find(hashHeads[0]);
+    if (it == mapBlockIndex.end()) {
+        return error("ReplayBlocks(): reorganization to unknown block requested");
+    }
+    pindexNew = it->second;
+
+    if (!hashHeads[1].IsNull()) { // The old tip is allowed to be null, indicating it's the first flush.
+        it = mapBlockIndex.find(hashHeads[1]);
+        if (it == mapBlockIndex.end()) {
+            return error("ReplayBlocks(): reorganization from unknown block requested");
+        }
+        pindexOld = it->second;
+        const CBlockIndex* pa = pindexOld->GetAncestor(std::min(pindexOld->nHeight, pindexNew->nHeight));
+        const CBlockIndex* pb = pindexNew->GetAncestor(pa->nHeight);
+        while (pa != pb) {
+            pa = pa->pprev;
+            pb = pb->pprev;
+        }
+        pindexFork = pa;
+        assert(pindexFork != NULL);
+    }
+
+    CCoinsViewCache cache(view);
+
+    // Rollback along the old branch.
+    while (pindexOld != pindexFork) {
+        LogPrintf("Rolling back %s (%i)\n", pindexOld->GetBlockHash().ToString(), pindexOld->nHeight);
+        if (!RollbackBlockCoins(pindexOld, cache, params)) return false;
+        pindexOld = pindexOld->pprev;
+    }
+
+    // Roll forward from the forking point to the new tip. The genesis block never touches the coins.
+    int nForkHeight = pindexFork ? pindexFork->nHeight : 0;
+    for (int nHeight = nForkHeight + 1; nHeight <= pindexNew->nHeight; ++nHeight) {
+        const CBlockIndex* pindex = pindexNew->GetAncestor(nHeight);
+        // Blocks below a UTXO set snapshot whose load was interrupted were never downloaded
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            return error("ReplayBlocks(): block %s (%i) to roll forward is not available, -reindex-chainstate is needed", pindex->GetBlockHash().ToString(), nHeight);
+        }
+        LogPrintf("Rolling forward %s (%i)\n", pindex->GetBlockHash().ToString(), nHeight);
+        uiInterface.ShowProgress(_("Replaying blocks..."), (int) ((nHeight - nForkHeight) * 100.0 / (pindexNew->nHeight - nForkHeight)));
+        if (!RollforwardBlockCoins(pindex, cache, params)) return false;
+    }
+
+    cache.SetBestBlock(pindexNew->GetBlockHash());
+    if (!cache.Flush()) return error("ReplayBlocks(): failed to write the coin database");
+    uiInterface.ShowProgress("", 100);
+    return true;
+}
+
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
     if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
@@ -3936,6 +4081,11 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     if (fHavePruned)
         LogPrintf("LoadBlockIndexDB(): Block files have previously been pruned\n");
 
+    // Check whether the chainstate was loaded from a UTXO set snapshot
+    pblocktree->ReadFlag("txoutsetsnapshot", fLoadedFromSnapshot);
+    if (fLoadedFromSnapshot)
+        LogPrintf("LoadBlockIndexDB(): Chainstate was loaded from a UTXO set snapshot\n");
+
     // Check whether we need to continue reindexing
     bool fReindexing = false;
     pblocktree->ReadReindexing(fReindexing);
@@ -3945,17 +4095,9 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     pblocktree->ReadFlag("txindex", fTxIndex);
     LogPrintf("%s: transaction index %s\n", __func__, fTxIndex ? "enabled" : "disabled");
 
-    // Check whether we have an address index
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
-    LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
-
-    // Check whether we have a timestamp index
-    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
-    LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
-
-    // Check whether we have a spent index
-    pblocktree->ReadFlag("spentindex", fSpentIndex);
-    LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
+    // Finish an interrupted write of the chainstate before its best block is used
+    if (!ReplayBlocks(chainparams, pcoinsdbview))
+        return false;
 
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
@@ -4018,8 +4160,8 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         uiInterface.ShowProgress(_("Verifying blocks..."), percentageDone);
         if (pindex->nHeight < chainActive.Height()-nCheckDepth)
             break;
-        if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
-            // If pruning, only go back as far as we have data.
+        if ((fPruneMode || fLoadedFromSnapshot) && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            // If pruning or starting from a snapshot, only go back as far as we have data.
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
@@ -4108,6 +4250,7 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    fLoadedFromSnapshot = false;
 }
 
 bool LoadBlockIndex(const CChainParams& chainparams)
@@ -4118,6 +4261,53 @@ bool LoadBlockIndex(const CChainParams& chainparams)
     return true;
 }
 
+bool ActivateSnapshotChain(const uint256& hashBaseBlock, const std::vector<unsigned int>& vTxCounts)
+{
+    LOCK(cs_main);
+
+    BlockMap::iterator mi = mapBlockIndex.find(hashBaseBlock);
+    if (mi == mapBlockIndex.end())
+        return error("%s: unknown base block %s", __func__, hashBaseBlock.ToString());
+    CBlockIndex* pindexBase = mi->second;
+    // On a new datadir the genesis block is only connected by the import thread, which runs after the snapshot is loaded
+    if (chainActive.Height() > 0 || pindexBase->nHeight != (int)vTxCounts.size())
+        return error("%s: base block %s at height %d does not fit the chain", __func__, hashBaseBlock.ToString(), pindexBase->nHeight);
+    CBlockIndex* pindexGenesis = pindexBase->GetAncestor(0);
+    if (pindexGenesis->GetBlockHash() != Params().GetConsensus().hashGenesisBlock || (chainActive.Genesis() != NULL && chainActive.Genesis() != pindexGenesis))
+        return error("%s: base block %s is not on top of the genesis block", __func__, hashBaseBlock.ToString());
+
+    std::vector<CBlockIndex*> vChain;
+    for (CBlockIndex* pindex = pindexBase; pindex->pprev; pindex = pindex->pprev) {
+        if (pindex->nStatus & BLOCK_FAILED_MASK)
+            return error("%s: block %s is invalid", __func__, pindex->GetBlockHash().ToString());
+        vChain.push_back(pindex);
+    }
+    if (pindexGenesis->RaiseValidity(BLOCK_VALID_SCRIPTS))
+        setDirtyBlockIndex.insert(pindexGenesis);
+    // The snapshot stands in for the validation of the blocks up to the base until CSnapshotValidator checked them
+    for (auto it = vChain.rbegin(); it != vChain.rend(); ++it) {
+        CBlockIndex* pindex = *it;
+        pindex->nTx = vTxCounts[pindex->nHeight - 1];
+        pindex->nChainTx = pindex->pprev->nChainTx + pindex->nTx;
+        pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
+        setDirtyBlockIndex.insert(pindex);
+    }
+    {
+        LOCK(cs_nBlockSequenceId);
+        pindexBase->nSequenceId = nBlockSequenceId++;
+    }
+    setBlockIndexCandidates.insert(pindexBase);
+
+    pcoinsTip->SetBestBlock(hashBaseBlock);
+    chainActive.SetTip(pindexBase);
+    PruneBlockIndexCandidates();
+
+    fLoadedFromSnapshot = true;
+    if (!pblocktree->WriteFlag("txoutsetsnapshot", true))
+        return error("%s: failed to write to the block index database", __func__);
+    return true;
+}
+
 static bool AddGenesisBlock(const CChainParams& chainparams, const CBlock& block, CValidationState& state)
 {
     // Start new block file
@@ -4145,17 +4335,6 @@ bool InitBlockIndex(const CChainParams& chainparams)
     fTxIndex = GetBoolArg("-txindex", DEFAULT_TXINDEX);
     pblocktree->WriteFlag("txindex", fTxIndex);
 
-    // Use the provided setting for -addressindex in the new database
-    fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
-    pblocktree->WriteFlag("addressindex", fAddressIndex);
-
-    // Use the provided setting for -timestampindex in the new database
-    fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-    pblocktree->WriteFlag("timestampindex", fTimestampIndex);
-
-    fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
-    pblocktree->WriteFlag("spentindex", fSpentIndex);
-
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -4185,10 +4364,81 @@ bool InitBlockIndex(const CChainParams& chainparams)
     return true;
 }
 
+// Map of disk positions for blocks with unknown parent (only used for reindex)
+static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+
+/**
+ * Accepts a block read by LoadExternalBlockFile or ReindexBlockFiles, together with the blocks found earlier which
+ * were waiting for it as their parent. Returns false if loading should stop.
+ */
+static bool AcceptLoadedBlock(const CChainParams& chainparams, const std::shared_ptr<const CBlock>& pblock, CDiskBlockPos *dbp, int& nLoaded)
+{
+    const CBlock& block = *pblock;
+
+    // detect out of order blocks, and store them for later
+    uint256 hash = block.GetHash();
+    if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
+        LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                block.hashPrevBlock.ToString());
+        if (dbp)
+            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+        return true;
+    }
+
+    // process in case the block isn't known yet
+    if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+        LOCK(cs_main);
+        CValidationState state;
+        if (AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL))
+            nLoaded++;
+        if (state.IsError())
+            return false;
+    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
+        LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+    }
+
+    // Activate the genesis block so normal node progress can continue
+    if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+        CValidationState state;
+        if (!ActivateBestChain(state, chainparams)) {
+            return false;
+        }
+    }
+
+    NotifyHeaderTip();
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
+            {
+                LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                CValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
+                {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
+
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
@@ -4228,79 +4478,168 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
+                blkdat >> *pblock;
                 nRewind = blkdat.GetPos();
 
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
-                    LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                            block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
+                if (!AcceptLoadedBlock(chainparams, pblock, dbp, nLoaded))
+                    break;
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        AbortNode(std::string("System error: ") + e.what());
+    }
+    if (nLoaded > 0)
+        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+    return nLoaded > 0;
+}
 
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    LOCK(cs_main);
-                    CValidationState state;
-                    if (AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
-                    LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+namespace {
+
+/** A blk?????.dat file mapped and scanned by a reindex worker */
+struct ScannedBlockFile
+{
+    bool fExists{false};
+    //! Null if the file can't be mapped, it is then loaded through LoadExternalBlockFile
+    std::shared_ptr<const CMappedBlockFile> file;
+    std::vector<CBlockFileRecord> records;
+};
+
+/** A block deserialized and checked by a reindex worker */
+struct ParsedBlock
+{
+    //! Null if the block doesn't deserialize
+    std::shared_ptr<const CBlock> pblock;
+    //! Where scanning continues after this block
+    size_t nNext;
+};
+
+ScannedBlockFile ScanBlockFile(const CChainParams& chainparams, int nFile)
+{
+    ScannedBlockFile scanned;
+    boost::filesystem::path path = GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk");
+    scanned.fExists = boost::filesystem::exists(path);
+    if (scanned.fExists) {
+        scanned.file = CMappedBlockFile::Open(path);
+        if (scanned.file) {
+            scanned.records = FindBlockRecords(*scanned.file, 0, chainparams.MessageStart(), MaxBlockSize(true));
+        }
+    }
+    return scanned;
+}
+
+ParsedBlock ParseBlock(const CChainParams& chainparams, std::shared_ptr<const CMappedBlockFile> file, CBlockFileRecord record)
+{
+    ParsedBlock parsed;
+    parsed.nNext = record.nStart + 1;
+    try {
+        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+        CSpanReader reader(SER_DISK, CLIENT_VERSION, file->data() + record.nPos, record.nSize);
+        reader >> *pblock;
+        parsed.nNext = record.nPos + record.nSize - reader.size();
+        // Hashing the header and the context independent checks (transaction checks and the merkle root) are most of
+        // the work of AcceptBlock, which skips them for a block that passed them here. A block which fails them is
+        // checked again by AcceptBlock, so that it is marked invalid.
+        pblock->GetHash();
+        CValidationState state;
+        CheckBlock(*pblock, state, chainparams.GetConsensus());
+        parsed.pblock = pblock;
+    } catch (const std::exception& e) {
+        LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+    }
+    return parsed;
+}
+
+} // namespace
+
+void ReindexBlockFiles(const CChainParams& chainparams, int nThreads)
+{
+    int64_t nStart = GetTimeMillis();
+    int nLoaded = 0;
+
+    CWorkStealingPool workerPool;
+    workerPool.Start(nThreads, "cbdhealthnetwork-reindex");
+
+    // Files are mapped and scanned ahead of the one being loaded
+    std::deque<std::future<ScannedBlockFile> > scans;
+    int nNextScan = 0;
+
+    try {
+        for (int nFile = 0; ; nFile++) {
+            while (scans.size() < REINDEX_SCAN_AHEAD_FILES) {
+                scans.emplace_back(workerPool.Push([&chainparams](int, int nScanFile) {
+                    return ScanBlockFile(chainparams, nScanFile);
+                }, nNextScan++));
+            }
+            ScannedBlockFile scanned = scans.front().get();
+            scans.pop_front();
+            if (!scanned.fExists)
+                break; // No block files left to reindex
+
+            CDiskBlockPos pos(nFile, 0);
+            LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+            if (!scanned.file) {
+                FILE *file = OpenBlockFile(pos, true);
+                if (!file)
+                    break; // This error is logged in OpenBlockFile
+                LoadExternalBlockFile(chainparams, file, &pos);
+                continue;
+            }
+
+            // Blocks are deserialized and checked by the workers and accepted here in the order of the file. At most
+            // REINDEX_MAX_PARSE_BYTES of serialized blocks are parsed ahead of the block being accepted.
+            std::deque<std::pair<CBlockFileRecord, std::future<ParsedBlock> > > parses;
+            size_t nParseBytes = 0;
+            size_t nNextRecord = 0;
+            // Like LoadExternalBlockFile, give up on the rest of the file when accepting a block fails with an error
+            bool fStop = false;
+            while (!fStop) {
+                while (nNextRecord < scanned.records.size() && (parses.empty() || nParseBytes < REINDEX_MAX_PARSE_BYTES)) {
+                    const CBlockFileRecord& record = scanned.records[nNextRecord++];
+                    parses.emplace_back(record, workerPool.Push([&chainparams](int, std::shared_ptr<const CMappedBlockFile> file, CBlockFileRecord r) {
+                        return ParseBlock(chainparams, file, r);
+                    }, scanned.file, record));
+                    nParseBytes += record.nSize;
                 }
+                if (parses.empty())
+                    break;
+
+                boost::this_thread::interruption_point();
+
+                CBlockFileRecord record = parses.front().first;
+                ParsedBlock parsed = parses.front().second.get();
+                parses.pop_front();
+                nParseBytes -= record.nSize;
 
-                // Activate the genesis block so normal node progress can continue
-                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
-                        break;
+                if (parsed.pblock) {
+                    pos.nPos = record.nPos;
+                    try {
+                        fStop = !AcceptLoadedBlock(chainparams, parsed.pblock, &pos, nLoaded);
+                    } catch (const std::exception& e) {
+                        LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
                     }
                 }
 
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, chainparams.GetConsensus()))
-                        {
-                            LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
-                    }
+                // Scanning went on after the end of the record. When the block didn't deserialize or was shorter than
+                // the record, scan again from where LoadExternalBlockFile would have continued.
+                size_t nScanned = record.nPos + record.nSize;
+                if (parsed.nNext != nScanned) {
+                    parses.clear();
+                    nParseBytes = 0;
+                    scanned.records = FindBlockRecords(*scanned.file, parsed.nNext, chainparams.MessageStart(), MaxBlockSize(true));
+                    nNextRecord = 0;
                 }
-            } catch (const std::exception& e) {
-                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
     }
-    if (nLoaded > 0)
-        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
-    return nLoaded > 0;
+
+    // Don't finish the scans of files which aren't needed anymore
+    workerPool.Stop(false);
+
+    LogPrintf("Loaded %i blocks from block files in %dms using %d threads\n", nLoaded, GetTimeMillis() - nStart, nThreads);
 }
 
 void static CheckBlockIndex(const Consensus::Params& consensusParams)
@@ -4363,7 +4702,8 @@ void static CheckBlockIndex(const Consensus::Params& consensusParams)
         if (pindex->nChainTx == 0) assert(pindex->nSequenceId <= 0);  // nSequenceId can't be set positive for blocks that aren't linked (negative is used for preciousblock)
         // VALID_TRANSACTIONS is equivalent to nTx > 0 for all nodes (whether or not pruning has occurred).
         // HAVE_DATA is only equivalent to nTx > 0 (or VALID_TRANSACTIONS) if no pruning has occurred.
-        if (!fHavePruned) {
+        // The blocks below a UTXO set snapshot are treated like pruned blocks.
+        if (!fHavePruned && !fLoadedFromSnapshot) {
             // If we've never pruned, then HAVE_DATA should be equivalent to nTx > 0
             assert(!(pindex->nStatus & BLOCK_HAVE_DATA) == (pindex->nTx == 0));
             assert(pindexFirstMissing == pindexFirstNeverProcessed);
@@ -4422,7 +4762,7 @@ void static CheckBlockIndex(const Consensus::Params& consensusParams)
         if (pindexFirstMissing == NULL) assert(!foundInUnlinked); // We aren't missing data for any parent -- cannot be in mapBlocksUnlinked.
         if (pindex->pprev && (pindex->nStatus & BLOCK_HAVE_DATA) && pindexFirstNeverProcessed == NULL && pindexFirstMissing != NULL) {
             // We HAVE_DATA for this block, have received data for all parents at some point, but we're currently missing data for some parent.
-            assert(fHavePruned); // We must have pruned.
+            assert(fHavePruned || fLoadedFromSnapshot); // We must have pruned, or started from a snapshot.
             // This block may have entered mapBlocksUnlinked if:
             //  - it has a descendant that at some point had more work than the
             //    tip, and
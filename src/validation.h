@@ -35,10 +35,13 @@
 #include <boost/filesystem/path.hpp>
 
 class CBlockIndex;
+class CBlockUndo;
 class CBlockTreeDB;
+class CInsightIndexDB;
 class CBloomFilter;
 class CChainParams;
 class CCoinsViewDB;
+class CCoinsViewPrefetch;
 class CInv;
 class CConnman;
 class CScriptCheck;
@@ -84,6 +87,14 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of threads parsing block files during -reindex */
+static const int MAX_REINDEX_THREADS = 16;
+/** -reindexthreads default (number of threads parsing block files during -reindex, 0 = auto) */
+static const int DEFAULT_REINDEX_THREADS = 0;
+/** Number of block files mapped and scanned ahead of the one being loaded during -reindex */
+static const size_t REINDEX_SCAN_AHEAD_FILES = 2;
+/** Maximum size of the serialized blocks parsed ahead of the one being accepted during -reindex */
+static const size_t REINDEX_MAX_PARSE_BYTES = 64 * 1024 * 1024;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -167,6 +178,9 @@ extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressIndex;
+extern bool fSpentIndex;
+extern bool fTimestampIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern unsigned int nBytesPerSigOp;
@@ -202,6 +216,8 @@ static const uint64_t nMinDiskSpace = 52428800;
 extern bool fHavePruned;
 /** True if we're running in -prune mode. */
 extern bool fPruneMode;
+/** True if the chainstate was loaded from a UTXO set snapshot, the blocks below the snapshot are treated like pruned blocks. */
+extern bool fLoadedFromSnapshot;
 /** Number of MiB of block files that we're trying to stay below. */
 extern uint64_t nPruneTarget;
 /** Block files containing a block-height within MIN_BLOCKS_TO_KEEP of chainActive.Tip() will not be pruned. */
@@ -253,6 +269,26 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  */
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
 
+/**
+ * Same as above, but with the context-free part already done by PreVerifyBlockHeaders.
+ * hashes must contain exactly one entry per header, in the same order.
+ * fPoWChecked must only be true if all headers passed the proof of work check.
+ */
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, const std::vector<uint256>& hashes, bool fPoWChecked, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
+
+/**
+ * Computes the hashes of a batch of block headers and checks them against the claimed
+ * proof of work, spread over the header check threads.
+ *
+ * Call without cs_main held.
+ *
+ * @param[in]  headers The block headers to check
+ * @param[out] hashesRet The hash of every header, always filled completely
+ * @param[in]  consensusParams The consensus params to check the proof of work against
+ * @return True if all headers passed CheckProofOfWork
+ */
+bool PreVerifyBlockHeaders(const std::vector<CBlockHeader>& headers, std::vector<uint256>& hashesRet, const Consensus::Params& consensusParams);
+
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
 /** Open a block file (blk?????.dat) */
@@ -263,14 +299,28 @@ FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 /** Import blocks from an external file */
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp = NULL);
+/**
+ * Reindex: loads all blk?????.dat files. The files are scanned and their blocks deserialized and checked on nThreads
+ * worker threads, the blocks are accepted in the order of the files on the calling thread.
+ */
+void ReindexBlockFiles(const CChainParams& chainparams, int nThreads);
 /** Initialize a new block tree database + block data on disk */
 bool InitBlockIndex(const CChainParams& chainparams);
 /** Load the block tree and coins database from disk */
 bool LoadBlockIndex(const CChainParams& chainparams);
+/** Finish a write of the chainstate that was interrupted, requires the block index to be loaded */
+bool ReplayBlocks(const CChainParams& params, CCoinsView* view);
+/**
+ * Makes the base block of a UTXO set snapshot the chain tip, once the headers up to it are known and the chainstate
+ * holds the snapshot. vTxCounts has the transaction count of every block above the genesis block.
+ */
+bool ActivateSnapshotChain(const uint256& hashBaseBlock, const std::vector<unsigned int>& vTxCounts);
 /** Unload database information */
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the block header checking thread */
+void ThreadHeaderCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -380,6 +430,9 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
 /** Apply the effects of this transaction on the UTXO set represented by view */
 void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight);
 
+/** The script verification flags and the lock time flags of the consensus rules which apply to the transactions of a block. Requires cs_main. */
+unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consensus::Params& consensusparams, int& nLockTimeFlags);
+
 /** Transaction validation functions */
 
 /** Context-independent validity checks */
@@ -469,6 +522,38 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the context-free check of a run of consecutive block headers:
+ * computing their X11 hashes and checking those against the claimed proof of work.
+ * Stores pointers into the headers and results vectors, which must outlive it.
+ */
+class CBlockHeaderCheck
+{
+private:
+    const CBlockHeader *pheaders;
+    size_t nCount;
+    uint256 *phashes;
+    const Consensus::Params *pparams;
+    std::atomic<bool> *pfPoWValid;
+
+public:
+    CBlockHeaderCheck(): pheaders(NULL), nCount(0), phashes(NULL), pparams(NULL), pfPoWValid(NULL) {}
+    CBlockHeaderCheck(const CBlockHeader* pheadersIn, size_t nCountIn, uint256* phashesIn, const Consensus::Params& paramsIn, std::atomic<bool>& fPoWValidIn) :
+        pheaders(pheadersIn), nCount(nCountIn), phashes(phashesIn), pparams(&paramsIn), pfPoWValid(&fPoWValidIn) { }
+
+    // Always returns true, so that the queue keeps going and all hashes get computed.
+    // Proof of work failures are reported through pfPoWValid instead.
+    bool operator()();
+
+    void swap(CBlockHeaderCheck &check) {
+        std::swap(pheaders, check.pheaders);
+        std::swap(nCount, check.nCount);
+        std::swap(phashes, check.phashes);
+        std::swap(pparams, check.pparams);
+        std::swap(pfPoWValid, check.pfPoWValid);
+    }
+};
+
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes);
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool GetAddressIndex(uint160 addressHash, int type,
@@ -481,6 +566,10 @@ bool GetAddressUnspent(uint160 addressHash, int type,
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read a block in its serialized form, which is the same on disk and on the wire. Checks that it is the block of pindex. */
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart);
+/** Read the undo data of a block, hashBlock is the hash of its parent */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -490,6 +579,8 @@ void ReprocessBlocks(int nBlocks);
 
 /** Context-independent validity checks */
 bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true);
+/** Same as above, but uses the given precomputed hash of the header instead of hashing it again */
+bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true);
 bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
 /** Context-dependent validity checks.
@@ -530,9 +621,15 @@ extern CCoinsViewDB *pcoinsdbview;
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache *pcoinsTip;
 
+/** Global variable that points to the view which prefetches block inputs for pcoinsTip (protected by cs_main) */
+extern CCoinsViewPrefetch *pcoinsPrefetch;
+
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB *pblocktree;
 
+/** Global variable that points to the address, spent and timestamp index database (protected by cs_main) */
+extern CInsightIndexDB *pinsightindex;
+
 /**
  * Return the spend height, which is one more than the inputs.GetBestBlock().
  * While checking, GetBestBlock() refers to the parent block. (protected by cs_main)
@@ -4945,7 +4945,8 @@ CWallet* CWallet::CreateWalletFromFile(const std::string walletFile)
         //We can't rescan beyond non-pruned blocks, stop and throw an error
         //this might happen if a user uses a old wallet within a pruned node
         // or if he ran -disablewallet for a longer time, then decided to re-enable
-        if (fPruneMode)
+        // The blocks below a UTXO set snapshot are missing in the same way
+        if (fPruneMode || fLoadedFromSnapshot)
         {
             CBlockIndex *block = chainActive.Tip();
             while (block && block->pprev && (block->pprev->nStatus & BLOCK_HAVE_DATA) && block->pprev->nTx > 0 && pindexRescan != block)
@@ -0,0 +1,208 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "workstealingpool.h"
+
+#include "tinyformat.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Set for worker threads, so that we can detect if a task is pushed from inside the pool
+static thread_local const CWorkStealingPool* currentPool = nullptr;
+static thread_local int currentThreadId = -1;
+
+CWorkStealingPool::CWorkStealingPool()
+{
+    // allows pushing tasks before the pool is started. These are executed after Start() is called
+    queues.emplace_back(new WorkerQueue());
+}
+
+CWorkStealingPool::~CWorkStealingPool()
+{
+    Stop(true);
+}
+
+void CWorkStealingPool::Start(int threadCount, const std::string& threadName)
+{
+    assert(threads.empty());
+    assert(threadCount > 0);
+
+    // tasks which were pushed before we got started
+    std::deque<Task> oldTasks;
+    for (auto& q : queues) {
+        std::move(q->tasks.begin(), q->tasks.end(), std::back_inserter(oldTasks));
+    }
+
+    queues.clear();
+    for (int i = 0; i < threadCount; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    queues[0]->tasks = std::move(oldTasks);
+
+    stopRequested = false;
+    finishQueue = false;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&CWorkStealingPool::ThreadMain, this, i, threadName);
+    }
+}
+
+void CWorkStealingPool::Stop(bool wait)
+{
+    if (!wait) {
+        ClearQueue();
+    }
+    {
+        std::unique_lock<std::mutex> l(cs);
+        stopRequested = true;
+        finishQueue = wait;
+    }
+    cond.notify_all();
+
+    for (auto& t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    threads.clear();
+
+    // if there were no threads, the queue might still contain tasks
+    ClearQueue();
+}
+
+void CWorkStealingPool::ClearQueue()
+{
+    for (auto& q : queues) {
+        std::unique_lock<std::mutex> l(q->cs);
+        pendingCount -= q->tasks.size();
+        q->tasks.clear();
+    }
+}
+
+void CWorkStealingPool::PushTask(Task&& task)
+{
+    WorkerQueue* q;
+    if (currentPool == this) {
+        q = queues[currentThreadId].get();
+    } else {
+        q = queues[nextQueue++ % queues.size()].get();
+    }
+
+    {
+        std::unique_lock<std::mutex> l(q->cs);
+        q->tasks.emplace_back(std::move(task));
+        pendingCount++;
+    }
+
+    {
+        // Taking the lock avoids a lost wakeup when a worker has checked pendingCount but did not start waiting yet
+        std::unique_lock<std::mutex> l(cs);
+    }
+    cond.notify_one();
+}
+
+bool CWorkStealingPool::PopTask(int threadId, Task& taskRet)
+{
+    {
+        auto& q = *queues[threadId];
+        std::unique_lock<std::mutex> l(q.cs);
+        if (!q.tasks.empty()) {
+            taskRet = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            pendingCount--;
+            return true;
+        }
+    }
+
+    // own queue is empty, try to steal from the others
+    for (size_t i = 1; i < queues.size(); i++) {
+        auto& q = *queues[(threadId + i) % queues.size()];
+        std::unique_lock<std::mutex> l(q.cs);
+        if (!q.tasks.empty()) {
+            taskRet = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            pendingCount--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CWorkStealingPool::ThreadMain(int threadId, std::string threadName)
+{
+    RenameThread(strprintf("%s-%d", threadName, threadId).c_str());
+    currentPool = this;
+    currentThreadId = threadId;
+
+    while (true) {
+        Task task;
+        if (PopTask(threadId, task)) {
+            task(threadId);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> l(cs);
+        cond.wait(l, [&]() {
+            return pendingCount != 0 || stopRequested;
+        });
+        if (stopRequested && (!finishQueue || pendingCount == 0)) {
+            break;
+        }
+    }
+
+    currentPool = nullptr;
+    currentThreadId = -1;
+}
+
+int CWorkStealingPool::GetNumaNodeThreadCount()
+{
+    int systemCount = std::max((int)std::thread::hardware_concurrency(), 1);
+
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu < 0) {
+        return systemCount;
+    }
+
+    for (int node = 0; node < 64; node++) {
+        std::ifstream f(strprintf("/sys/devices/system/node/node%d/cpulist", node));
+        if (!f.is_open()) {
+            continue;
+        }
+        std::string cpuList;
+        std::getline(f, cpuList);
+
+        // format is a comma separated list of single CPUs or ranges, e.g. "0-7,16-23"
+        int count = 0;
+        bool found = false;
+        std::stringstream ss(cpuList);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            int first, last;
+            if (sscanf(range.c_str(), "%d-%d", &first, &last) != 2) {
+                if (sscanf(range.c_str(), "%d", &first) != 1) {
+                    continue;
+                }
+                last = first;
+            }
+            count += last - first + 1;
+            if (cpu >= first && cpu <= last) {
+                found = true;
+            }
+        }
+        if (found && count > 0) {
+            return std::min(count, systemCount);
+        }
+    }
+#endif
+
+    return systemCount;
+}
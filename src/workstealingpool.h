@@ -0,0 +1,85 @@
+// Copyright (c) 2026 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHN_WORKSTEALINGPOOL_H
+#define CHN_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Thread pool with one task deque per worker thread
+// Tasks pushed from inside a worker thread go to the back of the worker's own deque and are also taken from the back
+// (LIFO), which keeps recursively split work local and cache friendly. Idle workers steal from the front of other
+// workers' deques (FIFO), which gives them the oldest and usually largest pieces of work. Tasks pushed from outside
+// the pool are distributed round-robin. Compared to a single shared queue, this avoids contention when thousands of
+// small tasks are pushed, e.g. while verifying DKG contributions
+//
+// Tasks get the index of the executing thread passed, same as with ctpl::thread_pool
+class CWorkStealingPool
+{
+public:
+    typedef std::function<void(int threadId)> Task;
+
+private:
+    struct WorkerQueue {
+        std::mutex cs;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue> > queues;
+    std::vector<std::thread> threads;
+
+    // number of tasks in all queues
+    std::atomic<size_t> pendingCount{0};
+    std::atomic<size_t> nextQueue{0};
+
+    std::mutex cs;
+    std::condition_variable cond;
+    bool stopRequested{false};
+    bool finishQueue{false};
+
+public:
+    CWorkStealingPool();
+    ~CWorkStealingPool();
+
+    // Starts threadCount worker threads, named "<threadName>-<idx>"
+    void Start(int threadCount, const std::string& threadName);
+    // Stops all worker threads. If wait is true, all queued tasks are executed before returning, otherwise they are
+    // dropped
+    void Stop(bool wait);
+    void ClearQueue();
+
+    int Size() const { return (int)threads.size(); }
+
+    template<typename F, typename... Rest>
+    auto Push(F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+    {
+        auto pck = std::make_shared<std::packaged_task<decltype(f(0, rest...))(int)> >(
+            std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...)
+        );
+        PushTask([pck](int threadId) {
+            (*pck)(threadId);
+        });
+        return pck->get_future();
+    }
+
+    // Number of logical CPUs on the NUMA node the calling thread is running on. Falls back to the number of logical
+    // CPUs of the whole system when NUMA information is not available
+    static int GetNumaNodeThreadCount();
+
+private:
+    void PushTask(Task&& task);
+    bool PopTask(int threadId, Task& taskRet);
+    void ThreadMain(int threadId, std::string threadName);
+};
+
+#endif //CHN_WORKSTEALINGPOOL_H